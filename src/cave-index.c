@@ -0,0 +1,195 @@
+/**
+ * \file cave-index.c
+ * \brief Spatial index of the monsters and objects in a chunk
+ *
+ * Copyright (c) 2026 StukovTTV
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#include "angband.h"
+#include "cave.h"
+
+/**
+ * Each chunk keeps, for monsters and for floor objects, a bitmap with one bit
+ * per grid which is set when the grid holds a monster (not the player) or an
+ * object pile.  Each row of the chunk takes a whole number of 64-bit words, so
+ * a query for a box only has to look at the words covering the box, and
+ * within a word only at the bits which are set; finding the monsters within
+ * a few dozen grids of the player costs a few dozen words plus the monsters
+ * found, however many monsters there are on the level.
+ *
+ * The bitmaps are kept up to date by square_set_mon() and square_set_obj(),
+ * and by cave_index_note() wherever a floor pile is changed directly.
+ */
+
+#define INDEX_BITS 64
+
+/**
+ * Index of the lowest bit set in a non-zero word
+ */
+static int lowest_bit(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(word);
+#else
+	int n = 0;
+
+	while (!(word & 1)) {
+		word >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/**
+ * Allocate the index for a chunk with nothing in it
+ */
+void cave_index_new(struct chunk *c)
+{
+	int i;
+
+	c->index_words = (c->width + INDEX_BITS - 1) / INDEX_BITS;
+	for (i = 0; i < CAVE_INDEX_MAX; i++) {
+		c->index[i] = mem_zalloc(c->height * c->index_words *
+			sizeof(*c->index[i]));
+	}
+}
+
+/**
+ * Free the index of a chunk
+ */
+void cave_index_free(struct chunk *c)
+{
+	int i;
+
+	for (i = 0; i < CAVE_INDEX_MAX; i++) {
+		mem_free(c->index[i]);
+		c->index[i] = NULL;
+	}
+}
+
+/**
+ * Set or clear the bit for a grid in one of the bitmaps
+ */
+static void index_set(struct chunk *c, enum cave_index_kind kind,
+		struct loc grid, bool on)
+{
+	uint64_t *word = &c->index[kind][grid.y * c->index_words +
+		grid.x / INDEX_BITS];
+	uint64_t bit = (uint64_t) 1 << (grid.x % INDEX_BITS);
+
+	if (on) {
+		*word |= bit;
+	} else {
+		*word &= ~bit;
+	}
+}
+
+/**
+ * Bring the index up to date with the monster and object pile at a grid
+ */
+void cave_index_note(struct chunk *c, struct loc grid)
+{
+	int i = square_idx(c, grid);
+
+	index_set(c, CAVE_INDEX_MON, grid, c->sq_mon[i] > 0);
+	index_set(c, CAVE_INDEX_OBJ, grid, c->sq_obj[i] != NULL);
+}
+
+/**
+ * Visit the grids within a box, corners included, which hold a monster or an
+ * object pile, row by row and from left to right within each row.
+ *
+ * \param c is the chunk
+ * \param kind is CAVE_INDEX_MON for monsters, CAVE_INDEX_OBJ for objects
+ * \param top_left is the top left corner of the box
+ * \param bottom_right is the bottom right corner of the box
+ * \param visit is called for each grid, and the search stops when it returns
+ * false; if NULL, the grids are just counted
+ * \param data is passed to visit
+ * \return the number of grids visited
+ *
+ * The box may extend beyond the chunk.  The visitor may change the contents
+ * of the grid it is given, but not those of grids still to be visited.
+ */
+int cave_index_box(struct chunk *c, enum cave_index_kind kind,
+		struct loc top_left, struct loc bottom_right,
+		cave_index_visitor visit, void *data)
+{
+	int x1 = MAX(top_left.x, 0), x2 = MIN(bottom_right.x, c->width - 1);
+	int y1 = MAX(top_left.y, 0), y2 = MIN(bottom_right.y, c->height - 1);
+	int w1 = x1 / INDEX_BITS, w2 = x2 / INDEX_BITS;
+	int y, n = 0;
+
+	if (x1 > x2 || y1 > y2) return 0;
+	for (y = y1; y <= y2; y++) {
+		const uint64_t *row = c->index[kind] + y * c->index_words;
+		int w;
+
+		for (w = w1; w <= w2; w++) {
+			uint64_t word = row[w];
+
+			/* Only the part of the word within the box */
+			if (w == w1) {
+				word &= ~(uint64_t) 0 << (x1 % INDEX_BITS);
+			}
+			if (w == w2 && x2 % INDEX_BITS != INDEX_BITS - 1) {
+				word &= ((uint64_t) 1 << (x2 % INDEX_BITS + 1)) - 1;
+			}
+
+			while (word) {
+				struct loc grid = loc(w * INDEX_BITS +
+					lowest_bit(word), y);
+
+				word &= word - 1;
+				n++;
+				if (visit && !visit(c, grid, data)) return n;
+			}
+		}
+	}
+	return n;
+}
+
+struct radius_visit {
+	struct loc centre;
+	int radius;
+	cave_index_visitor visit;
+	void *data;
+	int n;
+};
+
+static bool visit_in_radius(struct chunk *c, struct loc grid, void *data)
+{
+	struct radius_visit *rv = data;
+
+	if (distance(rv->centre, grid) > rv->radius) return true;
+	rv->n++;
+	return !rv->visit || rv->visit(c, grid, rv->data);
+}
+
+/**
+ * Visit the grids within distance() radius of a grid which hold a monster or
+ * an object pile, in the same order as cave_index_box(); the parameters are
+ * as for cave_index_box(), and it returns the number of grids visited.
+ */
+int cave_index_radius(struct chunk *c, enum cave_index_kind kind,
+		struct loc centre, int radius, cave_index_visitor visit,
+		void *data)
+{
+	struct radius_visit rv = { centre, radius, visit, data, 0 };
+
+	(void) cave_index_box(c, kind, loc(centre.x - radius, centre.y - radius),
+		loc(centre.x + radius, centre.y + radius), visit_in_radius, &rv);
+	return rv.n;
+}
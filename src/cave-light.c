@@ -0,0 +1,596 @@
+/**
+ * \file cave-light.c
+ * \brief Light levels of the grids in a chunk
+ *
+ * Copyright (c) 1997 Ben Harrison, James E. Wilson, Robert A. Koeneke
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#include "angband.h"
+#include "cave.h"
+#include "game-world.h"
+#include "init.h"
+#include "monster.h"
+#include "mon-predicate.h"
+#include "player-calcs.h"
+
+/**
+ * The light level of a grid is the sum of a base level, from SQUARE_GLOW and
+ * bright terrain, and the contributions of the light sources (the player and
+ * light-emitting monsters) near it.  Rather than recomputing all of that
+ * every time the view is updated, each chunk keeps a light map:
+ *
+ * - the base level is only recomputed, for the whole chunk, when terrain or
+ *   SQUARE_GLOW changes (see light_map_note_terrain() and
+ *   light_map_note_glow()) or when the sun rises or sets;
+ * - each source remembers the grids it lights, and by how much, and that is
+ *   only recomputed when the source moves, changes its radius or intensity,
+ *   or terrain within its radius changes;
+ * - whether a wall appears lit depends on where the player is, so lighting of
+ *   walls is kept as a list of entries which are retested, without any line
+ *   of sight calculation, when the player moves.
+ *
+ * The light level stored in each square is updated by applying or removing
+ * entries, so the result is the same as summing everything from scratch.
+ */
+
+enum light_test {
+	LIGHT_TEST_NONE = 0,	/* Always applies */
+	LIGHT_TEST_GLOW,	/* Glowing wall; see glow_can_light_wall() */
+	LIGHT_TEST_SOURCE	/* Wall lit from "from"; see source_can_light_wall() */
+};
+
+struct light_entry {
+	struct loc grid;
+	struct loc from;
+	int16_t amount;
+	uint8_t test;
+	bool applied;
+};
+
+struct light_source {
+	bool active;		/* Entries describe a current source */
+	bool valid;		/* Entries still match the terrain */
+	struct loc grid;
+	int radius;
+	int inten;
+	struct light_entry *entries;
+	int n;
+	int alloc;
+};
+
+struct light_map {
+	bool base_dirty;
+	bool sunlit;
+	struct loc player_grid;
+
+	/* Lighting of walls from SQUARE_GLOW and bright terrain */
+	struct light_entry *walls;
+	int n_walls;
+	int alloc_walls;
+
+	/* Index 0 is the player, others are monster indices */
+	struct light_source *sources;
+	int n_sources;
+};
+
+/**
+ * Help glow_can_light_wall() and light_entry_wanted():  check for
+ * whether a wall can appear to be lit, as viewed by the player, by a light
+ * source regardless of line-of-sight details.
+ * \param c Is the chunk in which to do the evaluation.
+ * \param p Is the player to test.
+ * \param sgrid Is the location of the light source.
+ * \param wgrid Is the location of the wall.
+ * \return Return true if the wall will appear to be lit for the player.
+ * Otherwise, return false.
+ */
+static bool source_can_light_wall(struct chunk *c, struct player *p,
+		struct loc sgrid, struct loc wgrid)
+{
+	struct loc sn = next_grid(wgrid, motion_dir(wgrid, sgrid)), pn, cn;
+
+	/*
+	 * If the light source is coincident with the wall, all faces will be
+	 * lit, and the player can potentially see it if it's within range and
+	 * the line of sight isn't broken.
+	 */
+	if (loc_eq(sn, wgrid)) return true;
+
+	/*
+	 * If the player is coincident with the wall, all faces of the wall are
+	 * visible to the player and the player can see whichever of those is
+	 * lit by the light source.
+	 */
+	pn = next_grid(wgrid, motion_dir(wgrid, p->grid));
+	if (loc_eq(pn, wgrid)) return true;
+
+	/*
+	 * For the lit face of the wall to be visible to the player, the
+	 * view directions from the wall to the player and the wall to the
+	 * light source must share at least one component.
+	 */
+	if (sn.x == pn.x) {
+		/*
+		 * If the view directions share both components, the lit face
+		 * will be visible to the player if in range and the line of
+		 * sight isn't broken.
+		 */
+		if (sn.y == pn.y) return true;
+		cn.x = sn.x;
+		cn.y = 0;
+	} else if (sn.y == pn.y) {
+		cn.x = 0;
+		cn.y = sn.y;
+	} else {
+		/*
+		 * If the view directions don't share a component, the lit face
+		 * is not visible to the player.
+		 */
+		return false;
+	}
+
+	/*
+	 * When only one component of the view directions is shared, take the
+	 * common component and test whether there's a wall there that would
+	 * block the player's view of the lit face.  That prevents instances
+	 * like this:
+	 *  p
+	 * ###1#
+	 *  @
+	 * where both the light-emitting monster, 'p', and the player, '@',
+	 * have line of sight to the wall, '1', but the face of '1' that would
+	 * be lit is blocked by the wall immediately to the left of '1'.
+	 */
+	return square_allowslos(c, cn);
+}
+
+/**
+ * Help light_entry_wanted():  check for whether a wall marked with SQUARE_GLOW
+ * can appear to be lit, as viewed by the player regardless of line-of-sight
+ * details.
+ * \param c Is the chunk in which to do the evaluation.
+ * \param p Is the player to test.
+ * \param wgrid Is the location of the wall.
+ * \param sunlit Is true if the level is lit by the sun.
+ * \return Return true if the wall will appear to be lit for the player.
+ * Otherwise, return false.
+ */
+static bool glow_can_light_wall(struct chunk *c, struct player *p,
+		struct loc wgrid, bool sunlit)
+{
+	struct loc pn = next_grid(wgrid, motion_dir(wgrid, p->grid)), chk;
+
+	/*
+	 * If the player is in the wall grid, the player will see the lit face.
+	 */
+	if (loc_eq(pn, wgrid)) return true;
+
+	/*
+	 * If the grid in the direction of the player is not a wall, is either
+	 * sunlit or in a room, and is glowing, it'll illuminate the wall.
+	 */
+	if (square_allowslos(c, pn) && (sunlit || square_isroom(c, pn)) &&
+			square_isglow(c, pn)) return true;
+
+	/*
+	 * Try the two neighboring squares adjacent to the one in the direction
+	 * of the player to see if one or more will illuminate the wall by
+	 * glowing.  Those could be out of bounds if the direction isn't
+	 * diagonal.
+	 */
+	if (pn.x != wgrid.x) {
+		if (pn.y != wgrid.y) {
+			chk.x = pn.x;
+			chk.y = wgrid.y;
+			if (square_allowslos(c, chk) &&
+					(sunlit || square_isroom(c, chk)) &&
+					square_isglow(c, chk) &&
+					source_can_light_wall(c, p, chk, wgrid))
+				return true;
+			chk.x = wgrid.x;
+			chk.y = pn.y;
+			if (square_allowslos(c, chk) &&
+					(sunlit || square_isroom(c, chk)) &&
+					square_isglow(c, chk) &&
+					source_can_light_wall(c, p, chk, wgrid))
+				return true;
+		} else {
+			chk.x = pn.x;
+			chk.y = wgrid.y - 1;
+			if (square_in_bounds(c, chk) &&
+					square_allowslos(c, chk) &&
+					(sunlit || square_isroom(c, chk)) &&
+					square_isglow(c, chk) &&
+					source_can_light_wall(c, p, chk, wgrid))
+				return true;
+			chk.y = wgrid.y + 1;
+			if (square_in_bounds(c, chk) &&
+					square_allowslos(c, chk) &&
+					(sunlit || square_isroom(c, chk)) &&
+					square_isglow(c, chk) &&
+					source_can_light_wall(c, p, chk, wgrid))
+				return true;
+		}
+	} else {
+		chk.y = pn.y;
+		chk.x = wgrid.x - 1;
+		if (square_in_bounds(c, chk) && square_allowslos(c, chk) &&
+				(sunlit || square_isroom(c, chk)) &&
+				square_isglow(c, chk) &&
+				source_can_light_wall(c, p, chk, wgrid))
+			return true;
+		chk.x = wgrid.x + 1;
+		if (square_in_bounds(c, chk) && square_allowslos(c, chk) &&
+				(sunlit || square_isroom(c, chk)) &&
+				square_isglow(c, chk) &&
+				source_can_light_wall(c, p, chk, wgrid))
+			return true;
+	}
+
+	/*
+	 * The adjacent squares towards the player won't light the wall by
+	 * by glowing.
+	 */
+	return false;
+}
+
+/**
+ * Add an entry to a list, growing it as necessary.
+ */
+static void light_entry_add(struct light_entry **entries, int *n, int *alloc,
+		struct loc grid, struct loc from, int amount, enum light_test test)
+{
+	struct light_entry *e;
+
+	if (*n == *alloc) {
+		*alloc = (*alloc) ? 2 * (*alloc) : 16;
+		*entries = mem_realloc(*entries, *alloc * sizeof(**entries));
+	}
+	e = &(*entries)[(*n)++];
+	e->grid = grid;
+	e->from = from;
+	e->amount = amount;
+	e->test = test;
+	e->applied = false;
+}
+
+/**
+ * Check whether an entry should currently contribute to the light level.
+ */
+static bool light_entry_wanted(struct chunk *c, struct player *p,
+		const struct light_entry *e, bool sunlit)
+{
+	switch (e->test) {
+		case LIGHT_TEST_GLOW:
+			return glow_can_light_wall(c, p, e->grid, sunlit);
+		case LIGHT_TEST_SOURCE:
+			return source_can_light_wall(c, p, e->from, e->grid);
+		default:
+			return true;
+	}
+}
+
+/**
+ * Apply or remove entries so that exactly the wanted ones contribute.
+ */
+static void light_entries_sync(struct chunk *c, struct player *p,
+		struct light_entry *entries, int n, bool sunlit)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		struct light_entry *e = &entries[i];
+		bool want = light_entry_wanted(c, p, e, sunlit);
+
+		if (want == e->applied) continue;
+		c->sq_light[square_idx(c, e->grid)] +=
+			(want) ? e->amount : -e->amount;
+		e->applied = want;
+	}
+}
+
+/**
+ * Remove all of a source's contribution.
+ */
+static void light_source_unapply(struct chunk *c, struct light_source *src)
+{
+	int i;
+
+	for (i = 0; i < src->n; i++) {
+		struct light_entry *e = &src->entries[i];
+
+		if (!e->applied) continue;
+		c->sq_light[square_idx(c, e->grid)] -= e->amount;
+		e->applied = false;
+	}
+}
+
+/**
+ * Work out which grids a light source reaches and by how much.  Light does
+ * not propagate through walls; walls are only lit if the lit face can be
+ * seen by the player, which is decided when the entries are applied.
+ */
+static void light_source_build(struct chunk *c, struct light_source *src)
+{
+	int y;
+
+	src->n = 0;
+	for (y = -src->radius; y <= src->radius; y++) {
+		int x;
+
+		for (x = -src->radius; x <= src->radius; x++) {
+			struct loc grid = loc_sum(src->grid, loc(x, y));
+			int dist = distance(src->grid, grid);
+
+			if (!square_in_bounds(c, grid)) continue;
+			if (dist > src->radius) continue;
+			if (!los(c, src->grid, grid)) continue;
+			light_entry_add(&src->entries, &src->n, &src->alloc, grid,
+				src->grid, (src->inten > 0) ?
+				src->inten - dist : src->inten + dist,
+				square_allowslos(c, grid) ?
+				LIGHT_TEST_NONE : LIGHT_TEST_SOURCE);
+		}
+	}
+	src->valid = true;
+}
+
+/**
+ * Bring one light source up to date.
+ * \param c Is the chunk to use.
+ * \param p Is the player to use.
+ * \param map Is the light map for c.
+ * \param idx Is the source's index:  0 for the player, otherwise the monster's.
+ * \param grid Is the location of the light source.
+ * \param radius Is the radius, in grids, of the light source.
+ * \param inten Is the intensity of the light source.
+ * \param retest Is true if entries for walls have to be retested.
+ */
+static void light_source_update(struct chunk *c, struct player *p,
+		struct light_map *map, int idx, struct loc grid, int radius,
+		int inten, bool retest)
+{
+	struct light_source *src = &map->sources[idx];
+
+	if (src->active && src->valid && loc_eq(src->grid, grid)
+			&& src->radius == radius && src->inten == inten) {
+		if (retest) {
+			light_entries_sync(c, p, src->entries, src->n,
+				map->sunlit);
+		}
+		return;
+	}
+
+	light_source_unapply(c, src);
+	src->active = true;
+	src->grid = grid;
+	src->radius = radius;
+	src->inten = inten;
+	light_source_build(c, src);
+	light_entries_sync(c, p, src->entries, src->n, map->sunlit);
+}
+
+/**
+ * Recompute the base light level of every grid from SQUARE_GLOW and bright
+ * terrain.  Anything applied by the light sources is lost.
+ */
+static void light_base_rebuild(struct chunk *c, struct player *p,
+		struct light_map *map)
+{
+	int dir, i, x, y;
+
+	map->n_walls = 0;
+	for (y = 0; y < c->height; y++) {
+		for (x = 0; x < c->width; x++) {
+			struct loc grid = loc(x, y);
+
+			/* Starting values based on permanent light */
+			if (square_isglow(c, grid) && (map->sunlit ||
+					square_allowslos(c, grid))) {
+				c->sq_light[square_idx(c, loc(x, y))] = 1;
+			} else {
+				c->sq_light[square_idx(c, loc(x, y))] = 0;
+				if (square_isglow(c, grid)) {
+					light_entry_add(&map->walls,
+						&map->n_walls,
+						&map->alloc_walls, grid, grid,
+						1, LIGHT_TEST_GLOW);
+				}
+			}
+
+			/* Squares with bright terrain have intensity 2 */
+			if (!square_isbright(c, grid)) continue;
+			c->sq_light[square_idx(c, loc(x, y))] += 2;
+			for (dir = 0; dir < 8; dir++) {
+				struct loc adj_grid = loc_sum(grid, ddgrid_ddd[dir]);
+
+				if (!square_in_bounds(c, adj_grid)) continue;
+
+				/*
+				 * The light level of grids later in the scan
+				 * is reset when they are reached, so only
+				 * those already visited are brightened.
+				 */
+				if (adj_grid.y > y || (adj_grid.y == y &&
+						adj_grid.x > x)) continue;
+
+				/*
+				 * Only brighten a wall if the player is in
+				 * position to view the face that's lit up.
+				 */
+				if (square_allowslos(c, adj_grid)) {
+					c->sq_light[square_idx(c, adj_grid)]
+						+= 1;
+				} else {
+					light_entry_add(&map->walls,
+						&map->n_walls,
+						&map->alloc_walls, adj_grid,
+						grid, 1, LIGHT_TEST_SOURCE);
+				}
+			}
+		}
+	}
+	light_entries_sync(c, p, map->walls, map->n_walls, map->sunlit);
+
+	/* Nothing from the light sources is applied any more */
+	for (i = 0; i < map->n_sources; i++) {
+		struct light_source *src = &map->sources[i];
+		int j;
+
+		for (j = 0; j < src->n; j++)
+			src->entries[j].applied = false;
+		if (src->active && src->valid) {
+			light_entries_sync(c, p, src->entries, src->n,
+				map->sunlit);
+		}
+	}
+	map->base_dirty = false;
+}
+
+/**
+ * Get the light map for a chunk, creating it if necessary.
+ */
+static struct light_map *light_map_get(struct chunk *c)
+{
+	if (!c->light_map) {
+		c->light_map = mem_zalloc(sizeof(*c->light_map));
+		c->light_map->base_dirty = true;
+	}
+	if (c->light_map->n_sources < cave_monster_max(c)) {
+		struct light_map *map = c->light_map;
+		int n = MAX(cave_monster_max(c), 1);
+
+		map->sources = mem_realloc(map->sources,
+			n * sizeof(*map->sources));
+		memset(map->sources + map->n_sources, 0,
+			(n - map->n_sources) * sizeof(*map->sources));
+		map->n_sources = n;
+	}
+	return c->light_map;
+}
+
+/**
+ * Calculate light level for every grid - stolen from Sil
+ */
+void calc_lighting(struct chunk *c, struct player *p)
+{
+	struct light_map *map = light_map_get(c);
+	int light = p->state.cur_light, k;
+	int old_light = square_light(c, p->grid);
+	bool sunlit = is_daytime() && outside();
+	bool moved;
+
+	/* Permanent light */
+	if (map->sunlit != sunlit) {
+		map->sunlit = sunlit;
+		map->base_dirty = true;
+	}
+	if (map->base_dirty) {
+		/* Evaluates everything for the current player position */
+		map->player_grid = p->grid;
+		light_base_rebuild(c, p, map);
+		moved = false;
+	} else {
+		moved = !loc_eq(map->player_grid, p->grid);
+		map->player_grid = p->grid;
+		if (moved) {
+			light_entries_sync(c, p, map->walls, map->n_walls,
+				sunlit);
+		}
+	}
+
+	/* Light around the player */
+	light_source_update(c, p, map, 0, p->grid, ABS(light) - 1, light,
+		moved);
+
+	/* Add monster light or darkness */
+	for (k = 1; k < map->n_sources; k++) {
+		struct monster *mon = (k < cave_monster_max(c)) ?
+			cave_monster(c, k) : NULL;
+		int radius;
+
+		/* Skip dead monsters and those hidden or emitting no light */
+		if (!mon || !mon->race || monster_is_camouflaged(mon)
+				|| !mon->race->light) {
+			light_source_unapply(c, &map->sources[k]);
+			map->sources[k].active = false;
+			continue;
+		}
+
+		/* Skip if the player can't see it. */
+		light = mon->race->light;
+		radius = ABS(light) - 1;
+		if (distance(p->grid, mon->grid) - radius > z_info->max_sight) {
+			light_source_unapply(c, &map->sources[k]);
+			map->sources[k].active = false;
+			continue;
+		}
+
+		light_source_update(c, p, map, k, mon->grid, radius, light,
+			moved);
+	}
+
+	/* Update light level indicator */
+	if (square_light(c, p->grid) != old_light) {
+		p->upkeep->redraw |= PR_LIGHT;
+	}
+}
+
+/**
+ * Note that the terrain at a grid has changed, so the base light levels and
+ * the light sources near the grid have to be recomputed.
+ */
+void light_map_note_terrain(struct chunk *c, struct loc grid)
+{
+	struct light_map *map = c->light_map;
+	int i;
+
+	if (!map) return;
+	map->base_dirty = true;
+	for (i = 0; i < map->n_sources; i++) {
+		struct light_source *src = &map->sources[i];
+
+		if (!src->active) continue;
+		if (ABS(grid.x - src->grid.x) <= src->radius + 1
+				&& ABS(grid.y - src->grid.y) <= src->radius + 1)
+			src->valid = false;
+	}
+}
+
+/**
+ * Note that SQUARE_GLOW, or SQUARE_ROOM, has changed for some grid, so the
+ * base light levels have to be recomputed.
+ */
+void light_map_note_glow(struct chunk *c)
+{
+	if (c->light_map) c->light_map->base_dirty = true;
+}
+
+/**
+ * Free a chunk's light map.  The light levels in the chunk are left as they
+ * are and will be recomputed from scratch by the next calc_lighting().
+ */
+void light_map_free(struct chunk *c)
+{
+	struct light_map *map = c->light_map;
+	int i;
+
+	if (!map) return;
+	for (i = 0; i < map->n_sources; i++)
+		mem_free(map->sources[i].entries);
+	mem_free(map->sources);
+	mem_free(map->walls);
+	mem_free(map);
+	c->light_map = NULL;
+}
@@ -32,61 +32,13 @@
 #include "trap.h"
 
 /**
- * This function takes a grid location and extracts information the
- * player is allowed to know about it, filling in the grid_data structure
- * passed in 'g'.
- *
- * The information filled in is as follows:
- *  - g->f_idx is filled in with the terrain's feature type, or FEAT_NONE
- *    if the player doesn't know anything about the grid.  The function
- *    makes use of the "mimic" field in terrain in order to allow one
- *    feature to look like another (hiding secret doors, invisible traps,
- *    etc).  This will return the terrain type the player "Knows" about,
- *    not necessarily the real terrain.
- *  - g->m_idx is set to the monster index, or 0 if there is none (or the
- *    player doesn't know it).
- *  - g->first_kind is set to the object_kind of the first object in a grid
- *    that the player knows about, or NULL for no objects.
- *  - g->muliple_objects is true if there is more than one object in the
- *    grid that the player knows and cares about (to facilitate any special
- *    floor stack symbol that might be used).
- *  - g->in_view is true if the player can currently see the grid - this can
- *    be used to indicate field-of-view, such as through the 
- *    OPT(player, view_bright_light) option.
- *  - g->lighting is set to indicate the lighting level for the grid:
- *    LIGHTING_LIT by default, LIGHTING_DARK for unlit but seen grids within the
- *    detection radius of a player with the UNLIGHT ability and a light source
- *    with an intensity of one or less, LIGHTING_TORCH for seen and lit grids
- *    within the radius of the player's light source when the view_yellow_light
- *    option is on, and LIGHTING_LOS for seen and lit grids that don't qualify
- *    for LIGHTING_TORCH.
- *  - g->is_player is true if the player is on the given grid.
- *  - g->hallucinate is true if the player is hallucinating something "strange"
- *    for this grid - this should pick a random monster to show if the m_idx
- *    is non-zero, and a random object if first_kind is non-zero.
- * 
- * NOTES:
- * This is called pretty frequently, whenever a grid on the map display
- * needs updating, so don't overcomplicate it.
- *
- * Terrain is remembered separately from objects and monsters, so can be
- * shown even when the player can't "see" it.  This leads to things like
- * doors out of the player's view still change from closed to open and so on.
- *
- * TODO:
- * Hallucination is a display-level hack (mostly in ui-map.c's
- * grid_data_as_text(); some here) and we need it to be a knowledge-level
- * hack.  The idea is that objects may turn into different objects, monsters
- * into different monsters, and terrain may be objects, monsters, or stay the
- * same.
+ * Work out what the player knows of a grid for map_info(), short of monster
+ * visibility and hallucination
  */
-void map_info(struct loc grid, struct grid_data *g)
+static void map_info_aux(struct loc grid, struct grid_data *g)
 {
 	struct object *obj;
 
-	assert(grid.x < cave->width);
-	assert(grid.y < cave->height);
-
 	/* Default "clear" values, others will be set later where appropriate. */
 	g->first_kind = NULL;
 	g->trap = NULL;
@@ -96,19 +48,19 @@ void map_info(struct loc grid, struct grid_data *g)
 	g->unseen_money = false;
 
 	/* Use real feature (remove later) */
-	g->f_idx = square(cave, grid)->feat;
+	g->f_idx = square(cave, grid).feat;
 	if (f_info[g->f_idx].mimic)
 		g->f_idx = lookup_feat(f_info[g->f_idx].mimic);
 
 	g->in_view = (square_isseen(cave, grid)) ? true : false;
-	g->is_player = (square(cave, grid)->mon < 0) ? true : false;
-	g->m_idx = (g->is_player) ? 0 : square(cave, grid)->mon;
+	g->is_player = (square(cave, grid).mon < 0) ? true : false;
+	g->m_idx = (g->is_player) ? 0 : square(cave, grid).mon;
 	g->hallucinate = player->timed[TMD_IMAGE] ? true : false;
 
 	if (g->in_view) {
 		bool lit = square_islit(cave, grid);
 
-		if (sqinfo_has(square(cave, grid)->info, SQUARE_CLOSE_PLAYER)) {
+		if (sqinfo_has(square(cave, grid).info, SQUARE_CLOSE_PLAYER)) {
 			if (player_has(player, PF_UNLIGHT) &&
 					player->state.cur_light <= 1) {
 				g->lighting = (lit) ?
@@ -130,13 +82,13 @@ void map_info(struct loc grid, struct grid_data *g)
 	}
 
 	/* Use known feature */
-	g->f_idx = square(player->cave, grid)->feat;
+	g->f_idx = square(player->cave, grid).feat;
 	if (f_info[g->f_idx].mimic)
 		g->f_idx = lookup_feat(f_info[g->f_idx].mimic);
 
 	/* There is a known trap in this square */
 	if (square_trap(player->cave, grid) && square_isknown(cave, grid)) {
-		struct trap *trap = square(player->cave, grid)->trap;
+		struct trap *trap = square(player->cave, grid).trap;
 
 		/* Scan the square trap list */
 		while (trap) {
@@ -170,6 +122,173 @@ void map_info(struct loc grid, struct grid_data *g)
 			break;
 		}
 	}
+}
+
+/**
+ * The map cache keeps what map_info_aux() found for each grid of the current
+ * level, along with the cheaply read things it was worked out from:  the real
+ * and known terrain, the view and light flags, the occupant, and the heads of
+ * the known object and trap lists.  An entry is used again while those are
+ * unchanged.  Anything else which changes how a grid looks to the player -
+ * an object being noticed or ignored, a trap being disarmed - has to go
+ * through square_note_spot() or square_light_spot() anyway to be shown, and
+ * those forget the entry.  Known piles can also change in place without
+ * either, when objects are sensed or seen by detection, so object_sense(),
+ * object_see() and forget_remembered_objects() forget the entry too.  Monster
+ * visibility is rechecked every time, and the cache is not used while the
+ * player hallucinates, since that draws random numbers.
+ */
+struct map_cache_entry {
+	struct grid_data g;
+	const struct object *obj;
+	const struct trap *trap;
+	int16_t mon;
+	uint8_t feat;
+	uint8_t known;
+	uint8_t flags;
+	bool valid;
+};
+
+struct map_cache {
+	struct map_cache_entry *entries;
+	const struct chunk *known;	/* The player's knowledge it was made with */
+	int context;			/* Player state which affects lighting */
+};
+
+/**
+ * Player state, common to every grid, which map_info_aux() depends on
+ */
+static int map_cache_context(void)
+{
+	int context = 1;
+
+	if (OPT(player, view_yellow_light)) context |= 2;
+	if (player_has(player, PF_UNLIGHT) && player->state.cur_light <= 1)
+		context |= 4;
+	return context;
+}
+
+/**
+ * Fill in or check the record of what a cache entry was worked out from
+ */
+static bool map_cache_key(struct map_cache_entry *e, struct loc grid,
+		bool set)
+{
+	int i = square_idx(cave, grid);
+	const struct object *obj = player->cave->sq_obj[i];
+	const struct trap *trap = player->cave->sq_trap[i];
+	uint8_t flags = 0;
+
+	if (sqinfo_has(square(cave, grid).info, SQUARE_SEEN)) flags |= 1;
+	if (sqinfo_has(square(cave, grid).info, SQUARE_CLOSE_PLAYER))
+		flags |= 2;
+	if (sqinfo_has(square(cave, grid).info, SQUARE_GLOW)) flags |= 4;
+	if (cave->sq_light[i] > 0) flags |= 8;
+
+	if (set) {
+		e->obj = obj;
+		e->trap = trap;
+		e->mon = cave->sq_mon[i];
+		e->feat = cave->sq_feat[i];
+		e->known = player->cave->sq_feat[i];
+		e->flags = flags;
+		e->valid = true;
+		return true;
+	}
+	return e->valid && e->obj == obj && e->trap == trap
+		&& e->mon == cave->sq_mon[i] && e->feat == cave->sq_feat[i]
+		&& e->known == player->cave->sq_feat[i] && e->flags == flags;
+}
+
+/**
+ * Get the map cache for the current level, creating it if necessary, and
+ * forgetting it if made for other player state
+ */
+static struct map_cache *map_cache_get(void)
+{
+	struct map_cache *mc = cave->map_cache;
+	int context = map_cache_context();
+
+	if (!mc) {
+		mc = mem_zalloc(sizeof(*mc));
+		mc->entries = mem_zalloc(cave->height * cave->width
+			* sizeof(*mc->entries));
+		cave->map_cache = mc;
+	} else if (mc->known != player->cave || mc->context != context) {
+		map_cache_forget_all(cave);
+	}
+	mc->known = player->cave;
+	mc->context = context;
+	return mc;
+}
+
+/**
+ * This function takes a grid location and extracts information the
+ * player is allowed to know about it, filling in the grid_data structure
+ * passed in 'g'.
+ *
+ * The information filled in is as follows:
+ *  - g->f_idx is filled in with the terrain's feature type, or FEAT_NONE
+ *    if the player doesn't know anything about the grid.  The function
+ *    makes use of the "mimic" field in terrain in order to allow one
+ *    feature to look like another (hiding secret doors, invisible traps,
+ *    etc).  This will return the terrain type the player "Knows" about,
+ *    not necessarily the real terrain.
+ *  - g->m_idx is set to the monster index, or 0 if there is none (or the
+ *    player doesn't know it).
+ *  - g->first_kind is set to the object_kind of the first object in a grid
+ *    that the player knows about, or NULL for no objects.
+ *  - g->muliple_objects is true if there is more than one object in the
+ *    grid that the player knows and cares about (to facilitate any special
+ *    floor stack symbol that might be used).
+ *  - g->in_view is true if the player can currently see the grid - this can
+ *    be used to indicate field-of-view, such as through the 
+ *    OPT(player, view_bright_light) option.
+ *  - g->lighting is set to indicate the lighting level for the grid:
+ *    LIGHTING_LIT by default, LIGHTING_DARK for unlit but seen grids within the
+ *    detection radius of a player with the UNLIGHT ability and a light source
+ *    with an intensity of one or less, LIGHTING_TORCH for seen and lit grids
+ *    within the radius of the player's light source when the view_yellow_light
+ *    option is on, and LIGHTING_LOS for seen and lit grids that don't qualify
+ *    for LIGHTING_TORCH.
+ *  - g->is_player is true if the player is on the given grid.
+ *  - g->hallucinate is true if the player is hallucinating something "strange"
+ *    for this grid - this should pick a random monster to show if the m_idx
+ *    is non-zero, and a random object if first_kind is non-zero.
+ * 
+ * NOTES:
+ * This is called pretty frequently, whenever a grid on the map display
+ * needs updating, so don't overcomplicate it.  Most of the work is kept in
+ * the map cache, see above.
+ *
+ * Terrain is remembered separately from objects and monsters, so can be
+ * shown even when the player can't "see" it.  This leads to things like
+ * doors out of the player's view still change from closed to open and so on.
+ *
+ * TODO:
+ * Hallucination is a display-level hack (mostly in ui-map.c's
+ * grid_data_as_text(); some here) and we need it to be a knowledge-level
+ * hack.  The idea is that objects may turn into different objects, monsters
+ * into different monsters, and terrain may be objects, monsters, or stay the
+ * same.
+ */
+void map_info(struct loc grid, struct grid_data *g)
+{
+	assert(grid.x < cave->width);
+	assert(grid.y < cave->height);
+
+	if (player->timed[TMD_IMAGE]) {
+		map_info_aux(grid, g);
+	} else {
+		struct map_cache *mc = map_cache_get();
+		struct map_cache_entry *e = &mc->entries[square_idx(cave, grid)];
+
+		if (!map_cache_key(e, grid, false)) {
+			map_info_aux(grid, &e->g);
+			map_cache_key(e, grid, true);
+		}
+		*g = e->g;
+	}
 
 	/* Monsters */
 	if (g->m_idx > 0) {
@@ -195,6 +314,39 @@ void map_info(struct loc grid, struct grid_data *g)
 	/* All other g fields are 'flags', mostly booleans. */
 }
 
+/**
+ * Forget what map_info() found for a grid
+ */
+void map_cache_forget(struct chunk *c, struct loc grid)
+{
+	if (c && c->map_cache)
+		c->map_cache->entries[square_idx(c, grid)].valid = false;
+}
+
+/**
+ * Forget what map_info() found for every grid, after changes to what the
+ * player knows of much of the level
+ */
+void map_cache_forget_all(struct chunk *c)
+{
+	int i, n = c->height * c->width;
+
+	if (!c->map_cache) return;
+	for (i = 0; i < n; i++)
+		c->map_cache->entries[i].valid = false;
+}
+
+/**
+ * Free a chunk's map cache
+ */
+void map_cache_free(struct chunk *c)
+{
+	if (!c->map_cache) return;
+	mem_free(c->map_cache->entries);
+	mem_free(c->map_cache);
+	c->map_cache = NULL;
+}
+
 
 /**
  * Memorize interesting viewable object/features in the given grid
@@ -230,6 +382,7 @@ void square_note_spot(struct chunk *c, struct loc grid)
 	/* Require "seen" flag and the current level */
 	if (c != cave) return;
 	if (!square_isseen(c, grid) && !square_isplayer(c, grid)) return;
+	map_cache_forget(c, grid);
 
 	/* Make the player know precisely what is on this grid */
 	square_know_pile(c, grid, NULL);
@@ -256,6 +409,7 @@ void square_note_spot(struct chunk *c, struct loc grid)
  */
 void square_light_spot(struct chunk *c, struct loc grid)
 {
+	map_cache_forget(c, grid);
 	if ((c == cave) && player->cave) {
 		player->upkeep->redraw |= PR_ITEMLIST;
 		event_signal_point(EVENT_MAP, grid.x, grid.y);
@@ -283,7 +437,7 @@ static void cave_light(struct point_set *ps)
 	/* Apply flag changes */
 	for (i = 0; i < ps->n; i++)	{
 		/* Perma-Light */
-		sqinfo_on(square(cave, ps->pts[i])->info, SQUARE_GLOW);
+		square_glow(cave, ps->pts[i]);
 	}
 
 	/* Process the grids */
@@ -292,7 +446,7 @@ static void cave_light(struct point_set *ps)
 		square_light_spot(cave, ps->pts[i]);
 
 		/* Process affected monsters */
-		if (square(cave, ps->pts[i])->mon > 0) {
+		if (square(cave, ps->pts[i]).mon > 0) {
 			int chance = 25;
 
 			struct monster *mon = square_monster(cave, ps->pts[i]);
@@ -330,7 +484,7 @@ static void cave_unlight(struct point_set *ps)
 
 		/* Darken the grid... */
 		if (!square_isbright(cave, ps->pts[i])) {
-			sqinfo_off(square(cave, ps->pts[i])->info, SQUARE_GLOW);
+			square_unglow(cave, ps->pts[i]);
 		}
 
 		/* ...but dark-loving characters remember them */
@@ -434,7 +588,7 @@ void wiz_light(struct chunk *c, struct player *p, bool full)
 					struct loc a_grid = loc_sum(grid, ddgrid_ddd[i]);
 
 					/* Perma-light the grid */
-					sqinfo_on(square(c, a_grid)->info, SQUARE_GLOW);
+					square_glow(c, a_grid);
 
 					/* Memorize normal features */
 					if (!square_isfloor(c, a_grid) || 
@@ -474,6 +628,7 @@ void wiz_light(struct chunk *c, struct player *p, bool full)
 
 	/* Fully update the visuals */
 	p->upkeep->update |= (PU_UPDATE_VIEW | PU_MONSTERS);
+	map_cache_forget_all(c);
 
 	/* Redraw whole map, monster list */
 	p->upkeep->redraw |= (PR_MAP | PR_MONLIST | PR_ITEMLIST);
@@ -505,7 +660,7 @@ void wiz_dark(struct chunk *c, struct player *p, bool full)
 					struct loc a_grid = loc_sum(grid, ddgrid_ddd[i]);
 
 					/* Perma-darken the grid */
-					sqinfo_off(square(c, a_grid)->info, SQUARE_GLOW);
+					square_unglow(c, a_grid);
 
 					/* Memorize normal features */
 					if (!square_isfloor(c, a_grid) || 
@@ -545,6 +700,7 @@ void wiz_dark(struct chunk *c, struct player *p, bool full)
 
 	/* Fully update the visuals */
 	p->upkeep->update |= (PU_UPDATE_VIEW | PU_MONSTERS);
+	map_cache_forget_all(c);
 
 	/* Redraw whole map, monster list */
 	p->upkeep->redraw |= (PR_MAP | PR_MONLIST | PR_ITEMLIST);
@@ -580,10 +736,10 @@ void cave_illuminate(struct chunk *c, bool daytime)
 
 			/* Only interesting grids at night */
 			if (is_daylight()) {
-				sqinfo_on(square(c, grid)->info, SQUARE_GLOW);
+				square_glow(c, grid);
 				if (light && square_isview(c, grid)) square_memorize(c, grid);
 			} else if (!square_isbright(c, grid)) {
-				sqinfo_off(square(c, grid)->info, SQUARE_GLOW);
+				square_unglow(c, grid);
 			}
 		}
 	}
@@ -597,7 +753,7 @@ void cave_illuminate(struct chunk *c, bool daytime)
 				continue;
 			for (i = 0; i < 8; i++) {
 				struct loc a_grid = loc_sum(grid, ddgrid_ddd[i]);
-				sqinfo_on(square(c, a_grid)->info, SQUARE_GLOW);
+				square_glow(c, a_grid);
 				square_memorize(c, a_grid);
 			}
 		}
@@ -606,6 +762,7 @@ void cave_illuminate(struct chunk *c, bool daytime)
 
 	/* Fully update the visuals */
 	player->upkeep->update |= (PU_UPDATE_VIEW | PU_MONSTERS);
+	map_cache_forget_all(c);
 
 	/* Redraw map, monster list */
 	player->upkeep->redraw |= (PR_MAP | PR_MONLIST | PR_ITEMLIST);
@@ -620,9 +777,9 @@ void cave_illuminate(struct chunk *c, bool daytime)
 void expose_to_sun(struct chunk *c, struct loc grid, bool daytime)
 {
 	if (daytime || !square_isfloor(c, grid)) {
-		sqinfo_on(square(c, grid)->info, SQUARE_GLOW);
+		square_glow(c, grid);
 	} else if (!square_isbright(c, grid)) {
-		sqinfo_off(square(c, grid)->info, SQUARE_GLOW);
+		square_unglow(c, grid);
 	}
 }
 
@@ -651,7 +808,10 @@ void cave_known(struct player *p)
 
 			/* Internal walls not known */
 			if (count < 8) {
-				p->cave->squares[y][x].feat = square(cave, grid)->feat;
+				p->cave->sq_feat[square_idx(p->cave, grid)] =
+					square(cave, grid).feat;
+				p->cave->sq_props[square_idx(p->cave, grid)] =
+					cave->sq_props[square_idx(cave, grid)];
 			}
 		}
 	}
@@ -20,6 +20,7 @@
 #include "cave.h"
 #include "game-world.h"
 #include "init.h"
+#include "mon-schedule.h"
 #include "monster.h"
 #include "obj-knowledge.h"
 #include "obj-pile.h"
@@ -156,7 +157,7 @@ bool feat_is_shop(int feat)
  */
 bool feat_is_los(int feat)
 {
-	return tf_has(f_info[feat].flags, TF_LOS);
+	return (feat_props[feat] & FPROP_LOS) ? true : false;
 }
 
 /**
@@ -164,7 +165,7 @@ bool feat_is_los(int feat)
  */
 bool feat_is_passable(int feat)
 {
-	return tf_has(f_info[feat].flags, TF_PASSABLE);
+	return (feat_props[feat] & FPROP_PASSABLE) ? true : false;
 }
 
 /**
@@ -172,7 +173,7 @@ bool feat_is_passable(int feat)
  */
 bool feat_is_projectable(int feat)
 {
-	return tf_has(f_info[feat].flags, TF_PROJECT);
+	return (feat_props[feat] & FPROP_PROJECT) ? true : false;
 }
 
 /**
@@ -180,7 +181,7 @@ bool feat_is_projectable(int feat)
  */
 bool feat_is_torch(int feat)
 {
-	return tf_has(f_info[feat].flags, TF_TORCH);
+	return (feat_props[feat] & FPROP_TORCH) ? true : false;
 }
 
 /**
@@ -188,7 +189,7 @@ bool feat_is_torch(int feat)
  */
 bool feat_is_bright(int feat)
 {
-	return tf_has(f_info[feat].flags, TF_BRIGHT);
+	return (feat_props[feat] & FPROP_BRIGHT) ? true : false;
 }
 
 /**
@@ -204,7 +205,7 @@ bool feat_is_fiery(int feat)
  */
 bool feat_is_no_flow(int feat)
 {
-	return tf_has(f_info[feat].flags, TF_NO_FLOW);
+	return (feat_props[feat] & FPROP_NO_FLOW) ? true : false;
 }
 
 /**
@@ -212,7 +213,7 @@ bool feat_is_no_flow(int feat)
  */
 bool feat_is_no_scent(int feat)
 {
-	return tf_has(f_info[feat].flags, TF_NO_SCENT);
+	return (feat_props[feat] & FPROP_NO_SCENT) ? true : false;
 }
 
 /**
@@ -299,8 +300,8 @@ bool feat_is_expose(int feat)
  * SQUARE FEATURE PREDICATES
  *
  * These functions are used to figure out what kind of square something is,
- * via c->squares[y][x].feat (preferably accessed via square(c, grid)).
- * All direct testing of square(c, grid)->feat should be rewritten
+ * via c->sq_feat (preferably accessed via square(c, grid)).
+ * All direct testing of square(c, grid).feat should be rewritten
  * in terms of these functions.
  *
  * It's often better to use square behavior predicates (written in terms of
@@ -316,7 +317,7 @@ bool feat_is_expose(int feat)
  */
 bool square_isfloor(struct chunk *c, struct loc grid)
 {
-	return feat_is_floor(square(c, grid)->feat);
+	return feat_is_floor(square(c, grid).feat);
 }
 
 /**
@@ -324,7 +325,7 @@ bool square_isfloor(struct chunk *c, struct loc grid)
  */
 bool square_isrun1(struct chunk *c, struct loc grid)
 {
-	return feat_is_run1(square(c, grid)->feat);
+	return feat_is_run1(square(c, grid).feat);
 }
 
 /**
@@ -332,7 +333,7 @@ bool square_isrun1(struct chunk *c, struct loc grid)
  */
 bool square_isrun2(struct chunk *c, struct loc grid)
 {
-	return feat_is_run2(square(c, grid)->feat);
+	return feat_is_run2(square(c, grid).feat);
 }
 
 /**
@@ -340,7 +341,7 @@ bool square_isrun2(struct chunk *c, struct loc grid)
  */
 bool square_istrappable(struct chunk *c, struct loc grid)
 {
-	return feat_is_trap_holding(square(c, grid)->feat);
+	return feat_is_trap_holding(square(c, grid).feat);
 }
 
 /**
@@ -348,7 +349,7 @@ bool square_istrappable(struct chunk *c, struct loc grid)
  */
 bool square_isobjectholding(struct chunk *c, struct loc grid)
 {
-	return feat_is_object_holding(square(c, grid)->feat);
+	return feat_is_object_holding(square(c, grid).feat);
 }
 
 /**
@@ -356,7 +357,7 @@ bool square_isobjectholding(struct chunk *c, struct loc grid)
  */
 bool square_isobjecthiding(struct chunk *c, struct loc grid)
 {
-	return feat_is_hide_obj(square(c, grid)->feat);
+	return feat_is_hide_obj(square(c, grid).feat);
 }
 
 /**
@@ -364,8 +365,8 @@ bool square_isobjecthiding(struct chunk *c, struct loc grid)
  */
 bool square_isrock(struct chunk *c, struct loc grid)
 {
-	return (tf_has(f_info[square(c, grid)->feat].flags, TF_GRANITE) &&
-			!tf_has(f_info[square(c, grid)->feat].flags, TF_DOOR_ANY));
+	return (tf_has(f_info[square(c, grid).feat].flags, TF_GRANITE) &&
+			!tf_has(f_info[square(c, grid).feat].flags, TF_DOOR_ANY));
 }
 
 /**
@@ -373,7 +374,7 @@ bool square_isrock(struct chunk *c, struct loc grid)
  */
 bool square_isgranite(struct chunk *c, struct loc grid)
 {
-	return feat_is_granite(square(c, grid)->feat);
+	return feat_is_granite(square(c, grid).feat);
 }
 
 /**
@@ -381,7 +382,7 @@ bool square_isgranite(struct chunk *c, struct loc grid)
  */
 bool square_ispermanent(struct chunk *c, struct loc grid)
 {
-	return feat_is_permanent(square(c, grid)->feat);
+	return feat_is_permanent(square(c, grid).feat);
 }
 
 /**
@@ -390,7 +391,7 @@ bool square_ispermanent(struct chunk *c, struct loc grid)
 bool square_isperm(struct chunk *c, struct loc grid)
 {
 	return (square_ispermanent(c, grid) &&
-			tf_has(f_info[square(c, grid)->feat].flags, TF_ROCK));
+			tf_has(f_info[square(c, grid).feat].flags, TF_ROCK));
 }
 
 /**
@@ -398,7 +399,7 @@ bool square_isperm(struct chunk *c, struct loc grid)
  */
 bool square_ismagma(struct chunk *c, struct loc grid)
 {
-	return feat_is_magma(square(c, grid)->feat);
+	return feat_is_magma(square(c, grid).feat);
 }
 
 /**
@@ -406,7 +407,7 @@ bool square_ismagma(struct chunk *c, struct loc grid)
  */
 bool square_isquartz(struct chunk *c, struct loc grid)
 {
-	return feat_is_quartz(square(c, grid)->feat);
+	return feat_is_quartz(square(c, grid).feat);
 }
 
 /**
@@ -420,7 +421,7 @@ bool square_ismineral(struct chunk *c, struct loc grid)
 
 bool square_hasgoldvein(struct chunk *c, struct loc grid)
 {
-	return tf_has(f_info[square(c, grid)->feat].flags, TF_GOLD);
+	return tf_has(f_info[square(c, grid).feat].flags, TF_GOLD);
 }
 
 /**
@@ -428,8 +429,8 @@ bool square_hasgoldvein(struct chunk *c, struct loc grid)
  */
 bool square_isrubble(struct chunk *c, struct loc grid)
 {
-    return (!tf_has(f_info[square(c, grid)->feat].flags, TF_WALL) &&
-			tf_has(f_info[square(c, grid)->feat].flags, TF_ROCK));
+    return (!tf_has(f_info[square(c, grid).feat].flags, TF_WALL) &&
+			tf_has(f_info[square(c, grid).feat].flags, TF_ROCK));
 }
 
 /**
@@ -440,8 +441,8 @@ bool square_isrubble(struct chunk *c, struct loc grid)
  */
 bool square_issecretdoor(struct chunk *c, struct loc grid)
 {
-    return (tf_has(f_info[square(c, grid)->feat].flags, TF_DOOR_ANY) &&
-			tf_has(f_info[square(c, grid)->feat].flags, TF_ROCK));
+    return (tf_has(f_info[square(c, grid).feat].flags, TF_DOOR_ANY) &&
+			tf_has(f_info[square(c, grid).feat].flags, TF_ROCK));
 }
 
 /**
@@ -449,7 +450,7 @@ bool square_issecretdoor(struct chunk *c, struct loc grid)
  */
 bool square_isopendoor(struct chunk *c, struct loc grid)
 {
-    return (tf_has(f_info[square(c, grid)->feat].flags, TF_CLOSABLE));
+    return (tf_has(f_info[square(c, grid).feat].flags, TF_CLOSABLE));
 }
 
 /**
@@ -457,13 +458,13 @@ bool square_isopendoor(struct chunk *c, struct loc grid)
  */
 bool square_iscloseddoor(struct chunk *c, struct loc grid)
 {
-	int feat = square(c, grid)->feat;
+	int feat = square(c, grid).feat;
 	return tf_has(f_info[feat].flags, TF_DOOR_CLOSED);
 }
 
 bool square_isbrokendoor(struct chunk *c, struct loc grid)
 {
-	int feat = square(c, grid)->feat;
+	int feat = square(c, grid).feat;
     return (tf_has(f_info[feat].flags, TF_DOOR_ANY) &&
 			tf_has(f_info[feat].flags, TF_PASSABLE) &&
 			!tf_has(f_info[feat].flags, TF_CLOSABLE));
@@ -476,7 +477,7 @@ bool square_isbrokendoor(struct chunk *c, struct loc grid)
  */
 bool square_isdoor(struct chunk *c, struct loc grid)
 {
-	int feat = square(c, grid)->feat;
+	int feat = square(c, grid).feat;
 	return tf_has(f_info[feat].flags, TF_DOOR_ANY);
 }
 
@@ -485,7 +486,7 @@ bool square_isdoor(struct chunk *c, struct loc grid)
  */
 bool square_isstairs(struct chunk *c, struct loc grid)
 {
-	int feat = square(c, grid)->feat;
+	int feat = square(c, grid).feat;
 	return tf_has(f_info[feat].flags, TF_STAIR);
 }
 
@@ -494,7 +495,7 @@ bool square_isstairs(struct chunk *c, struct loc grid)
  */
 bool square_isupstairs(struct chunk*c, struct loc grid)
 {
-	int feat = square(c, grid)->feat;
+	int feat = square(c, grid).feat;
 	return tf_has(f_info[feat].flags, TF_UPSTAIR);
 }
 
@@ -503,7 +504,7 @@ bool square_isupstairs(struct chunk*c, struct loc grid)
  */
 bool square_isdownstairs(struct chunk *c, struct loc grid)
 {
-	int feat = square(c, grid)->feat;
+	int feat = square(c, grid).feat;
 	return tf_has(f_info[feat].flags, TF_DOWNSTAIR);
 }
 
@@ -512,7 +513,7 @@ bool square_isdownstairs(struct chunk *c, struct loc grid)
  */
 bool square_ispath(struct chunk *c, struct loc grid)
 {
-	return feat_is_path(square(c, grid)->feat);
+	return feat_is_path(square(c, grid).feat);
 }
 
 /**
@@ -520,21 +521,21 @@ bool square_ispath(struct chunk *c, struct loc grid)
  */
 bool square_isshop(struct chunk *c, struct loc grid)
 {
-	return feat_is_shop(square(c, grid)->feat);
+	return feat_is_shop(square(c, grid).feat);
 }
 
 /**
  * True if the square contains the player
  */
 bool square_isplayer(struct chunk *c, struct loc grid) {
-	return square(c, grid)->mon < 0 ? true : false;
+	return square(c, grid).mon < 0 ? true : false;
 }
 
 /**
  * True if the square contains the player or a monster
  */
 bool square_isoccupied(struct chunk *c, struct loc grid) {
-	return square(c, grid)->mon != 0 ? true : false;
+	return square(c, grid).mon != 0 ? true : false;
 }
 
 /**
@@ -543,7 +544,7 @@ bool square_isoccupied(struct chunk *c, struct loc grid) {
 bool square_isknown(struct chunk *c, struct loc grid) {
 	if (c != cave && (!player || c != player->cave)) return false;
 	if (!player->cave) return false;
-	return square(player->cave, grid)->feat == FEAT_NONE ? false : true;
+	return square(player->cave, grid).feat == FEAT_NONE ? false : true;
 }
 
 /**
@@ -552,7 +553,7 @@ bool square_isknown(struct chunk *c, struct loc grid) {
  */
 bool square_ismemorybad(struct chunk *c, struct loc grid) {
 	return !square_isknown(c, grid)
-		|| square(player->cave, grid)->feat != square(cave, grid)->feat;
+		|| square(player->cave, grid).feat != square(cave, grid).feat;
 }
 
 /**
@@ -560,7 +561,7 @@ bool square_ismemorybad(struct chunk *c, struct loc grid) {
  */
 bool square_isfall(struct chunk *c, struct loc grid)
 {
-	return feat_is_fall(square(c, grid)->feat);
+	return feat_is_fall(square(c, grid).feat);
 }
 
 /**
@@ -568,7 +569,7 @@ bool square_isfall(struct chunk *c, struct loc grid)
  */
 bool square_istree(struct chunk *c, struct loc grid)
 {
-	return feat_is_tree(square(c, grid)->feat);
+	return feat_is_tree(square(c, grid).feat);
 }
 
 /**
@@ -576,7 +577,7 @@ bool square_istree(struct chunk *c, struct loc grid)
  */
 bool square_isorganic(struct chunk *c, struct loc grid)
 {
-	return feat_is_organic(square(c, grid)->feat);
+	return feat_is_organic(square(c, grid).feat);
 }
 
 /**
@@ -584,7 +585,7 @@ bool square_isorganic(struct chunk *c, struct loc grid)
  */
 bool square_isfreeze(struct chunk *c, struct loc grid)
 {
-	return feat_is_freeze(square(c, grid)->feat);
+	return feat_is_freeze(square(c, grid).feat);
 }
 
 /**
@@ -592,7 +593,7 @@ bool square_isfreeze(struct chunk *c, struct loc grid)
  */
 bool square_iswatery(struct chunk *c, struct loc grid)
 {
-	return feat_is_watery(square(c, grid)->feat);
+	return feat_is_watery(square(c, grid).feat);
 }
 
 /**
@@ -600,7 +601,7 @@ bool square_iswatery(struct chunk *c, struct loc grid)
  */
 bool square_isicy(struct chunk *c, struct loc grid)
 {
-	return feat_is_icy(square(c, grid)->feat);
+	return feat_is_icy(square(c, grid).feat);
 }
 
 /**
@@ -608,7 +609,7 @@ bool square_isicy(struct chunk *c, struct loc grid)
  */
 bool square_isprotect(struct chunk *c, struct loc grid)
 {
-	return feat_is_protect(square(c, grid)->feat);
+	return feat_is_protect(square(c, grid).feat);
 }
 
 /**
@@ -616,7 +617,7 @@ bool square_isprotect(struct chunk *c, struct loc grid)
  */
 bool square_isexpose(struct chunk *c, struct loc grid)
 {
-	return feat_is_expose(square(c, grid)->feat);
+	return feat_is_expose(square(c, grid).feat);
 }
 
 /**
@@ -632,7 +633,7 @@ bool square_isexpose(struct chunk *c, struct loc grid)
  */
 bool square_ismark(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_MARK);
+	return sqinfo_has(square(c, grid).info, SQUARE_MARK);
 }
 
 /**
@@ -640,7 +641,7 @@ bool square_ismark(struct chunk *c, struct loc grid) {
  */
 bool square_isglow(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_GLOW);
+	return sqinfo_has(square(c, grid).info, SQUARE_GLOW);
 }
 
 /**
@@ -650,7 +651,7 @@ bool square_isglow(struct chunk *c, struct loc grid) {
  */
 bool square_isvault(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_VAULT);
+	return sqinfo_has(square(c, grid).info, SQUARE_VAULT);
 }
 
 /**
@@ -658,7 +659,7 @@ bool square_isvault(struct chunk *c, struct loc grid) {
  */
 bool square_isroom(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_ROOM);
+	return sqinfo_has(square(c, grid).info, SQUARE_ROOM);
 }
 
 /**
@@ -666,7 +667,7 @@ bool square_isroom(struct chunk *c, struct loc grid) {
  */
 bool square_isseen(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_SEEN);
+	return sqinfo_has(square(c, grid).info, SQUARE_SEEN);
 }
 
 /**
@@ -674,7 +675,7 @@ bool square_isseen(struct chunk *c, struct loc grid) {
  */
 bool square_isview(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_VIEW);
+	return sqinfo_has(square(c, grid).info, SQUARE_VIEW);
 }
 
 /**
@@ -682,7 +683,7 @@ bool square_isview(struct chunk *c, struct loc grid) {
  */
 bool square_wasseen(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_WASSEEN);
+	return sqinfo_has(square(c, grid).info, SQUARE_WASSEEN);
 }
 
 /**
@@ -690,7 +691,7 @@ bool square_wasseen(struct chunk *c, struct loc grid) {
  */
 bool square_isfeel(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_FEEL);
+	return sqinfo_has(square(c, grid).info, SQUARE_FEEL);
 }
 
 /**
@@ -698,7 +699,7 @@ bool square_isfeel(struct chunk *c, struct loc grid) {
  */
 bool square_istrap(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_TRAP);
+	return sqinfo_has(square(c, grid).info, SQUARE_TRAP);
 }
 
 /**
@@ -706,7 +707,7 @@ bool square_istrap(struct chunk *c, struct loc grid) {
  */
 bool square_isinvis(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_INVIS);
+	return sqinfo_has(square(c, grid).info, SQUARE_INVIS);
 }
 
 /**
@@ -714,7 +715,7 @@ bool square_isinvis(struct chunk *c, struct loc grid) {
  */
 bool square_iswall_inner(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_WALL_INNER);
+	return sqinfo_has(square(c, grid).info, SQUARE_WALL_INNER);
 }
 
 /**
@@ -722,7 +723,7 @@ bool square_iswall_inner(struct chunk *c, struct loc grid) {
  */
 bool square_iswall_outer(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_WALL_OUTER);
+	return sqinfo_has(square(c, grid).info, SQUARE_WALL_OUTER);
 }
 
 /**
@@ -730,7 +731,7 @@ bool square_iswall_outer(struct chunk *c, struct loc grid) {
  */
 bool square_iswall_solid(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_WALL_SOLID);
+	return sqinfo_has(square(c, grid).info, SQUARE_WALL_SOLID);
 }
 
 /**
@@ -738,7 +739,7 @@ bool square_iswall_solid(struct chunk *c, struct loc grid) {
  */
 bool square_ismon_restrict(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_MON_RESTRICT);
+	return sqinfo_has(square(c, grid).info, SQUARE_MON_RESTRICT);
 }
 
 /**
@@ -746,7 +747,7 @@ bool square_ismon_restrict(struct chunk *c, struct loc grid) {
  */
 bool square_isno_teleport(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_NO_TELEPORT);
+	return sqinfo_has(square(c, grid).info, SQUARE_NO_TELEPORT);
 }
 
 /**
@@ -754,7 +755,7 @@ bool square_isno_teleport(struct chunk *c, struct loc grid) {
  */
 bool square_isno_map(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_NO_MAP);
+	return sqinfo_has(square(c, grid).info, SQUARE_NO_MAP);
 }
 
 /**
@@ -762,7 +763,7 @@ bool square_isno_map(struct chunk *c, struct loc grid) {
  */
 bool square_isno_esp(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_NO_ESP);
+	return sqinfo_has(square(c, grid).info, SQUARE_NO_ESP);
 }
 
 /**
@@ -770,7 +771,7 @@ bool square_isno_esp(struct chunk *c, struct loc grid) {
  */
 bool square_isproject(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_PROJECT);
+	return sqinfo_has(square(c, grid).info, SQUARE_PROJECT);
 }
 
 /**
@@ -778,7 +779,7 @@ bool square_isproject(struct chunk *c, struct loc grid) {
  */
 bool square_isdtrap(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_DTRAP);
+	return sqinfo_has(square(c, grid).info, SQUARE_DTRAP);
 }
 
 /**
@@ -786,7 +787,7 @@ bool square_isdtrap(struct chunk *c, struct loc grid) {
  */
 bool square_isno_stairs(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return sqinfo_has(square(c, grid)->info, SQUARE_NO_STAIRS);
+	return sqinfo_has(square(c, grid).info, SQUARE_NO_STAIRS);
 }
 
 
@@ -804,7 +805,7 @@ bool square_isno_stairs(struct chunk *c, struct loc grid) {
  * True if the square is open (a floor square not occupied by a monster).
  */
 bool square_isopen(struct chunk *c, struct loc grid) {
-	return square_isfloor(c, grid) && !square(c, grid)->mon;
+	return square_isfloor(c, grid) && !square(c, grid).mon;
 }
 
 /**
@@ -820,7 +821,7 @@ bool square_isempty(struct chunk *c, struct loc grid) {
  * True if the square is empty (an open square without any items).
  */
 bool square_isarrivable(struct chunk *c, struct loc grid) {
-	if (square(c, grid)->mon) return false;
+	if (square(c, grid).mon) return false;
 	if (square_isplayertrap(c, grid)) return false;
 	if (square_iswebbed(c, grid)) return false;
 	if (square_isfloor(c, grid)) return true;
@@ -864,23 +865,7 @@ bool square_iswebbable(struct chunk *c, struct loc grid) {
 bool square_is_monster_walkable(struct chunk *c, struct loc grid)
 {
 	assert(square_in_bounds(c, grid));
-	return feat_is_monster_walkable(square(c, grid)->feat);
-}
-
-/**
- * True if the square is passable by the player.
- */
-bool square_ispassable(struct chunk *c, struct loc grid) {
-	assert(square_in_bounds(c, grid));
-	return feat_is_passable(square(c, grid)->feat);
-}
-
-/**
- * True if any projectable can pass through the square.
- */
-bool square_isprojectable(struct chunk *c, struct loc grid) {
-	if (!square_in_bounds(c, grid)) return false;
-	return feat_is_projectable(square(c, grid)->feat);
+	return feat_is_monster_walkable(square(c, grid).feat);
 }
 
 /**
@@ -891,14 +876,6 @@ bool square_allowsfeel(struct chunk *c, struct loc grid) {
 		!square_isfall(c, grid);
 }
 
-/**
- * True if the square allows line-of-sight.
- */
-bool square_allowslos(struct chunk *c, struct loc grid) {
-	assert(square_in_bounds(c, grid));
-	return feat_is_los(square(c, grid)->feat);
-}
-
 /**
  * True if the square is a permanent wall or one of the "stronger" walls.
  *
@@ -915,7 +892,7 @@ bool square_isstrongwall(struct chunk *c, struct loc grid) {
  */
 bool square_isbright(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return feat_is_bright(square(c, grid)->feat);
+	return feat_is_bright(square(c, grid).feat);
 }
 
 /**
@@ -923,7 +900,7 @@ bool square_isbright(struct chunk *c, struct loc grid) {
  */
 bool square_isfiery(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return feat_is_fiery(square(c, grid)->feat);
+	return feat_is_fiery(square(c, grid).feat);
 }
 
 /**
@@ -939,23 +916,7 @@ bool square_islit(struct chunk *c, struct loc grid) {
  */
 bool square_isdamaging(struct chunk *c, struct loc grid) {
 	assert(square_in_bounds(c, grid));
-	return feat_is_fiery(square(c, grid)->feat);
-}
-
-/**
- * True if the cave square doesn't allow monster flow information.
- */
-bool square_isnoflow(struct chunk *c, struct loc grid) {
-	assert(square_in_bounds(c, grid));
-	return feat_is_no_flow(square(c, grid)->feat);
-}
-
-/**
- * True if the cave square doesn't carry player scent.
- */
-bool square_isnoscent(struct chunk *c, struct loc grid) {
-	assert(square_in_bounds(c, grid));
-	return feat_is_no_scent(square(c, grid)->feat);
+	return feat_is_fiery(square(c, grid).feat);
 }
 
 bool square_iswarded(struct chunk *c, struct loc grid)
@@ -978,12 +939,12 @@ bool square_iswebbed(struct chunk *c, struct loc grid)
 
 bool square_seemslikewall(struct chunk *c, struct loc grid)
 {
-	return tf_has(f_info[square(c, grid)->feat].flags, TF_ROCK);
+	return tf_has(f_info[square(c, grid).feat].flags, TF_ROCK);
 }
 
 bool square_isinteresting(struct chunk *c, struct loc grid)
 {
-	int f = square(c, grid)->feat;
+	int f = square(c, grid).feat;
 	return tf_has(f_info[f].flags, TF_INTERESTING);
 }
 
@@ -1120,20 +1081,6 @@ bool square_changeable(struct chunk *c, struct loc grid)
 }
 
 
-bool square_in_bounds(struct chunk *c, struct loc grid)
-{
-	assert(c);
-	return grid.x >= 0 && grid.x < c->width &&
-		grid.y >= 0 && grid.y < c->height;
-}
-
-bool square_in_bounds_fully(struct chunk *c, struct loc grid)
-{
-	assert(c);
-	return grid.x > 0 && grid.x < c->width - 1 &&
-		grid.y > 0 && grid.y < c->height - 1;
-}
-
 /**
  * Checks if a square is thought by the player to block projections
  */
@@ -1211,32 +1158,14 @@ bool square_allows_summon(struct chunk *c, struct loc grid)
  * Below are various square-specific functions which are not predicates
  */
 
-const struct square *square(struct chunk *c, struct loc grid)
-{
-	assert(square_in_bounds(c, grid));
-	return &c->squares[grid.y][grid.x];
-}
-
-struct feature *square_feat(struct chunk *c, struct loc grid)
-{
-	assert(square_in_bounds(c, grid));
-	return &f_info[square(c, grid)->feat];
-}
-
-int square_light(struct chunk *c, struct loc grid)
-{
-	assert(square_in_bounds(c, grid));
-	return square(c, grid)->light;
-}
-
 /**
  * Get a monster on the current level by its position.
  */
 struct monster *square_monster(struct chunk *c, struct loc grid)
 {
 	if (!square_in_bounds(c, grid)) return NULL;
-	if (square(c, grid)->mon > 0) {
-		struct monster *mon = cave_monster(c, square(c, grid)->mon);
+	if (square(c, grid).mon > 0) {
+		struct monster *mon = cave_monster(c, square(c, grid).mon);
 		return mon && mon->race ? mon : NULL;
 	}
 
@@ -1248,7 +1177,7 @@ struct monster *square_monster(struct chunk *c, struct loc grid)
  */
 struct object *square_object(struct chunk *c, struct loc grid) {
 	if (!square_in_bounds(c, grid)) return NULL;
-	return square(c, grid)->obj;
+	return square(c, grid).obj;
 }
 
 /**
@@ -1257,7 +1186,7 @@ struct object *square_object(struct chunk *c, struct loc grid) {
 struct trap *square_trap(struct chunk *c, struct loc grid)
 {
 	if (!square_in_bounds(c, grid)) return NULL;
-    return square(c, grid)->trap;
+    return square(c, grid).trap;
 }
 
 /**
@@ -1273,7 +1202,8 @@ bool square_holds_object(struct chunk *c, struct loc grid, struct object *obj) {
  */
 void square_excise_object(struct chunk *c, struct loc grid, struct object *obj){
 	assert(square_in_bounds(c, grid));
-	pile_excise(&c->squares[grid.y][grid.x].obj, obj);
+	pile_excise(&c->sq_obj[square_idx(c, grid)], obj);
+	cave_index_note(c, grid);
 }
 
 /**
@@ -1368,6 +1298,7 @@ static void forget_remembered_objects(struct chunk *c, struct chunk *knownc,
 			if (!pred || (*pred)(original)) {
 				square_excise_object(knownc, grid, obj);
 				obj->grid = loc(0, 0);
+				map_cache_forget(c, grid);
 
 				/*
 				 * Delete objects which no longer exist anywhere
@@ -1450,10 +1381,10 @@ int square_num_walls_adjacent(struct chunk *c, struct loc grid)
     int k = 0;
     assert(square_in_bounds(c, grid));
 
-    if (feat_is_wall(square(c, next_grid(grid, DIR_S))->feat)) k++;
-	if (feat_is_wall(square(c, next_grid(grid, DIR_N))->feat)) k++;
-    if (feat_is_wall(square(c, next_grid(grid, DIR_E))->feat)) k++;
-    if (feat_is_wall(square(c, next_grid(grid, DIR_W))->feat)) k++;
+    if (feat_is_wall(square(c, next_grid(grid, DIR_S)).feat)) k++;
+	if (feat_is_wall(square(c, next_grid(grid, DIR_N)).feat)) k++;
+    if (feat_is_wall(square(c, next_grid(grid, DIR_E)).feat)) k++;
+    if (feat_is_wall(square(c, next_grid(grid, DIR_W)).feat)) k++;
 
     return k;
 }
@@ -1470,10 +1401,10 @@ int square_num_walls_diagonal(struct chunk *c, struct loc grid)
     int k = 0;
     assert(square_in_bounds(c, grid));
 
-    if (feat_is_wall(square(c, next_grid(grid, DIR_SE))->feat)) k++;
-    if (feat_is_wall(square(c, next_grid(grid, DIR_NW))->feat)) k++;
-    if (feat_is_wall(square(c, next_grid(grid, DIR_NE))->feat)) k++;
-    if (feat_is_wall(square(c, next_grid(grid, DIR_SW))->feat)) k++;
+    if (feat_is_wall(square(c, next_grid(grid, DIR_SE)).feat)) k++;
+    if (feat_is_wall(square(c, next_grid(grid, DIR_NW)).feat)) k++;
+    if (feat_is_wall(square(c, next_grid(grid, DIR_NE)).feat)) k++;
+    if (feat_is_wall(square(c, next_grid(grid, DIR_SW)).feat)) k++;
 
     return k;
 }
@@ -1490,7 +1421,7 @@ void square_set_feat(struct chunk *c, struct loc grid, int feat)
 	int current_feat;
 
 	assert(square_in_bounds(c, grid));
-	current_feat = square(c, grid)->feat;
+	current_feat = square(c, grid).feat;
 
 	/* Floor and road have only cosmetic differences; use road when outside */
 	if (player->place && (feat == FEAT_FLOOR) &&
@@ -1503,11 +1434,16 @@ void square_set_feat(struct chunk *c, struct loc grid, int feat)
 	if (feat) c->feat_count[feat]++;
 
 	/* Make the change */
-	c->squares[grid.y][grid.x].feat = feat;
+	c->sq_feat[square_idx(c, grid)] = feat;
+	c->sq_props[square_idx(c, grid)] = feat_props[feat];
+	light_map_note_terrain(c, grid);
+	if (feat_is_no_flow(current_feat) != feat_is_no_flow(feat)) {
+		c->flow_changes++;
+	}
 
 	/* Light bright terrain */
 	if (feat_is_bright(feat)) {
-		sqinfo_on(square(c, grid)->info, SQUARE_GLOW);
+		sqinfo_on(square(c, grid).info, SQUARE_GLOW);
 	}
 
 	/* Make the new terrain feel at home */
@@ -1520,13 +1456,17 @@ void square_set_feat(struct chunk *c, struct loc grid, int feat)
 		if (!square_isobjectholding(c, grid))
 			square_excise_pile(c, grid);
 
+		/* A monster left be may feel the terrain */
+		if (square(c, grid).mon > 0)
+			monster_schedule_stir(c, square_monster(c, grid));
+
 		square_note_spot(c, grid);
 		square_light_spot(c, grid);
 	} else {
 		/* Make sure no incorrect wall flags set for dungeon generation */
-		sqinfo_off(square(c, grid)->info, SQUARE_WALL_INNER);
-		sqinfo_off(square(c, grid)->info, SQUARE_WALL_OUTER);
-		sqinfo_off(square(c, grid)->info, SQUARE_WALL_SOLID);
+		sqinfo_off(square(c, grid).info, SQUARE_WALL_INNER);
+		sqinfo_off(square(c, grid).info, SQUARE_WALL_OUTER);
+		sqinfo_off(square(c, grid).info, SQUARE_WALL_SOLID);
 	}
 }
 
@@ -1536,7 +1476,9 @@ void square_set_feat(struct chunk *c, struct loc grid, int feat)
 static void square_set_known_feat(struct chunk *c, struct loc grid, int feat)
 {
 	if (c != cave) return;
-	player->cave->squares[grid.y][grid.x].feat = feat;
+	player->cave->sq_feat[square_idx(player->cave, grid)] = feat;
+	player->cave->sq_props[square_idx(player->cave, grid)] =
+		feat_props[feat];
 }
 
 /**
@@ -1544,7 +1486,8 @@ static void square_set_known_feat(struct chunk *c, struct loc grid, int feat)
  */
 void square_set_mon(struct chunk *c, struct loc grid, int midx)
 {
-	c->squares[grid.y][grid.x].mon = midx;
+	c->sq_mon[square_idx(c, grid)] = midx;
+	cave_index_note(c, grid);
 }
 
 /**
@@ -1552,7 +1495,8 @@ void square_set_mon(struct chunk *c, struct loc grid, int midx)
  */
 void square_set_obj(struct chunk *c, struct loc grid, struct object *obj)
 {
-	c->squares[grid.y][grid.x].obj = obj;
+	c->sq_obj[square_idx(c, grid)] = obj;
+	cave_index_note(c, grid);
 }
 
 /**
@@ -1560,7 +1504,7 @@ void square_set_obj(struct chunk *c, struct loc grid, struct object *obj)
  */
 void square_set_trap(struct chunk *c, struct loc grid, struct trap *trap)
 {
-	c->squares[grid.y][grid.x].trap = trap;
+	c->sq_trap[square_idx(c, grid)] = trap;
 }
 
 void square_add_trap(struct chunk *c, struct loc grid)
@@ -1780,9 +1724,9 @@ void square_earthquake(struct chunk *c, struct loc grid) {
  */
 void square_upgrade_mineral(struct chunk *c, struct loc grid)
 {
-	if (square(c, grid)->feat == FEAT_MAGMA)
+	if (square(c, grid).feat == FEAT_MAGMA)
 		square_set_feat(c, grid, FEAT_MAGMA_K);
-	if (square(c, grid)->feat == FEAT_QUARTZ)
+	if (square(c, grid).feat == FEAT_QUARTZ)
 		square_set_feat(c, grid, FEAT_QUARTZ_K);
 }
 
@@ -1798,13 +1742,13 @@ void square_force_floor(struct chunk *c, struct loc grid) {
 /* Note that this returns the STORE_ index, which is one less than shopnum */
 int square_shopnum(struct chunk *c, struct loc grid) {
 	if (square_isshop(c, grid))
-		return f_info[square(c, grid)->feat].shopnum - 1;
+		return f_info[square(c, grid).feat].shopnum - 1;
 	return -1;
 }
 
 int square_digging(struct chunk *c, struct loc grid) {
 	if (square_isdiggable(c, grid) || square_iscloseddoor(c, grid))
-		return f_info[square(c, grid)->feat].dig;
+		return f_info[square(c, grid).feat].dig;
 	return 0;
 }
 
@@ -1817,7 +1761,7 @@ int square_digging(struct chunk *c, struct loc grid) {
  * \param grid Is the grid to use.
  */
 const char *square_apparent_name(struct chunk *c, struct loc grid) {
-	int actual = square(c, grid)->feat;
+	int actual = square(c, grid).feat;
 	char *mimic_name = f_info[actual].mimic;
 	int f = mimic_name ? lookup_feat(mimic_name) : actual;
 	return f_info[f].name;
@@ -1834,7 +1778,7 @@ const char *square_apparent_name(struct chunk *c, struct loc grid) {
  * The prefix is usually an indefinite article.  It may be an empty string.
  */
 const char *square_apparent_look_prefix(struct chunk *c, struct loc grid) {
-	int actual = square(c, grid)->feat;
+	int actual = square(c, grid).feat;
 	char *mimic_name = f_info[actual].mimic;
 	int f = mimic_name ? lookup_feat(mimic_name) : actual;
 	return (f_info[f].look_prefix) ? f_info[f].look_prefix :
@@ -1851,7 +1795,7 @@ const char *square_apparent_look_prefix(struct chunk *c, struct loc grid) {
  * \param grid Is the grid to use.
  */
 const char *square_apparent_look_in_preposition(struct chunk *c, struct loc grid) {
-	int actual = square(c, grid)->feat;
+	int actual = square(c, grid).feat;
 	char *mimic_name = f_info[actual].mimic;
 	int f = mimic_name ? lookup_feat(mimic_name) : actual;
 	return (f_info[f].look_in_preposition) ?
@@ -1861,7 +1805,7 @@ const char *square_apparent_look_in_preposition(struct chunk *c, struct loc grid
 /* Memorize the terrain */
 void square_memorize(struct chunk *c, struct loc grid) {
 	if (c != cave) return;
-	square_set_known_feat(c, grid, square(c, grid)->feat);
+	square_set_known_feat(c, grid, square(c, grid).feat);
 }
 
 /* Forget the terrain */
@@ -1871,9 +1815,23 @@ void square_forget(struct chunk *c, struct loc grid) {
 }
 
 void square_mark(struct chunk *c, struct loc grid) {
-	sqinfo_on(square(c, grid)->info, SQUARE_MARK);
+	sqinfo_on(square(c, grid).info, SQUARE_MARK);
 }
 
 void square_unmark(struct chunk *c, struct loc grid) {
-	sqinfo_off(square(c, grid)->info, SQUARE_MARK);
+	sqinfo_off(square(c, grid).info, SQUARE_MARK);
+}
+
+/* Permanently light the grid */
+void square_glow(struct chunk *c, struct loc grid) {
+	if (square_isglow(c, grid)) return;
+	sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+	light_map_note_glow(c);
+}
+
+/* Remove permanent light from the grid */
+void square_unglow(struct chunk *c, struct loc grid) {
+	if (!square_isglow(c, grid)) return;
+	sqinfo_off(square(c, grid).info, SQUARE_GLOW);
+	light_map_note_glow(c);
 }
@@ -21,6 +21,7 @@
 #include "cmds.h"
 #include "game-world.h"
 #include "init.h"
+#include "mon-schedule.h"
 #include "monster.h"
 #include "player-calcs.h"
 #include "player-timed.h"
@@ -431,307 +432,268 @@ bool los(struct chunk *c, struct loc grid1, struct loc grid2)
 
 
 /**
- * Mark the currently seen grids, then wipe in preparation for recalculating
+ * Precomputed line of sight paths for update_view().
+ *
+ * The grids los() tests only depend on the offset between its two end
+ * points, so for every offset within z_info->max_sight of the player the
+ * grids los() would test are recorded once.  Offsets are stored as indices
+ * into a (2 * max_sight + 1) square box centred on the player, and
+ * update_view() fills view_proj, the projectability of each grid in that
+ * box, before testing the grids in view.  The result is identical to calling
+ * los() from the player's grid but touches each wall at most once per call.
  */
-static void mark_wasseen(struct chunk *c)
-{
-	int x, y;
-	/* Save the old "view" grids for later */
-	for (y = 0; y < c->height; y++) {
-		for (x = 0; x < c->width; x++) {
-			struct loc grid = loc(x, y);
-			if (square_isseen(c, grid))
-				sqinfo_on(square(c, grid)->info, SQUARE_WASSEEN);
-			sqinfo_off(square(c, grid)->info, SQUARE_VIEW);
-			sqinfo_off(square(c, grid)->info, SQUARE_SEEN);
-			sqinfo_off(square(c, grid)->info, SQUARE_CLOSE_PLAYER);
-		}
-	}
-}
+static int view_radius;
+static int view_side;
+static int *view_path_start;
+static int *view_path_knight;
+static int *view_path_grids;
+static uint8_t *view_proj;
 
 /**
- * Help glow_can_light_wall(), add_light() and calc_lighting():  check for
- * whether a wall can appear to be lit, as viewed by the player, by a light
- * source regardless of line-of-sight details.
- * \param c Is the chunk in which to do the evaluation.
- * \param p Is the player to test.
- * \param sgrid Is the location of the light source.
- * \param wgrid Is the location of the wall.
- * \return Return true if the wall will appear to be lit for the player.
- * Otherwise, return false.
+ * Record the grids that los() tests when looking from the origin to
+ * (dx, dy).  Mirrors the logic of los() exactly.
+ * \param dx Is the horizontal offset of the target.
+ * \param dy Is the vertical offset of the target.
+ * \param knight If not NULL, is set to the grid which, if projectable, grants
+ * line of sight through the "knight's move" rule, or to the origin if the
+ * rule does not apply.
+ * \param path If not NULL, receives the grids which must all be projectable
+ * for line of sight.
+ * \return the number of grids in the path.
  */
-static bool source_can_light_wall(struct chunk *c, struct player *p,
-		struct loc sgrid, struct loc wgrid)
+static int view_path_build(int dx, int dy, struct loc *knight,
+		struct loc *path)
 {
-	struct loc sn = next_grid(wgrid, motion_dir(wgrid, sgrid)), pn, cn;
+	int ax = ABS(dx), ay = ABS(dy);
+	int sx, sy, qx, qy, tx, ty, f1, f2, m;
+	int n = 0;
 
-	/*
-	 * If the light source is coincident with the wall, all faces will be
-	 * lit, and the player can potentially see it if it's within range and
-	 * the line of sight isn't broken.
-	 */
-	if (loc_eq(sn, wgrid)) return true;
+	if (knight) *knight = loc(0, 0);
 
-	/*
-	 * If the player is coincident with the wall, all faces of the wall are
-	 * visible to the player and the player can see whichever of those is
-	 * lit by the light source.
-	 */
-	pn = next_grid(wgrid, motion_dir(wgrid, p->grid));
-	if (loc_eq(pn, wgrid)) return true;
+	/* Adjacent (or identical) grids */
+	if ((ax < 2) && (ay < 2)) return 0;
 
-	/*
-	 * For the lit face of the wall to be visible to the player, the
-	 * view directions from the wall to the player and the wall to the
-	 * light source must share at least one component.
-	 */
-	if (sn.x == pn.x) {
-		/*
-		 * If the view directions share both components, the lit face
-		 * will be visible to the player if in range and the line of
-		 * sight isn't broken.
-		 */
-		if (sn.y == pn.y) return true;
-		cn.x = sn.x;
-		cn.y = 0;
-	} else if (sn.y == pn.y) {
-		cn.x = 0;
-		cn.y = sn.y;
-	} else {
-		/*
-		 * If the view directions don't share a component, the lit face
-		 * is not visible to the player.
-		 */
-		return false;
+	/* Directly South/North */
+	if (!dx) {
+		sy = (dy < 0) ? -1 : 1;
+		for (ty = sy; ty != dy; ty += sy) {
+			if (path) path[n] = loc(0, ty);
+			n++;
+		}
+		return n;
 	}
 
-	/*
-	 * When only one component of the view directions is shared, take the
-	 * common component and test whether there's a wall there that would
-	 * block the player's view of the lit face.  That prevents instances
-	 * like this:
-	 *  p
-	 * ###1#
-	 *  @
-	 * where both the light-emitting monster, 'p', and the player, '@',
-	 * have line of sight to the wall, '1', but the face of '1' that would
-	 * be lit is blocked by the wall immediately to the left of '1'.
-	 */
-	return square_allowslos(c, cn);
-}
+	/* Directly East/West */
+	if (!dy) {
+		sx = (dx < 0) ? -1 : 1;
+		for (tx = sx; tx != dx; tx += sx) {
+			if (path) path[n] = loc(tx, 0);
+			n++;
+		}
+		return n;
+	}
 
-/**
- * Help calc_lighting():  check for whether a wall marked with SQUARE_GLOW
- * can appear to be lit, as viewed by the player regardless of line-of-sight
- * details.
- * \param c Is the chunk in which to do the evaluation.
- * \param p Is the player to test.
- * \param wgrid Is the location of the wall.
- * \param sunlit Is true if the level is lit by the sun.
- * \return Return true if the wall will appear to be lit for the player.
- * Otherwise, return false.
- */
-static bool glow_can_light_wall(struct chunk *c, struct player *p,
-		struct loc wgrid, bool sunlit)
-{
-	struct loc pn = next_grid(wgrid, motion_dir(wgrid, p->grid)), chk;
+	sx = (dx < 0) ? -1 : 1;
+	sy = (dy < 0) ? -1 : 1;
 
-	/*
-	 * If the player is in the wall grid, the player will see the lit face.
-	 */
-	if (loc_eq(pn, wgrid)) return true;
+	/* Vertical and horizontal "knights" */
+	if (knight) {
+		if ((ax == 1) && (ay == 2)) {
+			*knight = loc(0, sy);
+		} else if ((ay == 1) && (ax == 2)) {
+			*knight = loc(sx, 0);
+		}
+	}
 
-	/*
-	 * If the grid in the direction of the player is not a wall, is either
-	 * sunlit or in a room, and is glowing, it'll illuminate the wall.
-	 */
-	if (square_allowslos(c, pn) && (sunlit || square_isroom(c, pn)) &&
-			square_isglow(c, pn)) return true;
+	f2 = (ax * ay);
+	f1 = f2 << 1;
 
-	/*
-	 * Try the two neighboring squares adjacent to the one in the direction
-	 * of the player to see if one or more will illuminate the wall by
-	 * glowing.  Those could be out of bounds if the direction isn't
-	 * diagonal.
-	 */
-	if (pn.x != wgrid.x) {
-		if (pn.y != wgrid.y) {
-			chk.x = pn.x;
-			chk.y = wgrid.y;
-			if (square_allowslos(c, chk) &&
-					(sunlit || square_isroom(c, chk)) &&
-					square_isglow(c, chk) &&
-					source_can_light_wall(c, p, chk, wgrid))
-				return true;
-			chk.x = wgrid.x;
-			chk.y = pn.y;
-			if (square_allowslos(c, chk) &&
-					(sunlit || square_isroom(c, chk)) &&
-					square_isglow(c, chk) &&
-					source_can_light_wall(c, p, chk, wgrid))
-				return true;
+	if (ax >= ay) {
+		/* Travel horizontally */
+		qy = ay * ay;
+		m = qy << 1;
+		tx = sx;
+		if (qy == f2) {
+			ty = sy;
+			qy -= f1;
 		} else {
-			chk.x = pn.x;
-			chk.y = wgrid.y - 1;
-			if (square_in_bounds(c, chk) &&
-					square_allowslos(c, chk) &&
-					(sunlit || square_isroom(c, chk)) &&
-					square_isglow(c, chk) &&
-					source_can_light_wall(c, p, chk, wgrid))
-				return true;
-			chk.y = wgrid.y + 1;
-			if (square_in_bounds(c, chk) &&
-					square_allowslos(c, chk) &&
-					(sunlit || square_isroom(c, chk)) &&
-					square_isglow(c, chk) &&
-					source_can_light_wall(c, p, chk, wgrid))
-				return true;
+			ty = 0;
+		}
+		while (dx - tx) {
+			if (path) path[n] = loc(tx, ty);
+			n++;
+			qy += m;
+			if (qy < f2) {
+				tx += sx;
+			} else if (qy > f2) {
+				ty += sy;
+				if (path) path[n] = loc(tx, ty);
+				n++;
+				qy -= f1;
+				tx += sx;
+			} else {
+				ty += sy;
+				qy -= f1;
+				tx += sx;
+			}
 		}
 	} else {
-		chk.y = pn.y;
-		chk.x = wgrid.x - 1;
-		if (square_in_bounds(c, chk) && square_allowslos(c, chk) &&
-				(sunlit || square_isroom(c, chk)) &&
-				square_isglow(c, chk) &&
-				source_can_light_wall(c, p, chk, wgrid))
-			return true;
-		chk.x = wgrid.x + 1;
-		if (square_in_bounds(c, chk) && square_allowslos(c, chk) &&
-				(sunlit || square_isroom(c, chk)) &&
-				square_isglow(c, chk) &&
-				source_can_light_wall(c, p, chk, wgrid))
-			return true;
+		/* Travel vertically */
+		qx = ax * ax;
+		m = qx << 1;
+		ty = sy;
+		if (qx == f2) {
+			tx = sx;
+			qx -= f1;
+		} else {
+			tx = 0;
+		}
+		while (dy - ty) {
+			if (path) path[n] = loc(tx, ty);
+			n++;
+			qx += m;
+			if (qx < f2) {
+				ty += sy;
+			} else if (qx > f2) {
+				tx += sx;
+				if (path) path[n] = loc(tx, ty);
+				n++;
+				qx -= f1;
+				ty += sy;
+			} else {
+				tx += sx;
+				qx -= f1;
+				ty += sy;
+			}
+		}
 	}
 
-	/*
-	 * The adjacent squares towards the player won't light the wall by
-	 * by glowing.
-	 */
-	return false;
+	return n;
 }
 
 /**
- * Help calc_lighting():  add in the effect of a light source.
- * \param c Is the chunk to use.
- * \param p Is the player to use.
- * \param sgrid Is the location of the light source.
- * \param radius Is the radius, in grids, of the light source.
- * \param inten Is the intensity of the light source.
- * This is a brute force approach.  Some computation probably could be saved by
- * propagating the light out from the source and terminating paths when they
- * reach a wall.
+ * Convert an offset from the player to an index into the view box.
  */
-static void add_light(struct chunk *c, struct player *p, struct loc sgrid,
-		int radius, int inten)
+static int view_box_index(struct loc offset)
 {
-	int y;
-
-	for (y = -radius; y <= radius; y++) {
-		int x;
-
-		for (x = -radius; x <= radius; x++) {
-			struct loc grid = loc_sum(sgrid, loc(x, y));
-			int dist = distance(sgrid, grid);
-			if (!square_in_bounds(c, grid)) continue;
-			if (dist > radius) continue;
-			/* Don't propagate the light through walls. */
-			if (!los(c, sgrid, grid)) continue;
-			/*
-			 * Only light a wall if the face lit is possibly visible
-			 * to the player.
-			 */
-			if (!square_allowslos(c, grid) && !source_can_light_wall(c,
-					p, sgrid, grid)) continue;
-			/* Adjust the light level */
-			if (inten > 0) {
-				/* Light getting less further away */
-				c->squares[grid.y][grid.x].light +=
-					inten - dist;
-			} else {
-				/* Light getting greater further away */
-				c->squares[grid.y][grid.x].light +=
-					inten + dist;
-			}
-		}
-	}
+	return (offset.y + view_radius) * view_side + offset.x + view_radius;
 }
 
 /**
- * Calculate light level for every grid in view - stolen from Sil
+ * Build the precomputed line of sight paths.
  */
-static void calc_lighting(struct chunk *c, struct player *p)
+static void view_paths_init(void)
 {
-	int dir, k, x, y;
-	int light = p->state.cur_light, radius = ABS(light) - 1;
-	int old_light = square_light(c, p->grid);
-	bool sunlit = is_daytime() && outside();
-
-	/* Starting values based on permanent light */
-	for (y = 0; y < c->height; y++) {
-		for (x = 0; x < c->width; x++) {
-			struct loc grid = loc(x, y);
-
-			if (square_isglow(c, grid) &&
-					(sunlit || square_allowslos(c, grid) ||
-					glow_can_light_wall(c, p, grid, sunlit))) {
-				c->squares[y][x].light = 1;
-			} else {
-				c->squares[y][x].light = 0;
-			}
-
-			/* Squares with bright terrain have intensity 2 */
-			if (square_isbright(c, grid)) {
-				c->squares[y][x].light += 2;
-				for (dir = 0; dir < 8; dir++) {
-					struct loc adj_grid = loc_sum(grid, ddgrid_ddd[dir]);
-					if (!square_in_bounds(c, adj_grid)) continue;
-					/*
-					 * Only brighten a wall if the player
-					 * is in position to view the face
-					 * that's lit up.
-					 */
-					if (!square_allowslos(c, adj_grid) &&
-							!source_can_light_wall(
-							c, p, grid, adj_grid))
-							continue;
-					c->squares[adj_grid.y][adj_grid.x].light += 1;
-				}
-			}
+	int n_box, total = 0, i;
+	struct loc *path;
+
+	view_radius = z_info->max_sight;
+	view_side = 2 * view_radius + 1;
+	n_box = view_side * view_side;
+	view_path_start = mem_zalloc((n_box + 1) * sizeof(*view_path_start));
+	view_path_knight = mem_zalloc(n_box * sizeof(*view_path_knight));
+	view_proj = mem_zalloc(n_box * sizeof(*view_proj));
+
+	/* Size the path store */
+	for (i = 0; i < n_box; i++) {
+		total += view_path_build(i % view_side - view_radius,
+			i / view_side - view_radius, NULL, NULL);
+	}
+	view_path_grids = mem_zalloc((total ? total : 1) *
+		sizeof(*view_path_grids));
+
+	/* Fill it */
+	path = mem_zalloc(view_side * 2 * sizeof(*path));
+	total = 0;
+	for (i = 0; i < n_box; i++) {
+		struct loc knight;
+		int n = view_path_build(i % view_side - view_radius,
+			i / view_side - view_radius, &knight, path), j;
+
+		view_path_start[i] = total;
+		view_path_knight[i] = loc_is_zero(knight) ?
+			-1 : view_box_index(knight);
+		for (j = 0; j < n; j++) {
+			view_path_grids[total++] = view_box_index(path[j]);
 		}
 	}
+	view_path_start[n_box] = total;
+	mem_free(path);
+}
 
-	/* Light around the player */
-	add_light(c, p, p->grid, radius, light);
+/**
+ * Free the precomputed line of sight paths.
+ */
+static void view_paths_free(void)
+{
+	mem_free(view_proj);
+	view_proj = NULL;
+	mem_free(view_path_grids);
+	view_path_grids = NULL;
+	mem_free(view_path_knight);
+	view_path_knight = NULL;
+	mem_free(view_path_start);
+	view_path_start = NULL;
+}
 
-	/* Scan monster list and add monster light or darkness */
-	for (k = 1; k < cave_monster_max(c); k++) {
-		/* Check the k'th monster */
-		struct monster *mon = cave_monster(c, k);
+/**
+ * Equivalent to los() from the player to the grid at the given box index,
+ * using the projectability recorded in view_proj.
+ */
+static bool view_los(int idx)
+{
+	int i;
 
-		/* Skip dead monsters */
-		if (!mon->race) continue;
+	if (view_path_knight[idx] >= 0 && view_proj[view_path_knight[idx]])
+		return true;
+	for (i = view_path_start[idx]; i < view_path_start[idx + 1]; i++) {
+		if (!view_proj[view_path_grids[i]]) return false;
+	}
+	return true;
+}
 
-		/* Skip if the monster is hidden */
-		if (monster_is_camouflaged(mon)) continue;
+/**
+ * Get the part of the chunk within z_info->max_sight of the player.
+ */
+static void view_bounds(struct chunk *c, struct player *p, struct loc *tl,
+		struct loc *br)
+{
+	tl->x = MAX(0, p->grid.x - view_radius);
+	tl->y = MAX(0, p->grid.y - view_radius);
+	br->x = MIN(c->width - 1, p->grid.x + view_radius);
+	br->y = MIN(c->height - 1, p->grid.y + view_radius);
+}
 
-		/* Get light info for this monster */
-		light = mon->race->light;
-		radius = ABS(light) - 1;
+/**
+ * Mark the currently seen grids, then wipe in preparation for recalculating.
+ * Only the grids recorded as in view by the last update_view() need to be
+ * visited; without such a record, visit the whole chunk.
+ */
+static void mark_wasseen_one(struct chunk *c, struct loc grid)
+{
+	if (square_isseen(c, grid))
+		sqinfo_on(square(c, grid).info, SQUARE_WASSEEN);
+	sqinfo_off(square(c, grid).info, SQUARE_VIEW);
+	sqinfo_off(square(c, grid).info, SQUARE_SEEN);
+	sqinfo_off(square(c, grid).info, SQUARE_CLOSE_PLAYER);
+}
 
-		/* Skip monsters not affecting light */
-		if (!light) continue;
+static void mark_wasseen(struct chunk *c)
+{
+	int x, y;
 
-		/* Skip if the player can't see it. */
-		if (distance(p->grid, mon->grid) - radius > z_info->max_sight)
-			continue;
+	if (c->view_grids) {
+		int i;
 
-		add_light(c, p, mon->grid, radius, light);
+		for (i = 0; i < c->view_grids_n; i++)
+			mark_wasseen_one(c, c->view_grids[i]);
+		return;
 	}
 
-	/* Update light level indicator */
-	if (square_light(c, p->grid) != old_light) {
-		p->upkeep->redraw |= PR_LIGHT;
-	}
+	/* Save the old "view" grids for later */
+	for (y = 0; y < c->height; y++)
+		for (x = 0; x < c->width; x++)
+			mark_wasseen_one(c, loc(x, y));
 }
 
 /**
@@ -747,10 +709,10 @@ static void become_viewable(struct chunk *c, struct loc grid, struct player *p,
 	if (square_isview(c, grid)) return;
 
 	/* Add the grid to the view, make seen if it's close enough to the player */
-	sqinfo_on(square(c, grid)->info, SQUARE_VIEW);
+	sqinfo_on(square(c, grid).info, SQUARE_VIEW);
 	if (close) {
-		sqinfo_on(square(c, grid)->info, SQUARE_SEEN);
-		sqinfo_on(square(c, grid)->info, SQUARE_CLOSE_PLAYER);
+		sqinfo_on(square(c, grid).info, SQUARE_SEEN);
+		sqinfo_on(square(c, grid).info, SQUARE_CLOSE_PLAYER);
 	}
 
 	/* Mark lit grids, and walls near to them, as seen */
@@ -760,10 +722,10 @@ static void become_viewable(struct chunk *c, struct loc grid, struct player *p,
 			int xc = (x < p->grid.x) ? (x + 1) : (x > p->grid.x) ? (x - 1) : x;
 			int yc = (y < p->grid.y) ? (y + 1) : (y > p->grid.y) ? (y - 1) : y;
 			if (square_islit(c, loc(xc, yc))) {
-				sqinfo_on(square(c, grid)->info, SQUARE_SEEN);
+				sqinfo_on(square(c, grid).info, SQUARE_SEEN);
 			}
 		} else {
-			sqinfo_on(square(c, grid)->info, SQUARE_SEEN);
+			sqinfo_on(square(c, grid).info, SQUARE_SEEN);
 		}
 	}
 }
@@ -835,7 +797,7 @@ static void update_view_one(struct chunk *c, struct loc grid, struct player *p)
 		}
 	}
 
-	if (los(c, p->grid, loc(xc, yc)))
+	if (view_los(view_box_index(loc_diff(loc(xc, yc), p->grid))))
 		become_viewable(c, grid, p, close);
 }
 
@@ -846,8 +808,8 @@ static void update_one(struct chunk *c, struct loc grid, struct player *p)
 {
 	/* Remove view if blind, check visible squares for traps */
 	if (p->timed[TMD_BLIND]) {
-		sqinfo_off(square(c, grid)->info, SQUARE_SEEN);
-		sqinfo_off(square(c, grid)->info, SQUARE_CLOSE_PLAYER);
+		sqinfo_off(square(c, grid).info, SQUARE_SEEN);
+		sqinfo_off(square(c, grid).info, SQUARE_CLOSE_PLAYER);
 	} else if (square_isseen(c, grid)) {
 		square_reveal_trap(c, grid, false, true);
 	}
@@ -856,7 +818,7 @@ static void update_one(struct chunk *c, struct loc grid, struct player *p)
 	if (square_isseen(c, grid) && !square_wasseen(c, grid)) {
 		if (square_isfeel(c, grid)) {
 			c->feeling_squares++;
-			sqinfo_off(square(c, grid)->info, SQUARE_FEEL);
+			sqinfo_off(square(c, grid).info, SQUARE_FEEL);
 			/* Don't display feeling if it will display for the new level */
 			if (((c->feeling_squares & 0xff) == z_info->feeling_need) &&
 				!p->upkeep->only_partial) {
@@ -873,7 +835,59 @@ static void update_one(struct chunk *c, struct loc grid, struct player *p)
 	if (!square_isseen(c, grid) && square_wasseen(c, grid))
 		square_light_spot(c, grid);
 
-	sqinfo_off(square(c, grid)->info, SQUARE_WASSEEN);
+	sqinfo_off(square(c, grid).info, SQUARE_WASSEEN);
+}
+
+/**
+ * Record the grids, all within the view box, now in view.
+ */
+static void view_record(struct chunk *c, struct loc tl, struct loc br)
+{
+	struct loc grid;
+
+	if (!c->view_grids) {
+		c->view_grids = mem_zalloc(view_side * view_side *
+			sizeof(*c->view_grids));
+	}
+	c->view_grids_n = 0;
+	for (grid.y = tl.y; grid.y <= br.y; grid.y++) {
+		for (grid.x = tl.x; grid.x <= br.x; grid.x++) {
+			if (square_isview(c, grid))
+				c->view_grids[c->view_grids_n++] = grid;
+		}
+	}
+}
+
+/**
+ * Run update_one() on every grid in the view box and every grid recorded as
+ * in view by the last update_view(), in row-major order.
+ */
+static void update_view_changed(struct chunk *c, struct player *p,
+		struct loc tl, struct loc br)
+{
+	struct loc *old = c->view_grids;
+	int n_old = c->view_grids_n, i = 0;
+	struct loc grid;
+
+	for (grid.y = tl.y; grid.y <= br.y; grid.y++) {
+		/* Old grids before this row of the box */
+		while (i < n_old && (old[i].y < grid.y ||
+				(old[i].y == grid.y && old[i].x < tl.x))) {
+			update_one(c, old[i], p);
+			i++;
+		}
+
+		for (grid.x = tl.x; grid.x <= br.x; grid.x++)
+			update_one(c, grid, p);
+
+		/* Old grids within this row of the box have been handled */
+		while (i < n_old && old[i].y == grid.y && old[i].x <= br.x)
+			i++;
+	}
+	while (i < n_old) {
+		update_one(c, old[i], p);
+		i++;
+	}
 }
 
 /**
@@ -881,7 +895,8 @@ static void update_one(struct chunk *c, struct loc grid, struct player *p)
  */
 void update_view(struct chunk *c, struct player *p)
 {
-	int x, y;
+	struct loc tl, br, grid;
+	int i;
 
 	/* Record the current view */
 	mark_wasseen(c);
@@ -890,11 +905,11 @@ void update_view(struct chunk *c, struct player *p)
 	calc_lighting(c, p);
 
 	/* Assume we can view the player grid */
-	sqinfo_on(square(c, p->grid)->info, SQUARE_VIEW);
+	sqinfo_on(square(c, p->grid).info, SQUARE_VIEW);
 	if (p->state.cur_light > 0 || square_islit(c, p->grid) ||
 		player_has(p, PF_UNLIGHT) || player_of_has(p, OF_DARKNESS)) {
-		sqinfo_on(square(c, p->grid)->info, SQUARE_SEEN);
-		sqinfo_on(square(c, p->grid)->info, SQUARE_CLOSE_PLAYER);
+		sqinfo_on(square(c, p->grid).info, SQUARE_SEEN);
+		sqinfo_on(square(c, p->grid).info, SQUARE_CLOSE_PLAYER);
 	}
 	/*
 	 * If the player is blind and in terrain that was remembered to be
@@ -907,17 +922,58 @@ void update_view(struct chunk *c, struct player *p)
 		square_forget(c, p->grid);
 	}
 
+	/* Record which grids near the player block line of sight */
+	view_bounds(c, p, &tl, &br);
+	memset(view_proj, 0, view_side * view_side * sizeof(*view_proj));
+	for (grid.y = tl.y; grid.y <= br.y; grid.y++) {
+		for (grid.x = tl.x; grid.x <= br.x; grid.x++) {
+			view_proj[view_box_index(loc_diff(grid, p->grid))] =
+				square_isprojectable(c, grid);
+		}
+	}
+
 	/* Squares we have LOS to get marked as in the view, and perhaps seen */
-	for (y = 0; y < c->height; y++)
-		for (x = 0; x < c->width; x++)
-			update_view_one(c, loc(x, y), p);
+	for (grid.y = tl.y; grid.y <= br.y; grid.y++)
+		for (grid.x = tl.x; grid.x <= br.x; grid.x++)
+			update_view_one(c, grid, p);
 
 	/* Update each grid */
-	for (y = 0; y < c->height; y++)
-		for (x = 0; x < c->width; x++)
-			update_one(c, loc(x, y), p);
+	if (c->view_grids) {
+		update_view_changed(c, p, tl, br);
+	} else {
+		/* Nothing recorded from the last view, so visit everything */
+		for (grid.y = 0; grid.y < c->height; grid.y++)
+			for (grid.x = 0; grid.x < c->width; grid.x++)
+				update_one(c, grid, p);
+	}
+	view_record(c, tl, br);
+
+	/* Monsters left be may now be in view */
+	for (i = 0; i < c->view_grids_n; i++) {
+		if (square(c, c->view_grids[i]).mon > 0)
+			monster_schedule_stir(c, square_monster(c,
+				c->view_grids[i]));
+	}
 }
 
+/**
+ * Forget the record of which grids were in view, so the next update_view()
+ * visits the whole chunk.  Needed if the view flags are set or copied by
+ * anything other than update_view().
+ */
+void forget_view_grids(struct chunk *c)
+{
+	mem_free(c->view_grids);
+	c->view_grids = NULL;
+	c->view_grids_n = 0;
+}
+
+struct init_module view_module = {
+	.name = "view",
+	.init = view_paths_init,
+	.cleanup = view_paths_free
+};
+
 
 /**
  * Returns true if the player's grid is dark
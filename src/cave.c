@@ -25,6 +25,7 @@
 #include "generate.h"
 #include "init.h"
 #include "mon-group.h"
+#include "mon-schedule.h"
 #include "monster.h"
 #include "obj-ignore.h"
 #include "obj-pile.h"
@@ -33,9 +34,11 @@
 #include "object.h"
 #include "player-timed.h"
 #include "trap.h"
+#include "z-names.h"
 #include "z-queue.h"
 
 struct feature *f_info;
+uint8_t *feat_props;
 struct chunk *cave = NULL;
 
 int FEAT_NONE;
@@ -314,6 +317,29 @@ struct loc next_grid(struct loc grid, int dir)
 	return loc(grid.x + ddgrid[dir].x, grid.y + ddgrid[dir].y);
 }
 
+/**
+ * Index of terrain feature names, made once terrain.txt has been read
+ */
+static struct name_index *feat_names;
+
+void feat_name_index_build(void)
+{
+	int i;
+
+	name_index_free(feat_names);
+	feat_names = name_index_new(false);
+	for (i = 0; i < z_info->f_max; i++) {
+		if (f_info[i].name)
+			name_index_add(feat_names, f_info[i].name, i);
+	}
+}
+
+void feat_name_index_free(void)
+{
+	name_index_free(feat_names);
+	feat_names = NULL;
+}
+
 /**
  * Find a terrain feature index by name
  */
@@ -321,6 +347,12 @@ int lookup_feat(const char *name)
 {
 	int i;
 
+	if (feat_names) {
+		i = name_index_find(feat_names, name);
+		if (i >= 0)
+			return i;
+	}
+
 	/* Look for it */
 	for (i = 0; i < z_info->f_max; i++) {
 		struct feature *feat = &f_info[i];
@@ -396,26 +428,37 @@ void heatmap_free(struct chunk *c, struct heatmap map)
 	mem_free(map.grids);
 }
 
+/**
+ * Read a heatmap value; grids not set since the last change of base read as 0
+ */
+int heatmap_get(struct heatmap map, struct loc grid)
+{
+	uint16_t value = map.grids[grid.y][grid.x];
+
+	return (value > map.base) ? value - map.base : 0;
+}
+
 /**
  * Allocate a new chunk of the world
  */
 struct chunk *cave_new(int height, int width) {
-	int y, x;
-
 	struct chunk *c = mem_zalloc(sizeof *c);
+	int n = height * width;
+
 	c->height = height;
 	c->width = width;
 	c->feat_count = mem_zalloc((z_info->f_max + 1) * sizeof(int));
 
-	c->squares = mem_zalloc(c->height * sizeof(struct square*));
+	c->sq_feat = mem_zalloc(n * sizeof(*c->sq_feat));
+	c->sq_props = mem_zalloc(n * sizeof(*c->sq_props));
+	c->sq_info = mem_zalloc(n * SQUARE_SIZE * sizeof(*c->sq_info));
+	c->sq_light = mem_zalloc(n * sizeof(*c->sq_light));
+	c->sq_mon = mem_zalloc(n * sizeof(*c->sq_mon));
+	c->sq_obj = mem_zalloc(n * sizeof(*c->sq_obj));
+	c->sq_trap = mem_zalloc(n * sizeof(*c->sq_trap));
+	cave_index_new(c);
 	c->noise.grids = heatmap_new(c);
 	c->scent.grids = heatmap_new(c);
-	for (y = 0; y < c->height; y++) {
-		c->squares[y] = mem_zalloc(c->width * sizeof(struct square));
-		for (x = 0; x < c->width; x++) {
-			c->squares[y][x].info = mem_zalloc(SQUARE_SIZE * sizeof(bitflag));
-		}
-	}
 
 	c->objects = mem_zalloc(OBJECT_LIST_SIZE * sizeof(struct object*));
 	c->obj_max = OBJECT_LIST_SIZE - 1;
@@ -424,6 +467,9 @@ struct chunk *cave_new(int height, int width) {
 	c->mon_max = 1;
 	c->mon_current = -1;
 
+	/* Traps may come with timeouts, so look for them at least once */
+	c->timed_traps = 1;
+
 	c->monster_groups = mem_zalloc(z_info->level_monster_max *
 								   sizeof(struct monster_group*));
 
@@ -452,7 +498,8 @@ void cave_connectors_free(struct connector *join)
  */
 void cave_free(struct chunk *c) {
 	struct chunk *p_c = (c == cave && player) ? player->cave : NULL;
-	int y, x, i;
+	struct loc grid;
+	int i;
 
 	cave_connectors_free(c->join);
 
@@ -463,22 +510,33 @@ void cave_free(struct chunk *c) {
 		}
 	}
 
-	for (y = 0; y < c->height; y++) {
-		for (x = 0; x < c->width; x++) {
-			mem_free(c->squares[y][x].info);
-			if (c->squares[y][x].trap)
-				square_free_trap(c, loc(x, y));
-			if (c->squares[y][x].obj)
-				object_pile_free(c, p_c, c->squares[y][x].obj);
+	for (grid.y = 0; grid.y < c->height; grid.y++) {
+		for (grid.x = 0; grid.x < c->width; grid.x++) {
+			if (square(c, grid).trap)
+				square_free_trap(c, grid);
+			if (square(c, grid).obj)
+				object_pile_free(c, p_c, square(c, grid).obj);
 		}
-		mem_free(c->squares[y]);
 	}
-	mem_free(c->squares);
+	mem_free(c->sq_feat);
+	mem_free(c->sq_props);
+	mem_free(c->sq_info);
+	mem_free(c->sq_light);
+	mem_free(c->sq_mon);
+	mem_free(c->sq_obj);
+	mem_free(c->sq_trap);
+	cave_index_free(c);
 	heatmap_free(c, c->noise);
 	heatmap_free(c, c->scent);
+	if (c->flow_queue) q_free(c->flow_queue);
+	noise_cache_free(c);
+	forget_view_grids(c);
+	light_map_free(c);
+	map_cache_free(c);
 
 	mem_free(c->feat_count);
 	mem_free(c->objects);
+	monster_schedule_free(c);
 	mem_free(c->monsters);
 	mem_free(c->monster_groups);
 	if (c->ghost) {
@@ -780,6 +838,124 @@ struct loc cave_find_decoy(struct chunk *c)
 	return c->decoy;
 }
 
+/**
+ * Work out how far noise needs to flow: past the point where the keenest
+ * listener on the level could hear it, so that every grid from which a
+ * monster can hear has correct values all around it.
+ */
+static int noise_range(struct chunk *c)
+{
+	int range = NOISE_WAKE_RANGE;
+	int i;
+
+	for (i = 1; i < cave_monster_max(c); i++) {
+		struct monster *mon = cave_monster(c, i);
+
+		if (mon->race && mon->race->hearing > range) {
+			range = mon->race->hearing;
+		}
+	}
+	return range;
+}
+
+/**
+ * Check whether a noise flow already holds what a new one would compute
+ */
+static bool noise_flow_current(struct chunk *c, struct heatmap *noise_map,
+		struct loc source, struct loc quiet, int step, int range)
+{
+	return noise_map->flowed && loc_eq(noise_map->source, source) &&
+		loc_eq(noise_map->quiet, quiet) && (noise_map->step == step) &&
+		(noise_map->range >= range) &&
+		(noise_map->flow_changes == c->flow_changes);
+}
+
+/**
+ * Flow noise out from source, each grid's noise being step more than that of
+ * the grid it was reached from, until it reaches range.  Noise never reaches
+ * the quiet grid.  A flow that runs out of grids before reaching range is
+ * recorded as having range NOISE_RANGE_ALL.
+ */
+static void noise_flow(struct chunk *c, struct heatmap *noise_map,
+		struct loc source, struct loc quiet, int step, int range)
+{
+	struct loc next = source;
+	bool cut = false;
+	int d;
+
+	/* Set all the grids to silence by moving base past everything stored */
+	if (noise_map->top > UINT16_MAX - (range + step) - 1) {
+		int y, x;
+
+		for (y = 0; y < c->height; y++) {
+			for (x = 0; x < c->width; x++) {
+				noise_map->grids[y][x] = 0;
+			}
+		}
+		noise_map->base = 0;
+	} else {
+		noise_map->base = noise_map->top + 1;
+	}
+	noise_map->top = noise_map->base;
+	noise_map->flowed = true;
+	noise_map->source = source;
+	noise_map->quiet = quiet;
+	noise_map->step = step;
+	noise_map->range = range;
+	noise_map->flow_changes = c->flow_changes;
+
+	/* The source grid has noise 0, which needs no marking */
+	if (!c->flow_queue) {
+		c->flow_queue = q_new(c->height * c->width);
+	}
+	q_push_int(c->flow_queue, grid_to_i(next, c->width));
+
+	/* Propagate noise */
+	while (q_len(c->flow_queue) > 0) {
+		int noise;
+
+		/* Get the next grid */
+		i_to_grid(q_pop_int(c->flow_queue), c->width, &next);
+		noise = heatmap_get(*noise_map, next);
+
+		/* Nothing can hear it from here */
+		if (noise >= range) {
+			cut = true;
+			continue;
+		}
+		noise += step;
+
+		/* Assign noise to the children and enqueue them */
+		for (d = 0; d < 8; d++)	{
+			/* Child location */
+			struct loc grid = loc_sum(next, ddgrid_ddd[d]);
+
+			if (!square_in_bounds(c, grid)) continue;
+
+			/* Ignore features that don't transmit sound */
+			if (square_isnoflow(c, grid)) continue;
+
+			/* Skip grids that already have noise */
+			if (heatmap_get(*noise_map, grid) != 0) continue;
+
+			/* Skip the player/monster grid */
+			if (loc_eq(quiet, grid)) continue;
+
+			/* Save the noise */
+			noise_map->grids[grid.y][grid.x] = noise_map->base + noise;
+			noise_map->top = noise_map->base + noise;
+
+			/* Enqueue that entry */
+			q_push_int(c->flow_queue, grid_to_i(grid, c->width));
+		}
+	}
+
+	/* Everything the noise can reach has been reached */
+	if (!cut) {
+		noise_map->range = NOISE_RANGE_ALL;
+	}
+}
+
 /**
  * Every turn, the character makes enough noise that nearby monsters can use
  * it to home in.
@@ -796,76 +972,161 @@ struct loc cave_find_decoy(struct chunk *c)
  * mazes.  Monsters have a hearing value, which is the largest sound value
  * they can detect.
  *
- * Update: Monsters can also have noise heatmaps generated for them
+ * The flow stops once it is too far away for any monster on the level to
+ * hear, and grids it doesn't reach read as silent; make_noise_everywhere()
+ * carries it on for readers that need the rest.  If neither the source nor
+ * any terrain that blocks sound has changed since the last flow, the old
+ * values are still right and nothing is done.
+ *
+ * Noise made by monsters is handled by monster_noise().
  */
-void make_noise(struct chunk *c, struct player *p, struct monster *mon)
+void make_noise(struct chunk *c, struct player *p)
 {
-	struct loc next = p ? p->grid : mon->grid;
-	int y, x, d;
-	int noise = 0;
-	int noise_increment = p && p->timed[TMD_COVERTRACKS] ? 4 : 1;
-    struct queue *queue = q_new(c->height * c->width);
+	struct loc source = p->grid;
+	int step = p->timed[TMD_COVERTRACKS] ? 4 : 1;
+	int range = noise_range(c);
 	struct loc decoy = cave_find_decoy(c);
-	struct heatmap noise_map = p ? c->noise : mon->noise;
 
-	/* Set all the grids to silence */
-	for (y = 1; y < c->height - 1; y++) {
-		for (x = 1; x < c->width - 1; x++) {
-			noise_map.grids[y][x] = 0;
-		}
+	/* If there's a decoy, use that instead of the player */
+	if (!loc_is_zero(decoy)) {
+		source = decoy;
 	}
 
-	/* If there's a decoy, use that instead of the player */
-	if (p && !loc_is_zero(decoy)) {
-		next = decoy;
+	/* Nothing that affects the flow has changed */
+	if (noise_flow_current(c, &c->noise, source, p->grid, step, range)) {
+		return;
 	}
 
-	/* Player/monster makes noise */
-	noise_map.grids[next.y][next.x] = noise;
-	q_push_int(queue, grid_to_i(next, c->width));
-	noise += noise_increment;
+	noise_flow(c, &c->noise, source, p->grid, step, range);
 
-	/* Propagate noise */
-	while (q_len(queue) > 0) {
-		/* Get the next grid */
-		i_to_grid(q_pop_int(queue), c->width, &next);
+	/* Any monster left be may hear the difference */
+	monster_schedule_stir_all(c);
+}
 
-		/* If we've reached the current noise level, put it back and step */
-		if (noise_map.grids[next.y][next.x] == noise) {
-			q_push_int(queue, grid_to_i(next, c->width));
-			noise += noise_increment;
-			continue;
-		}
+/**
+ * Flow the player's noise again from where make_noise() last did, this time
+ * to every grid it can reach, for monsters that compare noise beyond where
+ * anything can hear it, as fleeing ones do.  Grids the noise can't get to
+ * still read as 0.
+ */
+void make_noise_everywhere(struct chunk *c)
+{
+	struct heatmap *noise_map = &c->noise;
 
-		/* Assign noise to the children and enqueue them */
-		for (d = 0; d < 8; d++)	{
-			/* Child location */
-			struct loc grid = loc_sum(next, ddgrid_ddd[d]);
+	if (!noise_map->flowed || noise_map->range >= NOISE_RANGE_ALL) {
+		return;
+	}
+	noise_flow(c, noise_map, noise_map->source, noise_map->quiet,
+		noise_map->step, NOISE_RANGE_ALL);
+}
 
-			if (!square_in_bounds(c, grid)) continue;
+/**
+ * Count the monsters listening for noise from the monster at grid
+ */
+static int noise_cache_refs(struct chunk *c, struct loc grid)
+{
+	int midx = square(c, grid).mon;
+	int i, refs = 0;
 
-			/* Ignore features that don't transmit sound */
-			if (square_isnoflow(c, grid)) continue;
+	if (midx <= 0) return 0;
+	for (i = 1; i < cave_monster_max(c); i++) {
+		struct monster *mon = cave_monster(c, i);
 
-			/* Skip grids that already have noise */
-			if (noise_map.grids[grid.y][grid.x] != 0) continue;
+		if (mon->race && (mon->target.midx == midx)) refs++;
+	}
+	return refs;
+}
 
-			/* Skip the player/monster grid */
-			if (p && loc_eq(player->grid, grid)) {
-				continue;
-			} else if (mon && loc_eq(mon->grid, grid)) {
-				continue;
-			}
+/**
+ * Monsters can be the target of other monsters, which then home in on the
+ * noise the target makes just as they would on the player's.
+ *
+ * Noise from a monster is only worked out when some monster needs to listen
+ * to it, and only out to that monster's hearing.  The results go into a
+ * small cache on the chunk, keyed by the grid of the noisy monster, so every
+ * monster after the same target shares one flow.  When the cache is full,
+ * the flow with fewest monsters listening for it is replaced, the least
+ * recently used one if there is a tie.
+ *
+ * \param c is the chunk
+ * \param mon is the monster making the noise
+ * \param range is how far from mon the noise needs to be known
+ */
+struct heatmap *monster_noise(struct chunk *c, struct monster *mon, int range)
+{
+	struct noise_cache *cache;
+	int i, slot = -1;
 
-			/* Save the noise */
-			noise_map.grids[grid.y][grid.x] = noise;
+	if (!c->noise_cache) {
+		c->noise_cache = mem_zalloc(sizeof(*c->noise_cache));
+	}
+	cache = c->noise_cache;
+	cache->lookups++;
 
-			/* Enqueue that entry */
-			q_push_int(queue, grid_to_i(grid, c->width));
+	/* Look for a flow from the right place */
+	for (i = 0; i < NOISE_CACHE_SIZE; i++) {
+		struct heatmap *flow = &cache->flows[i];
+
+		if (flow->flowed && loc_eq(flow->source, mon->grid)) {
+			slot = i;
+			break;
 		}
 	}
+	if (slot >= 0 && noise_flow_current(c, &cache->flows[slot], mon->grid,
+			mon->grid, 1, range)) {
+		cache->hits++;
+		cache->last_use[slot] = cache->lookups;
+		return &cache->flows[slot];
+	}
+
+	/* Take an unused slot, or replace one */
+	if (slot < 0) {
+		int best_refs = 0;
 
-	q_free(queue);
+		for (i = 0; i < NOISE_CACHE_SIZE; i++) {
+			int refs;
+
+			if (!cache->flows[i].flowed) {
+				slot = i;
+				break;
+			}
+			refs = noise_cache_refs(c, cache->flows[i].source);
+			if (slot < 0 || refs < best_refs || (refs == best_refs &&
+					cache->last_use[i] <
+					cache->last_use[slot])) {
+				slot = i;
+				best_refs = refs;
+			}
+		}
+		if (cache->flows[slot].flowed) {
+			cache->evictions++;
+		}
+	}
+	if (!cache->flows[slot].grids) {
+		cache->flows[slot].grids = heatmap_new(c);
+	}
+
+	noise_flow(c, &cache->flows[slot], mon->grid, mon->grid, 1, range);
+	cache->flows_made++;
+	cache->last_use[slot] = cache->lookups;
+	return &cache->flows[slot];
+}
+
+/**
+ * Free the monster noise cache of a chunk
+ */
+void noise_cache_free(struct chunk *c)
+{
+	int i;
+
+	if (!c->noise_cache) return;
+	for (i = 0; i < NOISE_CACHE_SIZE; i++) {
+		if (c->noise_cache->flows[i].grids) {
+			heatmap_free(c, c->noise_cache->flows[i]);
+		}
+	}
+	mem_free(c->noise_cache);
+	c->noise_cache = NULL;
 }
 
 /**
@@ -948,6 +1209,10 @@ void update_scent(struct chunk *c, struct player *p, struct monster *mon)
 
 			/* Mark the scent */
 			scent_map.grids[scent.y][scent.x] = new_scent;
+
+			/* A monster left be may smell it */
+			if (p && square(c, scent).mon > 0)
+				monster_schedule_stir(c, square_monster(c, scent));
 		}
 	}
 }
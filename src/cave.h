@@ -22,9 +22,15 @@
 #include "z-type.h"
 #include "z-bitflag.h"
 
+struct chunk;
 struct player;
 struct monster;
 struct monster_group;
+struct monster_schedule;
+struct light_map;
+struct map_cache;
+struct packed_chunk;
+struct queue;
 
 extern const int16_t ddd[9];
 extern const int16_t ddx[10];
@@ -136,6 +142,22 @@ struct feature {
 
 extern struct feature *f_info;
 
+/**
+ * Terrain properties tested by the busiest loops over grids; feat_props holds
+ * them for each feature, and a chunk's sq_props for each of its grids
+ */
+enum {
+	FPROP_LOS = 0x01,
+	FPROP_PROJECT = 0x02,
+	FPROP_PASSABLE = 0x04,
+	FPROP_NO_FLOW = 0x08,
+	FPROP_NO_SCENT = 0x10,
+	FPROP_TORCH = 0x20,
+	FPROP_BRIGHT = 0x40
+};
+
+extern uint8_t *feat_props;
+
 enum grid_light_level
 {
 	LIGHTING_LOS = 0,   /* line of sight */
@@ -160,6 +182,10 @@ struct grid_data {
 	bool hallucinate;
 };
 
+/**
+ * One grid of a chunk, as put together by square() from the chunk's grid
+ * arrays; info points into the chunk, so flags can be changed through it
+ */
 struct square {
 	uint8_t feat;
 	bitflag *info;
@@ -169,10 +195,53 @@ struct square {
 	struct trap *trap;
 };
 
+/**
+ * Noise heatmaps are not cleared between updates; a stored value only counts
+ * if it is above base, and reads as its excess over base (see heatmap_get()).
+ * The remaining fields record what the last noise flow was computed from, so
+ * the noise code can tell when it has nothing to do.  Scent heatmaps keep base
+ * at zero and ignore the rest.
+ */
 struct heatmap {
 	uint16_t **grids;
+	uint16_t base;
+	uint16_t top;		/* Largest value stored since base was last set */
+	bool flowed;		/* The fields below describe the grids */
+	struct loc source;
+	struct loc quiet;	/* Grid the noise is not allowed to reach */
+	int step;
+	int range;
+	uint32_t flow_changes;
+};
+
+/**
+ * Noise flows from monsters, shared by all the monsters listening for them;
+ * see monster_noise()
+ */
+#define NOISE_CACHE_SIZE 8
+
+struct noise_cache {
+	struct heatmap flows[NOISE_CACHE_SIZE];
+	uint32_t last_use[NOISE_CACHE_SIZE];
+
+	/* Counters */
+	uint32_t lookups;
+	uint32_t hits;
+	uint32_t flows_made;
+	uint32_t evictions;
 };
 
+/**
+ * Minimum distance, in noise units, that noise flows are computed to;
+ * sleeping monsters closer than this to the player wake faster
+ */
+#define NOISE_WAKE_RANGE 50
+
+/**
+ * Range of a noise flow that has reached every grid the noise can get to
+ */
+#define NOISE_RANGE_ALL UINT16_MAX
+
 struct connector {
 	struct loc grid;
 	uint8_t feat;
@@ -189,6 +258,18 @@ struct ghost_info {
 	bool has_spoken;
 };
 
+/**
+ * The bitmaps of the spatial index kept by each chunk (see cave-index.c)
+ */
+enum cave_index_kind {
+	CAVE_INDEX_MON,
+	CAVE_INDEX_OBJ,
+	CAVE_INDEX_MAX
+};
+
+typedef bool (*cave_index_visitor)(struct chunk *c, struct loc grid,
+	void *data);
+
 struct chunk {
 	char *name;
 	int32_t turn;
@@ -206,10 +287,30 @@ struct chunk {
 	uint16_t feeling_squares; /* How many feeling squares the player has visited */
 	int *feat_count;
 
-	struct square **squares;
+	/* Grid arrays, indexed by square_idx() */
+	uint8_t *sq_feat;
+	uint8_t *sq_props;	/* feat_props of sq_feat */
+	bitflag *sq_info;	/* SQUARE_SIZE flag bytes per grid */
+	int *sq_light;
+	int16_t *sq_mon;
+	struct object **sq_obj;
+	struct trap **sq_trap;
+
+	/* Grids holding monsters and object piles, a bit per grid */
+	uint64_t *index[CAVE_INDEX_MAX];
+	int index_words;	/* Words in each row of the bitmaps */
+
 	struct heatmap noise;
 	struct heatmap scent;
 	struct loc decoy;
+	struct queue *flow_queue;	/* Scratch space for noise flows */
+	struct noise_cache *noise_cache;
+	uint32_t flow_changes;	/* Counts changes to NO_FLOW terrain */
+
+	struct loc *view_grids;	/* Grids in view at the last update_view() */
+	int view_grids_n;
+	struct light_map *light_map;
+	struct map_cache *map_cache;	/* What map_info() found, by grid */
 
 	struct object **objects;
 	uint16_t obj_max;
@@ -219,11 +320,17 @@ struct chunk {
 	uint16_t mon_cnt;
 	int mon_current;
 	int num_repro;
+	int timed_traps;	/* At least as many traps as are timing out */
+	struct monster_schedule *schedule;	/* When the monsters next move */
 	struct ghost_info *ghost;
 
 	struct monster_group **monster_groups;
 
 	struct connector *join;
+
+	/* Contents while stored packed; a packed chunk keeps only its scalar
+	 * fields, name and connectors */
+	struct packed_chunk *packed;
 };
 
 /*** Feature Indexes (see "lib/gamedata/terrain.txt") ***/
@@ -283,14 +390,35 @@ extern struct chunk *cave;
 extern struct chunk **chunk_list;
 extern uint16_t chunk_list_max;
 
+/* cave-index.c */
+void cave_index_new(struct chunk *c);
+void cave_index_free(struct chunk *c);
+void cave_index_note(struct chunk *c, struct loc grid);
+int cave_index_box(struct chunk *c, enum cave_index_kind kind,
+		struct loc top_left, struct loc bottom_right,
+		cave_index_visitor visit, void *data);
+int cave_index_radius(struct chunk *c, enum cave_index_kind kind,
+		struct loc centre, int radius, cave_index_visitor visit,
+		void *data);
+
+/* cave-light.c */
+void calc_lighting(struct chunk *c, struct player *p);
+void light_map_note_terrain(struct chunk *c, struct loc grid);
+void light_map_note_glow(struct chunk *c);
+void light_map_free(struct chunk *c);
+
 /* cave-view.c */
 int distance(struct loc grid1, struct loc grid2);
 bool los(struct chunk *c, struct loc grid1, struct loc grid2);
 void update_view(struct chunk *c, struct player *p);
+void forget_view_grids(struct chunk *c);
 bool no_light(const struct player *p);
 
 /* cave-map.c */
 void map_info(struct loc grid, struct grid_data *g);
+void map_cache_forget(struct chunk *c, struct loc grid);
+void map_cache_forget_all(struct chunk *c);
+void map_cache_free(struct chunk *c);
 void square_note_spot(struct chunk *c, struct loc grid);
 void square_light_spot(struct chunk *c, struct loc grid);
 void light_room(struct loc grid, bool light);
@@ -412,17 +540,12 @@ bool square_canputitem(struct chunk *c, struct loc grid);
 bool square_isdiggable(struct chunk *c, struct loc grid);
 bool square_iswebbable(struct chunk *c, struct loc grid);
 bool square_is_monster_walkable(struct chunk *c, struct loc grid);
-bool square_ispassable(struct chunk *c, struct loc grid);
-bool square_isprojectable(struct chunk *c, struct loc grid);
 bool square_allowsfeel(struct chunk *c, struct loc grid);
-bool square_allowslos(struct chunk *c, struct loc grid);
 bool square_isstrongwall(struct chunk *c, struct loc grid);
 bool square_isbright(struct chunk *c, struct loc grid);
 bool square_isfiery(struct chunk *c, struct loc grid);
 bool square_islit(struct chunk *c, struct loc grid);
 bool square_isdamaging(struct chunk *c, struct loc grid);
-bool square_isnoflow(struct chunk *c, struct loc grid);
-bool square_isnoscent(struct chunk *c, struct loc grid);
 bool square_iswarded(struct chunk *c, struct loc grid);
 bool square_isdecoyed(struct chunk *c, struct loc grid);
 bool square_iswebbed(struct chunk *c, struct loc grid);
@@ -440,8 +563,6 @@ bool square_isdisabledtrap(struct chunk *c, struct loc grid);
 bool square_isdisarmabletrap(struct chunk *c, struct loc grid);
 bool square_dtrap_edge(struct chunk *c, struct loc grid);
 bool square_changeable(struct chunk *c, struct loc grid);
-bool square_in_bounds(struct chunk *c, struct loc grid);
-bool square_in_bounds_fully(struct chunk *c, struct loc grid);
 bool square_isbelievedwall(struct chunk *c, struct loc grid);
 bool square_isknownpassable(struct chunk *c, struct loc grid);
 bool square_suits_stairs_well(struct chunk *c, struct loc grid);
@@ -449,10 +570,99 @@ bool square_suits_stairs_ok(struct chunk *c, struct loc grid);
 bool square_isinemptysquare(struct chunk *c, struct loc grid);
 bool square_allows_summon(struct chunk *c, struct loc grid);
 
+/**
+ * These are called for nearly every grid the game looks at, so they live
+ * here where they can be inlined.
+ */
+static inline bool square_in_bounds(struct chunk *c, struct loc grid)
+{
+	assert(c);
+	return grid.x >= 0 && grid.x < c->width &&
+		grid.y >= 0 && grid.y < c->height;
+}
+
+static inline bool square_in_bounds_fully(struct chunk *c, struct loc grid)
+{
+	assert(c);
+	return grid.x > 0 && grid.x < c->width - 1 &&
+		grid.y > 0 && grid.y < c->height - 1;
+}
+
+static inline int square_idx(struct chunk *c, struct loc grid)
+{
+	assert(square_in_bounds(c, grid));
+	return grid.y * c->width + grid.x;
+}
+
+static inline struct square square(struct chunk *c, struct loc grid)
+{
+	int i = square_idx(c, grid);
+	struct square sq;
+
+	sq.feat = c->sq_feat[i];
+	sq.info = c->sq_info + i * SQUARE_SIZE;
+	sq.light = c->sq_light[i];
+	sq.mon = c->sq_mon[i];
+	sq.obj = c->sq_obj[i];
+	sq.trap = c->sq_trap[i];
+	return sq;
+}
+
+static inline struct feature *square_feat(struct chunk *c, struct loc grid)
+{
+	return &f_info[c->sq_feat[square_idx(c, grid)]];
+}
+
+static inline int square_light(struct chunk *c, struct loc grid)
+{
+	return c->sq_light[square_idx(c, grid)];
+}
+
+/**
+ * True if the square is passable by the player.
+ */
+static inline bool square_ispassable(struct chunk *c, struct loc grid)
+{
+	return (c->sq_props[square_idx(c, grid)] & FPROP_PASSABLE) ?
+		true : false;
+}
+
+/**
+ * True if any projectable can pass through the square.
+ */
+static inline bool square_isprojectable(struct chunk *c, struct loc grid)
+{
+	if (!square_in_bounds(c, grid)) return false;
+	return (c->sq_props[square_idx(c, grid)] & FPROP_PROJECT) ?
+		true : false;
+}
+
+/**
+ * True if the square allows line-of-sight.
+ */
+static inline bool square_allowslos(struct chunk *c, struct loc grid)
+{
+	return (c->sq_props[square_idx(c, grid)] & FPROP_LOS) ? true : false;
+}
+
+/**
+ * True if the cave square doesn't allow monster flow information.
+ */
+static inline bool square_isnoflow(struct chunk *c, struct loc grid)
+{
+	return (c->sq_props[square_idx(c, grid)] & FPROP_NO_FLOW) ?
+		true : false;
+}
+
+/**
+ * True if the cave square doesn't carry player scent.
+ */
+static inline bool square_isnoscent(struct chunk *c, struct loc grid)
+{
+	return (c->sq_props[square_idx(c, grid)] & FPROP_NO_SCENT) ?
+		true : false;
+}
 
-const struct square *square(struct chunk *c, struct loc grid);
-struct feature *square_feat(struct chunk *c, struct loc grid);
-int square_light(struct chunk *c, struct loc grid);
 struct monster *square_monster(struct chunk *c, struct loc grid);
 struct object *square_object(struct chunk *c, struct loc grid);
 struct trap *square_trap(struct chunk *c, struct loc grid);
@@ -510,14 +720,19 @@ void square_memorize(struct chunk *c, struct loc grid);
 void square_forget(struct chunk *c, struct loc grid);
 void square_mark(struct chunk *c, struct loc grid);
 void square_unmark(struct chunk *c, struct loc grid);
+void square_glow(struct chunk *c, struct loc grid);
+void square_unglow(struct chunk *c, struct loc grid);
 
 /* cave.c */
 int motion_dir(struct loc source, struct loc target);
 struct loc next_grid(struct loc grid, int dir);
+void feat_name_index_build(void);
+void feat_name_index_free(void);
 int lookup_feat(const char *name);
 void set_terrain(void);
 uint16_t **heatmap_new(struct chunk *c);
 void heatmap_free(struct chunk *c, struct heatmap map);
+int heatmap_get(struct heatmap map, struct loc grid);
 struct chunk *cave_new(int height, int width);
 void cave_connectors_free(struct connector *join);
 void cave_free(struct chunk *c);
@@ -538,7 +753,10 @@ int count_feats(struct loc *grid,
 int count_neighbors(struct loc *match, struct chunk *c, struct loc grid,
 	bool (*test)(struct chunk *c, struct loc grid), bool under);
 struct loc cave_find_decoy(struct chunk *c);
-void make_noise(struct chunk *c, struct player *p, struct monster *mon);
+void make_noise(struct chunk *c, struct player *p);
+void make_noise_everywhere(struct chunk *c);
+struct heatmap *monster_noise(struct chunk *c, struct monster *mon, int range);
+void noise_cache_free(struct chunk *c);
 void update_scent(struct chunk *c, struct player *p, struct monster *mon);
 bool is_quest(int level);
 
@@ -29,6 +29,7 @@
 #include "mon-desc.h"
 #include "mon-lore.h"
 #include "mon-predicate.h"
+#include "mon-schedule.h"
 #include "mon-spell.h"
 #include "mon-timed.h"
 #include "mon-util.h"
@@ -517,7 +518,7 @@ static bool do_cmd_close_test(struct player *p, struct loc grid)
 	}
 
 	/* Don't allow if player is in the way. */
-	if (square(cave, grid)->mon < 0) {
+	if (square(cave, grid).mon < 0) {
 		/* Message */
 		msg("You're standing in that doorway.");
 
@@ -606,7 +607,7 @@ void do_cmd_close(struct command *cmd)
 	}
 
 	/* Monster - alert, then attack */
-	if (square(cave, grid)->mon > 0) {
+	if (square(cave, grid).mon > 0) {
 		msg("There is a monster in the way!");
 		py_attack(player, grid);
 	} else
@@ -839,7 +840,7 @@ void do_cmd_tunnel(struct command *cmd)
 	}
 
 	/* Attack any monster we run into */
-	if (square(cave, grid)->mon > 0) {
+	if (square(cave, grid).mon > 0) {
 		msg("There is a monster in the way!");
 		py_attack(player, grid);
 	} else {
@@ -952,7 +953,7 @@ static bool do_cmd_lock_door(struct loc grid)
 static bool do_cmd_disarm_aux(struct loc grid)
 {
 	int skill, power, chance;
-    struct trap *trap = square(cave, grid)->trap;
+    struct trap *trap = square(cave, grid).trap;
 	bool more = false;
 
 	/* Verify legality */
@@ -1188,7 +1189,7 @@ static void do_cmd_alter_aux(int dir)
 	o_chest_trapped = chest_check(player, grid, CHEST_TRAPPED);
 
 	/* Action depends on what's there */
-	if (square(cave, grid)->mon > 0) {
+	if (square(cave, grid).mon > 0) {
 		/* Attack monster */
 		py_attack(player, grid);
 	} else if (square_isdiggable(cave, grid)) {
@@ -1251,7 +1252,7 @@ static void do_cmd_steal_aux(int dir)
 	}
 
 	/* Attack or steal from monsters */
-	if ((square(cave, grid)->mon > 0) && player_has(player, PF_STEAL)) {
+	if ((square(cave, grid).mon > 0) && player_has(player, PF_STEAL)) {
 		steal_monster_item(square_monster(cave, grid), -1);
 	} else {
 		/* Oops */
@@ -1282,7 +1283,7 @@ void move_player(int dir, bool disarm)
 {
 	struct loc grid = loc_sum(player->grid, ddgrid[dir]);
 
-	int m_idx = square(cave, grid)->mon;
+	int m_idx = square(cave, grid).mon;
 	struct monster *mon = cave_monster(cave, m_idx);
 	bool trapsafe = player_is_trapsafe(player);
 	bool trap = square_isdisarmabletrap(cave, grid);
@@ -1429,7 +1430,7 @@ void move_player(int dir, bool disarm)
  */
 static bool do_cmd_walk_test(struct player *p, struct loc grid)
 {
-	int m_idx = square(cave, grid)->mon;
+	int m_idx = square(cave, grid).mon;
 	struct monster *mon = cave_monster(cave, m_idx);
 
 	/* Allow attack on obvious monsters if unafraid */
@@ -1657,7 +1658,7 @@ void do_cmd_navigate_down(struct command *cmd)
 			if (loc_eq(grid, player->grid)) continue;
 
 			if (square_isoccupied(cave, grid)) {
-				int m_idx = square(cave, grid)->mon;
+				int m_idx = square(cave, grid).mon;
 				struct monster *mon = cave_monster(cave, m_idx);
 				if (monster_is_obvious(mon)) {
 					visible_monster_count++;
@@ -1720,7 +1721,7 @@ void do_cmd_navigate_up(struct command *cmd)
 			if (loc_eq(grid, player->grid)) continue;
 
 			if (square_isoccupied(cave, grid)) {
-				int m_idx = square(cave, grid)->mon;
+				int m_idx = square(cave, grid).mon;
 				struct monster *mon = cave_monster(cave, m_idx);
 				if (monster_is_obvious(mon)) {
 					visible_monster_count++;
@@ -1783,7 +1784,7 @@ void do_cmd_explore(struct command *cmd)
 			if (loc_eq(grid, player->grid)) continue;
 
 			if (square_isoccupied(cave, grid)) {
-				int m_idx = square(cave, grid)->mon;
+				int m_idx = square(cave, grid).mon;
 				struct monster *mon = cave_monster(cave, m_idx);
 				if (monster_is_obvious(mon)) {
 					visible_monster = true;
@@ -2100,6 +2101,7 @@ void do_cmd_mon_command(struct command *cmd)
 				return;
 			}
 			mon->target.midx = t_mon->midx;
+			monster_schedule_stir(cave, mon);
 
 			/* Pick a random spell and cast it */
 			rsf_copy(f, mon->race->spell_flags);
@@ -1485,7 +1485,7 @@ void do_cmd_wiz_magic_map(struct command *cmd)
 static void wiz_hack_map_peek_noise(struct chunk *c, void *closure,
 	struct loc grid, bool *show, uint8_t *color)
 {
-	if (c->noise.grids[grid.y][grid.x] == *((int*)closure)) {
+	if (heatmap_get(c->noise, grid) == *((int*)closure)) {
 		*show = true;
 		*color = COLOUR_RED;
 	} else {
@@ -1954,7 +1954,7 @@ static void wiz_hack_map_query_feature(struct chunk *c, void *closure,
 {
 	const struct wiz_query_feature_closure *sel_feats = closure;
 	int i = 0;
-	int sq_feat = square(c, grid)->feat;
+	int sq_feat = square(c, grid).feat;
 
 	while (1) {
 		if (i >= sel_feats->n) {
@@ -2136,7 +2136,7 @@ static void wiz_hack_map_query_square_flag(struct chunk *c, void *closure,
 	int flag = *((int*)closure);
 
 	/* With a flag, test for that.  Otherwise, test if grid is known. */
-	if ((flag && sqinfo_has(square(c, grid)->info, flag)) ||
+	if ((flag && sqinfo_has(square(c, grid).info, flag)) ||
 			(!flag && square_isknown(c, grid))) {
 		*show = true;
 		*color = (square_ispassable(c, grid)) ?
@@ -0,0 +1,1926 @@
+/**
+ * \file datacache.c
+ * \brief Keep the parsed game data tables in a binary image
+ *
+ * Copyright (c) 2026 StukovTTV
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#include "angband.h"
+#include "buildid.h"
+#include "cave.h"
+#include "datacache.h"
+#include "effects.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-blows.h"
+#include "mon-init.h"
+#include "mon-util.h"
+#include "monster.h"
+#include "obj-init.h"
+#include "obj-util.h"
+#include "object.h"
+#include "ui-visuals.h"
+
+/**
+ * Most of the time spent starting up goes on parsing the game data files,
+ * and the tables that come out are the same every time the files are.  With
+ * the cache on (the -k command line option), the sections listed in
+ * sections[] are kept in an image in the user directory once they have been
+ * parsed, and the next start loads each of them from the image instead of
+ * running its parser.
+ *
+ * A section is stored as the blocks its parser allocated - arrays, list
+ * entries, strings - with the pointers in them zeroed and listed in a table of
+ * relocations:  to a block of the section, to an entry of a table the section
+ * only refers to (an object kind, a monster base...), or to dice, which are
+ * stored as the strings the dice parser reads.  Loading gives each block an
+ * allocation of its own, just as parsing does, so the usual cleanup functions
+ * free it all, and fills the pointers back in.  The layouts below say where
+ * the pointers are in each structure.
+ *
+ * What a parser changes in data it does not own - counts in z_info, the svals
+ * of an object base, the kinds the artifacts add - is stored as the elements
+ * it changed, with a hash of that data from before the parser ran; a section
+ * is only loaded while the hash still matches.
+ *
+ * The image is keyed on its format, the size and modification time of the
+ * running executable, the sizes of the structures it holds and the contents
+ * of all the game data files (any copies in the user directory included).
+ * Any change to the code, parsers included, relinks the executable and so
+ * changes the key; if the executable cannot be found, the cache is not used.
+ * An image with another key, or one whose checksum fails, is ignored and
+ * written afresh, as is a section that fails to load.  The image is only
+ * written when every section could be stored.
+ */
+
+#define DATACACHE_VERSION 1
+#define DATACACHE_FILE "gamedata.cache"
+#define DATACACHE_MAGIC "PFBDATA"
+#define DATACACHE_MAGIC_LEN 8
+
+#define HASH_START 0xcbf29ce484222325ULL
+#define HASH_PRIME 0x100000001b3ULL
+
+#define BLOCK_NONE 0xffffffffU
+#define BLOCK_TRANSIENT 0x01	/* Only needed while the section is loading */
+
+#define MAX_ROOTS 3
+#define MAX_WATCHES 3
+
+/**
+ * ------------------------------------------------------------------------
+ * Layouts of the structures in the cache
+ * ------------------------------------------------------------------------ */
+
+/**
+ * Kinds of pointer in a structure
+ */
+enum field_type {
+	FIELD_END,
+	FIELD_STRING,	/* A string the structure owns */
+	FIELD_OWNED,	/* Structures the structure owns */
+	FIELD_BYTES,	/* An array of plain values the structure owns */
+	FIELD_LINK,	/* Something else in the same section */
+	FIELD_REF,	/* An entry of one of the tables[] */
+	FIELD_DICE,	/* Dice the structure owns */
+	FIELD_DEAD,	/* Not used once parsing is done; loaded as NULL */
+	FIELD_EMPTY	/* Has to be NULL when the section is stored */
+};
+
+struct cache_field {
+	enum field_type type;
+	size_t offset;
+	int layout;		/* FIELD_OWNED: layout of the structures */
+	size_t size;		/* FIELD_BYTES: size of a value */
+	size_t (*count)(void);	/* FIELD_OWNED, FIELD_BYTES: number; 1 if NULL */
+	int table;		/* FIELD_REF: index into tables[] */
+};
+
+struct cache_layout {
+	size_t size;
+	const struct cache_field *fields;
+};
+
+#define F_FIELD(type, s, m, layout, size, count, table) \
+	{ type, offsetof(struct s, m), layout, size, count, table }
+#define F_STRING(s, m) F_FIELD(FIELD_STRING, s, m, 0, 0, NULL, 0)
+#define F_OWNED(s, m, layout, count) \
+	F_FIELD(FIELD_OWNED, s, m, layout, 0, count, 0)
+#define F_BYTES(s, m, size, count) F_FIELD(FIELD_BYTES, s, m, 0, size, count, 0)
+#define F_LINK(s, m) F_FIELD(FIELD_LINK, s, m, 0, 0, NULL, 0)
+#define F_REF(s, m, table) F_FIELD(FIELD_REF, s, m, 0, 0, NULL, table)
+#define F_DICE(s, m) F_FIELD(FIELD_DICE, s, m, 0, 0, NULL, 0)
+#define F_DEAD(s, m) F_FIELD(FIELD_DEAD, s, m, 0, 0, NULL, 0)
+#define F_EMPTY(s, m) F_FIELD(FIELD_EMPTY, s, m, 0, 0, NULL, 0)
+#define F_END { FIELD_END, 0, 0, 0, NULL, 0 }
+
+enum {
+	LAYOUT_CRITICAL_LEVEL,
+	LAYOUT_CONSTANTS,
+	LAYOUT_FEATURE,
+	LAYOUT_FEATURE_PROPS,
+	LAYOUT_EFFECT,
+	LAYOUT_OBJECT_BASE,
+	LAYOUT_OBJECT_KIND,
+	LAYOUT_POSS_ITEM,
+	LAYOUT_EGO_ITEM,
+	LAYOUT_ARTIFACT,
+	LAYOUT_ARTIFACT_UPKEEP,
+	LAYOUT_MONSTER_RACE,
+	LAYOUT_MONSTER_BLOW,
+	LAYOUT_MONSTER_ALTMSG,
+	LAYOUT_MONSTER_DROP,
+	LAYOUT_MONSTER_FRIENDS,
+	LAYOUT_MONSTER_FRIENDS_BASE,
+	LAYOUT_MONSTER_MIMIC,
+	LAYOUT_MONSTER_SHAPE,
+	LAYOUT_VAULT,
+	LAYOUT_MAX
+};
+
+enum {
+	TABLE_OBJECT_BASE,
+	TABLE_OBJECT_KIND,
+	TABLE_ACTIVATION,
+	TABLE_MONSTER_BASE,
+	TABLE_BLOW_METHOD,
+	TABLE_BLOW_EFFECT
+};
+
+static size_t count_brands(void) { return z_info->brand_max; }
+static size_t count_slays(void) { return z_info->slay_max; }
+static size_t count_curses(void) { return z_info->curse_max; }
+static size_t count_blows(void) { return z_info->mon_blows_max; }
+static size_t count_tvals(void) { return TV_MAX; }
+static size_t count_features(void) { return z_info->f_max + 1; }
+static size_t count_kinds(void) { return z_info->k_max; }
+static size_t count_egos(void) { return z_info->e_max; }
+static size_t count_artifacts(void) { return z_info->a_max; }
+static size_t count_races(void) { return z_info->r_max; }
+static size_t count_activations(void) { return z_info->act_max + 1; }
+static size_t count_blow_methods(void) { return z_info->blow_methods_max + 1; }
+static size_t count_blow_effects(void) { return z_info->blow_effects_max + 1; }
+
+static const struct cache_field critical_level_fields[] = {
+	F_OWNED(critical_level, next, LAYOUT_CRITICAL_LEVEL, NULL),
+	F_END
+};
+
+static const struct cache_field constants_fields[] = {
+	F_OWNED(angband_constants, m_crit_level_head, LAYOUT_CRITICAL_LEVEL, NULL),
+	F_OWNED(angband_constants, r_crit_level_head, LAYOUT_CRITICAL_LEVEL, NULL),
+	F_END
+};
+
+static const struct cache_field feature_fields[] = {
+	F_STRING(feature, name),
+	F_STRING(feature, desc),
+	F_LINK(feature, next),
+	F_STRING(feature, mimic),
+	F_STRING(feature, walk_msg),
+	F_STRING(feature, run_msg),
+	F_STRING(feature, hurt_msg),
+	F_STRING(feature, die_msg),
+	F_STRING(feature, confused_msg),
+	F_STRING(feature, look_prefix),
+	F_STRING(feature, look_in_preposition),
+	F_END
+};
+
+static const struct cache_field no_fields[] = {
+	F_END
+};
+
+static const struct cache_field effect_fields[] = {
+	F_OWNED(effect, next, LAYOUT_EFFECT, NULL),
+	F_DICE(effect, dice),
+	F_STRING(effect, msg),
+	F_END
+};
+
+static const struct cache_field object_base_fields[] = {
+	F_STRING(object_base, name),
+	F_STRING(object_base, text),
+	F_LINK(object_base, next),
+	F_END
+};
+
+static const struct cache_field object_kind_fields[] = {
+	F_STRING(object_kind, name),
+	F_STRING(object_kind, text),
+	F_REF(object_kind, base, TABLE_OBJECT_BASE),
+	F_DEAD(object_kind, next),
+	F_BYTES(object_kind, brands, sizeof(bool), count_brands),
+	F_BYTES(object_kind, slays, sizeof(bool), count_slays),
+	F_BYTES(object_kind, curses, sizeof(int), count_curses),
+	F_REF(object_kind, activation, TABLE_ACTIVATION),
+	F_OWNED(object_kind, effect, LAYOUT_EFFECT, NULL),
+	F_STRING(object_kind, effect_msg),
+	F_STRING(object_kind, vis_msg),
+	F_EMPTY(object_kind, flavor),
+	F_END
+};
+
+static const struct cache_field poss_item_fields[] = {
+	F_OWNED(poss_item, next, LAYOUT_POSS_ITEM, NULL),
+	F_END
+};
+
+static const struct cache_field ego_item_fields[] = {
+	F_LINK(ego_item, next),
+	F_STRING(ego_item, name),
+	F_STRING(ego_item, text),
+	F_BYTES(ego_item, brands, sizeof(bool), count_brands),
+	F_BYTES(ego_item, slays, sizeof(bool), count_slays),
+	F_BYTES(ego_item, curses, sizeof(int), count_curses),
+	F_OWNED(ego_item, poss_items, LAYOUT_POSS_ITEM, NULL),
+	F_REF(ego_item, activation, TABLE_ACTIVATION),
+	F_END
+};
+
+static const struct cache_field artifact_fields[] = {
+	F_STRING(artifact, name),
+	F_STRING(artifact, text),
+	F_LINK(artifact, next),
+	F_BYTES(artifact, brands, sizeof(bool), count_brands),
+	F_BYTES(artifact, slays, sizeof(bool), count_slays),
+	F_BYTES(artifact, curses, sizeof(int), count_curses),
+	F_REF(artifact, activation, TABLE_ACTIVATION),
+	F_STRING(artifact, alt_msg),
+	F_OWNED(artifact, effect, LAYOUT_EFFECT, NULL),
+	F_STRING(artifact, effect_msg),
+	F_END
+};
+
+static const struct cache_field monster_race_fields[] = {
+	F_LINK(monster_race, next),
+	F_STRING(monster_race, name),
+	F_STRING(monster_race, text),
+	F_STRING(monster_race, plural),
+	F_REF(monster_race, base, TABLE_MONSTER_BASE),
+	F_OWNED(monster_race, blow, LAYOUT_MONSTER_BLOW, count_blows),
+	F_OWNED(monster_race, spell_msgs, LAYOUT_MONSTER_ALTMSG, NULL),
+	F_OWNED(monster_race, drops, LAYOUT_MONSTER_DROP, NULL),
+	F_OWNED(monster_race, friends, LAYOUT_MONSTER_FRIENDS, NULL),
+	F_OWNED(monster_race, friends_base, LAYOUT_MONSTER_FRIENDS_BASE, NULL),
+	F_OWNED(monster_race, mimic_kinds, LAYOUT_MONSTER_MIMIC, NULL),
+	F_OWNED(monster_race, shapes, LAYOUT_MONSTER_SHAPE, NULL),
+	F_END
+};
+
+static const struct cache_field monster_blow_fields[] = {
+	F_LINK(monster_blow, next),
+	F_REF(monster_blow, method, TABLE_BLOW_METHOD),
+	F_REF(monster_blow, effect, TABLE_BLOW_EFFECT),
+	F_END
+};
+
+static const struct cache_field monster_altmsg_fields[] = {
+	F_OWNED(monster_altmsg, next, LAYOUT_MONSTER_ALTMSG, NULL),
+	F_STRING(monster_altmsg, message),
+	F_END
+};
+
+static const struct cache_field monster_drop_fields[] = {
+	F_OWNED(monster_drop, next, LAYOUT_MONSTER_DROP, NULL),
+	F_REF(monster_drop, kind, TABLE_OBJECT_KIND),
+	F_END
+};
+
+static const struct cache_field monster_friends_fields[] = {
+	F_OWNED(monster_friends, next, LAYOUT_MONSTER_FRIENDS, NULL),
+	F_DEAD(monster_friends, name),
+	F_LINK(monster_friends, race),
+	F_END
+};
+
+static const struct cache_field monster_friends_base_fields[] = {
+	F_OWNED(monster_friends_base, next, LAYOUT_MONSTER_FRIENDS_BASE, NULL),
+	F_REF(monster_friends_base, base, TABLE_MONSTER_BASE),
+	F_END
+};
+
+static const struct cache_field monster_mimic_fields[] = {
+	F_OWNED(monster_mimic, next, LAYOUT_MONSTER_MIMIC, NULL),
+	F_REF(monster_mimic, kind, TABLE_OBJECT_KIND),
+	F_END
+};
+
+static const struct cache_field monster_shape_fields[] = {
+	F_OWNED(monster_shape, next, LAYOUT_MONSTER_SHAPE, NULL),
+	F_DEAD(monster_shape, name),
+	F_LINK(monster_shape, race),
+	F_REF(monster_shape, base, TABLE_MONSTER_BASE),
+	F_END
+};
+
+static const struct cache_field vault_fields[] = {
+	F_OWNED(vault, next, LAYOUT_VAULT, NULL),
+	F_STRING(vault, name),
+	F_STRING(vault, text),
+	F_STRING(vault, typ),
+	F_END
+};
+
+static const struct cache_layout layouts[LAYOUT_MAX] = {
+	{ sizeof(struct critical_level), critical_level_fields },
+	{ sizeof(struct angband_constants), constants_fields },
+	{ sizeof(struct feature), feature_fields },
+	{ sizeof(*feat_props), no_fields },
+	{ sizeof(struct effect), effect_fields },
+	{ sizeof(struct object_base), object_base_fields },
+	{ sizeof(struct object_kind), object_kind_fields },
+	{ sizeof(struct poss_item), poss_item_fields },
+	{ sizeof(struct ego_item), ego_item_fields },
+	{ sizeof(struct artifact), artifact_fields },
+	{ sizeof(struct artifact_upkeep), no_fields },
+	{ sizeof(struct monster_race), monster_race_fields },
+	{ sizeof(struct monster_blow), monster_blow_fields },
+	{ sizeof(struct monster_altmsg), monster_altmsg_fields },
+	{ sizeof(struct monster_drop), monster_drop_fields },
+	{ sizeof(struct monster_friends), monster_friends_fields },
+	{ sizeof(struct monster_friends_base), monster_friends_base_fields },
+	{ sizeof(struct monster_mimic), monster_mimic_fields },
+	{ sizeof(struct monster_shape), monster_shape_fields },
+	{ sizeof(struct vault), vault_fields }
+};
+
+/**
+ * Tables outside the cached sections which cached data points into; an array
+ * with a count, or a list linked through the pointer at offset next
+ */
+struct cache_table {
+	void *global;
+	size_t size;
+	size_t (*count)(void);
+	size_t next;
+};
+
+static const struct cache_table tables[] = {
+	{ &kb_info, sizeof(struct object_base), count_tvals, 0 },
+	{ &k_info, sizeof(struct object_kind), count_kinds, 0 },
+	{ &activations, sizeof(struct activation), count_activations, 0 },
+	{ &rb_info, sizeof(struct monster_base), NULL,
+	  offsetof(struct monster_base, next) },
+	{ &blow_methods, sizeof(struct blow_method), count_blow_methods, 0 },
+	{ &blow_effects, sizeof(struct blow_effect), count_blow_effects, 0 }
+};
+
+/**
+ * Read and write the global pointers the tables are held in; memcpy() since
+ * they are all kinds of pointer.
+ */
+static uint8_t *global_get(const void *global)
+{
+	uint8_t *value;
+
+	memcpy(&value, global, sizeof(value));
+	return value;
+}
+
+static void global_set(void *global, const void *value)
+{
+	memcpy(global, &value, sizeof(value));
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * The cached sections
+ * ------------------------------------------------------------------------ */
+
+struct cache_buffer;
+struct cache_reader;
+
+/**
+ * The tables a section makes, by their global pointers:  one structure or a
+ * list if there is no count, otherwise an array; or, if append is set, the
+ * elements the section adds to the end of an array already there (with one
+ * spare element after them, zeroed).
+ */
+struct cache_root {
+	void *global;
+	int layout;
+	size_t (*count)(void);
+	bool append;
+};
+
+/**
+ * Data outside the section which its parser changes
+ */
+struct cache_watch {
+	void *global;
+	int layout;
+	size_t (*count)(void);
+};
+
+struct cache_section {
+	const char *name;
+	struct cache_root roots[MAX_ROOTS];
+	struct cache_watch watches[MAX_WATCHES];
+	void (*begin)(void);
+	bool (*save)(struct cache_buffer *b);
+	void (*loaded)(struct cache_reader *r);
+};
+
+static void terrain_loaded(struct cache_reader *r);
+static void ego_loaded(struct cache_reader *r);
+static void artifact_loaded(struct cache_reader *r);
+static void monster_begin(void);
+static bool monster_save(struct cache_buffer *b);
+static void monster_loaded(struct cache_reader *r);
+
+#define WATCH_CONSTANTS { &z_info, LAYOUT_CONSTANTS, NULL }
+#define WATCH_OBJECT_BASES { &kb_info, LAYOUT_OBJECT_BASE, count_tvals }
+
+static const struct cache_section sections[] = {
+	{ "constants",
+	  { { &z_info, LAYOUT_CONSTANTS, NULL, false } },
+	  { { NULL } },
+	  NULL, NULL, NULL },
+	{ "terrain",
+	  { { &f_info, LAYOUT_FEATURE, count_features, false },
+		{ &feat_props, LAYOUT_FEATURE_PROPS, count_features, false } },
+	  { WATCH_CONSTANTS },
+	  NULL, NULL, terrain_loaded },
+	{ "object",
+	  { { &k_info, LAYOUT_OBJECT_KIND, count_kinds, false } },
+	  { WATCH_CONSTANTS, WATCH_OBJECT_BASES },
+	  NULL, NULL, NULL },
+	{ "ego_item",
+	  { { &e_info, LAYOUT_EGO_ITEM, count_egos, false } },
+	  { WATCH_CONSTANTS },
+	  NULL, NULL, ego_loaded },
+	{ "artifact",
+	  { { &a_info, LAYOUT_ARTIFACT, count_artifacts, false },
+		{ &aup_info, LAYOUT_ARTIFACT_UPKEEP, count_artifacts, false },
+		{ &k_info, LAYOUT_OBJECT_KIND, count_kinds, true } },
+	  { WATCH_CONSTANTS, WATCH_OBJECT_BASES,
+		{ &k_info, LAYOUT_OBJECT_KIND, count_kinds } },
+	  NULL, NULL, artifact_loaded },
+	{ "monster",
+	  { { &r_info, LAYOUT_MONSTER_RACE, count_races, false } },
+	  { WATCH_CONSTANTS },
+	  monster_begin, monster_save, monster_loaded },
+	{ "vault",
+	  { { &vaults, LAYOUT_VAULT, NULL, false } },
+	  { { NULL } },
+	  NULL, NULL, NULL }
+};
+
+/**
+ * ------------------------------------------------------------------------
+ * Buffers, readers and hashes
+ * ------------------------------------------------------------------------ */
+
+struct cache_buffer {
+	uint8_t *data;
+	size_t len;
+	size_t size;
+};
+
+struct cache_reader {
+	const uint8_t *pos;
+	const uint8_t *end;
+	bool error;
+};
+
+static void buffer_put(struct cache_buffer *b, const void *data, size_t len)
+{
+	if (b->len + len > b->size) {
+		while (b->len + len > b->size) {
+			b->size = b->size ? 2 * b->size : 4096;
+		}
+		b->data = mem_realloc(b->data, b->size);
+	}
+	if (len) {
+		memcpy(b->data + b->len, data, len);
+	}
+	b->len += len;
+}
+
+static void buffer_put_u32(struct cache_buffer *b, uint32_t value)
+{
+	buffer_put(b, &value, sizeof(value));
+}
+
+static void buffer_put_u64(struct cache_buffer *b, uint64_t value)
+{
+	buffer_put(b, &value, sizeof(value));
+}
+
+/**
+ * Strings are written with their length, terminator included
+ */
+static void buffer_put_string(struct cache_buffer *b, const char *s)
+{
+	buffer_put_u32(b, (uint32_t)(strlen(s) + 1));
+	buffer_put(b, s, strlen(s) + 1);
+}
+
+static void buffer_free(struct cache_buffer *b)
+{
+	mem_free(b->data);
+	memset(b, 0, sizeof(*b));
+}
+
+static void reader_init(struct cache_reader *r, const void *data, size_t len)
+{
+	r->pos = data;
+	r->end = r->pos + len;
+	r->error = false;
+}
+
+static const uint8_t *reader_bytes(struct cache_reader *r, size_t len)
+{
+	const uint8_t *data = r->pos;
+
+	if (r->error || len > (size_t)(r->end - r->pos)) {
+		r->error = true;
+		return NULL;
+	}
+	r->pos += len;
+	return data;
+}
+
+static uint32_t reader_u32(struct cache_reader *r)
+{
+	const uint8_t *data = reader_bytes(r, sizeof(uint32_t));
+	uint32_t value = 0;
+
+	if (data) {
+		memcpy(&value, data, sizeof(value));
+	}
+	return value;
+}
+
+static uint64_t reader_u64(struct cache_reader *r)
+{
+	const uint8_t *data = reader_bytes(r, sizeof(uint64_t));
+	uint64_t value = 0;
+
+	if (data) {
+		memcpy(&value, data, sizeof(value));
+	}
+	return value;
+}
+
+static const char *reader_string(struct cache_reader *r)
+{
+	uint32_t len = reader_u32(r);
+	const uint8_t *data = reader_bytes(r, len);
+
+	if (!data || !len || data[len - 1]) {
+		r->error = true;
+		return NULL;
+	}
+	return (const char *)data;
+}
+
+/**
+ * Hash some bytes, a word at a time; this checks a whole image, so should not
+ * take long.
+ */
+static uint64_t hash_bytes(uint64_t h, const void *data, size_t len)
+{
+	const uint8_t *pos = data;
+
+	while (len >= sizeof(uint64_t)) {
+		uint64_t word;
+
+		memcpy(&word, pos, sizeof(word));
+		h = (h ^ word) * HASH_PRIME;
+		h ^= h >> 29;
+		pos += sizeof(word);
+		len -= sizeof(word);
+	}
+	while (len--) {
+		h = (h ^ *pos++) * HASH_PRIME;
+	}
+	return h;
+}
+
+static uint64_t hash_u64(uint64_t h, uint64_t value)
+{
+	return hash_bytes(h, &value, sizeof(value));
+}
+
+/**
+ * Copy of an element with its pointers zeroed, for comparing and hashing data
+ * whatever it points to
+ */
+static void mask_pointers(const struct cache_layout *layout, uint8_t *element)
+{
+	const struct cache_field *field;
+
+	for (field = layout->fields; field->type != FIELD_END; field++) {
+		memset(element + field->offset, 0, sizeof(void *));
+	}
+}
+
+static uint64_t hash_masked(uint64_t h, const struct cache_layout *layout,
+		const uint8_t *array, size_t count)
+{
+	uint8_t *element = mem_alloc(layout->size);
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		memcpy(element, array + i * layout->size, layout->size);
+		mask_pointers(layout, element);
+		h = hash_bytes(h, element, layout->size);
+	}
+	mem_free(element);
+	return h;
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Packing a section into blocks
+ * ------------------------------------------------------------------------ */
+
+enum reloc_type {
+	RELOC_BLOCK,	/* target is a block, value an offset into it */
+	RELOC_REF,	/* target is a table, value an index into it */
+	RELOC_DICE	/* target is a block holding the dice strings */
+};
+
+struct pack_block {
+	size_t start;	/* Where its bytes are in the pack's data */
+	size_t size;
+	uint32_t flags;
+	int layout;	/* -1 for strings, plain values and dice */
+	size_t count;
+};
+
+struct pack_reloc {
+	uint32_t block;
+	uint32_t offset;
+	uint32_t type;
+	uint32_t target;
+	uint32_t value;
+};
+
+/**
+ * Where each structure, string and array put in a pack starts, so that more
+ * pointers to the same thing come out as pointers to the same block
+ */
+struct pack_address {
+	uintptr_t address;
+	uint32_t block;
+	uint32_t offset;
+};
+
+struct pack {
+	struct pack_block *blocks;
+	size_t n_blocks, blocks_size;
+	struct pack_reloc *relocs;
+	size_t n_relocs, relocs_size;
+	struct pack_address *addresses;
+	size_t n_addresses, addresses_size;
+	struct cache_buffer data;
+	bool digest;
+	bool failed;
+};
+
+static size_t address_slot(const struct pack *pk, uintptr_t address)
+{
+	size_t slot = (size_t)((address >> 3) * 0x9e3779b1U);
+
+	slot &= pk->addresses_size - 1;
+	while (pk->addresses[slot].address && pk->addresses[slot].address != address) {
+		slot = (slot + 1) & (pk->addresses_size - 1);
+	}
+	return slot;
+}
+
+static void address_add(struct pack *pk, const void *pointer, uint32_t block,
+		uint32_t offset)
+{
+	uintptr_t address = (uintptr_t)pointer;
+	size_t slot;
+
+	if (2 * (pk->n_addresses + 1) > pk->addresses_size) {
+		struct pack_address *old = pk->addresses;
+		size_t i, old_size = pk->addresses_size;
+
+		pk->addresses_size = old_size ? 2 * old_size : 4096;
+		pk->addresses = mem_zalloc(pk->addresses_size * sizeof(*old));
+		for (i = 0; i < old_size; i++) {
+			if (old[i].address) {
+				pk->addresses[address_slot(pk, old[i].address)] = old[i];
+			}
+		}
+		mem_free(old);
+	}
+
+	slot = address_slot(pk, address);
+	if (!pk->addresses[slot].address) {
+		pk->addresses[slot].address = address;
+		pk->addresses[slot].block = block;
+		pk->addresses[slot].offset = offset;
+		pk->n_addresses++;
+	}
+}
+
+static const struct pack_address *address_find(const struct pack *pk,
+		const void *pointer)
+{
+	size_t slot;
+
+	if (!pk->addresses_size) return NULL;
+	slot = address_slot(pk, (uintptr_t)pointer);
+	return pk->addresses[slot].address ? &pk->addresses[slot] : NULL;
+}
+
+/**
+ * Put a copy of some memory in the pack as a new block; if it is to be found
+ * again by its address, note where each of its elements starts.
+ */
+static uint32_t pack_add_block(struct pack *pk, const void *src, size_t size,
+		uint32_t flags, int layout, size_t count, bool findable)
+{
+	uint32_t index = (uint32_t)pk->n_blocks;
+	struct pack_block *block;
+
+	if (pk->n_blocks == pk->blocks_size) {
+		pk->blocks_size = pk->blocks_size ? 2 * pk->blocks_size : 1024;
+		pk->blocks = mem_realloc(pk->blocks,
+			pk->blocks_size * sizeof(*pk->blocks));
+	}
+	block = &pk->blocks[pk->n_blocks++];
+	block->start = pk->data.len;
+	block->size = size;
+	block->flags = flags;
+	block->layout = layout;
+	block->count = count;
+	buffer_put(&pk->data, src, size);
+
+	if (findable && layout < 0) {
+		address_add(pk, src, index, 0);
+	} else if (findable) {
+		size_t i, step = layouts[layout].size;
+
+		for (i = 0; i < count; i++) {
+			address_add(pk, (const uint8_t *)src + i * step, index,
+				(uint32_t)(i * step));
+		}
+	}
+	return index;
+}
+
+static void pack_add_reloc(struct pack *pk, uint32_t block, size_t offset,
+		enum reloc_type type, uint32_t target, uint32_t value)
+{
+	struct pack_reloc *reloc;
+
+	if (pk->n_relocs == pk->relocs_size) {
+		pk->relocs_size = pk->relocs_size ? 2 * pk->relocs_size : 1024;
+		pk->relocs = mem_realloc(pk->relocs,
+			pk->relocs_size * sizeof(*pk->relocs));
+	}
+	reloc = &pk->relocs[pk->n_relocs++];
+	reloc->block = block;
+	reloc->offset = (uint32_t)offset;
+	reloc->type = type;
+	reloc->target = target;
+	reloc->value = value;
+}
+
+static void pack_free(struct pack *pk)
+{
+	mem_free(pk->blocks);
+	mem_free(pk->relocs);
+	mem_free(pk->addresses);
+	buffer_free(&pk->data);
+	memset(pk, 0, sizeof(*pk));
+}
+
+/**
+ * Index of an entry in one of the tables[], or -1 if it is not in there
+ */
+static int table_index(int table, const void *entry)
+{
+	const struct cache_table *t = &tables[table];
+	const uint8_t *base = global_get(t->global);
+
+	if (!base) return -1;
+	if (t->count) {
+		uintptr_t offset = (uintptr_t)entry - (uintptr_t)base;
+
+		if ((uintptr_t)entry < (uintptr_t)base || offset % t->size
+				|| offset / t->size >= t->count()) {
+			return -1;
+		}
+		return (int)(offset / t->size);
+	} else {
+		const uint8_t *current = base;
+		int index = 0;
+
+		while (current) {
+			if (current == entry) return index;
+			current = global_get(current + t->next);
+			index++;
+		}
+		return -1;
+	}
+}
+
+/**
+ * Entry of one of the tables[] by index, or NULL if there is none
+ */
+static void *table_entry(uint32_t table, uint32_t index)
+{
+	const struct cache_table *t;
+	uint8_t *current;
+
+	if (table >= N_ELEMENTS(tables)) return NULL;
+	t = &tables[table];
+	current = global_get(t->global);
+	if (!current) return NULL;
+	if (t->count) {
+		return (index < t->count()) ? current + index * t->size : NULL;
+	}
+	while (current && index--) {
+		current = global_get(current + t->next);
+	}
+	return current;
+}
+
+/**
+ * Put dice in the pack as the strings that make them again:  the dice, then
+ * the name, base value and operations of each expression bound to them.
+ */
+static bool pack_dice(struct pack *pk, const dice_t *dice, uint32_t *block)
+{
+	struct cache_buffer spec = { NULL, 0, 0 };
+	char buf[1024];
+	int i;
+
+	if (!dice_format_string(dice, buf, sizeof(buf))) return false;
+	buffer_put(&spec, buf, strlen(buf) + 1);
+	for (i = 0; i < DICE_MAX_EXPRESSIONS; i++) {
+		const char *name, *base = "";
+		const expression_t *expression = dice_get_expression(dice, i, &name);
+
+		if (!expression) continue;
+		if (expression_get_base_value(expression)) {
+			base = effect_value_base_name(
+				expression_get_base_value(expression));
+		}
+		if (!base || !expression_operations_string(expression, buf,
+				sizeof(buf))) {
+			buffer_free(&spec);
+			return false;
+		}
+		buffer_put(&spec, name, strlen(name) + 1);
+		buffer_put(&spec, base, strlen(base) + 1);
+		buffer_put(&spec, buf, strlen(buf) + 1);
+	}
+	*block = pack_add_block(pk, spec.data, spec.len, BLOCK_TRANSIENT, -1, 0,
+		false);
+	buffer_free(&spec);
+	return true;
+}
+
+/**
+ * Put a pointer in a block in the pack's relocations, and what it points to
+ * in the pack if that is not there yet.
+ */
+static void pack_pointer(struct pack *pk, uint32_t block, size_t offset,
+		const struct cache_field *field)
+{
+	uint8_t *at = pk->data.data + pk->blocks[block].start + offset;
+	const struct pack_address *found;
+	const uint8_t *pointer;
+	uint32_t target;
+	size_t count, size;
+	int layout = -1;
+
+	memcpy(&pointer, at, sizeof(pointer));
+	memset(at, 0, sizeof(pointer));
+	if (!pointer || field->type == FIELD_DEAD) return;
+
+	switch (field->type) {
+		case FIELD_EMPTY: {
+			if (!pk->digest) pk->failed = true;
+			return;
+		}
+		case FIELD_REF: {
+			int index = table_index(field->table, pointer);
+
+			if (index < 0) {
+				pk->failed = true;
+			} else {
+				pack_add_reloc(pk, block, offset, RELOC_REF,
+					(uint32_t)field->table, (uint32_t)index);
+			}
+			return;
+		}
+		case FIELD_DICE: {
+			if (!pack_dice(pk, (const dice_t *)pointer, &target)) {
+				pk->failed = true;
+			} else {
+				pack_add_reloc(pk, block, offset, RELOC_DICE, target, 0);
+			}
+			return;
+		}
+		default: break;
+	}
+
+	found = address_find(pk, pointer);
+	if (found) {
+		if (pk->blocks[found->block].flags & BLOCK_TRANSIENT) {
+			pk->failed = true;
+		} else {
+			pack_add_reloc(pk, block, offset, RELOC_BLOCK, found->block,
+				found->offset);
+		}
+		return;
+	}
+
+	/* Links to something outside the section may be left dangling by a
+	 * later parser; a digest only notes that they are set */
+	if (field->type == FIELD_LINK) {
+		if (!pk->digest) {
+			pk->failed = true;
+		} else {
+			pack_add_reloc(pk, block, offset, RELOC_BLOCK, BLOCK_NONE, 0);
+		}
+		return;
+	}
+
+	count = field->count ? field->count() : 1;
+	if (field->type == FIELD_STRING) {
+		size = strlen((const char *)pointer) + 1;
+		count = 1;
+	} else if (field->type == FIELD_OWNED) {
+		layout = field->layout;
+		size = count * layouts[layout].size;
+	} else {
+		size = count * field->size;
+	}
+	if (!size) {
+		pk->failed = true;
+		return;
+	}
+	target = pack_add_block(pk, pointer, size, 0, layout, count, true);
+	pack_add_reloc(pk, block, offset, RELOC_BLOCK, target, 0);
+}
+
+/**
+ * Put the pointers of every block in the pack which has structures in it in
+ * the relocations, which puts everything they point to in the pack in turn.
+ */
+static void pack_walk(struct pack *pk, size_t from)
+{
+	size_t block;
+
+	for (block = from; block < pk->n_blocks && !pk->failed; block++) {
+		int layout = pk->blocks[block].layout;
+		size_t i;
+
+		if (layout < 0) continue;
+		for (i = 0; i < pk->blocks[block].count; i++) {
+			const struct cache_field *field;
+
+			for (field = layouts[layout].fields; field->type != FIELD_END;
+					field++) {
+				pack_pointer(pk, (uint32_t)block,
+					i * layouts[layout].size + field->offset, field);
+			}
+		}
+	}
+}
+
+/**
+ * Put the tables a section makes in a pack, as the first blocks, in order;
+ * begins has where each appended root starts.
+ */
+static void pack_roots(struct pack *pk, const struct cache_section *s,
+		const size_t *begins, uint32_t *blocks)
+{
+	int i;
+
+	for (i = 0; i < MAX_ROOTS && s->roots[i].global; i++) {
+		const struct cache_root *root = &s->roots[i];
+		const struct cache_layout *layout = &layouts[root->layout];
+		const uint8_t *data = global_get(root->global);
+		size_t begin = 0, count = root->count ? root->count() : 1;
+
+		blocks[i] = BLOCK_NONE;
+		if (root->append) {
+			if (pk->digest) continue;
+			begin = begins[i];
+			if (count < begin || !data) {
+				pk->failed = true;
+				continue;
+			}
+		}
+		if (!data) continue;
+		blocks[i] = pack_add_block(pk, data + begin * layout->size,
+			(count - begin) * layout->size,
+			root->append ? BLOCK_TRANSIENT : 0, root->layout, count - begin,
+			true);
+	}
+	pack_walk(pk, 0);
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Saving and loading sections
+ * ------------------------------------------------------------------------ */
+
+/**
+ * What is kept about a section between its parser starting and finishing
+ */
+struct section_state {
+	bool begun;
+	bool stored;
+	size_t begins[MAX_ROOTS];
+	uint8_t *before[MAX_WATCHES];
+	size_t before_count[MAX_WATCHES];
+};
+
+static struct {
+	bool open;
+	bool failed;
+	int parsed;
+	uint64_t key;
+	char *image;
+	size_t image_len;
+	const uint8_t *records[N_ELEMENTS(sections)];
+	size_t record_lens[N_ELEMENTS(sections)];
+	struct section_state states[N_ELEMENTS(sections)];
+	struct cache_buffer out;
+} cache;
+
+static int sections_loaded;
+
+static int section_find(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < N_ELEMENTS(sections); i++) {
+		if (streq(sections[i].name, name)) return (int)i;
+	}
+	return -1;
+}
+
+static void state_free(struct section_state *st)
+{
+	int i;
+
+	for (i = 0; i < MAX_WATCHES; i++) {
+		mem_free(st->before[i]);
+		st->before[i] = NULL;
+	}
+	st->begun = false;
+}
+
+/**
+ * Note the state of what the parser of a section will change, before it runs
+ */
+static void section_begin(const struct cache_section *s,
+		struct section_state *st)
+{
+	int i;
+
+	state_free(st);
+	st->begun = true;
+	for (i = 0; i < MAX_ROOTS && s->roots[i].global; i++) {
+		st->begins[i] = s->roots[i].count ? s->roots[i].count() : 0;
+	}
+	for (i = 0; i < MAX_WATCHES && s->watches[i].global; i++) {
+		const struct cache_watch *w = &s->watches[i];
+		const uint8_t *data = global_get(w->global);
+		size_t count = w->count ? w->count() : 1;
+		size_t size = count * layouts[w->layout].size;
+
+		st->before_count[i] = data ? count : 0;
+		if (data && size) {
+			st->before[i] = mem_alloc(size);
+			memcpy(st->before[i], data, size);
+		}
+	}
+	if (s->begin) s->begin();
+}
+
+/**
+ * Write what a parser changed in one watched table:  the hash of the table
+ * from before, and the elements that changed.  Fails if a pointer changed.
+ */
+static bool save_watch(struct cache_buffer *b, const struct cache_watch *w,
+		const uint8_t *before, size_t count)
+{
+	const struct cache_layout *layout = &layouts[w->layout];
+	const uint8_t *now = global_get(w->global);
+	struct cache_buffer changed = { NULL, 0, 0 };
+	uint8_t *element = mem_alloc(layout->size);
+	uint32_t n_changed = 0;
+	size_t i;
+	bool ok = (now != NULL) || !count;
+
+	for (i = 0; i < count && ok; i++) {
+		const uint8_t *old = before + i * layout->size;
+		const uint8_t *new = now + i * layout->size;
+		const struct cache_field *field;
+
+		if (!memcmp(old, new, layout->size)) continue;
+		for (field = layout->fields; field->type != FIELD_END; field++) {
+			if (memcmp(old + field->offset, new + field->offset,
+					sizeof(void *))) {
+				ok = false;
+			}
+		}
+		memcpy(element, new, layout->size);
+		mask_pointers(layout, element);
+		buffer_put_u32(&changed, (uint32_t)i);
+		buffer_put(&changed, element, layout->size);
+		n_changed++;
+	}
+
+	if (ok) {
+		buffer_put_u32(b, (uint32_t)count);
+		buffer_put_u64(b, hash_masked(HASH_START, layout, before, count));
+		buffer_put_u32(b, n_changed);
+		buffer_put(b, changed.data, changed.len);
+	}
+	buffer_free(&changed);
+	mem_free(element);
+	return ok;
+}
+
+/**
+ * Store a section whose parser has just finished, after the others in the
+ * image that will be written
+ */
+static bool section_save(const struct cache_section *s,
+		struct section_state *st)
+{
+	struct pack pk;
+	struct cache_buffer record = { NULL, 0, 0 }, extra = { NULL, 0, 0 };
+	uint32_t roots[MAX_ROOTS];
+	int i, n_roots = 0, n_watches = 0;
+	size_t j;
+	bool ok;
+
+	memset(&pk, 0, sizeof(pk));
+	pack_roots(&pk, s, st->begins, roots);
+	ok = !pk.failed;
+
+	buffer_put_u32(&record, (uint32_t)pk.n_blocks);
+	for (j = 0; j < pk.n_blocks; j++) {
+		buffer_put_u32(&record, (uint32_t)pk.blocks[j].size);
+		buffer_put_u32(&record, pk.blocks[j].flags);
+	}
+	buffer_put_u32(&record, (uint32_t)pk.n_relocs);
+	buffer_put(&record, pk.relocs, pk.n_relocs * sizeof(*pk.relocs));
+
+	while (n_roots < MAX_ROOTS && s->roots[n_roots].global) n_roots++;
+	buffer_put_u32(&record, (uint32_t)n_roots);
+	for (i = 0; i < n_roots; i++) {
+		const struct cache_root *root = &s->roots[i];
+
+		buffer_put_u32(&record, roots[i]);
+		buffer_put_u32(&record, root->append ? (uint32_t)st->begins[i] : 0);
+		buffer_put_u32(&record, root->append ? (uint32_t)root->count() : 0);
+	}
+
+	while (n_watches < MAX_WATCHES && s->watches[n_watches].global) n_watches++;
+	buffer_put_u32(&record, (uint32_t)n_watches);
+	for (i = 0; i < n_watches && ok; i++) {
+		ok = save_watch(&record, &s->watches[i], st->before[i],
+			st->before_count[i]);
+	}
+
+	if (ok && s->save) ok = s->save(&extra);
+	buffer_put_u32(&record, (uint32_t)extra.len);
+	buffer_put(&record, extra.data, extra.len);
+
+	buffer_put_u32(&record, (uint32_t)pk.data.len);
+	buffer_put(&record, pk.data.data, pk.data.len);
+
+	if (ok) {
+		buffer_put_string(&cache.out, s->name);
+		buffer_put_u32(&cache.out, (uint32_t)record.len);
+		buffer_put(&cache.out, record.data, record.len);
+	}
+	buffer_free(&extra);
+	buffer_free(&record);
+	pack_free(&pk);
+	return ok;
+}
+
+/**
+ * Turn the strings pack_dice() made back into dice
+ */
+static dice_t *load_dice(const uint8_t *spec, size_t len)
+{
+	struct cache_reader r;
+	const char *string;
+	dice_t *dice;
+
+	if (!len || spec[len - 1]) return NULL;
+	reader_init(&r, spec, len);
+	string = (const char *)reader_bytes(&r, strlen((const char *)spec) + 1);
+	dice = dice_new();
+	if (!string || !dice_parse_string(dice, string)) {
+		dice_free(dice);
+		return NULL;
+	}
+	while (r.pos < r.end) {
+		const char *strings[3];
+		expression_t *expression;
+		int i, bound;
+
+		for (i = 0; i < 3; i++) {
+			strings[i] = (const char *)r.pos;
+			reader_bytes(&r, strlen(strings[i]) + 1);
+		}
+		if (r.error) break;
+		expression = expression_new();
+		expression_set_base_value(expression,
+			effect_value_base_by_name(strings[1]));
+		bound = -1;
+		if (expression_add_operations_string(expression, strings[2]) >= 0) {
+			bound = dice_bind_expression(dice, strings[0], expression);
+		}
+		expression_free(expression);
+		if (bound < 0) {
+			r.error = true;
+			break;
+		}
+	}
+	if (r.error) {
+		dice_free(dice);
+		return NULL;
+	}
+	return dice;
+}
+
+/**
+ * Load a section from its record in the image.  Nothing outside the section
+ * is touched until everything has been checked, so on failure the section
+ * can still be parsed.
+ */
+static bool section_load(const struct cache_section *s, const uint8_t *data,
+		size_t len)
+{
+	struct cache_reader r, extra;
+	const uint8_t *block_info, *relocs, *blob;
+	const uint8_t *changes[MAX_WATCHES];
+	uint32_t n_changes[MAX_WATCHES];
+	uint32_t roots[MAX_ROOTS][3];
+	uint32_t n_blocks, n_relocs, n_roots, n_watches, extra_len;
+	uint8_t **mem = NULL;
+	dice_t **dice = NULL;
+	size_t n_dice = 0, blob_len, total = 0;
+	uint32_t i, j;
+	bool ok = true;
+
+	reader_init(&r, data, len);
+	n_blocks = reader_u32(&r);
+	block_info = reader_bytes(&r, (size_t)n_blocks * 2 * sizeof(uint32_t));
+	n_relocs = reader_u32(&r);
+	relocs = reader_bytes(&r, (size_t)n_relocs * sizeof(struct pack_reloc));
+	n_roots = reader_u32(&r);
+	if (n_roots > MAX_ROOTS) return false;
+	for (i = 0; i < n_roots; i++) {
+		for (j = 0; j < 3; j++) {
+			roots[i][j] = reader_u32(&r);
+		}
+	}
+	for (i = 0; i < MAX_ROOTS && s->roots[i].global; i++) {
+		if (s->roots[i].append && roots[i][2] < roots[i][1]) return false;
+	}
+	if (i != n_roots) return false;
+
+	/* The data the parser would change has to be as it was when stored */
+	n_watches = reader_u32(&r);
+	if (n_watches > MAX_WATCHES) return false;
+	for (i = 0; i < n_watches && !r.error; i++) {
+		const struct cache_watch *w = &s->watches[i];
+		const struct cache_layout *layout;
+		uint32_t count = reader_u32(&r);
+		uint64_t hash = reader_u64(&r);
+		const uint8_t *now;
+
+		if (!w->global) return false;
+		layout = &layouts[w->layout];
+		now = global_get(w->global);
+		n_changes[i] = reader_u32(&r);
+		changes[i] = reader_bytes(&r, (size_t)n_changes[i] *
+			(sizeof(uint32_t) + layout->size));
+		if (count != (now ? (w->count ? w->count() : 1) : 0)) return false;
+		if (hash != hash_masked(HASH_START, layout, now, count)) return false;
+		for (j = 0; changes[i] && j < n_changes[i]; j++) {
+			uint32_t index;
+
+			memcpy(&index, changes[i] + j * (sizeof(index) + layout->size),
+				sizeof(index));
+			if (index >= count) return false;
+		}
+	}
+	if (i < MAX_WATCHES && s->watches[i].global) return false;
+	for (i = 0; i < n_roots; i++) {
+		if (s->roots[i].append && roots[i][1] != s->roots[i].count()) {
+			return false;
+		}
+	}
+	extra_len = reader_u32(&r);
+	reader_init(&extra, reader_bytes(&r, extra_len), extra_len);
+	blob_len = reader_u32(&r);
+	blob = reader_bytes(&r, blob_len);
+	if (r.error || r.pos != r.end) return false;
+
+	/* Give each block its own allocation */
+	mem = mem_zalloc((n_blocks + 1) * sizeof(*mem));
+	for (i = 0; i < n_blocks; i++) {
+		uint32_t size;
+
+		memcpy(&size, block_info + i * 2 * sizeof(uint32_t), sizeof(size));
+		if (size > blob_len - total) {
+			ok = false;
+			break;
+		}
+		mem[i] = mem_alloc(size ? size : 1);
+		memcpy(mem[i], blob + total, size);
+		total += size;
+	}
+	if (total != blob_len) ok = false;
+
+	/* Each table has to be the size it says */
+	for (i = 0; i < n_roots && ok; i++) {
+		const struct cache_root *root = &s->roots[i];
+		uint32_t size = 0;
+
+		if (roots[i][0] == BLOCK_NONE) continue;
+		if (roots[i][0] >= n_blocks) {
+			ok = false;
+			break;
+		}
+		memcpy(&size, block_info + roots[i][0] * 2 * sizeof(uint32_t),
+			sizeof(size));
+		if (root->append) {
+			ok = (size == (roots[i][2] - roots[i][1])
+				* layouts[root->layout].size);
+		} else if (root->count) {
+			/* Counts in z_info may not have been put back yet */
+			ok = size && !(size % layouts[root->layout].size);
+		} else {
+			ok = (size == layouts[root->layout].size);
+		}
+	}
+
+	/* Fill the pointers in */
+	dice = mem_zalloc((n_relocs + 1) * sizeof(*dice));
+	for (i = 0; i < n_relocs && ok; i++) {
+		struct pack_reloc reloc;
+		uint32_t size, target_size = 0, target_flags = 0;
+		void *pointer = NULL;
+
+		memcpy(&reloc, relocs + i * sizeof(reloc), sizeof(reloc));
+		if (reloc.block >= n_blocks) {
+			ok = false;
+			break;
+		}
+		memcpy(&size, block_info + reloc.block * 2 * sizeof(uint32_t),
+			sizeof(size));
+		if (reloc.type != RELOC_REF && reloc.target < n_blocks) {
+			memcpy(&target_size,
+				block_info + reloc.target * 2 * sizeof(uint32_t),
+				sizeof(target_size));
+			memcpy(&target_flags, block_info +
+				(reloc.target * 2 + 1) * sizeof(uint32_t),
+				sizeof(target_flags));
+		}
+		if (reloc.offset > size || size - reloc.offset < sizeof(void *)) {
+			ok = false;
+			break;
+		}
+		switch (reloc.type) {
+			case RELOC_BLOCK:
+				if (reloc.target < n_blocks && reloc.value < target_size
+						&& !(target_flags & BLOCK_TRANSIENT)) {
+					pointer = mem[reloc.target] + reloc.value;
+				}
+				break;
+			case RELOC_REF:
+				pointer = table_entry(reloc.target, reloc.value);
+				break;
+			case RELOC_DICE:
+				if (reloc.target < n_blocks) {
+					pointer = dice[n_dice] = load_dice(mem[reloc.target],
+						target_size);
+					if (pointer) n_dice++;
+				}
+				break;
+		}
+		if (!pointer) {
+			ok = false;
+			break;
+		}
+		memcpy(mem[reloc.block] + reloc.offset, &pointer, sizeof(pointer));
+	}
+
+	if (!ok) {
+		for (i = 0; i < n_dice; i++) {
+			dice_free(dice[i]);
+		}
+		for (i = 0; i < n_blocks; i++) {
+			mem_free(mem[i]);
+		}
+		mem_free(dice);
+		mem_free(mem);
+		return false;
+	}
+
+	/* It all checks out, so put the tables in place */
+	for (i = 0; i < n_roots; i++) {
+		const struct cache_root *root = &s->roots[i];
+		size_t size = layouts[root->layout].size;
+		uint8_t *table = (roots[i][0] < n_blocks) ? mem[roots[i][0]] : NULL;
+
+		if (!root->append) {
+			global_set(root->global, table);
+		} else {
+			uint8_t *array = mem_realloc(global_get(root->global),
+				(roots[i][2] + 1) * size);
+
+			if (table) {
+				memcpy(array + roots[i][1] * size, table,
+					(roots[i][2] - roots[i][1]) * size);
+			}
+			memset(array + roots[i][2] * size, 0, size);
+			global_set(root->global, array);
+		}
+	}
+	for (i = 0; i < n_watches; i++) {
+		const struct cache_layout *layout = &layouts[s->watches[i].layout];
+		uint8_t *now = global_get(s->watches[i].global);
+		uint8_t *element = mem_alloc(layout->size);
+		const struct cache_field *field;
+
+		for (j = 0; j < n_changes[i]; j++) {
+			const uint8_t *change = changes[i] +
+				j * (sizeof(uint32_t) + layout->size);
+			uint32_t index;
+			uint8_t *at;
+
+			memcpy(&index, change, sizeof(index));
+			at = now + index * layout->size;
+			memcpy(element, at, layout->size);
+			memcpy(at, change + sizeof(index), layout->size);
+			for (field = layout->fields; field->type != FIELD_END; field++) {
+				memcpy(at + field->offset, element + field->offset,
+					sizeof(void *));
+			}
+		}
+		mem_free(element);
+	}
+	for (i = 0; i < n_blocks; i++) {
+		uint32_t flags;
+
+		memcpy(&flags, block_info + (i * 2 + 1) * sizeof(uint32_t),
+			sizeof(flags));
+		if (flags & BLOCK_TRANSIENT) mem_free(mem[i]);
+	}
+	mem_free(dice);
+	mem_free(mem);
+
+	if (s->loaded) s->loaded(&extra);
+	return true;
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * What the sections do besides their tables
+ * ------------------------------------------------------------------------ */
+
+static void terrain_loaded(struct cache_reader *r)
+{
+	feat_name_index_build();
+	set_terrain();
+}
+
+static void ego_loaded(struct cache_reader *r)
+{
+	ego_name_index_build();
+}
+
+static void artifact_loaded(struct cache_reader *r)
+{
+	artifact_name_index_build();
+	finish_artifact_kinds();
+}
+
+/**
+ * The monster parser gives races color cycles as it reads them, so the color
+ * cycles set while it runs are kept with the races.
+ */
+struct cycle_names {
+	const char *group;
+	const char *cycle;
+};
+
+static struct cycle_names *monster_cycles;
+static size_t monster_cycles_count;
+
+static void monster_begin(void)
+{
+	size_t i;
+
+	mem_free(monster_cycles);
+	monster_cycles_count = visuals_cycler_race_entries();
+	monster_cycles = mem_zalloc((monster_cycles_count + 1) *
+		sizeof(*monster_cycles));
+	for (i = 0; i < monster_cycles_count; i++) {
+		visuals_cycler_get_cycle_for_race(i, &monster_cycles[i].group,
+			&monster_cycles[i].cycle);
+	}
+}
+
+static bool monster_save(struct cache_buffer *b)
+{
+	struct cache_buffer changed = { NULL, 0, 0 };
+	size_t i, entries = visuals_cycler_race_entries();
+	uint32_t n_changed = 0;
+	bool ok = true;
+
+	for (i = 0; i < entries && ok; i++) {
+		struct cycle_names now = { NULL, NULL }, before = { NULL, NULL };
+
+		visuals_cycler_get_cycle_for_race(i, &now.group, &now.cycle);
+		if (i < monster_cycles_count) before = monster_cycles[i];
+		if (now.group == before.group && now.cycle == before.cycle) continue;
+		if (!now.group || i >= z_info->r_max) {
+			ok = false;
+		} else {
+			buffer_put_u32(&changed, (uint32_t)i);
+			buffer_put_string(&changed, now.group);
+			buffer_put_string(&changed, now.cycle);
+			n_changed++;
+		}
+	}
+	buffer_put_u32(b, n_changed);
+	buffer_put(b, changed.data, changed.len);
+	buffer_free(&changed);
+	mem_free(monster_cycles);
+	monster_cycles = NULL;
+	monster_cycles_count = 0;
+	return ok;
+}
+
+static void monster_loaded(struct cache_reader *r)
+{
+	uint32_t n_changed = reader_u32(r);
+
+	monster_name_index_build();
+	alloc_monster_lore();
+	while (n_changed-- && !r->error) {
+		uint32_t ridx = reader_u32(r);
+		const char *group = reader_string(r);
+		const char *cycle = reader_string(r);
+
+		if (!r->error && ridx < z_info->r_max) {
+			visuals_cycler_set_cycle_for_race(&r_info[ridx], group, cycle);
+		}
+	}
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * The image
+ * ------------------------------------------------------------------------ */
+
+static int cmp_names(const void *a, const void *b)
+{
+	return strcmp(*(const char * const *)a, *(const char * const *)b);
+}
+
+/**
+ * Get the size and modification time of the running executable, which change
+ * whenever it is relinked
+ */
+static bool executable_stamp(uint64_t *size, uint64_t *mtime)
+{
+#ifdef __linux__
+	if (file_stamp("/proc/self/exe", size, mtime)) return true;
+#endif
+	return argv0 && file_stamp(argv0, size, mtime);
+}
+
+/**
+ * Work out the key the image has to have:  it changes with the format, the
+ * executable, the structures and every game data file the parsers could read.
+ *
+ * eturn false if the executable cannot be found, so there is no key.
+ */
+static bool datacache_key(uint64_t *key)
+{
+	uint64_t h = hash_u64(HASH_START, DATACACHE_VERSION);
+	uint64_t exe_size, exe_mtime;
+	char **names = NULL;
+	size_t n_names = 0, names_size = 0, i;
+	char name[256];
+	ang_dir *dir;
+
+	if (!executable_stamp(&exe_size, &exe_mtime)) return false;
+	h = hash_bytes(h, buildid, strlen(buildid));
+	h = hash_u64(h, exe_size);
+	h = hash_u64(h, exe_mtime);
+	h = hash_u64(h, sizeof(void *));
+	for (i = 0; i < LAYOUT_MAX; i++) {
+		h = hash_u64(h, layouts[i].size);
+	}
+
+	dir = my_dopen(ANGBAND_DIR_GAMEDATA);
+	while (dir && my_dread(dir, name, sizeof(name))) {
+		size_t len = strlen(name);
+
+		if (len < 4 || !streq(name + len - 4, ".txt")) continue;
+		if (n_names == names_size) {
+			names_size = names_size ? 2 * names_size : 64;
+			names = mem_realloc(names, names_size * sizeof(*names));
+		}
+		names[n_names++] = string_make(name);
+	}
+	if (dir) my_dclose(dir);
+	if (n_names) sort(names, n_names, sizeof(*names), cmp_names);
+
+	for (i = 0; i < n_names; i++) {
+		char path[1024];
+		ang_file *fh;
+		char *text = NULL;
+		size_t len = 0;
+
+		/* As parse_file() does, the user's own copy first */
+		path_build(path, sizeof(path), ANGBAND_DIR_USER, names[i]);
+		fh = file_open(path, MODE_READ, FTYPE_TEXT);
+		if (!fh) {
+			path_build(path, sizeof(path), ANGBAND_DIR_GAMEDATA, names[i]);
+			fh = file_open(path, MODE_READ, FTYPE_TEXT);
+		}
+		if (fh) {
+			text = file_read_all(fh, &len);
+			file_close(fh);
+		}
+		h = hash_bytes(h, names[i], strlen(names[i]) + 1);
+		h = hash_u64(h, len);
+		if (text) h = hash_bytes(h, text, len);
+		mem_free(text);
+		string_free(names[i]);
+	}
+	mem_free(names);
+
+	*key = h;
+	return true;
+}
+
+/**
+ * Check an image read in and find its sections:  the header has the magic
+ * string, the format version, the number of sections, the key, the checksum
+ * of what follows, and its length.
+ */
+static bool image_check(void)
+{
+	struct cache_reader r;
+	const uint8_t *magic;
+	uint32_t version, n_sections, i;
+	uint64_t key, checksum, len;
+
+	reader_init(&r, cache.image, cache.image_len);
+	magic = reader_bytes(&r, DATACACHE_MAGIC_LEN);
+	version = reader_u32(&r);
+	n_sections = reader_u32(&r);
+	key = reader_u64(&r);
+	checksum = reader_u64(&r);
+	len = reader_u64(&r);
+	if (r.error || memcmp(magic, DATACACHE_MAGIC, DATACACHE_MAGIC_LEN)
+			|| version != DATACACHE_VERSION || key != cache.key
+			|| len != (uint64_t)(r.end - r.pos)
+			|| checksum != hash_bytes(HASH_START, r.pos, (size_t)len)) {
+		return false;
+	}
+
+	for (i = 0; i < n_sections; i++) {
+		const char *name = reader_string(&r);
+		uint32_t record_len = reader_u32(&r);
+		const uint8_t *record = reader_bytes(&r, record_len);
+		int index;
+
+		if (r.error) return false;
+		index = section_find(name);
+		if (index >= 0) {
+			cache.records[index] = record;
+			cache.record_lens[index] = record_len;
+		}
+	}
+	return true;
+}
+
+static void image_write(void)
+{
+	char path[1024], new_path[1024];
+	struct cache_buffer header = { NULL, 0, 0 };
+	ang_file *fh;
+	bool ok;
+
+	buffer_put(&header, DATACACHE_MAGIC, DATACACHE_MAGIC_LEN);
+	buffer_put_u32(&header, DATACACHE_VERSION);
+	buffer_put_u32(&header, (uint32_t)N_ELEMENTS(sections));
+	buffer_put_u64(&header, cache.key);
+	buffer_put_u64(&header, hash_bytes(HASH_START, cache.out.data,
+		cache.out.len));
+	buffer_put_u64(&header, cache.out.len);
+
+	/* Write a new image, then put it in place of the old one */
+	path_build(path, sizeof(path), ANGBAND_DIR_USER, DATACACHE_FILE);
+	strnfmt(new_path, sizeof(new_path), "%s.new", path);
+	fh = file_open(new_path, MODE_WRITE, FTYPE_RAW);
+	if (fh) {
+		ok = file_write(fh, (const char *)header.data, header.len)
+			&& file_write(fh, (const char *)cache.out.data, cache.out.len);
+		file_close(fh);
+		if (ok && file_exists(path)) ok = file_delete(path);
+		if (!ok || !file_move(new_path, path)) file_delete(new_path);
+	}
+	buffer_free(&header);
+}
+
+/**
+ * ------------------------------------------------------------------------
+ * Using the cache
+ * ------------------------------------------------------------------------ */
+
+/**
+ * Start using the cache, reading in the image if it is there and good
+ */
+void datacache_open(void)
+{
+	char path[1024];
+	ang_file *fh;
+
+	datacache_close();
+	sections_loaded = 0;
+	if (!datacache_key(&cache.key)) return;
+	cache.open = true;
+
+	path_build(path, sizeof(path), ANGBAND_DIR_USER, DATACACHE_FILE);
+	fh = file_open(path, MODE_READ, FTYPE_RAW);
+	if (fh) {
+		cache.image = file_read_all(fh, &cache.image_len);
+		file_close(fh);
+	}
+	if (cache.image && !image_check()) {
+		mem_free(cache.image);
+		cache.image = NULL;
+		memset(cache.records, 0, sizeof(cache.records));
+	}
+}
+
+/**
+ * Stop using the cache, writing the image if any section had to be parsed
+ * and all of them could be stored
+ */
+void datacache_close(void)
+{
+	size_t i;
+	bool complete = !cache.failed;
+
+	if (!cache.open) return;
+	for (i = 0; i < N_ELEMENTS(sections); i++) {
+		if (!cache.states[i].stored) complete = false;
+		state_free(&cache.states[i]);
+	}
+	if (complete && cache.parsed) image_write();
+
+	mem_free(cache.image);
+	buffer_free(&cache.out);
+	memset(&cache, 0, sizeof(cache));
+}
+
+/**
+ * Load the section made by the parser of the given name from the image, if
+ * it is one the cache holds and the image has it.  If not, get ready to
+ * store it once it has been parsed.
+ *
+ * \return true if the section was loaded, so there is no need to parse it.
+ */
+bool datacache_load(const char *name)
+{
+	int index = section_find(name);
+	struct section_state *st;
+
+	if (!cache.open || index < 0) return false;
+	st = &cache.states[index];
+
+	if (cache.records[index] && !st->stored
+			&& section_load(&sections[index], cache.records[index],
+				cache.record_lens[index])) {
+		buffer_put_string(&cache.out, name);
+		buffer_put_u32(&cache.out, (uint32_t)cache.record_lens[index]);
+		buffer_put(&cache.out, cache.records[index], cache.record_lens[index]);
+		st->stored = true;
+		sections_loaded++;
+		return true;
+	}
+
+	section_begin(&sections[index], st);
+	return false;
+}
+
+/**
+ * Store the section made by the parser of the given name, which has just
+ * finished
+ */
+void datacache_save(const char *name)
+{
+	int index = section_find(name);
+	struct section_state *st;
+
+	if (!cache.open || index < 0) return;
+	st = &cache.states[index];
+	if (!st->begun || st->stored) return;
+
+	cache.parsed++;
+	if (section_save(&sections[index], st)) {
+		st->stored = true;
+	} else {
+		cache.failed = true;
+	}
+	state_free(st);
+}
+
+/**
+ * Get the number of sections the cache holds, and how many of them the last
+ * start loaded from the image.
+ */
+int datacache_sections(int *loaded)
+{
+	*loaded = sections_loaded;
+	return (int)N_ELEMENTS(sections);
+}
+
+/**
+ * Work out a digest of the tables the cached sections make as they are now,
+ * whether they were loaded or parsed; two starts with the same data files
+ * should have the same digest.
+ */
+uint64_t datacache_digest(void)
+{
+	uint64_t h = HASH_START;
+	size_t i, j;
+	int k;
+
+	for (i = 0; i < N_ELEMENTS(sections); i++) {
+		const struct cache_section *s = &sections[i];
+		size_t begins[MAX_ROOTS] = { 0 };
+		uint32_t roots[MAX_ROOTS];
+		struct pack pk;
+
+		memset(&pk, 0, sizeof(pk));
+		pk.digest = true;
+		pack_roots(&pk, s, begins, roots);
+		h = hash_u64(h, pk.failed);
+		for (j = 0; j < pk.n_blocks; j++) {
+			h = hash_u64(h, pk.blocks[j].size);
+		}
+		h = hash_bytes(h, pk.relocs, pk.n_relocs * sizeof(*pk.relocs));
+		h = hash_bytes(h, pk.data.data, pk.data.len);
+		pack_free(&pk);
+
+		for (k = 0; k < MAX_WATCHES && s->watches[k].global; k++) {
+			const struct cache_watch *w = &s->watches[k];
+			const uint8_t *data = global_get(w->global);
+
+			if (data) {
+				h = hash_masked(h, &layouts[w->layout], data,
+					w->count ? w->count() : 1);
+			}
+		}
+	}
+
+	for (i = 0; i < visuals_cycler_race_entries(); i++) {
+		const char *group, *cycle;
+
+		if (i < z_info->r_max
+				&& visuals_cycler_get_cycle_for_race(i, &group, &cycle)) {
+			h = hash_u64(h, i);
+			h = hash_bytes(h, group, strlen(group));
+			h = hash_bytes(h, cycle, strlen(cycle));
+		}
+	}
+
+	return h;
+}
@@ -0,0 +1,30 @@
+/**
+ * \file datacache.h
+ * \brief Keep the parsed game data tables in a binary image
+ *
+ * Copyright (c) 2026 StukovTTV
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+#ifndef INCLUDED_DATACACHE_H
+#define INCLUDED_DATACACHE_H
+
+#include "h-basic.h"
+
+void datacache_open(void);
+void datacache_close(void);
+bool datacache_load(const char *name);
+void datacache_save(const char *name);
+int datacache_sections(int *loaded);
+uint64_t datacache_digest(void);
+
+#endif /* INCLUDED_DATACACHE_H */
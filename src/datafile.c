@@ -20,6 +20,7 @@
  */
 
 #include "angband.h"
+#include "datacache.h"
 #include "datafile.h"
 #include "game-world.h"
 #include "init.h"
@@ -52,8 +53,12 @@ static void print_error(struct file_parser *fp, struct parser *p) {
 }
 
 errr run_parser(struct file_parser *fp) {
-	struct parser *p = fp->init();
+	struct parser *p;
 	errr r;
+	if (datacache_load(fp->name)) {
+		return 0;
+	}
+	p = fp->init();
 	if (!p) {
 		return PARSE_ERROR_GENERIC;
 	}
@@ -70,6 +75,7 @@ errr run_parser(struct file_parser *fp) {
 		event_signal(EVENT_MESSAGE_FLUSH);
 		quit_fmt("Parser finish error in %s.", fp->name);
 	}
+	datacache_save(fp->name);
 	return r;
 }
 
@@ -93,6 +99,9 @@ errr parse_file(struct parser *p, const char *filename) {
 	char path[1024];
 	char buf[1024];
 	ang_file *fh;
+	char *text;
+	const char *pos;
+	size_t len;
 	errr r = 0;
 
 	/* The player can put a customised file in the user directory */
@@ -111,13 +120,20 @@ errr parse_file(struct parser *p, const char *filename) {
 	if (!fh)
 		return PARSE_ERROR_NO_FILE_FOUND;
 
+	/* Read it in one go */
+	text = file_read_all(fh, &len);
+	file_close(fh);
+	if (!text)
+		return PARSE_ERROR_NO_FILE_FOUND;
+
 	/* Parse it */
-	while (file_getl(fh, buf, sizeof(buf))) {
+	pos = text;
+	while (text_getl(&pos, text + len, buf, sizeof(buf))) {
 		r = parser_parse(p, buf);
 		if (r)
 			break;
 	}
-	file_close(fh);
+	mem_free(text);
 	return r;
 }
 
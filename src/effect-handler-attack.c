@@ -22,6 +22,7 @@
 #include "init.h"
 #include "mon-desc.h"
 #include "mon-make.h"
+#include "mon-schedule.h"
 #include "mon-spell.h"
 #include "mon-util.h"
 #include "obj-desc.h"
@@ -1549,14 +1550,15 @@ bool effect_handler_DESTRUCTION(effect_handler_context_t *context)
 			if (k > r) continue;
 
 			/* Lose room and vault */
-			sqinfo_off(square(cave, grid)->info, SQUARE_ROOM);
-			sqinfo_off(square(cave, grid)->info, SQUARE_VAULT);
+			sqinfo_off(square(cave, grid).info, SQUARE_ROOM);
+			sqinfo_off(square(cave, grid).info, SQUARE_VAULT);
+			light_map_note_glow(cave);
 
 			/* Forget completely */
 			if (!square_isbright(cave, grid)) {
-				sqinfo_off(square(cave, grid)->info, SQUARE_GLOW);
+				square_unglow(cave, grid);
 			}
-			sqinfo_off(square(cave, grid)->info, SQUARE_SEEN);
+			sqinfo_off(square(cave, grid).info, SQUARE_SEEN);
 			square_forget(cave, grid);
 			square_light_spot(cave, grid);
 
@@ -1698,14 +1700,15 @@ bool effect_handler_EARTHQUAKE(effect_handler_context_t *context)
 			if (distance(centre, grid) > r) continue;
 
 			/* Lose room and vault */
-			sqinfo_off(square(cave, grid)->info, SQUARE_ROOM);
-			sqinfo_off(square(cave, grid)->info, SQUARE_VAULT);
+			sqinfo_off(square(cave, grid).info, SQUARE_ROOM);
+			sqinfo_off(square(cave, grid).info, SQUARE_VAULT);
+			light_map_note_glow(cave);
 
 			/* Forget completely */
 			if (!square_isbright(cave, grid)) {
-				sqinfo_off(square(cave, grid)->info, SQUARE_GLOW);
+				square_unglow(cave, grid);
 			}
-			sqinfo_off(square(cave, grid)->info, SQUARE_SEEN);
+			sqinfo_off(square(cave, grid).info, SQUARE_SEEN);
 			square_forget(cave, grid);
 			square_light_spot(cave, grid);
 
@@ -1825,7 +1828,7 @@ bool effect_handler_EARTHQUAKE(effect_handler_context_t *context)
 			if (!map[16 + grid.y - centre.y][16 + grid.x - centre.x]) continue;
 
 			/* Process monsters */
-			if (square(cave, grid)->mon > 0) {
+			if (square(cave, grid).mon > 0) {
 				struct monster *mon = square_monster(cave, grid);
 
 				/* Most monsters cannot co-exist with rock */
@@ -1871,6 +1874,7 @@ bool effect_handler_EARTHQUAKE(effect_handler_context_t *context)
 
 					/* Apply damage directly */
 					mon->hp -= m_dam;
+					monster_schedule_update(cave, mon);
 
 					if (mon->hp < 0) {
 						if (display_dam) {
@@ -2024,8 +2028,10 @@ bool effect_handler_ENERGY_DRAIN(effect_handler_context_t *context)
 			if (!mon) continue;
 
 			/* Take the energy */
+			monster_schedule_sync(cave, mon);
 			player->energy += mon->energy;
 			mon->energy = 0;
+			monster_schedule_update(cave, mon);
 		}
 	}
 
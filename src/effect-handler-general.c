@@ -148,7 +148,7 @@ static bool has_teleport_destination_prereqs(struct chunk *c, struct loc grid,
 			return false;
 		}
 	}
-	if (square(c, grid)->mon
+	if (square(c, grid).mon
 			|| square_isdamaging(c, grid)
 			|| square_isfall(c, grid)
 			|| square_iswebbed(c, grid)
@@ -1334,6 +1334,7 @@ bool effect_handler_MAP_AREA(effect_handler_context_t *context)
 
 	/* Fully update the visuals */
 	player->upkeep->update |= (PU_UPDATE_VIEW | PU_MONSTERS);
+	map_cache_forget_all(cave);
 
 	/* Redraw whole map, monster list */
 	player->upkeep->redraw |= (PR_MAP | PR_MONLIST | PR_ITEMLIST);
@@ -1446,7 +1447,7 @@ bool effect_handler_DETECT_TRAPS(effect_handler_context_t *context)
 				}
 			}
 			/* Mark as trap-detected */
-			sqinfo_on(square(cave, loc(x, y))->info, SQUARE_DTRAP);
+			sqinfo_on(square(cave, loc(x, y)).info, SQUARE_DTRAP);
 		}
 	}
 
@@ -1643,6 +1644,72 @@ bool effect_handler_DETECT_ORE(effect_handler_context_t *context)
 	return true;
 }
 
+struct object_search {
+	bool (*pred)(const struct object*);
+	const struct object_kind *unknown_kind;
+	cave_index_visitor visit;
+	bool found;
+};
+
+/**
+ * Visit a grid with remembered objects but no actual objects
+ */
+static bool visit_remembered_pile(struct chunk *c, struct loc grid,
+		void *data)
+{
+	struct object_search *search = data;
+
+	/* Grids with objects have been visited already */
+	if (square_object(cave, grid)) return true;
+	return search->visit(cave, grid, search);
+}
+
+/**
+ * Visit the grids within context->y of the player in y and context->x of
+ * the player in x which hold objects or which the player remembers as
+ * holding objects; those are the only grids where sensing or detecting
+ * objects has anything to do.
+ */
+static void search_object_grids(effect_handler_context_t *context,
+		struct object_search *search)
+{
+	struct loc top_left = loc(player->grid.x - context->x,
+		player->grid.y - context->y);
+	struct loc bottom_right = loc(player->grid.x + context->x,
+		player->grid.y + context->y);
+
+	cave_index_box(cave, CAVE_INDEX_OBJ, top_left, bottom_right,
+		search->visit, search);
+	cave_index_box(player->cave, CAVE_INDEX_OBJ, top_left, bottom_right,
+		visit_remembered_pile, search);
+}
+
+/**
+ * Sense the objects at a grid for sense_stuff()
+ */
+static bool sense_pile_at(struct chunk *c, struct loc grid, void *data)
+{
+	struct object_search *search = data;
+	struct object *obj = square_object(c, grid);
+
+	for (; !search->found && obj; obj = obj->next) {
+		if ((*search->pred)(obj)
+				&& (!obj->known
+				|| obj->known->kind == search->unknown_kind
+				|| !ignore_item_ok(player, obj))) {
+			search->found = true;
+		}
+	}
+
+	/*
+	 * Become aware of the parts of the pile that match
+	 * the predicate.  Forget remembered parts that match
+	 * the predicate which are no longer there.
+	 */
+	square_sense_pile(c, grid, search->pred);
+	return true;
+}
+
 /**
  * Help effect_handler_SENSE_GOLD() or effect_handler_SENSE_OBJECTS(): sense
  * objects of a given class about the player.  The range of detection in y
@@ -1653,47 +1720,38 @@ static bool sense_stuff(effect_handler_context_t *context,
 		bool (*pred)(const struct object*),
 		const struct object_kind *unknown_kind)
 {
-	int x, y;
-	int x1, x2, y1, y2;
-
-	bool have_stuff = false;
+	struct object_search search = { pred, unknown_kind, sense_pile_at,
+		false };
 
-	/* Pick an area to sense */
-	y1 = player->grid.y - context->y;
-	y2 = player->grid.y + context->y;
-	x1 = player->grid.x - context->x;
-	x2 = player->grid.x + context->x;
-
-	if (y1 < 0) y1 = 0;
-	if (x1 < 0) x1 = 0;
-	if (y2 > cave->height - 1) y2 = cave->height - 1;
-	if (x2 > cave->width - 1) x2 = cave->width - 1;
+	search_object_grids(context, &search);
+	return search.found;
+}
 
-	/* Scan the area */
-	for (y = y1; y <= y2; y++) {
-		for (x = x1; x <= x2; x++) {
-			struct loc grid = loc(x, y);
-			struct object *obj = square_object(cave, grid);
-
-			for (; !have_stuff && obj; obj = obj->next) {
-				if ((*pred)(obj)
-						&& (!obj->known
-						|| obj->known->kind == unknown_kind
-						|| !ignore_item_ok(player, obj))) {
-					have_stuff = true;
-				}
-			}
+/**
+ * Detect the objects at a grid for detect_stuff()
+ */
+static bool detect_pile_at(struct chunk *c, struct loc grid, void *data)
+{
+	struct object_search *search = data;
+	struct object *obj = square_object(c, grid);
 
-			/*
-			 * Become aware of the parts of the pile that match
-			 * the predicate.  Forget remembered parts that match
-			 * the predicate which are no longer there.
-			 */
-			square_sense_pile(cave, grid, pred);
+	/*
+	 * Is there any object matching the predicate which is
+	 * not ignored?
+	 */
+	for (; !search->found && obj; obj = obj->next) {
+		if ((*search->pred)(obj) && !ignore_item_ok(player, obj)) {
+			search->found = true;
 		}
 	}
 
-	return have_stuff;
+	/*
+	 * Mark the parts of the pile that match the predicate
+	 * as seen.  Forget remembered parts that match the
+	 * predicate which are no longer there.
+	 */
+	square_know_pile(c, grid, search->pred);
+	return true;
 }
 
 /**
@@ -1705,48 +1763,10 @@ static bool sense_stuff(effect_handler_context_t *context,
 static bool detect_stuff(effect_handler_context_t *context,
 		bool (*pred)(const struct object*))
 {
-	int x, y;
-	int x1, x2, y1, y2;
-
-	bool have_stuff = false;
+	struct object_search search = { pred, NULL, detect_pile_at, false };
 
-	/* Pick an area to detect */
-	y1 = player->grid.y - context->y;
-	y2 = player->grid.y + context->y;
-	x1 = player->grid.x - context->x;
-	x2 = player->grid.x + context->x;
-
-	if (y1 < 0) y1 = 0;
-	if (x1 < 0) x1 = 0;
-	if (y2 > cave->height - 1) y2 = cave->height - 1;
-	if (x2 > cave->width - 1) x2 = cave->width - 1;
-
-	/* Scan the area */
-	for (y = y1; y <= y2; y++) {
-		for (x = x1; x <= x2; x++) {
-			struct loc grid = loc(x, y);
-			struct object *obj = square_object(cave, grid);
-
-			/*
-			 * Is there any object matching the predicate which is
-			 * not ignored?
-			 */
-			for (; !have_stuff && obj; obj = obj->next) {
-				if ((*pred)(obj) && !ignore_item_ok(player, obj)) {
-					have_stuff = true;
-				}
-			}
-
-			/*
-			 * Mark the parts of the pile that match the predicate
-			 * as seen.  Forget remembered parts that match the
-			 * predicate which are no longer there.
-			 */
-			square_know_pile(cave, grid, pred);
-		}
-	}
-
-	return have_stuff;
+	search_object_grids(context, &search);
+	return search.found;
 }
 
 /**
@@ -1833,69 +1853,61 @@ bool effect_handler_DETECT_OBJECTS(effect_handler_context_t *context)
 	return true;
 }
 
+struct monster_detection {
+	monster_predicate pred;
+	bool found;
+};
+
 /**
- * Detect monsters which satisfy the given predicate around the player.
- * The height to detect above and below the player is y_dist,
- * the width either side of the player x_dist.
+ * Detect the monster at a grid if it satisfies the predicate and is obvious
  */
-static bool detect_monsters(int y_dist, int x_dist, monster_predicate pred)
+static bool detect_monster_at(struct chunk *c, struct loc grid, void *data)
 {
-	int i, x, y;
-	int x1, x2, y1, y2;
-
-	bool monsters = false;
+	struct monster_detection *detect = data;
+	struct monster *mon = square_monster(c, grid);
 
-	/* Set the detection area */
-	y1 = player->grid.y - y_dist;
-	y2 = player->grid.y + y_dist;
-	x1 = player->grid.x - x_dist;
-	x2 = player->grid.x + x_dist;
+	/* Detect all appropriate, obvious monsters */
+	if (detect->pred(mon) && !monster_is_camouflaged(mon)) {
+		/* Detect the monster */
+		mflag_on(mon->mflag, MFLAG_MARK);
+		mflag_on(mon->mflag, MFLAG_SHOW);
 
-	if (y1 < 0) y1 = 0;
-	if (x1 < 0) x1 = 0;
-	if (y2 > cave->height - 1) y2 = cave->height - 1;
-	if (x2 > cave->width - 1) x2 = cave->width - 1;
-
-	/* Scan monsters */
-	for (i = 1; i < cave_monster_max(cave); i++) {
-		struct monster *mon = cave_monster(cave, i);
-
-		/* Skip dead monsters */
-		if (!mon->race) continue;
-
-		/* Location */
-		y = mon->grid.y;
-		x = mon->grid.x;
-
-		/* Only detect nearby monsters */
-		if (x < x1 || y < y1 || x > x2 || y > y2) continue;
+		/* Note invisible monsters */
+		if (monster_is_invisible(mon)) {
+			struct monster_lore *lore = get_lore(mon->race);
+			rf_on(lore->flags, RF_INVISIBLE);
+		}
 
-		/* Detect all appropriate, obvious monsters */
-		if (pred(mon) && !monster_is_camouflaged(mon)) {
-			/* Detect the monster */
-			mflag_on(mon->mflag, MFLAG_MARK);
-			mflag_on(mon->mflag, MFLAG_SHOW);
+		/* Update monster recall window */
+		if (player->upkeep->monster_race == mon->race)
+			/* Redraw stuff */
+			player->upkeep->redraw |= (PR_MONSTER);
 
-			/* Note invisible monsters */
-			if (monster_is_invisible(mon)) {
-				struct monster_lore *lore = get_lore(mon->race);
-				rf_on(lore->flags, RF_INVISIBLE);
-			}
+		/* Update the monster */
+		update_mon(mon, c, false);
 
-			/* Update monster recall window */
-			if (player->upkeep->monster_race == mon->race)
-				/* Redraw stuff */
-				player->upkeep->redraw |= (PR_MONSTER);
+		/* Detect */
+		detect->found = true;
+	}
+	return true;
+}
 
-			/* Update the monster */
-			update_mon(mon, cave, false);
+/**
+ * Detect monsters which satisfy the given predicate around the player.
+ * The height to detect above and below the player is y_dist,
+ * the width either side of the player x_dist.
+ */
+static bool detect_monsters(int y_dist, int x_dist, monster_predicate pred)
+{
+	struct monster_detection detect = { pred, false };
 
-			/* Detect */
-			monsters = true;
-		}
-	}
+	/* Only the grids with monsters in the detection area */
+	cave_index_box(cave, CAVE_INDEX_MON,
+		loc(player->grid.x - x_dist, player->grid.y - y_dist),
+		loc(player->grid.x + x_dist, player->grid.y + y_dist),
+		detect_monster_at, &detect);
 
-	return monsters;
+	return detect.found;
 }
 
 /**
@@ -2800,7 +2812,7 @@ bool effect_handler_TELEPORT(effect_handler_context_t *context)
 	}
 
 	/* Clear any projection marker to prevent double processing */
-	sqinfo_off(square(cave, spots->grid)->info, SQUARE_PROJECT);
+	sqinfo_off(square(cave, spots->grid).info, SQUARE_PROJECT);
 
 	/* Clear monster target if it's no longer visible */
 	if (!target_able(target_get_monster())) {
@@ -2958,7 +2970,7 @@ bool effect_handler_TELEPORT_TO(effect_handler_context_t *context)
 	}
 
 	/* Clear any projection marker to prevent double processing */
-	sqinfo_off(square(cave, land)->info, SQUARE_PROJECT);
+	sqinfo_off(square(cave, land).info, SQUARE_PROJECT);
 
 	/* Lots of updates after monster_swap() */
 	handle_stuff(player);
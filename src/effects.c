@@ -28,6 +28,7 @@
 #include "player-util.h"
 #include "project.h"
 #include "trap.h"
+#include "z-names.h"
 
 
 /**
@@ -116,10 +117,39 @@ const char *effect_desc(const struct effect *effect)
 	return effects[effect->index].desc;
 }
 
+/**
+ * Index of effect names, made before the data files are read
+ */
+static struct name_index *effect_name_index;
+
+void effect_name_index_build(void)
+{
+	size_t i;
+
+	name_index_free(effect_name_index);
+	effect_name_index = name_index_new(false);
+	for (i = 0; i < N_ELEMENTS(effect_names); i++) {
+		if (effect_names[i])
+			name_index_add(effect_name_index, effect_names[i], (int)i);
+	}
+}
+
+void effect_name_index_free(void)
+{
+	name_index_free(effect_name_index);
+	effect_name_index = NULL;
+}
+
 effect_index effect_lookup(const char *name)
 {
 	size_t i;
 
+	if (effect_name_index) {
+		int found = name_index_find(effect_name_index, name);
+
+		return (found >= 0) ? (effect_index)found : EF_MAX;
+	}
+
 	for (i = 0; i < N_ELEMENTS(effect_names); i++) {
 		const char *effect_name = effect_names[i];
 
@@ -367,23 +397,24 @@ static int32_t effect_value_base_trap_power(void)
 	return 3 + randint1(n) + n / 2;
 }
 
+static const struct value_base_s {
+	const char *name;
+	expression_base_value_f function;
+} value_bases[] = {
+	{ "SPELL_POWER", effect_value_base_spell_power },
+	{ "PLAYER_LEVEL", effect_value_base_player_level },
+	{ "DUNGEON_LEVEL", effect_value_base_dungeon_level },
+	{ "MAX_SIGHT", effect_value_base_max_sight },
+	{ "WEAPON_DAMAGE", effect_value_base_weapon_damage },
+	{ "PLAYER_HP", effect_value_base_player_hp },
+	{ "MONSTER_PERCENT_HP_GONE",
+	  effect_value_base_monster_percent_hp_gone },
+	{ "TRAP_POWER", effect_value_base_trap_power },
+	{ NULL, NULL },
+};
+
 expression_base_value_f effect_value_base_by_name(const char *name)
 {
-	static const struct value_base_s {
-		const char *name;
-		expression_base_value_f function;
-	} value_bases[] = {
-		{ "SPELL_POWER", effect_value_base_spell_power },
-		{ "PLAYER_LEVEL", effect_value_base_player_level },
-		{ "DUNGEON_LEVEL", effect_value_base_dungeon_level },
-		{ "MAX_SIGHT", effect_value_base_max_sight },
-		{ "WEAPON_DAMAGE", effect_value_base_weapon_damage },
-		{ "PLAYER_HP", effect_value_base_player_hp },
-		{ "MONSTER_PERCENT_HP_GONE",
-		  effect_value_base_monster_percent_hp_gone },
-		{ "TRAP_POWER", effect_value_base_trap_power },
-		{ NULL, NULL },
-	};
 	const struct value_base_s *current = value_bases;
 
 	while (current->name != NULL && current->function != NULL) {
@@ -396,6 +427,24 @@ expression_base_value_f effect_value_base_by_name(const char *name)
 	return NULL;
 }
 
+/**
+ * Get the name effect_value_base_by_name() knows a base value function by,
+ * or NULL if it is not one of them.
+ */
+const char *effect_value_base_name(expression_base_value_f function)
+{
+	const struct value_base_s *current = value_bases;
+
+	while (current->name != NULL && current->function != NULL) {
+		if (current->function == function)
+			return current->name;
+
+		current++;
+	}
+
+	return NULL;
+}
+
 /**
  * ------------------------------------------------------------------------
  * Execution of effects
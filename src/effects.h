@@ -42,10 +42,13 @@ bool effect_valid(const struct effect *effect);
 bool effect_aim(const struct effect *effect);
 const char *effect_info(const struct effect *effect);
 const char *effect_desc(const struct effect *effect);
+void effect_name_index_build(void);
+void effect_name_index_free(void);
 effect_index effect_lookup(const char *name);
 bool effect_equal(struct effect *effect1, struct effect *effect2);
 int effect_subtype(int index, const char *type);
 extern expression_base_value_f effect_value_base_by_name(const char *name);
+extern const char *effect_value_base_name(expression_base_value_f function);
 bool effect_do(struct effect *effect,
 	struct source origin,
 	struct object *obj,
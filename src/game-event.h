@@ -74,6 +74,7 @@ typedef enum game_event_type
 	EVENT_COMMAND_REPEAT,
 	EVENT_ANIMATE,
 	EVENT_CHEAT_DEATH,
+	EVENT_SAVEFILE_DONE,	/* has flag in event data indicating success */
 
 	EVENT_INITSTATUS,	/* New status message for initialisation */
 	EVENT_BIRTHPOINTS,	/* Change in the birth points */
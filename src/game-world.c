@@ -34,9 +34,11 @@
 #include "player-calcs.h"
 #include "player-timed.h"
 #include "player-util.h"
+#include "savefile.h"
 #include "source.h"
 #include "target.h"
 #include "trap.h"
+#include "z-names.h"
 
 uint16_t daycount = 0;
 uint32_t seed_randart;		/* Hack -- consistent random artifacts */
@@ -151,6 +153,11 @@ char *level_name(struct level *lev)
 struct level *level_by_name(struct level_map *map, const char *name)
 {
 	int i;
+	if (!name) return NULL;
+	if (map->level_names) {
+		i = name_index_find(map->level_names, name);
+		return (i >= 0) ? &map->levels[i] : NULL;
+	}
 	for (i = 0; i < map->num_levels; i++) {
 		struct level *lev = &map->levels[i];
 		if (streq(name, level_name(lev))) {
@@ -817,7 +824,7 @@ void process_world(struct chunk *c)
 
 	/* Update noise and scent (not if resting) */
 	if (!player_is_resting(player)) {
-		make_noise(cave, player, NULL);
+		make_noise(cave, player);
 		update_scent(cave, player, NULL);
 	}
 
@@ -841,18 +848,23 @@ void process_world(struct chunk *c)
 	if (!(turn % 100))
 		equip_learn_after_time(player);
 
-	/* Decrease trap timeouts */
-	for (y = 0; y < c->height; y++) {
-		for (x = 0; x < c->width; x++) {
-			struct loc grid = loc(x, y);
-			struct trap *trap = square(c, grid)->trap;
-			while (trap) {
-				if (trap->timeout) {
-					trap->timeout--;
-					if (!trap->timeout)
-						square_light_spot(c, grid);
+	/* Decrease trap timeouts, counting the traps still timing out */
+	if (c->timed_traps) {
+		c->timed_traps = 0;
+		for (y = 0; y < c->height; y++) {
+			for (x = 0; x < c->width; x++) {
+				struct loc grid = loc(x, y);
+				struct trap *trap = square(c, grid).trap;
+				while (trap) {
+					if (trap->timeout) {
+						trap->timeout--;
+						if (!trap->timeout)
+							square_light_spot(c, grid);
+						else
+							c->timed_traps++;
+					}
+					trap = trap->next;
 				}
-				trap = trap->next;
 			}
 		}
 	}
@@ -1008,6 +1020,25 @@ static void process_player_cleanup(void)
 }
 
 
+/**
+ * Bring the game up to date with what has happened, and show it to the player.
+ *
+ * While the player is resting only the game is brought up to date; redraws
+ * pile up until the rest stops, by finishing or by being disturbed, and the
+ * first refresh after that shows the lot at once.  Running is shown step by
+ * step, since the map may scroll to a new panel on any step.
+ */
+static void refresh_stuff(void)
+{
+	notice_stuff(player);
+	if (player_is_resting(player)) {
+		update_stuff(player);
+		return;
+	}
+	handle_stuff(player);
+	event_signal(EVENT_REFRESH);
+}
+
 /**
  * Process player commands from the command queue, finishing when there is a
  * command using energy (any regular game command), or we run out of commands
@@ -1033,9 +1064,7 @@ void process_player(void)
 	/* Repeat until energy is reduced */
 	do {
 		/* Refresh */
-		notice_stuff(player);
-		handle_stuff(player);
-		event_signal(EVENT_REFRESH);
+		refresh_stuff();
 
 		/* Hack -- Pack Overflow */
 		pack_overflow(NULL);
@@ -1071,7 +1100,8 @@ void process_player(void)
 				player->upkeep->redraw |= (PR_MONSTER);
 
 			/* Place cursor on player/target */
-			event_signal(EVENT_REFRESH);
+			if (!player_is_resting(player))
+				event_signal(EVENT_REFRESH);
 		}
 
 		/* Get a command from the queue if there is one */
@@ -1188,6 +1218,9 @@ void run_game_loop(void)
 	/* Tidy up after the player's command */
 	process_player_cleanup();
 
+	/* Hear about any save in the background that is done */
+	savefile_save_poll();
+
 	/* Keep processing the player until they use some energy or
 	 * another command is needed */
 	while (player->upkeep->playing) {
@@ -1201,8 +1234,9 @@ void run_game_loop(void)
 	/* The player may still have enough energy to move, so we run another
 	 * player turn before processing the rest of the world */
 	while (player->energy >= z_info->move_energy) {
-		/* Do any necessary animations */
-		event_signal(EVENT_ANIMATE);
+		/* Do any necessary animations, unless resting through turns */
+		if (!player_is_resting(player))
+			event_signal(EVENT_ANIMATE);
 		
 		/* Process monster with even more energy first */
 		process_monsters(player->energy + 1);
@@ -1223,9 +1257,7 @@ void run_game_loop(void)
 	/* Now that the player's turn is fully complete, we run the main loop 
 	 * until player input is needed again */
 	while (true) {
-		notice_stuff(player);
-		handle_stuff(player);
-		event_signal(EVENT_REFRESH);
+		refresh_stuff();
 
 		/* Process the rest of the world, give the player energy and 
 		 * increment the turn counter unless we need to stop playing or
@@ -1240,9 +1272,7 @@ void run_game_loop(void)
 			reset_monsters();
 
 			/* Refresh */
-			notice_stuff(player);
-			handle_stuff(player);
-			event_signal(EVENT_REFRESH);
+			refresh_stuff();
 			if (player->is_dead || !player->upkeep->playing)
 				return;
 
@@ -1251,9 +1281,7 @@ void run_game_loop(void)
 				process_world(cave);
 
 				/* Refresh */
-				notice_stuff(player);
-				handle_stuff(player);
-				event_signal(EVENT_REFRESH);
+				refresh_stuff();
 				if (player->is_dead || !player->upkeep->playing)
 					return;
 			}
@@ -1290,8 +1318,9 @@ void run_game_loop(void)
 		/* If the player has enough energy to move they now do so, after
 		 * any monsters with more energy take their turns */
 		while (player->energy >= z_info->move_energy) {
-			/* Do any necessary animations */
-			event_signal(EVENT_ANIMATE);
+			/* Do any necessary animations, unless resting through turns */
+			if (!player_is_resting(player))
+				event_signal(EVENT_ANIMATE);
 
 			/* Process monster with even more energy first */
 			process_monsters(player->energy + 1);
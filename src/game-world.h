@@ -63,6 +63,7 @@ struct level_map {
 	int num_towns;
 	struct level *levels;
 	struct town *towns;
+	struct name_index *level_names;	/* Levels by name, while world.txt is read */
 	struct level_map *next;
 };
 
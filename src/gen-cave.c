@@ -88,8 +88,8 @@
 static bool square_is_granite_with_flag(struct chunk *c, struct loc grid,
 										int flag)
 {
-	if (square(c, grid)->feat != FEAT_GRANITE) return false;
-	if (!sqinfo_has(square(c, grid)->info, flag)) return false;
+	if (square(c, grid).feat != FEAT_GRANITE) return false;
+	if (!sqinfo_has(square(c, grid).info, flag)) return false;
 
 	return true;
 }
@@ -549,7 +549,7 @@ static void build_tunnel(struct chunk *c, struct loc grid1, struct loc grid2)
 
 		/* Avoid obstacles */
 		if ((square_isperm(c, tmp_grid) && !sqinfo_has(square(c,
-				tmp_grid)->info, SQUARE_WALL_INNER)) ||
+				tmp_grid).info, SQUARE_WALL_INNER)) ||
 				square_is_granite_with_flag(c, tmp_grid,
 				SQUARE_WALL_SOLID)) {
 			continue;
@@ -1386,7 +1386,7 @@ static struct chunk *labyrinth_chunk(struct player *p, int h, int w, bool lit,
 {
 	int i, j, k;
 	struct loc grid;
-	int *find_state;
+	struct cave_find_state *find_state;
 
 	/* This is the number of squares in the labyrinth */
 	int n = h * w;
@@ -1432,7 +1432,7 @@ static struct chunk *labyrinth_chunk(struct player *p, int h, int w, bool lit,
 			struct loc diag = next_grid(grid, DIR_SE);
 			sets[k_local] = k_local;
 			square_set_feat(c, diag, FEAT_FLOOR);
-			if (lit) sqinfo_on(square(c, diag)->info, SQUARE_GLOW);
+			if (lit) sqinfo_on(square(c, diag).info, SQUARE_GLOW);
 		}
 	}
 
@@ -1463,7 +1463,7 @@ static struct chunk *labyrinth_chunk(struct player *p, int h, int w, bool lit,
 			int sb = sets[b];
 			square_set_feat(c, next_grid(grid, DIR_SE), FEAT_FLOOR);
 			if (lit) {
-				sqinfo_on(square(c, next_grid(grid, DIR_SE))->info, SQUARE_GLOW);
+				sqinfo_on(square(c, next_grid(grid, DIR_SE)).info, SQUARE_GLOW);
 			}
 			for (k = 0; k < n; k++) {
 				if (sets[k] == sb) sets[k] = sa;
@@ -1485,7 +1485,7 @@ static struct chunk *labyrinth_chunk(struct player *p, int h, int w, bool lit,
 			--i;
 		}
 	}
-	mem_free(find_state);
+	cave_find_free(find_state);
 
 	/* Unlit labyrinths will have some good items */
 	if (!lit)
@@ -1705,14 +1705,14 @@ static void mutate_cavern(struct chunk *c) {
 			if (square_isstairs(c, grid) ||
 					square_isperm(c, grid)) {
 				temp[grid_to_i(grid, w)] =
-					square(c, grid)->feat;
+					square(c, grid).feat;
 			} else if (count > 5) {
 				temp[grid_to_i(grid, w)] = FEAT_GRANITE;
 			} else if (count < 4) {
 				temp[grid_to_i(grid, w)] = FEAT_FLOOR;
 			} else {
 				temp[grid_to_i(grid, w)] =
-					square(c, grid)->feat;
+					square(c, grid).feat;
 			}
 		}
 	}
@@ -2299,7 +2299,7 @@ static bool lot_has_shop(struct chunk *c, struct loc xroads, struct loc lot,
 
 	for (probe.x = nw_corner.x; probe.x <= se_corner.x; probe.x++) {
 		for (probe.y = nw_corner.y; probe.y <= se_corner.y; probe.y++) {
-			if (feat_is_shop(square(c, probe)->feat)) {
+			if (feat_is_shop(square(c, probe).feat)) {
 				return true;
 			}
 		}
@@ -2659,7 +2659,7 @@ static void town_gen_layout(struct chunk *c, struct player *p, struct town *t)
 		/* Turn off room illumination flag */
 		for (grid.y = 1; grid.y < c->height - 1; grid.y++) {
 			for (grid.x = 1; grid.x < c->width - 1; grid.x++) {
-				sqinfo_off(square(c, grid)->info, SQUARE_ROOM);
+				sqinfo_off(square(c, grid).info, SQUARE_ROOM);
 				if (!square_isperm(c, grid) && !square_isfiery(c, grid) &&
 					!square_isfloor(c, grid)) {
 					square_set_feat(c, grid, FEAT_PERM);
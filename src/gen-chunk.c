@@ -19,6 +19,11 @@
  * at any time.  The initial example of this is the town, which is saved
  * immediately after generation and restored when the player returns there.
  *
+ * Chunks in the list other than the one being worked on are kept packed in
+ * their savefile form, and unpacked when chunk_find_name() looks for them.
+ * If the packed chunks outgrow z_info->level_memory, the least recently used
+ * are written out to files in the user directory until they are next needed.
+ *
  * The copying routines are also useful for generating a level in pieces and
  * then copying those pieces into the actual level chunk.
  */
@@ -30,13 +35,20 @@
 #include "init.h"
 #include "mon-group.h"
 #include "mon-make.h"
+#include "obj-pile.h"
 #include "obj-util.h"
+#include "player.h"
+#include "savefile.h"
 #include "trap.h"
 
 #define CHUNK_LIST_INCR 10
 struct chunk **chunk_list;     /**< list of pointers to saved chunks */
 uint16_t chunk_list_max = 0;   /**< current max actual chunk index */
 
+static uint32_t chunk_uses = 0;	/**< Clock for packed chunk last_use */
+static uint32_t packed_bytes = 0;	/**< Packed chunk data held in memory */
+static uint32_t spill_count = 0;	/**< Serial number for spill files */
+
 /**
  * Write the terrain info of a chunk to memory and return a pointer to it
  *
@@ -45,18 +57,13 @@ uint16_t chunk_list_max = 0;   /**< current max actual chunk index */
  */
 struct chunk *chunk_write(struct chunk *c)
 {
-	int x, y;
-
 	struct chunk *new = cave_new(c->height, c->width);
+	int n = c->height * c->width;
 
 	/* Write the location stuff */
-	for (y = 0; y < new->height; y++) {
-		for (x = 0; x < new->width; x++) {
-			/* Terrain */
-			new->squares[y][x].feat = square(c, loc(x, y))->feat;
-			sqinfo_copy(square(new, loc(x, y))->info, square(c, loc(x, y))->info);
-		}
-	}
+	memcpy(new->sq_feat, c->sq_feat, n * sizeof(*c->sq_feat));
+	memcpy(new->sq_props, c->sq_props, n * sizeof(*c->sq_props));
+	memcpy(new->sq_info, c->sq_info, n * SQUARE_SIZE * sizeof(*c->sq_info));
 
 	return new;
 }
@@ -107,7 +114,281 @@ bool chunk_list_remove(const char *name)
 }
 
 /**
- * Find a chunk by name
+ * Free the objects held by the monsters of a chunk and their groups, which
+ * cave_free() leaves alone.  Unlike wipe_mon_list(), this keeps the monsters
+ * counted and their artifacts created, as the monsters live on in the packed
+ * chunk.
+ */
+static void chunk_free_monster_data(struct chunk *c)
+{
+	int i;
+
+	for (i = 1; i < cave_monster_max(c); i++) {
+		struct monster *mon = cave_monster(c, i);
+
+		if (!mon->race || !mon->held_obj) continue;
+		object_pile_free(c, NULL, mon->held_obj);
+		mon->held_obj = NULL;
+	}
+	for (i = 1; i < z_info->level_monster_max; i++) {
+		if (c->monster_groups[i]) {
+			monster_group_free(c, c->monster_groups[i]);
+		}
+	}
+}
+
+/**
+ * Pack a chunk in the chunk list into its savefile form and free the rest of
+ * it, keeping only what is needed to find it and join levels to it
+ * \param idx the index of the chunk in the chunk list
+ */
+static void chunk_pack(int idx)
+{
+	struct chunk *c = chunk_list[idx];
+	struct chunk *stored = mem_zalloc(sizeof(*stored));
+	struct packed_chunk *packed = mem_zalloc(sizeof(*packed));
+
+	packed->data = savefile_pack_chunk(c, &packed->size);
+	packed->last_use = ++chunk_uses;
+	packed_bytes += packed->size;
+
+	stored->name = c->name;
+	stored->turn = c->turn;
+	stored->depth = c->depth;
+	stored->place = c->place;
+	stored->feeling = c->feeling;
+	stored->obj_rating = c->obj_rating;
+	stored->mon_rating = c->mon_rating;
+	stored->good_item = c->good_item;
+	stored->height = c->height;
+	stored->width = c->width;
+	stored->feeling_squares = c->feeling_squares;
+	stored->decoy = c->decoy;
+	stored->join = c->join;
+	stored->packed = packed;
+	c->name = NULL;
+	c->join = NULL;
+
+	chunk_free_monster_data(c);
+	cave_free(c);
+	chunk_list[idx] = stored;
+}
+
+/**
+ * Read the data of a spilled chunk back from its file
+ * \param packed the packed chunk
+ * \param data where to put the data, with room for packed->size bytes
+ * \return whether the whole of the data was read
+ */
+static bool chunk_read_spill(const struct packed_chunk *packed, uint8_t *data)
+{
+	ang_file *f = file_open(packed->spill, MODE_READ, FTYPE_RAW);
+	int n;
+
+	if (!f) return false;
+	n = file_read(f, (char *) data, packed->size);
+	file_close(f);
+	return n == (int) packed->size;
+}
+
+/**
+ * Write the data of a packed chunk out to a file and free it
+ * \param packed the packed chunk
+ * \return whether the data was written
+ */
+static bool chunk_spill(struct packed_chunk *packed)
+{
+	char safe[40], leaf[64], path[1024];
+	ang_file *f;
+	bool written;
+
+	player_safe_name(safe, sizeof(safe), player->full_name, false);
+	strnfmt(leaf, sizeof(leaf), "%s.lv%u", safe, ++spill_count);
+	path_build(path, sizeof(path), ANGBAND_DIR_USER, leaf);
+	f = file_open(path, MODE_WRITE, FTYPE_RAW);
+	if (!f) return false;
+	written = file_write(f, (const char *) packed->data, packed->size);
+	file_close(f);
+	if (!written) {
+		file_delete(path);
+		return false;
+	}
+
+	packed->spill = string_make(path);
+	mem_free(packed->data);
+	packed->data = NULL;
+	packed_bytes -= packed->size;
+	return true;
+}
+
+/**
+ * Spill the least recently used packed chunks to disk until the ones left in
+ * memory fit in z_info->level_memory kilobytes, if that is set
+ */
+static void chunk_list_trim(void)
+{
+	uint32_t budget = z_info->level_memory * 1024;
+
+	if (!budget) return;
+	while (packed_bytes > budget) {
+		struct packed_chunk *oldest = NULL;
+		int i;
+
+		for (i = 0; i < chunk_list_max; i++) {
+			struct packed_chunk *packed = chunk_list[i]->packed;
+
+			if (!packed || !packed->data) continue;
+			if (!oldest || packed->last_use < oldest->last_use) {
+				oldest = packed;
+			}
+		}
+		if (!oldest || !chunk_spill(oldest)) break;
+	}
+}
+
+/**
+ * Free a packed chunk, deleting its spill file if it has one
+ */
+static void chunk_packed_free(struct chunk *stored)
+{
+	struct packed_chunk *packed = stored->packed;
+
+	if (packed->data) {
+		packed_bytes -= packed->size;
+		mem_free(packed->data);
+	}
+	if (packed->spill) {
+		file_delete(packed->spill);
+		string_free(packed->spill);
+	}
+	mem_free(packed);
+	cave_connectors_free(stored->join);
+	string_free(stored->name);
+	mem_free(stored);
+}
+
+/**
+ * Unpack a packed chunk in the chunk list
+ * \param idx the index of the chunk in the chunk list
+ * \return the unpacked chunk, which replaces the packed one in the list
+ */
+static struct chunk *chunk_unpack(int idx)
+{
+	struct chunk *stored = chunk_list[idx], *c;
+	struct packed_chunk *packed = stored->packed;
+	int *cur_num = mem_alloc(z_info->r_max * sizeof(*cur_num));
+	int i;
+
+	if (!packed->data) {
+		uint8_t *data = mem_alloc(packed->size);
+
+		if (!chunk_read_spill(packed, data)) {
+			quit_fmt("Could not read back stored level %s from %s",
+				stored->name, packed->spill);
+		}
+		packed->data = data;
+		packed_bytes += packed->size;
+	}
+
+	/*
+	 * The monsters never left the world, so the racial counts (including
+	 * that of a player ghost, which gets set up again) should stay as
+	 * they are
+	 */
+	for (i = 0; i < z_info->r_max; i++) {
+		cur_num[i] = r_info[i].cur_num;
+	}
+	c = savefile_unpack_chunk(packed->data, packed->size);
+	if (!c) {
+		quit_fmt("Could not unpack stored level %s", stored->name);
+	}
+	for (i = 0; i < z_info->r_max; i++) {
+		r_info[i].cur_num = cur_num[i];
+	}
+	mem_free(cur_num);
+
+	/* Restore what the savefile form may leave out */
+	c->turn = stored->turn;
+	c->depth = stored->depth;
+	c->place = stored->place;
+	c->feeling = stored->feeling;
+	c->obj_rating = stored->obj_rating;
+	c->mon_rating = stored->mon_rating;
+	c->good_item = stored->good_item;
+	c->feeling_squares = stored->feeling_squares;
+	c->decoy = stored->decoy;
+
+	chunk_packed_free(stored);
+	chunk_list[idx] = c;
+	return c;
+}
+
+/**
+ * Pack every chunk in the chunk list which isn't already, then spill the
+ * least recently used to disk if they take too much memory.
+ *
+ * Nothing is packed while the player is in an arena, as the monster there is
+ * a copy of one from the stored level, sharing its objects.
+ */
+void chunk_list_pack(void)
+{
+	int i;
+
+	if (player->upkeep->arena_level) return;
+	for (i = 0; i < chunk_list_max; i++) {
+		if (!chunk_list[i]->packed) {
+			chunk_pack(i);
+		}
+	}
+	chunk_list_trim();
+}
+
+/**
+ * Get the savefile form of a packed chunk, reading it back from disk if it
+ * has been spilled
+ * \param c the packed chunk
+ * \param size is set to the length of the data
+ * \return a copy of the data, to be freed by the caller
+ */
+uint8_t *chunk_packed_copy(struct chunk *c, uint32_t *size)
+{
+	struct packed_chunk *packed = c->packed;
+	uint8_t *data = mem_alloc(packed->size);
+
+	if (packed->data) {
+		memcpy(data, packed->data, packed->size);
+	} else if (!chunk_read_spill(packed, data)) {
+		quit_fmt("Could not read back stored level %s from %s", c->name,
+			packed->spill);
+	}
+	*size = packed->size;
+	return data;
+}
+
+/**
+ * Free the chunk list, packed chunks and all
+ */
+void chunk_list_free(void)
+{
+	int i;
+
+	for (i = 0; i < chunk_list_max; i++) {
+		struct chunk *c = chunk_list[i];
+
+		if (c->packed) {
+			chunk_packed_free(c);
+		} else {
+			wipe_mon_list(c, player);
+			cave_free(c);
+		}
+	}
+	mem_free(chunk_list);
+	chunk_list = NULL;
+	chunk_list_max = 0;
+}
+
+/**
+ * Find a chunk by name, unpacking it if need be
  * \param name the name of the chunk being sought
  * \return the pointer to the chunk
  */
@@ -115,6 +396,26 @@ struct chunk *chunk_find_name(const char *name)
 {
 	int i;
 
+	for (i = 0; i < chunk_list_max; i++) {
+		if (streq(name, chunk_list[i]->name)) {
+			return chunk_list[i]->packed ? chunk_unpack(i) :
+				chunk_list[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Find a chunk by name, leaving it packed if it is; only the name, size,
+ * depth and connectors of a packed chunk may be used
+ * \param name the name of the chunk being sought
+ * \return the pointer to the chunk
+ */
+struct chunk *chunk_peek_name(const char *name)
+{
+	int i;
+
 	for (i = 0; i < chunk_list_max; i++)
 		if (streq(name, chunk_list[i]->name))
 			return chunk_list[i];
@@ -146,22 +447,24 @@ bool chunk_find(struct chunk *c)
 struct chunk *chunk_find_adjacent(int place, const char *direction)
 {
 	struct level *lev = &world->levels[place];
+	const char *name = NULL;
 
 	if (streq(direction, "north")) {
-		return chunk_find_name(lev->north);
+		name = lev->north;
 	} else if (streq(direction, "east")) {
-		return chunk_find_name(lev->east);
+		name = lev->east;
 	} else if (streq(direction, "south")) {
-		return chunk_find_name(lev->south);
+		name = lev->south;
 	} else if (streq(direction, "west")) {
-		return chunk_find_name(lev->west);
+		name = lev->west;
 	} else if (streq(direction, "up")) {
-		return chunk_find_name(lev->up);
+		name = lev->up;
 	} else if (streq(direction, "down")) {
-		return chunk_find_name(lev->down);
+		name = lev->down;
 	}
 
-	return NULL;
+	/* Not every level has a neighbour in every direction */
+	return name ? chunk_peek_name(name) : NULL;
 }
 
 /**
@@ -369,6 +672,27 @@ bool chunk_copy(struct chunk *dest, struct player *p, struct chunk *source,
 			return false;
 	}
 
+	/* The copied view flags, light and terrain are not in dest's records */
+	forget_view_grids(dest);
+	light_map_free(dest);
+	dest->flow_changes++;
+
+	/* Untransformed terrain can be copied a row at a time */
+	if (rotate % 4 == 0 && !reflect) {
+		for (grid.y = 0; grid.y < h; grid.y++) {
+			int from = square_idx(source, loc(0, grid.y));
+			int to = square_idx(dest, loc(x0, grid.y + y0));
+
+			memcpy(dest->sq_feat + to, source->sq_feat + from,
+				w * sizeof(*dest->sq_feat));
+			memcpy(dest->sq_props + to, source->sq_props + from,
+				w * sizeof(*dest->sq_props));
+			memcpy(dest->sq_info + to * SQUARE_SIZE,
+				source->sq_info + from * SQUARE_SIZE,
+				w * SQUARE_SIZE * sizeof(*dest->sq_info));
+		}
+	}
+
 	/* Write the location stuff (terrain, objects, traps) */
 	for (grid.y = 0; grid.y < h; grid.y++) {
 		for (grid.x = 0; grid.x < w; grid.x++) {
@@ -377,41 +701,46 @@ bool chunk_copy(struct chunk *dest, struct player *p, struct chunk *source,
 			symmetry_transform(&dest_grid, y0, x0, h, w, rotate, reflect);
 
 			/* Terrain */
-			dest->squares[dest_grid.y][dest_grid.x].feat =
-				square(source, grid)->feat;
-			sqinfo_copy(square(dest, dest_grid)->info,
-						square(source, grid)->info);
+			if (rotate % 4 != 0 || reflect) {
+				dest->sq_feat[square_idx(dest, dest_grid)] =
+					square(source, grid).feat;
+				dest->sq_props[square_idx(dest, dest_grid)] =
+					source->sq_props[square_idx(source, grid)];
+				sqinfo_copy(square(dest, dest_grid).info,
+					square(source, grid).info);
+			}
 
 			/* Dungeon objects */
 			if (square_object(source, grid)) {
 				struct object *obj;
-				dest->squares[dest_grid.y][dest_grid.x].obj =
-					square_object(source, grid);
+				square_set_obj(dest, dest_grid,
+					square_object(source, grid));
 
 				for (obj = square_object(source, grid); obj; obj = obj->next) {
 					/* Adjust position */
 					obj->grid = dest_grid;
 				}
-				source->squares[grid.y][grid.x].obj = NULL;
+				square_set_obj(source, grid, NULL);
 			}
 
 			/* Traps */
-			if (square(source, grid)->trap) {
-				struct trap *trap = square(source, grid)->trap;
-				dest->squares[dest_grid.y][dest_grid.x].trap = trap;
+			if (square(source, grid).trap) {
+				struct trap *trap = square(source, grid).trap;
+				dest->sq_trap[square_idx(dest, dest_grid)] = trap;
 
 				/* Traverse the trap list */
 				while (trap) {
 					/* Adjust location */
 					trap->grid = dest_grid;
+					if (trap->timeout) dest->timed_traps++;
 					trap = trap->next;
 				}
-				source->squares[grid.y][grid.x].trap = NULL;
+				source->sq_trap[square_idx(source, grid)] = NULL;
 			}
 
 			/* Player */
-			if (square(source, grid)->mon == -1) {
-				dest->squares[dest_grid.y][dest_grid.x].mon = -1;
+			if (square(source, grid).mon == -1) {
+				square_set_mon(dest, dest_grid, -1);
 				p->grid = dest_grid;
 			}
 		}
@@ -458,7 +787,7 @@ bool chunk_copy(struct chunk *dest, struct player *p, struct chunk *source,
 
 		/* Move grid */
 		symmetry_transform(&dest_mon->grid, y0, x0, h, w, rotate, reflect);
-		dest->squares[dest_mon->grid.y][dest_mon->grid.x].mon = dest_mon->midx;
+		square_set_mon(dest, dest_mon->grid, dest_mon->midx);
 
 		/* Held or mimicked objects */
 		if (source_mon->held_obj) {
@@ -569,7 +898,7 @@ void chunk_validate_objects(struct chunk *c) {
 			struct loc grid = loc(x, y);
 			for (obj = square_object(c, grid); obj; obj = obj->next)
 				assert(obj->tval != 0);
-			if (square(c, grid)->mon > 0) {
+			if (square(c, grid).mon > 0) {
 				struct monster *mon = square_monster(c, grid);
 				if (mon->held_obj)
 					for (obj = mon->held_obj; obj; obj = obj->next)
@@ -148,6 +148,42 @@ void shuffle(int *arr, int n)
 }
 
 
+/**
+ * The state of a search for a square:  a Fisher-Yates shuffle of the grids of
+ * a rectangle, done a step at a time as grids are asked for.  Only the places
+ * the shuffle has written to are stored, so starting a search costs the same
+ * however big the rectangle is, and the grids come out just as they would
+ * from shuffling a full array.  Freed states are kept for reuse.
+ */
+struct cave_find_state {
+	int n;				/* Number of grids in the rectangle */
+	int width;			/* Width of the rectangle */
+	struct loc top_left;
+	int next;			/* Number of grids handed out so far */
+	uint32_t stamp;		/* Marks places written during this search */
+	int alloc;			/* Size of the arrays below */
+	int *value;			/* What each written place holds */
+	uint32_t *written;	/* Stamp of the search which last wrote each place */
+	struct cave_find_state *next_free;
+};
+
+static struct cave_find_state *find_pool;
+
+/**
+ * What is at a place in the shuffle; places not yet written hold their own
+ * index
+ */
+static int cave_find_place(const struct cave_find_state *state, int i)
+{
+	return (state->written[i] == state->stamp) ? state->value[i] : i;
+}
+
+static void cave_find_write(struct cave_find_state *state, int i, int value)
+{
+	state->value[i] = value;
+	state->written[i] = state->stamp;
+}
+
 /**
  * Set up to locate a square in a rectangular region of a chunk.
  *
@@ -155,28 +191,42 @@ void shuffle(int *arr, int n)
  * \param bottom_right is the lower right corner of the rectangle to be
  * searched.
  * \return the state for the search.  When no longer needed, the returned
- * value should be passed to mem_free().
+ * value should be passed to cave_find_free().
  */
-int *cave_find_init(struct loc top_left, struct loc bottom_right)
+struct cave_find_state *cave_find_init(struct loc top_left,
+		struct loc bottom_right)
 {
 	struct loc diff = loc_diff(bottom_right, top_left);
 	int n = (diff.y < 0 || diff.x < 0) ? 0 : (diff.x + 1) * (diff.y + 1);
-	int *state = mem_alloc((5 + n) * sizeof(*state));
-	int i;
+	struct cave_find_state *state = find_pool;
 
-	state[0] = n;
-	state[1] = diff.x + 1;
-	state[2] = top_left.x;
-	state[3] = top_left.y;
-	/* The next to search is the first one. */
-	state[4] = 0;
-	/*
-	 * Set up for left to right, top to bottom, search; will randomize in
-	 * cave_find_get_grid().
-	 */
-	for (i = 5; i < 5 + n; ++i) {
-		state[i] = i - 5;
+	if (state) {
+		find_pool = state->next_free;
+	} else {
+		state = mem_zalloc(sizeof(*state));
 	}
+
+	if (state->alloc < n) {
+		mem_free(state->value);
+		mem_free(state->written);
+		state->alloc = MAX(n, 2 * state->alloc);
+		state->value = mem_alloc(state->alloc * sizeof(*state->value));
+		state->written = mem_zalloc(state->alloc *
+			sizeof(*state->written));
+		state->stamp = 0;
+	}
+
+	/* Forget what earlier searches wrote */
+	if (++state->stamp == 0) {
+		memset(state->written, 0, state->alloc * sizeof(*state->written));
+		state->stamp = 1;
+	}
+
+	state->n = n;
+	state->width = diff.x + 1;
+	state->top_left = top_left;
+	state->next = 0;
+	state->next_free = NULL;
 	return state;
 }
 
@@ -186,10 +236,10 @@ int *cave_find_init(struct loc top_left, struct loc bottom_right)
  *
  * \param state is the search state created by cave_find_init().
  */
-void cave_find_reset(int *state)
+void cave_find_reset(struct cave_find_state *state)
 {
 	/* The next to search is the first one. */
-	state[4] = 0;
+	state->next = 0;
 }
 
 /**
@@ -201,34 +251,61 @@ void cave_find_reset(int *state)
  * searched; otherwise return false to indicate that there are no more grids
  * available.
  */
-bool cave_find_get_grid(struct loc *grid, int *state)
+bool cave_find_get_grid(struct loc *grid, struct cave_find_state *state)
 {
 	int j, k;
 
-	assert(state[4] >= 0);
-	if (state[4] >= state[0]) return false;
+	assert(state->next >= 0);
+	if (state->next >= state->n) return false;
 
 	/*
 	 * Choose one of the remaining ones at random.  Swap it with the one
 	 * that's next in order.
 	 */
-	j = randint0(state[0] - state[4]) + state[4];
-	k = state[5 + j];
-	state[5 + j] = state[5 + state[4]];
-	state[5 + state[4]] = k;
+	j = randint0(state->n - state->next) + state->next;
+	k = cave_find_place(state, j);
+	cave_find_write(state, j, cave_find_place(state, state->next));
+	cave_find_write(state, state->next, k);
 
-	grid->y = (k / state[1]) + state[3];
-	grid->x = (k % state[1]) + state[2];
+	grid->y = (k / state->width) + state->top_left.y;
+	grid->x = (k % state->width) + state->top_left.x;
 
 	/*
 	 * Increment so a future call to cave_find_get_grid() will get the
 	 * next one.
 	 */
-	++state[4];
+	++state->next;
 	return true;
 }
 
 
+/**
+ * Finish with a search created by cave_find_init(), keeping its storage for
+ * later searches.
+ */
+void cave_find_free(struct cave_find_state *state)
+{
+	state->next_free = find_pool;
+	find_pool = state;
+}
+
+
+/**
+ * Free the storage kept for searches.
+ */
+void cave_find_cleanup(void)
+{
+	while (find_pool) {
+		struct cave_find_state *state = find_pool;
+
+		find_pool = state->next_free;
+		mem_free(state->value);
+		mem_free(state->written);
+		mem_free(state);
+	}
+}
+
+
 /**
  * Locate a square in a rectangle which satisfies the given predicate.
  *
@@ -243,13 +320,13 @@ bool cave_find_in_range(struct chunk *c, struct loc *grid,
 		struct loc top_left, struct loc bottom_right,
 		square_predicate pred)
 {
-	int *state = cave_find_init(top_left, bottom_right);
+	struct cave_find_state *state = cave_find_init(top_left, bottom_right);
 	bool found = false;
 
 	while (!found && cave_find_get_grid(grid, state)) {
 		found = pred(c, *grid);
 	}
-	mem_free(state);
+	cave_find_free(state);
 	return found;
 }
 
@@ -391,7 +468,7 @@ void rand_dir(struct loc *offset)
  */
 static bool find_start(struct chunk *c, struct loc *grid)
 {
-	int *state = cave_find_init(loc(1, 1),
+	struct cave_find_state *state = cave_find_init(loc(1, 1),
 		loc(c->width - 2, c->height - 2));
 	bool found = false;
 
@@ -430,7 +507,7 @@ static bool find_start(struct chunk *c, struct loc *grid)
 		}
 	}
 
-	mem_free(state);
+	cave_find_free(state);
 
 	return found;
 }
@@ -677,7 +754,7 @@ void alloc_stairs(struct chunk *c, int feat, int num, int minsep, bool sepany,
 {
 	int i, navalloc, nav, walls;
 	struct loc *av;
-	int *state;
+	struct cave_find_state *state;
 
 	nav = 0;
 	if (minsep > 0) {
@@ -773,7 +850,7 @@ void alloc_stairs(struct chunk *c, int feat, int num, int minsep, bool sepany,
 		}
 	}
 
-	mem_free(state);
+	cave_find_free(state);
 	mem_free(av);
 }
 
@@ -814,7 +891,7 @@ void alloc_objects(struct chunk *c, int set, int typ, int num, int depth,
 bool alloc_object(struct chunk *c, int set, int typ, int depth, uint8_t origin)
 {
 	bool placed = false;
-	int *state = cave_find_init(loc(1, 1),
+	struct cave_find_state *state = cave_find_init(loc(1, 1),
 		loc(c->width - 2, c->height - 2));
 	struct loc grid;
 
@@ -851,7 +928,7 @@ bool alloc_object(struct chunk *c, int set, int typ, int depth, uint8_t origin)
 		}
 	}
 
-	mem_free(state);
+	cave_find_free(state);
 	return placed;
 }
 
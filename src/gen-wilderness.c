@@ -351,7 +351,7 @@ static void alloc_paths(struct chunk *c, struct player *p, int place,
 	/* Mark all the roads, so we know not to overwrite them */
 	for (grid.y = 0; grid.y < c->height; grid.y++) {
 		for (grid.x = 0; grid.x < c->width; grid.x++) {
-			if (square(c, grid)->feat == FEAT_ROAD) {
+			if (square(c, grid).feat == FEAT_ROAD) {
 				square_mark(c, grid);
 			}
 		}
@@ -543,7 +543,7 @@ static bool check_vault_space(struct chunk *c, struct loc avoid,
 			if (square_ispath(c, grid)) return false;
 			if (distance(grid, avoid) < 20) return false;
 			if (square_ismark(c, grid)) return false;
-			if (square(c, grid)->mon) return false;
+			if (square(c, grid).mon) return false;
 			if (square_isplayertrap(c, grid)) return false;
 			if (square_object(c, grid)) return false;
 			if (square_iswebbed(c, grid)) return false;
@@ -791,7 +791,7 @@ static bool verify_level(struct chunk *c)
 			if ((grid.y == 0 || grid.x == 0
 					|| grid.y == c->height - 1
 					|| grid.x == c->width - 1)
-					&& square(c, grid)->feat != FEAT_PERM) {
+					&& square(c, grid).feat != FEAT_PERM) {
 				++broken_bnd;
 				last_bad_bnd = grid;
 			}
@@ -814,15 +814,15 @@ static bool verify_level(struct chunk *c)
 		if (broken_bnd) {
 			title = format("Broken Wilderness:  %d Bounding Walls; Last at (x=%d,y=%d) with Feature=%d",
 				broken_bnd, last_bad_bnd.x, last_bad_bnd.y,
-				(int) square(c, last_bad_bnd)->feat);
+				(int) square(c, last_bad_bnd).feat);
 		} else if (broken_mon) {
 			title = format("Broken Monster:  %d Embedded in Terrain; Last at (x=%d,y=%d) with Terrain=%d",
 				broken_mon, last_bad_mon.x, last_bad_mon.y,
-				(int) square(c, last_bad_mon)->feat);
+				(int) square(c, last_bad_mon).feat);
 		} else {
 			title = format("Broken Object:  %d Embedded in Terrain; Last at (x=%d,y=%d) with Terrain=%d",
 				broken_obj, last_bad_obj.x, last_bad_obj.y,
-				(int) square(c, last_bad_obj)->feat);
+				(int) square(c, last_bad_obj).feat);
 		}
 		dump_level_simple(NULL, title, c);
 		msg("Restarting wilderness generation; bad level in dumpedlevel.html");
@@ -37,6 +37,7 @@
 #include "init.h"
 #include "mon-make.h"
 #include "mon-move.h"
+#include "mon-schedule.h"
 #include "mon-spell.h"
 #include "monster.h"
 #include "obj-tval.h"
@@ -746,7 +747,7 @@ static void run_template_parser(void) {
 
 
 /**
- * Free the template arrays
+ * Free the template arrays, and what was kept for finding squares
  */
 static void cleanup_template_parser(void)
 {
@@ -754,6 +755,7 @@ static void cleanup_template_parser(void)
 	cleanup_parser(&room_parser);
 	cleanup_parser(&vault_parser);
 	cleanup_parser(&themed_parser);
+	cave_find_cleanup();
 }
 
 
@@ -784,7 +786,7 @@ static void place_feeling(struct chunk *c)
 				continue;
 
 			/* Set the cave square appropriately */
-			sqinfo_on(square(c, grid)->info, SQUARE_FEEL);
+			sqinfo_on(square(c, grid).info, SQUARE_FEEL);
 			
 			break;
 		}
@@ -1074,7 +1076,7 @@ static void get_join_info(struct player *p, struct dun_data *dd)
 	/* Check level north */
 	lev = level_by_name(world, current_lev->north);
 	if (lev) {
-		struct chunk *check = chunk_find_name(level_name(lev));
+		struct chunk *check = chunk_peek_name(level_name(lev));
 		if (check) {
 			struct connector *join = check->join;
 			while (join) {
@@ -1099,7 +1101,7 @@ static void get_join_info(struct player *p, struct dun_data *dd)
 	/* Check level east */
 	lev = level_by_name(world, current_lev->east);
 	if (lev) {
-		struct chunk *check = chunk_find_name(level_name(lev));
+		struct chunk *check = chunk_peek_name(level_name(lev));
 		if (check) {
 			struct connector *join = check->join;
 			while (join) {
@@ -1124,7 +1126,7 @@ static void get_join_info(struct player *p, struct dun_data *dd)
 	/* Check level south */
 	lev = level_by_name(world, current_lev->south);
 	if (lev) {
-		struct chunk *check = chunk_find_name(level_name(lev));
+		struct chunk *check = chunk_peek_name(level_name(lev));
 		if (check) {
 			struct connector *join = check->join;
 			while (join) {
@@ -1149,7 +1151,7 @@ static void get_join_info(struct player *p, struct dun_data *dd)
 	/* Check level west */
 	lev = level_by_name(world, current_lev->west);
 	if (lev) {
-		struct chunk *check = chunk_find_name(level_name(lev));
+		struct chunk *check = chunk_peek_name(level_name(lev));
 		if (check) {
 			struct connector *join = check->join;
 			while (join) {
@@ -1174,7 +1176,7 @@ static void get_join_info(struct player *p, struct dun_data *dd)
 	/* Check level above */
 	lev = level_by_name(world, current_lev->up);
 	if (lev) {
-		struct chunk *check = chunk_find_name(level_name(lev));
+		struct chunk *check = chunk_peek_name(level_name(lev));
 		if (check) {
 			struct connector *join = check->join;
 			while (join) {
@@ -1197,7 +1199,7 @@ static void get_join_info(struct player *p, struct dun_data *dd)
 		 * on this level won't conflict with them if the level above is
 		 * ever generated.
 		 */
-		struct chunk *check = chunk_find_name(level_name(lev));
+		struct chunk *check = chunk_peek_name(level_name(lev));
 
 		if (check) {
 			struct connector *join;
@@ -1219,7 +1221,7 @@ static void get_join_info(struct player *p, struct dun_data *dd)
 	/* Check level below */
 	lev = level_by_name(world, current_lev->down);
 	if (lev) {
-		struct chunk *check = chunk_find_name(level_name(lev));
+		struct chunk *check = chunk_peek_name(level_name(lev));
 		if (check) {
 			struct connector *join = check->join;
 			while (join) {
@@ -1237,7 +1239,7 @@ static void get_join_info(struct player *p, struct dun_data *dd)
 	} else if ((lev = level_by_name(world, current_lev->down)) &&
 			   lev && (lev = level_by_name(world, lev->down))) {
 		/* Same logic as above for looking one past the next level */
-		struct chunk *check = chunk_find_name(level_name(lev));
+		struct chunk *check = chunk_peek_name(level_name(lev));
 
 		if (check) {
 			struct connector *join;
@@ -1424,7 +1426,7 @@ static void leave_arena(struct chunk *c, struct player *p)
 		for (y = 0; y < cave->height; y++) {
 			for (x = 0; x < cave->width; x++) {
 				struct loc grid = loc(x, y);
-				if (square(cave, grid)->mon == -1) {
+				if (square(cave, grid).mon == -1) {
 					p->grid = grid;
 					found = true;
 					break;
@@ -1601,10 +1603,10 @@ static struct chunk *cave_generate(struct player *p, int height, int width)
 			for (x = 0; x < chunk->width; x++) {
 				struct loc grid = loc(x, y);
 
-				sqinfo_off(square(chunk, grid)->info, SQUARE_WALL_INNER);
-				sqinfo_off(square(chunk, grid)->info, SQUARE_WALL_OUTER);
-				sqinfo_off(square(chunk, grid)->info, SQUARE_WALL_SOLID);
-				sqinfo_off(square(chunk, grid)->info, SQUARE_MON_RESTRICT);
+				sqinfo_off(square(chunk, grid).info, SQUARE_WALL_INNER);
+				sqinfo_off(square(chunk, grid).info, SQUARE_WALL_OUTER);
+				sqinfo_off(square(chunk, grid).info, SQUARE_WALL_SOLID);
+				sqinfo_off(square(chunk, grid).info, SQUARE_MON_RESTRICT);
 
 				if (square_isstairs(chunk, grid)) {
 					size_t n;
@@ -1613,7 +1615,7 @@ static struct chunk *cave_generate(struct player *p, int height, int width)
 					new->feat = square_feat(chunk, grid)->fidx;
 					new->info = mem_zalloc(SQUARE_SIZE * sizeof(bitflag));
 					for (n = 0; n < SQUARE_SIZE; n++) {
-						new->info[n] = square(chunk, grid)->info[n];
+						new->info[n] = square(chunk, grid).info[n];
 					}
 					new->next = chunk->join;
 					chunk->join = new;
@@ -1699,6 +1701,10 @@ void prepare_next_level(struct player *p)
 	if (character_dungeon) {
 		assert (p->cave);
 
+		/* Its monsters keep their energies */
+		monster_schedule_drop(cave);
+		map_cache_free(cave);
+
 		if (persist) {
 			/* Arenas don't get stored */
 			if (!cave->name || !streq(cave->name, "arena")) {
@@ -1732,7 +1738,7 @@ void prepare_next_level(struct player *p)
 			}
 		} else {
 			/* Save the town */
-			if (!cave->depth && !chunk_find_name(prev_name)) {
+			if (!cave->depth && !chunk_peek_name(prev_name)) {
 				cave_store(cave, prev_name, false, false);
 			}
 
@@ -1799,7 +1805,7 @@ void prepare_next_level(struct player *p)
 			/* Check level above */
 			lev = level_by_name(world, world->levels[p->place].up);
 			if (lev) {
-				struct chunk *check = chunk_find_name(level_name(lev));
+				struct chunk *check = chunk_peek_name(level_name(lev));
 				if (check) {
 					get_min_level_size(check, &min_height, &min_width, true);
 				}
@@ -1808,7 +1814,7 @@ void prepare_next_level(struct player *p)
 			/* Check level below */
 			lev = level_by_name(world, world->levels[p->place].down);
 			if (lev) {
-				struct chunk *check = chunk_find_name(level_name(lev));
+				struct chunk *check = chunk_peek_name(level_name(lev));
 				if (check) {
 					get_min_level_size(check, &min_height, &min_width, false);
 				}
@@ -1835,6 +1841,9 @@ void prepare_next_level(struct player *p)
 
 	/* The dungeon is ready */
 	character_dungeon = true;
+
+	/* Pack away the stored levels */
+	chunk_list_pack();
 }
 
 /**
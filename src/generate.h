@@ -117,6 +117,17 @@ struct pit_profile {
 extern struct pit_profile *pit_info;
 
 
+/**
+ * The contents of a stored chunk while it is packed; chunk_find_name()
+ * unpacks it.  The data is the chunk's savefile record.
+ */
+struct packed_chunk {
+	uint8_t *data;		/*!< Savefile form, or NULL while spilled */
+	uint32_t size;		/*!< Length of the savefile form */
+	uint32_t last_use;	/*!< When the chunk was last stored or sought */
+	char *spill;		/*!< File holding the data once spilled, or NULL */
+};
+
 /**
  * Structure to hold all "dungeon generation" data
  */
@@ -369,7 +380,11 @@ struct chunk *chunk_write(struct chunk *c);
 void chunk_list_add(struct chunk *c);
 bool chunk_list_remove(const char *name);
 struct chunk *chunk_find_name(const char *name);
+struct chunk *chunk_peek_name(const char *name);
 bool chunk_find(struct chunk *c);
+void chunk_list_pack(void);
+uint8_t *chunk_packed_copy(struct chunk *c, uint32_t *size);
+void chunk_list_free(void);
 struct chunk *chunk_find_adjacent(int place, const char *direction);
 void symmetry_transform(struct loc *grid, int y0, int x0, int height, int width,
 	int rotate, bool reflect);
@@ -432,9 +447,12 @@ extern uint8_t get_angle_to_grid[41][41];
 int grid_to_i(struct loc grid, int w);
 void i_to_grid(int i, int w, struct loc *grid);
 void shuffle(int *arr, int n);
-int *cave_find_init(struct loc top_left, struct loc bottom_right);
-void cave_find_reset(int *state);
-bool cave_find_get_grid(struct loc *grid, int *state);
+struct cave_find_state *cave_find_init(struct loc top_left,
+	struct loc bottom_right);
+void cave_find_reset(struct cave_find_state *state);
+bool cave_find_get_grid(struct loc *grid, struct cave_find_state *state);
+void cave_find_free(struct cave_find_state *state);
+void cave_find_cleanup(void);
 
 bool cave_find_in_range(struct chunk *c, struct loc *grid, struct loc top_left,
 	struct loc bottom_right, square_predicate pred);
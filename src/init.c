@@ -28,6 +28,7 @@
 #include "cave.h"
 #include "cmds.h"
 #include "cmd-core.h"
+#include "datacache.h"
 #include "datafile.h"
 #include "effects.h"
 #include "game-event.h"
@@ -64,13 +65,16 @@
 #include "player-timed.h"
 #include "project.h"
 #include "randname.h"
+#include "savefile.h"
 #include "store.h"
 #include "trap.h"
 #include "ui-entry.h"
 #include "ui-entry-init.h"
 #include "ui-visuals.h"
+#include "z-names.h"
 
 bool play_again = false;
+bool use_data_cache = false;
 
 /**
  * Structure (not array) of game constants
@@ -613,6 +617,8 @@ static enum parser_error parse_constants_world(struct parser *p) {
 		z->themed_dun = value;
 	else if (streq(label, "themed-wild"))
 		z->themed_wild = value;
+	else if (streq(label, "level-memory"))
+		z->level_memory = value;
 	else
 		return PARSE_ERROR_UNDEFINED_DIRECTIVE;
 
@@ -776,7 +782,7 @@ static enum parser_error parse_constants_melee_critical_level(struct parser *p)
 	if (msgt < 0) {
 		return PARSE_ERROR_INVALID_MESSAGE;
 	}
-	new_level = mem_alloc(sizeof(*new_level));
+	new_level = mem_zalloc(sizeof(*new_level));
 	new_level->next = NULL;
 	new_level->chance = chance;
 	new_level->added_dice = parser_getuint(p, "dice");
@@ -842,7 +848,7 @@ static enum parser_error parse_constants_ranged_critical_level(struct parser *p)
 	if (msgt < 0) {
 		return PARSE_ERROR_INVALID_MESSAGE;
 	}
-	new_level = mem_alloc(sizeof(*new_level));
+	new_level = mem_zalloc(sizeof(*new_level));
 	new_level->next = NULL;
 	new_level->chance = chance;
 	new_level->added_dice = parser_getuint(p, "dice");
@@ -1162,6 +1168,15 @@ static errr finish_parse_world(struct parser *p) {
 	struct level_map *map;
 	int i;
 
+	/* Index the levels by name while checking; names change in play */
+	for (map = maps; map; map = map->next) {
+		map->level_names = name_index_new(false);
+		for (i = 0; i < map->num_levels; i++) {
+			name_index_add(map->level_names,
+				level_name(&map->levels[i]), i);
+		}
+	}
+
 	/* Check that all levels referred to exist */
 	for (map = maps; map; map = map->next) {
 		for (i = 0; i < map->num_levels; i++) {
@@ -1203,6 +1218,8 @@ static errr finish_parse_world(struct parser *p) {
 				}
 			}
 		}
+		name_index_free(map->level_names);
+		map->level_names = NULL;
 	}
 
 	parser_destroy(p);
@@ -2325,7 +2342,22 @@ static errr finish_parse_feat(struct parser *p) {
 		mem_free(f);
 	}
 
+	/* Summarise the terrain properties the busiest grid loops test */
+	feat_props = mem_zalloc((z_info->f_max + 1) * sizeof(*feat_props));
+	for (fidx = 0; fidx < z_info->f_max; fidx++) {
+		bitflag *flags = f_info[fidx].flags;
+
+		if (tf_has(flags, TF_LOS)) feat_props[fidx] |= FPROP_LOS;
+		if (tf_has(flags, TF_PROJECT)) feat_props[fidx] |= FPROP_PROJECT;
+		if (tf_has(flags, TF_PASSABLE)) feat_props[fidx] |= FPROP_PASSABLE;
+		if (tf_has(flags, TF_NO_FLOW)) feat_props[fidx] |= FPROP_NO_FLOW;
+		if (tf_has(flags, TF_NO_SCENT)) feat_props[fidx] |= FPROP_NO_SCENT;
+		if (tf_has(flags, TF_TORCH)) feat_props[fidx] |= FPROP_TORCH;
+		if (tf_has(flags, TF_BRIGHT)) feat_props[fidx] |= FPROP_BRIGHT;
+	}
+
 	/* Set the terrain constants */
+	feat_name_index_build();
 	set_terrain();
 
 	parser_destroy(p);
@@ -2346,7 +2378,10 @@ static void cleanup_feat(void) {
 		string_free(f_info[idx].desc);
 		string_free(f_info[idx].name);
 	}
+	feat_name_index_free();
 	mem_free(f_info);
+	mem_free(feat_props);
+	feat_props = NULL;
 }
 
 struct file_parser feat_parser = {
@@ -4592,6 +4627,10 @@ void init_arrays(void)
 {
 	unsigned int i;
 
+	/* The data files refer to effects and projections by name */
+	effect_name_index_build();
+	proj_name_index_build();
+
 	for (i = 0; i < N_ELEMENTS(pl); i++) {
 		char *msg = string_make(format("Initializing %s...", pl[i].name));
 		event_signal_message(EVENT_INITSTATUS, 0, msg);
@@ -4612,6 +4651,9 @@ static void cleanup_arrays(void)
 		cleanup_parser(pl[i].parser);
 
 	cleanup_parser(pl[0].parser);
+
+	proj_name_index_free();
+	effect_name_index_free();
 }
 
 static struct init_module arrays_module = {
@@ -4623,6 +4665,7 @@ static struct init_module arrays_module = {
 
 extern struct init_module z_quark_module;
 extern struct init_module generate_module;
+extern struct init_module view_module;
 extern struct init_module rune_module;
 extern struct init_module obj_make_module;
 extern struct init_module ignore_module;
@@ -4641,6 +4684,7 @@ static struct init_module *modules[] = {
 	&arrays_module,
 	&player_module,
 	&generate_module,
+	&view_module,
 	&rune_module,
 	&obj_make_module,
 	&ignore_module,
@@ -4672,6 +4716,9 @@ bool init_angband(void)
 
 	event_signal(EVENT_ENTER_INIT);
 
+	/* Load what data tables we can from the cache, if it is wanted */
+	if (use_data_cache) datacache_open();
+
 	init_game_constants();
 
 	/* Initialise modules */
@@ -4679,6 +4726,9 @@ bool init_angband(void)
 		if (modules[i]->init)
 			modules[i]->init();
 
+	/* Write the cache if tables had to be parsed */
+	datacache_close();
+
 	/* Initialize some other things */
 	event_signal_message(EVENT_INITSTATUS, 0, "Initializing other stuff...");
 
@@ -4700,13 +4750,11 @@ void cleanup_angband(void)
 {
 	int i;
 
+	/* Don't leave a save half done */
+	savefile_save_wait();
+
 	/* Free the chunk list */
-	for (i = 0; i < chunk_list_max; i++) {
-		wipe_mon_list(chunk_list[i], player);
-		cave_free(chunk_list[i]);
-	}
-	mem_free(chunk_list);
-	chunk_list = NULL;
+	chunk_list_free();
 
 	for (i = 0; modules[i]; i++)
 		if (modules[i]->cleanup)
@@ -4733,6 +4781,9 @@ void cleanup_angband(void)
 	/* Free the format() buffer */
 	vformat_kill();
 
+	/* Free the dice distributions */
+	damroll_distributions_free();
+
 	/* Free the directories */
 	string_free(ANGBAND_DIR_GAMEDATA);
 	string_free(ANGBAND_DIR_CUSTOMIZE);
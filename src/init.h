@@ -111,6 +111,7 @@ struct angband_constants
 	uint16_t move_energy;	/* Energy the player or monster needs to move */
 	uint16_t themed_dun;	/* !/Chance of a themed level in the dungeon */
 	uint16_t themed_wild;	/* !/Chance of a themed level in the wilderness */
+	uint16_t level_memory;	/* Kilobytes of stored levels to keep in memory */
 
 	/* Carrying capacity constants, read from constants.txt */
 	uint16_t pack_size;		/**< Maximum number of pack slots */
@@ -183,6 +184,7 @@ struct init_module {
 };
 
 extern bool play_again;
+extern bool use_data_cache;
 
 extern const char *list_element_names[];
 extern const char *list_obj_flag_names[];
@@ -422,19 +422,19 @@ int rd_randomizer(void)
 	rd_u32b(&Rand_value);
 
 	/* state index */
-	rd_u32b(&state_i);
+	rd_u32b(&Rand_game.i);
 
 	/* for safety, make sure state_i < RAND_DEG */
-	state_i = state_i % RAND_DEG;
+	Rand_game.i = Rand_game.i % RAND_DEG;
     
-	/* RNG variables */
-	rd_u32b(&z0);
-	rd_u32b(&z1);
-	rd_u32b(&z2);
+	/* RNG variables, no longer kept */
+	rd_u32b(&noop);
+	rd_u32b(&noop);
+	rd_u32b(&noop);
     
 	/* RNG state */
 	for (i = 0; i < RAND_DEG; i++)
-		rd_u32b(&STATE[i]);
+		rd_u32b(&Rand_game.state[i]);
 
 	/* NULL padding */
 	for (i = 0; i < 59 - RAND_DEG; i++)
@@ -1437,7 +1437,7 @@ static int rd_dungeon_aux(struct chunk **c)
 	c1 = cave_new(height, width);
 	c1->name = string_make(name);
 
-    /* Run length decoding of cave->squares[y][x].info */
+    /* Run length decoding of cave->sq_info */
 	for (n = 0; n < square_size; n++) {
 		/* Load the dungeon data */
 		for (x = y = 0; y < c1->height; ) {
@@ -1448,7 +1448,7 @@ static int rd_dungeon_aux(struct chunk **c)
 			/* Apply the RLE info */
 			for (i = count; i > 0; i--) {
 				/* Extract "info" */
-				c1->squares[y][x].info[n] = tmp8u;
+				square(c1, loc(x, y)).info[n] = tmp8u;
 
 				/* Advance/Wrap */
 				if (++x >= c1->width) {
@@ -1549,7 +1549,8 @@ static int rd_objects_aux(rd_item_t rd_item_version, struct chunk *c)
 #else
 		if (square_in_bounds_fully(c, obj->grid)) {
 #endif
-			pile_insert_end(&c->squares[obj->grid.y][obj->grid.x].obj, obj);
+			pile_insert_end(&c->sq_obj[square_idx(c, obj->grid)], obj);
+			cave_index_note(c, obj->grid);
 		}
 		assert(obj->oidx);
 		assert(c->objects[obj->oidx] == NULL);
@@ -1757,84 +1758,117 @@ int rd_traps(void)
 }
 
 /**
- * Read the chunk list
+ * Read a stored chunk
  */
-int rd_chunks(void)
+static int rd_chunk(struct chunk **pc)
 {
-	int j;
-	uint16_t chunk_max;
-
-	if (player->is_dead)
-		return 0;
-
-	rd_u16b(&chunk_max);
-	for (j = 0; j < chunk_max; j++) {
-		struct chunk *c;
-
-		/* Read the dungeon */
-		if (rd_dungeon_aux(&c))
-			return -1;
+	struct chunk *c = NULL;
 
-		/* Read the objects */
-		if (rd_objects_aux(rd_item, c))
-			return -1;
+	/* Read the dungeon */
+	if (rd_dungeon_aux(&c))
+		return -1;
+	*pc = c;
 
-		/* Read the monsters */
-		if (rd_monsters_aux(c))
-			return -1;
+	/* Read the objects */
+	if (rd_objects_aux(rd_item, c))
+		return -1;
 
-		/* Read traps */
-		if (rd_traps_aux(c))
-			return -1;
+	/* Read the monsters */
+	if (rd_monsters_aux(c))
+		return -1;
 
+	/* Read traps */
+	if (rd_traps_aux(c))
+		return -1;
 
-		/* Read other chunk info */
-		if (OPT(player, birth_levels_persist)) {
-			char buf[80];
-			int i;
-			uint8_t tmp8u;
-			uint16_t tmp16u;
+	/* Read other chunk info */
+	if (OPT(player, birth_levels_persist)) {
+		char buf[80];
+		int i;
+		uint8_t tmp8u;
+		uint16_t tmp16u;
 
-			rd_string(buf, sizeof(buf));
-			string_free(c->name);
-			c->name = string_make(buf);
-			rd_s32b(&c->turn);
-			rd_u16b(&tmp16u);
-			c->depth = tmp16u;
-			rd_byte(&c->feeling);
-			rd_u32b(&c->obj_rating);
-			rd_u32b(&c->mon_rating);
-			rd_byte(&tmp8u);
-			c->good_item  = tmp8u ? true : false;
-			rd_u16b(&tmp16u);
-			c->height = tmp16u;
+		rd_string(buf, sizeof(buf));
+		string_free(c->name);
+		c->name = string_make(buf);
+		rd_s32b(&c->turn);
+		rd_u16b(&tmp16u);
+		c->depth = tmp16u;
+		rd_byte(&c->feeling);
+		rd_u32b(&c->obj_rating);
+		rd_u32b(&c->mon_rating);
+		rd_byte(&tmp8u);
+		c->good_item  = tmp8u ? true : false;
+		rd_u16b(&tmp16u);
+		c->height = tmp16u;
+		rd_u16b(&tmp16u);
+		c->width = tmp16u;
+		rd_u16b(&c->feeling_squares);
+		for (i = 0; i < z_info->f_max + 1; i++) {
 			rd_u16b(&tmp16u);
-			c->width = tmp16u;
-			rd_u16b(&c->feeling_squares);
-			for (i = 0; i < z_info->f_max + 1; i++) {
-				rd_u16b(&tmp16u);
-				c->feat_count[i] = tmp16u;
-			}
-			rd_byte(&tmp8u);
-			c->ghost->bones_selector = tmp8u;
-		} else if (c->name) {
-			struct level *lev = level_by_name(world, c->name);
-
+			c->feat_count[i] = tmp16u;
+		}
+		rd_byte(&tmp8u);
+		c->ghost->bones_selector = tmp8u;
+	} else if (c->name) {
+		struct level *lev = level_by_name(world, c->name);
+
+		if (lev) {
+			c->depth = lev->depth;
+		} else if (suffix(c->name, " known")) {
+			size_t offset = strlen(c->name) -
+				strlen(" known");
+			c->name[offset] = '\0';
+			lev = level_by_name(world, c->name);
 			if (lev) {
 				c->depth = lev->depth;
-			} else if (suffix(c->name, " known")) {
-				size_t offset = strlen(c->name) -
-					strlen(" known");
-				c->name[offset] = '\0';
-				lev = level_by_name(world, c->name);
-				if (lev) {
-					c->depth = lev->depth;
-				}
-				c->name[offset] = ' ';
 			}
+			c->name[offset] = ' ';
 		}
+	}
+
+	return 0;
+}
+
+/**
+ * Read a chunk packed by savefile_pack_chunk() earlier in this game, so with
+ * the sizes of this version rather than those of the savefile
+ */
+int rd_packed_chunk(struct chunk **c)
+{
+	square_size = SQUARE_SIZE;
+	obj_mod_max = OBJ_MOD_MAX;
+	of_size = OF_SIZE;
+	elem_max = ELEM_MAX;
+	brand_max = z_info->brand_max;
+	slay_max = z_info->slay_max;
+	curse_max = z_info->curse_max;
+	mflag_size = MFLAG_SIZE;
+
+	return rd_chunk(c);
+}
 
+/**
+ * Read the chunk list
+ */
+int rd_chunks(void)
+{
+	int j;
+	uint16_t chunk_max;
+
+	if (player->is_dead)
+		return 0;
+
+	rd_u16b(&chunk_max);
+	for (j = 0; j < chunk_max; j++) {
+		struct chunk *c = NULL;
+
+		if (rd_chunk(&c))
+			return -1;
 		chunk_list_add(c);
+
+		/* Pack as we go, so the stored levels never all need memory */
+		chunk_list_pack();
 	}
 
 #if OBJ_RECOVER
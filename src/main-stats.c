@@ -43,6 +43,9 @@
 #include "store.h"
 #include <stddef.h>
 #include <time.h>
+#ifdef UNIX
+#include <sys/wait.h>
+#endif
 
 #define OBJ_FEEL_MAX	 11
 #define MON_FEEL_MAX 	 10
@@ -66,6 +69,7 @@
 
 static int no_selling = 0;
 static uint32_t num_runs = 1;
+static int num_jobs = 1;
 static bool quiet = false;
 static int nextkey = 0;
 static int running_stats = 0;
@@ -176,6 +180,42 @@ static void free_stats_memory(void)
 	string_free(ANGBAND_DIR_STATS);
 }
 
+/**
+ * Pass each block of counters in level_data to func, always in the same
+ * order; wide blocks hold long longs, the others uint32_ts
+ */
+static void visit_counters(void (*func)(void *counts, size_t n, bool wide,
+		void *arg), void *arg)
+{
+	int i, j, k, l;
+
+	for (i = 0; i < LEVEL_MAX; i++) {
+		struct level_data *ld = &level_data[i];
+
+		func(ld->monsters, z_info->r_max, false, arg);
+		func(ld->obj_feelings, OBJ_FEEL_MAX, false, arg);
+		func(ld->mon_feelings, MON_FEEL_MAX, false, arg);
+		func(ld->gold, ORIGIN_STATS, true, arg);
+		for (j = 0; j < ORIGIN_STATS; j++) {
+			func(ld->artifacts[j], z_info->a_max, false, arg);
+			func(ld->consumables[j], consumable_count + 1, false, arg);
+			for (k = 0; k < wearable_count + 1; k++) {
+				struct wearables_data *w = &ld->wearables[j][k];
+
+				func(&w->count, 1, false, arg);
+				func(&w->dice[0][0], TOP_DICE * TOP_SIDES, false, arg);
+				func(w->ac, TOP_AC, false, arg);
+				func(w->hit, TOP_PLUS, false, arg);
+				func(w->dam, TOP_PLUS, false, arg);
+				func(w->egos, z_info->e_max, false, arg);
+				func(w->flags, OF_MAX, false, arg);
+				for (l = 0; l < TOP_MOD; l++)
+					func(w->modifiers[l], OBJ_MOD_MAX + 1, false, arg);
+			}
+		}
+	}
+}
+
 /* Copied from birth.c:generate_player() */
 static void generate_player_for_stats(void)
 {
@@ -227,7 +267,7 @@ static void generate_player_for_stats(void)
 	player->history = get_history(player->race->history);
 }
 
-static void initialize_character(void)
+static void initialize_character(uint32_t run)
 {
 	uint32_t seed;
 
@@ -236,7 +276,8 @@ static void initialize_character(void)
 		fflush(stdout);
 	}
 
-	seed = (time(NULL));
+	/* Mix in the run, so runs begun in the same second differ */
+	seed = (uint32_t) time(NULL) ^ (run * 2654435761U);
 	Rand_quick = false;
 	Rand_state_init(seed);
 
@@ -1493,6 +1534,191 @@ static void stats_cleanup_angband_run(void)
 	player->history = NULL;
 }
 
+/**
+ * Make one run through the dungeon, adding what is found to level_data
+ */
+static void stats_run(uint32_t run)
+{
+	initialize_character(run);
+	unkill_uniques();
+	reset_artifacts();
+	descend_dungeon();
+	stats_cleanup_angband_run();
+}
+
+#ifdef UNIX
+
+/**
+ * Runs on several cores at once.
+ *
+ * The game keeps everything about the game in progress in globals, so each
+ * worker is a forked copy of the whole program, sharing the game data loaded
+ * at start up until it writes to it.  A worker makes its share of the runs,
+ * writing a byte to a shared pipe after each one, and then sends back its
+ * counters as a list of the positions and values of the nonzero ones, in
+ * visit_counters() order; the parent merges all the lists at once into its
+ * own counters.
+ */
+struct counter_entry {
+	uint64_t pos;
+	uint64_t value;
+};
+
+struct counter_stream {
+	uint64_t pos;			/* Position of the current block */
+	int workers;
+	FILE **in;				/* Lists from the workers, or */
+	struct counter_entry *next;	/* the next entry on each list */
+	FILE *out;				/* the list of a worker */
+	bool failed;
+};
+
+static void send_counter_block(void *counts, size_t n, bool wide, void *arg)
+{
+	struct counter_stream *s = arg;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		struct counter_entry e;
+
+		e.value = wide ? (uint64_t) ((long long *) counts)[i] :
+			((uint32_t *) counts)[i];
+		if (!e.value) continue;
+		e.pos = s->pos + i;
+		if (fwrite(&e, sizeof(e), 1, s->out) != 1) s->failed = true;
+	}
+	s->pos += n;
+}
+
+static void read_counter_entry(struct counter_stream *s, int w)
+{
+	if (fread(&s->next[w], sizeof(s->next[w]), 1, s->in[w]) != 1) {
+		s->next[w].pos = UINT64_MAX;
+		s->failed = true;
+	}
+}
+
+/**
+ * Each worker started with the parent's counters, so the merged counter is
+ * what the parent had plus what each worker added to it; a counter missing
+ * from a worker's list is still zero, so nothing was added.
+ */
+static void merge_counter_block(void *counts, size_t n, bool wide, void *arg)
+{
+	struct counter_stream *s = arg;
+
+	while (true) {
+		uint64_t pos = UINT64_MAX, start, total;
+		int w;
+
+		for (w = 0; w < s->workers; w++)
+			pos = MIN(pos, s->next[w].pos);
+		if (pos >= s->pos + n) break;
+
+		start = wide ? (uint64_t) ((long long *) counts)[pos - s->pos] :
+			((uint32_t *) counts)[pos - s->pos];
+		total = start;
+		for (w = 0; w < s->workers; w++) {
+			if (s->next[w].pos != pos) continue;
+			total += s->next[w].value - start;
+			read_counter_entry(s, w);
+		}
+
+		if (wide)
+			((long long *) counts)[pos - s->pos] = (long long) total;
+		else
+			((uint32_t *) counts)[pos - s->pos] = (uint32_t) total;
+	}
+	s->pos += n;
+}
+
+/**
+ * Make the runs from first to last in num_jobs workers, and merge what they
+ * found into level_data
+ */
+static void stats_run_parallel(uint32_t first, uint32_t last, time_t start)
+{
+	struct counter_stream s = { 0 };
+	int progress[2];
+	pid_t *pids = mem_zalloc(num_jobs * sizeof(*pids));
+	uint32_t done = first - 1;
+	char tick;
+	int w;
+
+	s.workers = MIN(num_jobs, (int) (last - first + 1));
+	s.in = mem_zalloc(s.workers * sizeof(*s.in));
+	s.next = mem_zalloc(s.workers * sizeof(*s.next));
+
+	if (pipe(progress)) quit("Couldn't make a pipe for the workers!");
+	fflush(stdout);
+	for (w = 0; w < s.workers; w++) {
+		int data[2];
+
+		if (pipe(data)) quit("Couldn't make a pipe for the workers!");
+		pids[w] = fork();
+		if (pids[w] < 0) quit("Couldn't start a worker!");
+
+		if (pids[w] == 0) {
+			uint32_t run;
+
+			/* Leave the screen to the parent */
+			quiet = true;
+			close(progress[0]);
+			close(data[0]);
+			for (run = first + w; run <= last; run += s.workers) {
+				stats_run(run);
+				if (write(progress[1], "", 1) != 1) _exit(1);
+			}
+			close(progress[1]);
+
+			s.out = fdopen(data[1], "wb");
+			if (!s.out) _exit(1);
+			visit_counters(send_counter_block, &s);
+			s.next[0].pos = UINT64_MAX;
+			s.next[0].value = 0;
+			if (fwrite(&s.next[0], sizeof(s.next[0]), 1, s.out) != 1)
+				s.failed = true;
+			if (fclose(s.out)) s.failed = true;
+			_exit(s.failed ? 1 : 0);
+		}
+
+		close(data[1]);
+		s.in[w] = fdopen(data[0], "rb");
+		if (!s.in[w]) quit("Couldn't read from a worker!");
+	}
+	close(progress[1]);
+
+	/* Follow the runs until every worker is done with them */
+	while (read(progress[0], &tick, 1) == 1) {
+		done++;
+		if (!quiet) progress_bar(done, start);
+	}
+	close(progress[0]);
+
+	for (w = 0; w < s.workers; w++)
+		read_counter_entry(&s, w);
+	visit_counters(merge_counter_block, &s);
+
+	for (w = 0; w < s.workers; w++) {
+		int status;
+
+		fclose(s.in[w]);
+		if (waitpid(pids[w], &status, 0) < 0 || !WIFEXITED(status)
+				|| WEXITSTATUS(status))
+			s.failed = true;
+	}
+	if (s.failed || done != last) {
+		stats_db_close();
+		quit("A worker failed to finish its runs!");
+	}
+
+	mem_free(s.next);
+	mem_free(s.in);
+	mem_free(pids);
+}
+
+#endif /* UNIX */
+
 static errr run_stats(void)
 {
 	uint32_t run;
@@ -1515,14 +1741,34 @@ static errr run_stats(void)
 	}
 
 	start = time(NULL);
-	for (run = 1; run <= num_runs; run++) {
+	run = 1;
+#ifdef UNIX
+	/* Several at once, checkpointing between rounds */
+	for (; num_jobs > 1 && run <= num_runs; run += RUNS_PER_CHECKPOINT) {
+		uint32_t last = MIN(num_runs, run + RUNS_PER_CHECKPOINT - 1);
+
 		if (!quiet) progress_bar(run - 1, start);
+		stats_run_parallel(run, last, start);
 
-		initialize_character();
-		unkill_uniques();
-		reset_artifacts();
-		descend_dungeon();
-		stats_cleanup_angband_run();
+		if (last % RUNS_PER_CHECKPOINT == 0) {
+			err = stats_write_db(last);
+			if (err) {
+				stats_db_close();
+				quit_fmt("Problems writing to database!  sqlite3 errno %d.",
+						 err);
+			}
+		}
+
+		if (quiet) {
+			printf("Finished %d runs.\n", last);
+			fflush(stdout);
+		}
+	}
+#endif
+	for (; run <= num_runs; run++) {
+		if (!quiet) progress_bar(run - 1, start);
+
+		stats_run(run);
 
 		/* Checkpoint every so many runs */
 		if (run % RUNS_PER_CHECKPOINT == 0) {
@@ -1546,7 +1792,7 @@ static errr run_stats(void)
 		fflush(stdout);
 	}
 
-	err = stats_write_db(run);
+	err = stats_write_db(num_runs);
 	stats_db_close();
 	if (err) quit_fmt("Problems writing to database!  sqlite3 errno %d.", err);
 
@@ -1679,15 +1925,16 @@ static void term_data_link(int i) {
 	angband_term[i] = t;
 }
 
-const char help_stats[] = "Stats mode, subopts -q(uiet) -r(andarts) -n(# of runs) -s(no selling)";
+const char help_stats[] = "Stats mode, subopts -q(uiet) -r(andarts) -n(# of runs) -j(# of jobs) -s(no selling)";
 
 /**
  * Usage:
  *
- * angband -mstats -- [-q] [-r] [-nNNNN] [-s]
+ * angband -mstats -- [-q] [-r] [-nNNNN] [-jNN] [-s]
  *
  *   -q      Quiet mode (turn off progress messages)
  *   -nNNNN  Make NNNN runs through the dungeon (default: 1)
+ *   -jNN    Make NN runs at once (default: 1); needs a UNIX-like system
  *   -s      Turn on no-selling
  */
 
@@ -1704,6 +1951,16 @@ errr init_stats(int argc, char *argv[]) {
 			num_runs = atoi(&argv[i][2]);
 			continue;
 		}
+		if (prefix(argv[i], "-j")) {
+			num_jobs = MAX(1, atoi(&argv[i][2]));
+#ifndef UNIX
+			if (num_jobs > 1) {
+				printf("init-stats: runs are made one at a time here\n");
+				num_jobs = 1;
+			}
+#endif
+			continue;
+		}
 		if (prefix(argv[i], "-s")) {
 			no_selling = 1;
 			continue;
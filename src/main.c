@@ -388,6 +388,10 @@ int main(int argc, char *argv[])
 				if (*arg) arg_graphics = atoi(arg);
 				break;
 
+			case 'k':
+				use_data_cache = true;
+				break;
+
 			case 'u': {
 				if (!*arg) goto usage;
 
@@ -443,6 +447,7 @@ int main(int argc, char *argv[])
 				puts("  -l             Lists all savefiles you can play");
 				puts("  -w             Resurrect dead character (marks savefile)");
 				puts("  -g             Request graphics mode");
+				puts("  -k             Keep the parsed game data in a cache file to start faster");
 				puts("  -u<who>        Use your <who> savefile");
 				puts("  -d<dir>=<path> Override a specific directory with <path>. <path> can be:");
 				for (i = 0; i < (int)N_ELEMENTS(change_path_values); i++) {
@@ -1433,7 +1433,7 @@ static enum parser_error parse_monster_spells(struct parser *p) {
 static void add_alternate_spell_message(struct monster_race *r,
 		int s_idx, enum monster_altmsg_type msg_type, const char *msg)
 {
-	struct monster_altmsg *alt = mem_alloc(sizeof(*alt));
+	struct monster_altmsg *alt = mem_zalloc(sizeof(*alt));
 
 	alt->next = r->spell_msgs;
 	r->spell_msgs = alt;
@@ -1814,6 +1814,7 @@ static errr finish_parse_monster(struct parser *p) {
 		mem_free(r);
 	}
 	z_info->r_max += 1;
+	monster_name_index_build();
 
 	/* Convert friend and shape names into race pointers */
 	for (i = 0; i < z_info->r_max; i++) {
@@ -1844,16 +1845,25 @@ static errr finish_parse_monster(struct parser *p) {
 		}
 	}
 
-	/* Allocate space for the monster lore */
+	alloc_monster_lore();
+
+	parser_destroy(p);
+	return 0;
+}
+
+/**
+ * Allocate space for the monster lore, once the races are in place
+ */
+void alloc_monster_lore(void)
+{
+	size_t i;
+
 	l_list = mem_zalloc(z_info->r_max * sizeof(struct monster_lore));
 	for (i = 0; i < z_info->r_max; i++) {
 		struct monster_lore *l = &l_list[i];
 		l->blows = mem_zalloc(z_info->mon_blows_max * sizeof(struct monster_blow));
 		l->blow_known = mem_zalloc(z_info->mon_blows_max * sizeof(bool));
 	}
-
-	parser_destroy(p);
-	return 0;
 }
 
 static void cleanup_monster(void)
@@ -1919,6 +1929,7 @@ static void cleanup_monster(void)
 	 */
 	mem_free(r_info[z_info->r_max - 1].blow);
 
+	monster_name_index_free();
 	mem_free(r_info);
 }
 
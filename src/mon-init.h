@@ -32,5 +32,7 @@ extern struct file_parser ghost_parser;
 extern struct file_parser pit_parser;
 extern struct file_parser pain_parser;
 
+void alloc_monster_lore(void);
+
 
 #endif /* MONSTER_INIT_H_ */
@@ -24,6 +24,7 @@
 #include "mon-lore.h"
 #include "mon-make.h"
 #include "mon-predicate.h"
+#include "mon-schedule.h"
 #include "mon-spell.h"
 #include "mon-timed.h"
 #include "mon-util.h"
@@ -44,18 +45,86 @@ int **race_prob;
  *
  * Monster race allocation is done using an allocation table (see alloc.h).
  * This table is sorted by depth.  Each line of the table contains the
- * monster race index, the monster race level, and three probabilities:
+ * monster race index, the monster race level, and two probabilities:
  * - prob1 is the base probability of the race, calculated from monster.txt.
  * - prob2 is calculated by get_mon_num_prep(), which decides whether a
  *         monster is appropriate based on a secondary function; prob2 is
  *         always either prob1 or 0.
- * - prob3 is calculated by get_mon_num(), which checks whether universal
- *         restrictions apply (for example, unique monsters can only appear
- *         once on a given level); prob3 is always either prob2 or 0.
+ *
+ * get_mon_num() then works out which races can appear on the current level,
+ * and how often, as running totals of their probabilities (struct
+ * mon_num_dist below).  These depend only on the level asked for and things
+ * which seldom change, so the most recent few are kept for reuse.  Uniques
+ * which are already around (or dead) get no chance; they come and go seldom
+ * enough that the running totals are just worked out again when they do.
  * ------------------------------------------------------------------------ */
 static int16_t alloc_race_size;
 static struct alloc_entry *alloc_race_table;
 
+/**
+ * What the chances of each race appearing depend on, besides the uniques
+ * which are already around
+ */
+struct mon_num_key {
+	int level;		/* Level asked for */
+	int depth;		/* Player depth, for RF_FORCE_DEPTH */
+	int locality;		/* Locality and topography of the player's level */
+	int topography;
+	bool seasonal;		/* Whether seasonal monsters can appear */
+	bool local;		/* Whether locality monsters keep to their own */
+	uint32_t hook;		/* Restriction from get_mon_num_prep(); 0 for none */
+};
+
+/**
+ * The races which can appear for a given key, in allocation table order,
+ * with their probabilities and the running totals of those, leaving out the
+ * uniques which were gone when the totals were made
+ */
+struct mon_num_dist {
+	struct mon_num_key key;
+	int num;
+	int *prob;
+	long *total;
+	struct monster_race **race;
+	int num_uniques;
+	int *unique;		/* Where the uniques are among the races */
+	bool *gone;		/* Which of them the totals leave out */
+	uint32_t last_use;
+};
+
+#define MON_NUM_CACHE_SIZE	16
+
+static struct mon_num_dist mon_num_cache[MON_NUM_CACHE_SIZE];
+static uint32_t mon_num_uses;
+static uint32_t mon_num_hook;
+static uint32_t mon_num_hooks_made;
+
+static void mon_num_dist_alloc(struct mon_num_dist *dist)
+{
+	dist->prob = mem_zalloc(alloc_race_size * sizeof(*dist->prob));
+	dist->total = mem_zalloc(alloc_race_size * sizeof(*dist->total));
+	dist->race = mem_zalloc(alloc_race_size * sizeof(*dist->race));
+	dist->unique = mem_zalloc(alloc_race_size * sizeof(*dist->unique));
+	dist->gone = mem_zalloc(alloc_race_size * sizeof(*dist->gone));
+	dist->num = 0;
+	dist->num_uniques = 0;
+	dist->last_use = 0;
+}
+
+static void mon_num_dist_free(struct mon_num_dist *dist)
+{
+	mem_free(dist->prob);
+	mem_free(dist->total);
+	mem_free(dist->race);
+	mem_free(dist->unique);
+	mem_free(dist->gone);
+	dist->prob = NULL;
+	dist->total = NULL;
+	dist->race = NULL;
+	dist->unique = NULL;
+	dist->gone = NULL;
+}
+
 /**
  * Initialize monster allocation info
  */
@@ -129,7 +198,6 @@ static void init_race_allocs(void) {
 			table[race_index].level = lev;
 			table[race_index].prob1 = p;
 			table[race_index].prob2 = p;
-			table[race_index].prob3 = p;
 
 			/* Another entry complete for this locale */
 			already_counted[lev]++;
@@ -137,9 +205,21 @@ static void init_race_allocs(void) {
 	}
 	mem_free(already_counted);
 	mem_free(num);
+
+	/* Set up the distributions */
+	for (i = 0; i < MON_NUM_CACHE_SIZE; i++) {
+		mon_num_dist_alloc(&mon_num_cache[i]);
+	}
+	mon_num_uses = 0;
+	mon_num_hook = 0;
 }
 
 static void cleanup_race_allocs(void) {
+	int i;
+
+	for (i = 0; i < MON_NUM_CACHE_SIZE; i++) {
+		mon_num_dist_free(&mon_num_cache[i]);
+	}
 	mem_free(alloc_race_table);
 }
 
@@ -154,6 +234,17 @@ void get_mon_num_prep(bool (*get_mon_num_hook)(struct monster_race *race))
 {
 	int i;
 
+	/* Nothing to do if there was no restriction and still isn't */
+	if (!get_mon_num_hook && !mon_num_hook) return;
+
+	/* Hooks may depend on other things, so each call is a new restriction */
+	if (get_mon_num_hook) {
+		mon_num_hook = ++mon_num_hooks_made;
+		if (!mon_num_hook) mon_num_hook = ++mon_num_hooks_made;
+	} else {
+		mon_num_hook = 0;
+	}
+
 	/* Scan the allocation table */
 	for (i = 0; i < alloc_race_size; i++) {
 		alloc_entry *entry = &alloc_race_table[i];
@@ -171,57 +262,80 @@ void get_mon_num_prep(bool (*get_mon_num_hook)(struct monster_race *race))
 }
 
 /**
- * Helper function for get_mon_num(). Excludes monsters from selection
- * based on time, uniqueness, depth, locality, or topography
+ * Helper function for get_mon_num().  Work out what the chances of each race
+ * appearing at the given level depend on.
  */
-static bool get_mon_forbidden(struct monster_race *race)
+static void get_mon_num_key(struct mon_num_key *key, int generated_level)
 {
 	time_t cur_time = time(NULL);
 	struct tm *date = localtime(&cur_time);
 	struct level *lev = &world->levels[player->place];
 
-	/* No seasonal monsters outside of Christmas */
-	if (rf_has(race->flags, RF_SEASONAL) &&
-		!(date->tm_mon == 11 && date->tm_mday >= 24 && date->tm_mday <= 26))
-		return true;
+	/* Keys are compared whole, padding and all */
+	memset(key, 0, sizeof(*key));
+	key->level = generated_level;
+	key->depth = player->depth;
+	key->locality = lev->locality;
+	key->topography = lev->topography;
+	key->seasonal = date->tm_mon == 11 && date->tm_mday >= 24 &&
+		date->tm_mday <= 26;
+	key->local = !streq(world->name, "Angband Dungeon");
+	key->hook = mon_num_hook;
+}
 
-	/* Only one copy of a a unique must be around at the same time */
-	if (rf_has(race->flags, RF_UNIQUE) && (race->cur_num >= race->max_num))
+/**
+ * Helper function for get_mon_num().  Check for a unique which can't appear
+ * because it is already around (or dead).
+ */
+static bool get_mon_unique_gone(const struct monster_race *race)
+{
+	return rf_has(race->flags, RF_UNIQUE) && (race->cur_num >= race->max_num);
+}
+
+/**
+ * Helper function for get_mon_num(). Excludes monsters from selection
+ * based on time, depth, locality, or topography
+ */
+static bool get_mon_forbidden(const struct monster_race *race,
+		const struct mon_num_key *key)
+{
+	/* No seasonal monsters outside of Christmas */
+	if (rf_has(race->flags, RF_SEASONAL) && !key->seasonal)
 		return true;
 
 	/* Some monsters never appear out of depth */
-	if (rf_has(race->flags, RF_FORCE_DEPTH) && race->level > player->depth)
+	if (rf_has(race->flags, RF_FORCE_DEPTH) && race->level > key->depth)
 		return true;
 
 	/* Some monsters only appear in a given dungeon... */
-	if (rf_has(race->flags, RF_ANGBAND) && (lev->locality != LOC_ANGBAND))
+	if (rf_has(race->flags, RF_ANGBAND) && (key->locality != LOC_ANGBAND))
 		return true;
 
 	/* ...if it exists on the current map */
-	if (!streq(world->name, "Angband Dungeon")) {
+	if (key->local) {
 		if (rf_has(race->flags, RF_AMON_RUDH) &&
-			(lev->locality != LOC_AMON_RUDH)) {
+			(key->locality != LOC_AMON_RUDH)) {
 			return true;
 		} else if (rf_has(race->flags, RF_NARGOTHROND) &&
-				   (lev->locality != LOC_NARGOTHROND)) {
+				   (key->locality != LOC_NARGOTHROND)) {
 			return true;
 		} else if (rf_has(race->flags, RF_DUNGORTHEB) &&
-				   (lev->locality != LOC_NAN_DUNGORTHEB)) {
+				   (key->locality != LOC_NAN_DUNGORTHEB)) {
 			return true;
 		} else if (rf_has(race->flags, RF_GAURHOTH) &&
-				   (lev->locality != LOC_TOL_IN_GAURHOTH)) {
+				   (key->locality != LOC_TOL_IN_GAURHOTH)) {
 			return true;
 		}
 	}
 
 	/* Dungeon-only monsters */
-	if (rf_has(race->flags, RF_DUNGEON)	&& (lev->topography != TOP_CAVE)) {
+	if (rf_has(race->flags, RF_DUNGEON)	&& (key->topography != TOP_CAVE)) {
 		return true;
 	}
 
 	/* Flying monsters for mountaintop */
 	if (!rf_has(race->flags, RF_FLYING) &&
-		(lev->topography == TOP_MOUNTAINTOP)) {
+		(key->topography == TOP_MOUNTAINTOP)) {
 		return true;
 	}
 
@@ -235,12 +349,11 @@ static bool get_mon_forbidden(struct monster_race *race)
  * Ideally topography and locality and their effects on monsters would be
  * read from datafiles
  */
-static int get_mon_adjust(int prob, struct monster_race *race)
+static int get_mon_adjust(int prob, const struct monster_race *race,
+		const struct mon_num_key *key)
 {
-	struct level *lev = &world->levels[player->place];
-
 	/* Locality adjustments */
-	if (lev->locality == LOC_NAN_DUNGORTHEB) {
+	if (key->locality == LOC_NAN_DUNGORTHEB) {
 		/* Nan Dungortheb is spiderland, bad for humans and humanoids */
 		if (streq(race->base->name, "spider")) {
 			prob *= 5;
@@ -248,7 +361,7 @@ static int get_mon_adjust(int prob, struct monster_race *race)
 				   streq(race->base->name, "humanoid")) {
 			prob /= 3;
 		}
-	} else if (lev->locality == LOC_TOL_IN_GAURHOTH) {
+	} else if (key->locality == LOC_TOL_IN_GAURHOTH) {
 		/* Tol-In-Gaurhoth is full of wolves and undead */
 		if (streq(race->base->name, "wolf")) {
 			prob *= 4;
@@ -258,7 +371,7 @@ static int get_mon_adjust(int prob, struct monster_race *race)
 	}
 
 	/* Topography adjustments */
-	if ((lev->topography == TOP_DESERT)	|| (lev->topography == TOP_MOUNTAIN)) {
+	if ((key->topography == TOP_DESERT) || (key->topography == TOP_MOUNTAIN)) {
 		/* Some animals love desert and mountains, most don't */
 		if (streq(race->base->name, "reptile") ||
 			streq(race->base->name, "snake") ||
@@ -267,7 +380,7 @@ static int get_mon_adjust(int prob, struct monster_race *race)
 		} else if (rf_has(race->flags, RF_ANIMAL)) {
 			prob /= 2;
 		}
-	} else if (lev->topography == TOP_FOREST) {
+	} else if (key->topography == TOP_FOREST) {
 		/* Most animals do like forest */
 		if (streq(race->base->name, "reptile")) {
 			prob /= 2;
@@ -281,28 +394,135 @@ static int get_mon_adjust(int prob, struct monster_race *race)
 }
 
 /**
- * Helper function for get_mon_num(). Scans the prepared monster allocation
- * table and picks a random monster. Returns the index of a monster in
- * `table`.
+ * Helper function for get_mon_num().  Work out the running totals of the
+ * probabilities in dist, leaving out uniques which are already around;
+ * those are left with no width, so are never picked.
  */
-static struct monster_race *get_mon_race_aux(long total,
-											 const alloc_entry *table)
+static void get_mon_num_totals(struct mon_num_dist *dist)
 {
+	long total = 0L;
 	int i;
 
-	/* Pick a monster */
-	long value = randint0(total);
+	for (i = 0; i < dist->num; i++) {
+		if (!get_mon_unique_gone(dist->race[i])) total += dist->prob[i];
+		dist->total[i] = total;
+	}
+	for (i = 0; i < dist->num_uniques; i++) {
+		dist->gone[i] = get_mon_unique_gone(dist->race[dist->unique[i]]);
+	}
+}
+
+/**
+ * Helper function for get_mon_num().  Check whether any unique in dist has
+ * come or gone since its running totals were worked out.
+ */
+static bool get_mon_num_stale(const struct mon_num_dist *dist)
+{
+	int i;
+
+	for (i = 0; i < dist->num_uniques; i++) {
+		if (dist->gone[i] !=
+				get_mon_unique_gone(dist->race[dist->unique[i]])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Helper function for get_mon_num().  Make the distribution of races for
+ * dist->key from the prepared monster allocation table.
+ */
+static void get_mon_num_build(struct mon_num_dist *dist)
+{
+	const struct mon_num_key *key = &dist->key;
+	int i;
 
-	/* Find the monster */
+	dist->num = 0;
+	dist->num_uniques = 0;
 	for (i = 0; i < alloc_race_size; i++) {
-		/* Found the entry */
-		if (value < table[i].prob3) break;
+		const alloc_entry *entry = &alloc_race_table[i];
+		struct monster_race *race = &r_info[entry->index];
+		int prob;
+
+		/* Monsters are sorted by depth */
+		if (entry->level > key->level) break;
+
+		/* No town monsters in dungeon */
+		if (key->level > 0 && entry->level <= 0) continue;
+
+		/* Left out by get_mon_num_prep() */
+		if (!entry->prob2) continue;
+
+		/* Some monsters will not be allowed on the current level */
+		if (get_mon_forbidden(race, key)) continue;
+
+		/* Adjust for locality and topography */
+		prob = get_mon_adjust(entry->prob2, race, key);
+		if (prob <= 0) continue;
 
-		/* Decrement */
-		value -= table[i].prob3;
+		/* Keep track of the uniques */
+		if (rf_has(race->flags, RF_UNIQUE)) {
+			dist->unique[dist->num_uniques++] = dist->num;
+		}
+		dist->prob[dist->num] = prob;
+		dist->race[dist->num] = race;
+		dist->num++;
+	}
+	get_mon_num_totals(dist);
+}
+
+/**
+ * Helper function for get_mon_num().  Find the distribution of races for
+ * 'key', making it if it hasn't been made recently.
+ */
+static struct mon_num_dist *get_mon_num_dist(const struct mon_num_key *key)
+{
+	struct mon_num_dist *dist = &mon_num_cache[0];
+	int i;
+
+	for (i = 0; i < MON_NUM_CACHE_SIZE; i++) {
+		struct mon_num_dist *try = &mon_num_cache[i];
+
+		if (try->last_use && !memcmp(&try->key, key, sizeof(*key))) {
+			try->last_use = ++mon_num_uses;
+			if (get_mon_num_stale(try)) get_mon_num_totals(try);
+			return try;
+		}
+
+		/* Replace the least recently used if not found */
+		if (try->last_use < dist->last_use) dist = try;
 	}
 
-	return &r_info[table[i].index];
+	dist->key = *key;
+	get_mon_num_build(dist);
+	dist->last_use = ++mon_num_uses;
+	return dist;
+}
+
+/**
+ * Helper function for get_mon_num().  Pick a random race from a
+ * distribution; this lands on the same race as going through the races in
+ * order, taking off the chance of each, would.
+ */
+static struct monster_race *get_mon_race_aux(const struct mon_num_dist *dist)
+{
+	/* Pick a monster */
+	long value = randint0(dist->total[dist->num - 1]);
+	int low = 0, high = dist->num - 1;
+
+	/* Find the first race whose running total is past the value */
+	while (low < high) {
+		int mid = (low + high) / 2;
+
+		if (dist->total[mid] > value) {
+			high = mid;
+		} else {
+			low = mid + 1;
+		}
+	}
+
+	return dist->race[low];
 }
 
 /**
@@ -313,8 +533,8 @@ static struct monster_race *get_mon_race_aux(long total,
  * for checks on an out-of-depth monster.
  *
  * This function uses the "prob2" field of the monster allocation table,
- * and various local information, to calculate the "prob3" field of the
- * same table, which is then used to choose an appropriate monster, in
+ * and various local information, to work out the chances of each race
+ * appearing, which are then used to choose an appropriate monster, in
  * a relatively efficient manner.
  *
  * Note that town monsters will *only* be created in the town, and
@@ -333,50 +553,25 @@ static struct monster_race *get_mon_race_aux(long total,
  */
 struct monster_race *get_mon_num(int generated_level, int current_level)
 {
-	int i, p;
-	long total;
+	int p;
+	struct mon_num_key key;
+	struct mon_num_dist *dist;
 	struct monster_race *race;
-	alloc_entry *table = alloc_race_table;
 
 	/* Occasionally produce a nastier monster in the dungeon */
 	if (generated_level > 0 && one_in_(z_info->ood_monster_chance))
 		generated_level += MIN(generated_level / 4 + 2,
 			z_info->ood_monster_amount);
 
-	total = 0L;
-
-	/* Process probabilities */
-	for (i = 0; i < alloc_race_size; i++) {
-		/* Monsters are sorted by depth */
-		if (table[i].level > generated_level) break;
-
-		/* Default */
-		table[i].prob3 = 0;
-
-		/* No town monsters in dungeon */
-		if (generated_level > 0 && table[i].level <= 0) continue;
-
-		/* Get the chosen monster */
-		race = &r_info[table[i].index];
-
-		/* Some monsters will not be allowed on the current level */
-		if (get_mon_forbidden(race)) continue;
-
-		/* Accept */
-		table[i].prob3 = table[i].prob2;
-
-		/* Adjust for locality and topography */
-		table[i].prob3 = get_mon_adjust(table[i].prob3, race);
-
-		/* Total */
-		total += table[i].prob3;
-	}
+	/* Get the chances of each race */
+	get_mon_num_key(&key, generated_level);
+	dist = get_mon_num_dist(&key);
 
 	/* No legal monsters */
-	if (total <= 0) return NULL;
+	if (!dist->num || dist->total[dist->num - 1] <= 0) return NULL;
 
 	/* Pick a monster */
-	race = get_mon_race_aux(total, table);
+	race = get_mon_race_aux(dist);
 
 	/* Try for a "harder" monster once (50%) or twice (10%) */
 	p = randint0(100);
@@ -385,7 +580,7 @@ struct monster_race *get_mon_num(int generated_level, int current_level)
 		struct monster_race *old = race;
 
 		/* Pick a new monster */
-		race = get_mon_race_aux(total, table);
+		race = get_mon_race_aux(dist);
 
 		/* Keep the deepest one */
 		if (race->level < old->level) race = old;
@@ -396,7 +591,7 @@ struct monster_race *get_mon_num(int generated_level, int current_level)
 		struct monster_race *old = race;
 
 		/* Pick a monster */
-		race = get_mon_race_aux(total, table);
+		race = get_mon_race_aux(dist);
 
 		/* Keep the deepest one */
 		if (race->level < old->level) race = old;
@@ -933,15 +1128,14 @@ void delete_monster_idx(struct chunk *c, int m_idx)
 		(void) player_clear_timed(player, TMD_COMMAND, true, true);
 	}
 
-	/* Monster is gone from square and group, and no longer targeted */
+	/* Monster is gone from square, group and schedule, and no longer
+	 * targeted */
+	monster_schedule_remove(c, mon);
 	square_set_mon(c, grid, 0);
 	monster_remove_from_groups(c, mon);
 	monster_remove_from_targets(c, mon);
 
-	/* Free any heatmaps */
-	if (mon->noise.grids) {
-		heatmap_free(c, mon->noise);
-	}
+	/* Free any scent trail */
 	if (mon->scent.grids) {
 		heatmap_free(c, mon->scent);
 	}
@@ -1020,8 +1214,8 @@ void delete_monster(struct chunk *c, struct loc grid)
 	assert(square_in_bounds(c, grid));
 
 	/* Delete the monster (if any) */
-	if (square(c, grid)->mon > 0)
-		delete_monster_idx(c, square(c, grid)->mon);
+	if (square(c, grid).mon > 0)
+		delete_monster_idx(c, square(c, grid).mon);
 }
 
 
@@ -1042,6 +1236,9 @@ void monster_index_move(struct chunk *c, int i1, int i2)
 	mon = cave_monster(c, i1);
 	if (!mon) return;
 
+	/* Update the schedule */
+	monster_schedule_move(c, i1, i2);
+
 	/* Update the cave */
 	square_set_mon(c, mon->grid, i2);
 
@@ -1261,6 +1458,9 @@ void wipe_mon_list(struct chunk *c, struct player *p)
 	/* Reset "reproducer" count */
 	c->num_repro = 0;
 
+	/* Nothing to schedule */
+	monster_schedule_free(c);
+
 	/* Hack -- no more target */
 	target_set_monster(0);
 
@@ -1751,6 +1951,9 @@ int16_t place_monster(struct chunk *c, struct loc grid, struct monster *mon,
 	/* Assign monster to its monster group, or update its entry */
 	monster_group_assign(c, new_mon, info, loading);
 
+	/* Schedule it */
+	monster_schedule_add(c, new_mon);
+
 	update_mon(new_mon, c, true);
 
 	/* Count the number of "reproducers" */
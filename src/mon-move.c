@@ -34,6 +34,7 @@
 #include "mon-make.h"
 #include "mon-move.h"
 #include "mon-predicate.h"
+#include "mon-schedule.h"
 #include "mon-spell.h"
 #include "mon-util.h"
 #include "mon-timed.h"
@@ -112,16 +113,17 @@ static bool monster_can_hear(struct monster *mon)
 		noise_map = cave->noise;
 		hearing -= player->state.skills[SKILL_STEALTH] / 3;
 	} else if (mon->target.midx > 0) {
-		noise_map = cave_monster(cave, mon->target.midx)->noise;
+		noise_map = *monster_noise(cave,
+			cave_monster(cave, mon->target.midx), hearing);
 	} else {
 		return false;
 	}
 
 	/* Try and hear */
-	if (noise_map.grids[mon->grid.y][mon->grid.x] == 0) {
+	if (heatmap_get(noise_map, mon->grid) == 0) {
 		return false;
 	}
-	return hearing > noise_map.grids[mon->grid.y][mon->grid.x];
+	return hearing > heatmap_get(noise_map, mon->grid);
 }
 
 /**
@@ -400,7 +402,7 @@ static bool get_move_bodyguard(struct monster *mon)
  * Choose the best direction to advance toward the player, using sound or scent.
  *
  * Ghosts and rock-eaters generally just head straight for the player. Other
- * monsters try sight, then current sound as saved in cave->noise.grids[y][x],
+ * monsters try sight, then current sound as saved in cave->noise,
  * then current scent as saved in cave->scent.grids[y][x].
  *
  * This function assumes the monster is moving to an adjacent grid, and so the
@@ -460,7 +462,8 @@ static bool get_move_advance(struct monster *mon, bool *track)
 		hearing -= player->state.skills[SKILL_STEALTH] / 3;
 	} else if (mon->target.midx > 0) {
 		/* Monster */
-		noise_map = cave_monster(cave, mon->target.midx)->noise;
+		noise_map = *monster_noise(cave,
+			cave_monster(cave, mon->target.midx), hearing);
 	} else {
 		/* Location */
 		best_grid = target;
@@ -469,13 +472,13 @@ static bool get_move_advance(struct monster *mon, bool *track)
 
 	/* Try to use sound */
 	if (monster_can_hear(mon)) {
-		int current_noise = hearing - noise_map.grids[mon->grid.y][mon->grid.x];
+		int current_noise = hearing - heatmap_get(noise_map, mon->grid);
 
 		/* Check nearby sound, giving preference to the cardinal directions */
 		for (i = 0; i < 8; i++) {
 			/* Get the location */
 			struct loc grid = loc_sum(mon->grid, ddgrid_ddd[i]);
-			int heard_noise = hearing - noise_map.grids[grid.y][grid.x];
+			int heard_noise = hearing - heatmap_get(noise_map, grid);
 
 			/* Bounds check */
 			if (!square_in_bounds(cave, grid)) {
@@ -483,7 +486,7 @@ static bool get_move_advance(struct monster *mon, bool *track)
 			}
 
 			/* Must be some noise */
-			if (noise_map.grids[grid.y][grid.x] == 0) {
+			if (heatmap_get(noise_map, grid) == 0) {
 				continue;
 			}
 
@@ -594,6 +597,9 @@ static bool get_move_find_safety(struct monster *mon)
 	const int *y_offsets;
 	const int *x_offsets;
 
+	/* Noise is compared however far away from the player this is */
+	make_noise_everywhere(cave);
+
 	/* Start with adjacent locations, spread further */
 	for (d = 1; d < 10; d++) {
 		struct loc best = loc(0, 0);
@@ -615,8 +621,8 @@ static bool get_move_find_safety(struct monster *mon)
 			if (!square_ispassable(cave, grid)) continue;
 
 			/* Ignore too-distant grids */
-			if (cave->noise.grids[grid.y][grid.x] >
-				cave->noise.grids[mon->grid.y][mon->grid.x] + 2 * d)
+			if (heatmap_get(cave->noise, grid) >
+				heatmap_get(cave->noise, mon->grid) + 2 * d)
 				continue;
 
 			/* Ignore damaging terrain if they can't handle it */
@@ -739,6 +745,9 @@ static bool get_move_flee(struct monster *mon)
 		}
 	}
 
+	/* The player's noise is needed around the monster, even out of earshot */
+	make_noise_everywhere(cave);
+
 	/* Check nearby grids, diagonals first */
 	for (i = 7; i >= 0; i--) {
 		int dis, score;
@@ -756,7 +765,7 @@ static bool get_move_flee(struct monster *mon)
 		 * First half of calculation is inversely proportional to distance
 		 * Second half is inversely proportional to grid's distance from player
 		 */
-		score = 5000 / (dis + 3) - 500 /(cave->noise.grids[grid.y][grid.x] + 1);
+		score = 5000 / (dis + 3) - 500 /(heatmap_get(cave->noise, grid) + 1);
 
 		/* No negative scores */
 		if (score < 0) score = 0;
@@ -1093,7 +1102,7 @@ static bool monster_turn_multiply(struct monster *mon)
 	/* Count the adjacent monsters */
 	for (y = mon->grid.y - 1; y <= mon->grid.y + 1; y++)
 		for (x = mon->grid.x - 1; x <= mon->grid.x + 1; x++)
-			if (square(cave, loc(x, y))->mon > 0) k++;
+			if (square(cave, loc(x, y)).mon > 0) k++;
 
 	/* Multiply slower in crowded areas */
 	if ((k < 4) && (k == 0 || one_in_(k * z_info->repro_monster_rate))) {
@@ -1958,12 +1967,12 @@ static void monster_reduce_sleep(struct monster *mon)
 		}
 	} else if ((notice * notice * notice) <= player_noise) {
 		int sleep_reduction = 1;
-		int local_noise = cave->noise.grids[mon->grid.y][mon->grid.x];
+		int local_noise = heatmap_get(cave->noise, mon->grid);
 		bool woke_up = false;
 
 		/* Test - wake up faster in hearing distance of the player 
 		 * Note no dependence on stealth for now */
-		if ((local_noise > 0) && (local_noise < 50)) {
+		if ((local_noise > 0) && (local_noise < NOISE_WAKE_RANGE)) {
 			sleep_reduction = (100 / local_noise);
 		}
 
@@ -2079,6 +2088,62 @@ static void regen_monster(struct monster *mon, int num)
  * ------------------------------------------------------------------------
  * Monster processing routines to be called by the main game loop
  * ------------------------------------------------------------------------ */
+/**
+ * Give a monster its energy for this game turn, and let it take its turn if
+ * it has enough energy to move.  Returns true if it took its turn but, being
+ * passive, did nothing.
+ */
+static bool process_monster(struct monster *mon, bool regen)
+{
+	/* Does this monster have enough energy to move? */
+	bool moving = mon->energy >= z_info->move_energy ? true : false;
+
+	/* Prevent reprocessing */
+	monster_schedule_handle(cave, mon);
+
+	/* Handle monster regeneration if requested */
+	if (regen)
+		regen_monster(mon, 1);
+
+	/* Give this monster some energy */
+	mon->energy += monster_turn_energy(mon);
+
+	/* End the turn of monsters without enough energy to move */
+	if (!moving)
+		return false;
+
+	/* Use up "some" energy */
+	mon->energy -= z_info->move_energy;
+
+	/* Mimics lie in wait */
+	if (monster_is_mimicking(mon)) return false;
+
+	/* Check if the monster is active */
+	if (monster_check_active(mon)) {
+		/* Process timed effects - skip turn if necessary */
+		if (process_monster_timed(mon))
+			return false;
+
+		/* Set this monster to be the current actor */
+		cave->mon_current = mon->midx;
+
+		/* The monster takes its turn */
+		monster_turn(mon);
+
+		/*
+		 * For symmetry with the player, monster can take
+		 * terrain damage after its turn.
+		 */
+		monster_take_terrain_damage(mon);
+
+		/* Monster is no longer current */
+		cave->mon_current = -1;
+		return false;
+	}
+
+	return true;
+}
+
 /**
  * Process all the "live" monsters, once per game turn.
  *
@@ -2086,6 +2151,12 @@ static void regen_monster(struct monster *mon, int num)
  * (backwards, so we can excise any "freshly dead" monsters), energizing each
  * monster, and allowing fully energized monsters to move, attack, pass, etc.
  *
+ * Usually the level's monster schedule can say which monsters are due to
+ * move, and the rest get their energy when it is next wanted, so only the
+ * monsters which move are visited, in the same order as the scan would.
+ * Passive monsters after the player are then left dormant until something
+ * they could notice changes, as all their turns would do is pass.
+ *
  * This function and its children are responsible for a considerable fraction
  * of the processor time in normal situations, greater if the character is
  * resting.
@@ -2093,7 +2164,6 @@ static void regen_monster(struct monster *mon, int num)
 void process_monsters(int minimum_energy)
 {
 	int i;
-	int mspeed;
 
 	/* Only process some things every so often */
 	bool regen = false;
@@ -2102,77 +2172,46 @@ void process_monsters(int minimum_energy)
 	if (turn % 100 == 0)
 		regen = true;
 
-	/* Process the monsters (backwards) */
-	for (i = cave_monster_max(cave) - 1; i >= 1; i--) {
-		struct monster *mon;
-		bool moving;
-
-		/* Handle "leaving" */
-		if (player->is_dead || player->upkeep->generate_level) break;
-
-		/* Get a 'live' monster */
-		mon = cave_monster(cave, i);
-		if (!mon->race) continue;
-
-		/* Ignore monsters that have already been handled */
-		if (mflag_has(mon->mflag, MFLAG_HANDLED))
-			continue;
-
-		/* Not enough energy to move yet */
-		if (mon->energy < minimum_energy) continue;
-
-		/* Does this monster have enough energy to move? */
-		moving = mon->energy >= z_info->move_energy ? true : false;
+	if (monster_schedule_begin(cave, minimum_energy, regen)) {
+		/* Process the monsters due to move (backwards) */
+		i = cave_monster_max(cave);
+		while (!player->is_dead && !player->upkeep->generate_level) {
+			struct monster *mon;
 
-		/* Prevent reprocessing */
-		mflag_on(mon->mflag, MFLAG_HANDLED);
+			i = monster_schedule_next(cave, i);
+			if (i < 1) break;
+			mon = cave_monster(cave, i);
 
-		/* Handle monster regeneration if requested */
-		if (regen)
-			regen_monster(mon, 1);
+			/* Not enough energy to move yet */
+			if (mon->energy < minimum_energy) continue;
 
-		/* Calculate the net speed */
-		mspeed = mon->mspeed;
-		if (mon->m_timed[MON_TMD_FAST])
-			mspeed += 10;
-		if (mon->m_timed[MON_TMD_SLOW]) {
-			int slow_level = monster_effect_level(mon, MON_TMD_SLOW);
-			mspeed -= (2 * slow_level);
+			/* Leave passive monsters be, or work out when they move next */
+			if (process_monster(mon, regen) && mon->target.midx == -1) {
+				monster_schedule_park(cave, mon);
+			} else if (mon->race) {
+				monster_schedule_update(cave, mon);
+			}
 		}
+	} else {
+		/* Process the monsters (backwards) */
+		for (i = cave_monster_max(cave) - 1; i >= 1; i--) {
+			struct monster *mon;
 
-		/* Give this monster some energy */
-		mon->energy += turn_energy(mspeed);
-
-		/* End the turn of monsters without enough energy to move */
-		if (!moving)
-			continue;
-
-		/* Use up "some" energy */
-		mon->energy -= z_info->move_energy;
+			/* Handle "leaving" */
+			if (player->is_dead || player->upkeep->generate_level) break;
 
-		/* Mimics lie in wait */
-		if (monster_is_mimicking(mon)) continue;
+			/* Get a 'live' monster */
+			mon = cave_monster(cave, i);
+			if (!mon->race) continue;
 
-		/* Check if the monster is active */
-		if (monster_check_active(mon)) {
-			/* Process timed effects - skip turn if necessary */
-			if (process_monster_timed(mon))
+			/* Ignore monsters that have already been handled */
+			if (mflag_has(mon->mflag, MFLAG_HANDLED))
 				continue;
 
-			/* Set this monster to be the current actor */
-			cave->mon_current = i;
-
-			/* The monster takes its turn */
-			monster_turn(mon);
+			/* Not enough energy to move yet */
+			if (mon->energy < minimum_energy) continue;
 
-			/*
-			 * For symmetry with the player, monster can take
-			 * terrain damage after its turn.
-			 */
-			monster_take_terrain_damage(mon);
-
-			/* Monster is no longer current */
-			cave->mon_current = -1;
+			(void) process_monster(mon, regen);
 		}
 	}
 
@@ -2191,6 +2230,9 @@ void reset_monsters(void)
 	int i;
 	struct monster *mon;
 
+	/* Nothing to clear if the game turn went by the schedule */
+	if (monster_schedule_next_turn(cave)) return;
+
 	/* Process the monsters (backwards) */
 	for (i = cave_monster_max(cave) - 1; i >= 1; i--) {
 		/* Access the monster */
@@ -2199,6 +2241,9 @@ void reset_monsters(void)
 		/* Monster is ready to go again */
 		mflag_off(mon->mflag, MFLAG_HANDLED);
 	}
+
+	/* Schedule the monsters from here on */
+	monster_schedule_new(cave);
 }
 
 /**
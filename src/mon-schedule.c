@@ -0,0 +1,598 @@
+/**
+ * \file mon-schedule.c
+ * \brief Scheduling of monster turns by the game turn they next move
+ *
+ * Copyright (c) 2026 StukovTTV
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#include "angband.h"
+#include "game-world.h"
+#include "init.h"
+#include "mon-schedule.h"
+#include "mon-timed.h"
+#include "monster.h"
+
+/**
+ * Each game turn process_monsters() gives every monster on the level its
+ * energy for the turn, and lets those with enough energy move.  Most game
+ * turns most monsters are only gaining energy, and how much they gain each
+ * turn depends only on their speed, so the schedule keeps the energy of those
+ * monsters as it was at some game turn together with the energy they gain a
+ * turn, and gives it to them only when they are due to move, or when their
+ * speed or energy changes, or when something wants to know it.  The monsters
+ * due to move on each of the next few game turns are kept in a timing wheel
+ * of bitmaps by monster index, so a game turn only visits those monsters, in
+ * the same order as a full pass through the monster list would.
+ *
+ * A game turn here runs from one reset_monsters() to the next, and has one
+ * pass of process_monsters(0), which reaches every monster not handled by an
+ * earlier pass with a higher minimum that turn.  A monster "passed" by that
+ * pass has had its energy for the turn, unless it was placed after the pass
+ * went by its index, in which case it gets no energy until the next turn, as
+ * process_monsters() would have missed it.  Passes with a minimum, made when
+ * the player has energy to spare, only reach the monsters due to move.  On
+ * game turns when monsters regenerate, the hurt monsters are due as well.
+ * Game turns the schedule can't follow cheaply - those in which a pass is cut
+ * short, or the pass with no minimum is made twice - put the energies back in
+ * the monsters, and the next game turn is scheduled afresh.
+ *
+ * A monster which finds on its turn that it is passive (see
+ * monster_check_active()) and is after the player is left dormant: it isn't
+ * due to move at all, and its energy comes and goes on its turns as if it
+ * had been given them, until something it could notice changes - its health,
+ * grid, target or shape, the terrain under it, whether the player can see
+ * its grid, the player's distance, noise, scent or stealth - and it is
+ * stirred back into the schedule.  Passive monsters only gain and spend
+ * energy on their turns, so that is all that is skipped.
+ *
+ * The monsters' own energies and MFLAG_HANDLED are only exact when the chunk
+ * has no schedule, which monster_schedule_drop() sees to, or for a monster
+ * just given to monster_schedule_sync().
+ */
+
+/**
+ * Timing of one monster, by index
+ */
+struct monster_timing {
+	int32_t from;		/* First game turn whose energy is not yet given */
+	int32_t handled;	/* Last game turn the monster was handled in */
+	int32_t due;		/* Game turn the monster next moves, or -1 */
+	int16_t gain;		/* Energy gained a game turn at its current speed */
+	bool dormant;		/* Left be until something stirs it */
+};
+
+struct monster_schedule {
+	int32_t tick;		/* Game turns scheduled on this chunk */
+	int minimum;		/* Minimum energy of the current pass */
+	int least;		/* Least minimum of earlier passes this game turn */
+	bool passing;		/* The current pass has a minimum */
+	bool sweeping;		/* The pass with no minimum has begun */
+	int passed;		/* and has passed the monsters above this index */
+	bool regen;		/* Monsters regenerate this game turn */
+	int stealth;		/* Player stealth the dormant monsters had to hear */
+	int dormant;		/* Dormant monsters */
+	int slots;		/* Game turns in the wheel, a power of two */
+	int words;		/* Words in the bitmap for each game turn */
+	uint64_t *due;		/* The bitmaps of monsters due to move */
+	struct monster_timing *timing;
+};
+
+#define SCHEDULE_BITS 64
+
+/**
+ * Index of the highest bit set in a non-zero word
+ */
+static int highest_bit(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return SCHEDULE_BITS - 1 - __builtin_clzll(word);
+#else
+	int n = SCHEDULE_BITS - 1;
+
+	while (!(word >> n)) {
+		n--;
+	}
+	return n;
+#endif
+}
+
+/**
+ * The bitmap of monsters due to move on a game turn
+ */
+static uint64_t *slot_bits(struct monster_schedule *s, int32_t tick)
+{
+	return s->due + (tick & (s->slots - 1)) * s->words;
+}
+
+/**
+ * Change the game turn a monster is due to move
+ */
+static void set_due(struct monster_schedule *s, int idx, int32_t due)
+{
+	struct monster_timing *t = &s->timing[idx];
+	uint64_t bit = (uint64_t) 1 << (idx % SCHEDULE_BITS);
+
+	if (t->due >= 0) {
+		slot_bits(s, t->due)[idx / SCHEDULE_BITS] &= ~bit;
+	}
+	t->due = due;
+	if (due >= 0) {
+		slot_bits(s, due)[idx / SCHEDULE_BITS] |= bit;
+	}
+}
+
+/**
+ * Whether the pass with no minimum this game turn has gone by an index
+ */
+static bool swept(const struct monster_schedule *s, int idx)
+{
+	return s->sweeping && idx > s->passed;
+}
+
+/**
+ * A monster's energy some game turns on from the given energy; a dormant
+ * monster spends move_energy on each turn it starts with enough to move,
+ * which comes to once for each move_energy it has gained by the start of the
+ * last turn, as long as it started with less than twice move_energy
+ */
+static int gained(const struct monster_timing *t, int energy, int32_t turns)
+{
+	int32_t before;
+
+	if (turns <= 0) return energy;
+	if (!t->dormant) return energy + turns * t->gain;
+	before = energy + (turns - 1) * t->gain;
+	return energy + turns * t->gain -
+		(before / z_info->move_energy) * z_info->move_energy;
+}
+
+/**
+ * Whether the passes so far this game turn have handled a monster without
+ * visiting it, given its energy at the start of the turn; dormant monsters
+ * are handled by any pass which reaches them, as they would have been
+ */
+static bool passed_by(const struct monster_schedule *s, int idx,
+		const struct monster_timing *t, int energy)
+{
+	if (swept(s, idx)) return true;
+	if (!t->dormant) return false;
+	return energy >= s->least || (s->passing && energy >= s->minimum
+		&& idx > s->passed);
+}
+
+/**
+ * Whether a monster has been handled this game turn
+ */
+static bool handled_now(const struct monster_schedule *s,
+		const struct monster *mon)
+{
+	const struct monster_timing *t = &s->timing[mon->midx];
+
+	if (t->handled == s->tick) return true;
+	return t->from <= s->tick && passed_by(s, mon->midx, t,
+		gained(t, mon->energy, s->tick - t->from));
+}
+
+/**
+ * A monster's energy, with all it has gained so far
+ */
+static int energy_now(const struct monster_schedule *s,
+		const struct monster *mon)
+{
+	const struct monster_timing *t = &s->timing[mon->midx];
+	int32_t turns = s->tick - t->from;
+
+	if (turns < 0) return mon->energy;
+	if (passed_by(s, mon->midx, t, gained(t, mon->energy, turns))) turns++;
+	return gained(t, mon->energy, turns);
+}
+
+/**
+ * Work out when a monster whose energy is up to date next moves
+ */
+static void schedule_due(struct monster_schedule *s, int idx,
+		const struct monster *mon)
+{
+	struct monster_timing *t = &s->timing[idx];
+	int32_t due = -1;
+
+	t->gain = monster_turn_energy(mon);
+	if (mon->energy >= z_info->move_energy) {
+		due = t->from;
+	} else if (s->regen && t->from == s->tick && mon->hp < mon->maxhp) {
+		/* Regenerates when the passes reach it */
+		due = s->tick;
+	} else if (t->gain > 0) {
+		due = t->from + (z_info->move_energy - mon->energy + t->gain - 1) /
+			t->gain;
+	}
+	set_due(s, idx, due);
+}
+
+/**
+ * Energy a monster gains each game turn at its current speed
+ */
+int monster_turn_energy(const struct monster *mon)
+{
+	int mspeed = mon->mspeed;
+
+	if (mon->m_timed[MON_TMD_FAST])
+		mspeed += 10;
+	if (mon->m_timed[MON_TMD_SLOW]) {
+		int slow_level = monster_effect_level(mon, MON_TMD_SLOW);
+		mspeed -= (2 * slow_level);
+	}
+	return turn_energy(mspeed);
+}
+
+/**
+ * Schedule the monsters of a chunk from their energies, at the start of a
+ * game turn with none of them handled
+ */
+void monster_schedule_new(struct chunk *c)
+{
+	struct monster_schedule *s;
+	int n = z_info->level_monster_max + 1;
+	int i;
+
+	monster_schedule_free(c);
+	s = mem_zalloc(sizeof(*s));
+	s->slots = 1;
+	while (s->slots < z_info->move_energy + 2) {
+		s->slots <<= 1;
+	}
+	s->words = (n + SCHEDULE_BITS - 1) / SCHEDULE_BITS;
+	s->due = mem_zalloc(s->slots * s->words * sizeof(*s->due));
+	s->timing = mem_zalloc(n * sizeof(*s->timing));
+	for (i = 0; i < n; i++) {
+		s->timing[i].handled = -1;
+		s->timing[i].due = -1;
+	}
+	s->least = INT_MAX;
+	s->stealth = player->state.skills[SKILL_STEALTH];
+	c->schedule = s;
+
+	for (i = 1; i < cave_monster_max(c); i++) {
+		struct monster *mon = cave_monster(c, i);
+
+		if (mon->race) monster_schedule_add(c, mon);
+	}
+}
+
+/**
+ * Free the schedule of a chunk, without giving the monsters their energy
+ */
+void monster_schedule_free(struct chunk *c)
+{
+	if (!c->schedule) return;
+	mem_free(c->schedule->due);
+	mem_free(c->schedule->timing);
+	mem_free(c->schedule);
+	c->schedule = NULL;
+}
+
+/**
+ * Give the monsters of a chunk the energy they have gained and mark those
+ * handled this game turn, and stop scheduling them until the next game turn
+ */
+void monster_schedule_drop(struct chunk *c)
+{
+	struct monster_schedule *s = c->schedule;
+	int i;
+
+	if (!s) return;
+	for (i = 1; i < cave_monster_max(c); i++) {
+		struct monster *mon = cave_monster(c, i);
+
+		if (!mon->race) continue;
+		if (handled_now(s, mon)) {
+			mflag_on(mon->mflag, MFLAG_HANDLED);
+		} else {
+			mflag_off(mon->mflag, MFLAG_HANDLED);
+		}
+		mon->energy = energy_now(s, mon);
+	}
+	monster_schedule_free(c);
+}
+
+/**
+ * Start a pass of process_monsters() over a chunk, returning whether it can
+ * go by the schedule.  If not, the schedule is dropped and the pass has to
+ * look at every monster.
+ *
+ * \param c is the chunk
+ * \param minimum_energy is the least energy a monster needs to be handled
+ * \param regen is whether the handled monsters regenerate
+ */
+bool monster_schedule_begin(struct chunk *c, int minimum_energy, bool regen)
+{
+	struct monster_schedule *s = c->schedule;
+
+	int i;
+
+	if (!s) return false;
+
+	/* Monsters not due to move would be handled, monsters passed by before
+	 * are to be handled, or the last pass was cut short */
+	if ((minimum_energy > 0 && minimum_energy < z_info->move_energy)
+			|| s->sweeping || (s->passing && s->passed)) {
+		monster_schedule_drop(c);
+		return false;
+	}
+
+	if (s->passing) s->least = MIN(s->least, s->minimum);
+	s->minimum = minimum_energy;
+	s->passing = minimum_energy > 0;
+	s->sweeping = minimum_energy == 0;
+	s->passed = cave_monster_max(c) - 1;
+
+	/* Monsters may hear the player differently */
+	if (player->state.skills[SKILL_STEALTH] != s->stealth) {
+		s->stealth = player->state.skills[SKILL_STEALTH];
+		monster_schedule_stir_all(c);
+	}
+
+	/* Hurt monsters are due to regenerate */
+	if (regen && !s->regen) {
+		s->regen = true;
+		for (i = 1; i < cave_monster_max(c); i++) {
+			struct monster *mon = cave_monster(c, i);
+
+			if (mon->race && mon->hp < mon->maxhp) {
+				monster_schedule_update(c, mon);
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * The next monster due to move this game turn below an index, or 0 if none;
+ * the current pass has passed the monsters above it
+ */
+int monster_schedule_next(struct chunk *c, int below)
+{
+	struct monster_schedule *s = c->schedule;
+	const uint64_t *bits = slot_bits(s, s->tick);
+	int w, found = 0;
+
+	if (below > 1) {
+		int top = below - 1;
+		uint64_t word;
+
+		w = top / SCHEDULE_BITS;
+		word = bits[w];
+		if (top % SCHEDULE_BITS != SCHEDULE_BITS - 1) {
+			word &= ((uint64_t) 1 << (top % SCHEDULE_BITS + 1)) - 1;
+		}
+		while (!word && w > 0) {
+			word = bits[--w];
+		}
+		if (word) found = w * SCHEDULE_BITS + highest_bit(word);
+	}
+
+	s->passed = found;
+	return found;
+}
+
+/**
+ * Mark a monster as handled this game turn; with a schedule, its energy is
+ * then up to date, and it is rescheduled by monster_schedule_update()
+ */
+void monster_schedule_handle(struct chunk *c, struct monster *mon)
+{
+	struct monster_schedule *s = c->schedule;
+	struct monster_timing *t;
+
+	if (!s) {
+		mflag_on(mon->mflag, MFLAG_HANDLED);
+		return;
+	}
+	t = &s->timing[mon->midx];
+	set_due(s, mon->midx, -1);
+	t->handled = s->tick;
+	t->from = s->tick + 1;
+}
+
+/**
+ * Move the schedule of a chunk on to the next game turn, if the game turn
+ * just finished went as scheduled; if not, drop the schedule and return false
+ */
+bool monster_schedule_next_turn(struct chunk *c)
+{
+	struct monster_schedule *s = c->schedule;
+	uint64_t *bits;
+	int w;
+
+	if (!s) return false;
+	if (!s->sweeping || s->passed) {
+		monster_schedule_drop(c);
+		return false;
+	}
+	s->tick++;
+	s->least = INT_MAX;
+	s->passing = false;
+	s->sweeping = false;
+	s->regen = false;
+
+	/* Give the monsters due to move their energy */
+	bits = slot_bits(s, s->tick);
+	for (w = 0; w < s->words; w++) {
+		uint64_t word = bits[w];
+
+		while (word) {
+			int idx = w * SCHEDULE_BITS + highest_bit(word);
+			struct monster *mon = cave_monster(c, idx);
+			struct monster_timing *t = &s->timing[idx];
+
+			word &= ~((uint64_t) 1 << (idx % SCHEDULE_BITS));
+			mon->energy += (s->tick - t->from) * t->gain;
+			t->from = s->tick;
+		}
+	}
+	return true;
+}
+
+/**
+ * Schedule a monster just placed in a chunk
+ */
+void monster_schedule_add(struct chunk *c, struct monster *mon)
+{
+	struct monster_schedule *s = c->schedule;
+	struct monster_timing *t;
+
+	if (!s) return;
+	t = &s->timing[mon->midx];
+	if (t->dormant) {
+		t->dormant = false;
+		s->dormant--;
+	}
+	t->handled = -1;
+	t->from = swept(s, mon->midx) ? s->tick + 1 : s->tick;
+	schedule_due(s, mon->midx, mon);
+}
+
+/**
+ * Stop scheduling a monster about to be deleted from a chunk
+ */
+void monster_schedule_remove(struct chunk *c, struct monster *mon)
+{
+	struct monster_schedule *s = c->schedule;
+
+	if (!s) return;
+	set_due(s, mon->midx, -1);
+	s->timing[mon->midx].handled = -1;
+	if (s->timing[mon->midx].dormant) {
+		s->timing[mon->midx].dormant = false;
+		s->dormant--;
+	}
+}
+
+/**
+ * Bring a monster's energy up to date, so it can be looked at or changed
+ */
+void monster_schedule_sync(struct chunk *c, struct monster *mon)
+{
+	struct monster_schedule *s = c ? c->schedule : NULL;
+	struct monster_timing *t;
+	bool handled;
+
+	if (!s || mon->midx <= 0 || mon->midx > z_info->level_monster_max)
+		return;
+	t = &s->timing[mon->midx];
+	handled = handled_now(s, mon);
+	mon->energy = energy_now(s, mon);
+	if (handled) {
+		t->handled = s->tick;
+		t->from = s->tick + 1;
+	} else if (t->from < s->tick) {
+		t->from = s->tick;
+	}
+}
+
+/**
+ * Reschedule a monster after a change to its energy, speed or health; its
+ * energy must have been brought up to date before any change to its energy
+ */
+void monster_schedule_update(struct chunk *c, struct monster *mon)
+{
+	struct monster_schedule *s = c ? c->schedule : NULL;
+	struct monster_timing *t;
+
+	if (!s || mon->midx <= 0 || mon->midx > z_info->level_monster_max)
+		return;
+	t = &s->timing[mon->midx];
+	monster_schedule_sync(c, mon);
+	if (t->dormant) {
+		t->dormant = false;
+		s->dormant--;
+	}
+	schedule_due(s, mon->midx, mon);
+}
+
+/**
+ * Leave a monster which has just had its turn, and found it had nothing to
+ * do, dormant until something stirs it
+ */
+void monster_schedule_park(struct chunk *c, struct monster *mon)
+{
+	struct monster_schedule *s = c->schedule;
+	struct monster_timing *t;
+
+	/* Energy this high isn't spent as gained() reckons */
+	if (!s || mon->energy >= 2 * z_info->move_energy) {
+		monster_schedule_update(c, mon);
+		return;
+	}
+	t = &s->timing[mon->midx];
+	set_due(s, mon->midx, -1);
+	t->gain = monster_turn_energy(mon);
+	if (!t->dormant) {
+		t->dormant = true;
+		s->dormant++;
+	}
+}
+
+/**
+ * Put a dormant monster back in the schedule, after a change to something
+ * it could notice
+ */
+void monster_schedule_stir(struct chunk *c, struct monster *mon)
+{
+	struct monster_schedule *s = c ? c->schedule : NULL;
+
+	if (!s || mon->midx <= 0 || mon->midx > z_info->level_monster_max)
+		return;
+	if (s->timing[mon->midx].dormant) monster_schedule_update(c, mon);
+}
+
+/**
+ * Put all the dormant monsters of a chunk back in the schedule, after a
+ * change which any of them could notice
+ */
+void monster_schedule_stir_all(struct chunk *c)
+{
+	struct monster_schedule *s = c ? c->schedule : NULL;
+	int i;
+
+	if (!s) return;
+	for (i = 1; s->dormant && i < cave_monster_max(c); i++) {
+		if (s->timing[i].dormant) {
+			monster_schedule_update(c, cave_monster(c, i));
+		}
+	}
+}
+
+/**
+ * Move the schedule of the monster at one index of a chunk to another, before
+ * the monster itself is moved
+ */
+void monster_schedule_move(struct chunk *c, int i1, int i2)
+{
+	struct monster_schedule *s = c->schedule;
+	struct monster *mon = cave_monster(c, i1);
+	struct monster_timing *t;
+
+	if (!s) return;
+	monster_schedule_update(c, mon);
+	set_due(s, i1, -1);
+	s->timing[i2] = s->timing[i1];
+	s->timing[i2].due = -1;
+	s->timing[i1].handled = -1;
+	t = &s->timing[i2];
+	if (t->handled != s->tick) {
+		t->from = swept(s, i2) ? s->tick + 1 : s->tick;
+	}
+	schedule_due(s, i2, mon);
+}
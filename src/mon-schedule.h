@@ -0,0 +1,40 @@
+/**
+ * \file mon-schedule.h
+ * \brief Scheduling of monster turns by the game turn they next move
+ *
+ * Copyright (c) 2026 StukovTTV
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+#ifndef MONSTER_SCHEDULE_H
+#define MONSTER_SCHEDULE_H
+
+#include "cave.h"
+
+int monster_turn_energy(const struct monster *mon);
+void monster_schedule_new(struct chunk *c);
+void monster_schedule_free(struct chunk *c);
+void monster_schedule_drop(struct chunk *c);
+bool monster_schedule_begin(struct chunk *c, int minimum_energy, bool regen);
+int monster_schedule_next(struct chunk *c, int below);
+void monster_schedule_handle(struct chunk *c, struct monster *mon);
+bool monster_schedule_next_turn(struct chunk *c);
+void monster_schedule_add(struct chunk *c, struct monster *mon);
+void monster_schedule_remove(struct chunk *c, struct monster *mon);
+void monster_schedule_sync(struct chunk *c, struct monster *mon);
+void monster_schedule_update(struct chunk *c, struct monster *mon);
+void monster_schedule_park(struct chunk *c, struct monster *mon);
+void monster_schedule_stir(struct chunk *c, struct monster *mon);
+void monster_schedule_stir_all(struct chunk *c);
+void monster_schedule_move(struct chunk *c, int i1, int i2);
+
+#endif /* !MONSTER_SCHEDULE_H */
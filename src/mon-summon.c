@@ -23,6 +23,7 @@
 #include "init.h"
 #include "mon-group.h"
 #include "mon-make.h"
+#include "mon-schedule.h"
 #include "mon-summon.h"
 #include "mon-util.h"
 #include "parser.h"
@@ -377,7 +378,9 @@ static int call_monster(struct loc grid)
 	monster_wake(mon, false, 100);
 
 	/* Set it's energy to 0 */
+	monster_schedule_sync(cave, mon);
 	mon->energy = 0;
+	monster_schedule_update(cave, mon);
 
 	return (mon->race->level);
 }
@@ -465,7 +468,7 @@ int summon_specific(struct loc grid, int lev, int type, bool delay, bool call,
 	if (friendly) {
 		if (t_mon) {
 			mon->target.midx = t_mon->midx;
-			monster_make_heatmaps(cave, t_mon);
+			monster_make_scent(cave, t_mon);
 		}
 	} else {
 		/* All other summons are hostile */
@@ -490,7 +493,9 @@ int summon_specific(struct loc grid, int lev, int type, bool delay, bool call,
 			 + m_e_per_turn * p_e_per_turn - 1)
 			 / (m_e_per_turn * p_e_per_turn);
 
+		monster_schedule_sync(cave, mon);
 		mon->energy = 0;
+		monster_schedule_update(cave, mon);
 		if (turns > 0) {
 			/* Set timer directly to avoid resistance */
 			mon->m_timed[MON_TMD_HOLD] = MIN(turns, 32767);
@@ -21,6 +21,7 @@
 #include "mon-lore.h"
 #include "mon-msg.h"
 #include "mon-predicate.h"
+#include "mon-schedule.h"
 #include "mon-spell.h"
 #include "mon-timed.h"
 #include "mon-util.h"
@@ -190,6 +191,11 @@ static bool mon_set_timed(struct monster *mon,
 	} else {
 		mon->m_timed[effect_type] = timer;
 		update = true;
+
+		/* Speed changes change when the monster next moves */
+		if (effect_type == MON_TMD_FAST || effect_type == MON_TMD_SLOW) {
+			monster_schedule_update(cave, mon);
+		}
 	}
 
 	/* Special case - deal with monster shapechanges */
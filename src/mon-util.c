@@ -27,6 +27,7 @@
 #include "mon-make.h"
 #include "mon-msg.h"
 #include "mon-predicate.h"
+#include "mon-schedule.h"
 #include "mon-spell.h"
 #include "mon-summon.h"
 #include "mon-timed.h"
@@ -46,6 +47,7 @@
 #include "player-util.h"
 #include "project.h"
 #include "trap.h"
+#include "z-names.h"
 
 /**
  * ------------------------------------------------------------------------
@@ -112,11 +114,43 @@ void create_mon_flag_mask(bitflag *f, ...)
  * Lookup utilities
  * ------------------------------------------------------------------------ */
 /**
- * Returns the monster with the given name. If no monster has the exact name
- * given, returns the first monster with the given name as a (case-insensitive)
- * substring.
+ * Indexes of monster race names, made once monster.txt has been read; the
+ * one ignoring case is filled from the end so that, like a search through
+ * r_info, it gives the last race to match
  */
-struct monster_race *lookup_monster(const char *name)
+static struct name_index *race_names;
+static struct name_index *race_names_nocase;
+
+void monster_name_index_build(void)
+{
+	int i;
+
+	monster_name_index_free();
+	race_names = name_index_new(false);
+	race_names_nocase = name_index_new(true);
+	for (i = 0; i < z_info->r_max; i++) {
+		if (r_info[i].name)
+			name_index_add(race_names, r_info[i].name, i);
+	}
+	for (i = z_info->r_max - 1; i >= 0; i--) {
+		if (r_info[i].name)
+			name_index_add(race_names_nocase, r_info[i].name, i);
+	}
+}
+
+void monster_name_index_free(void)
+{
+	name_index_free(race_names);
+	race_names = NULL;
+	name_index_free(race_names_nocase);
+	race_names_nocase = NULL;
+}
+
+/**
+ * Returns the monster nearest to having the given name, looking through all
+ * of them; this also finds races named since the index was made
+ */
+static struct monster_race *lookup_monster_closest(const char *name)
 {
 	int i;
 	struct monster_race *closest = NULL;
@@ -144,6 +178,29 @@ struct monster_race *lookup_monster(const char *name)
 	return closest;
 }
 
+/**
+ * Returns the monster with the given name. If no monster has the exact name
+ * given, returns the first monster with the given name as a (case-insensitive)
+ * substring.
+ */
+struct monster_race *lookup_monster(const char *name)
+{
+	if (race_names) {
+		int i = name_index_find(race_names, name);
+
+		if (i >= 0 && r_info[i].name && streq(r_info[i].name, name))
+			return &r_info[i];
+	}
+	if (race_names_nocase) {
+		int i = name_index_find(race_names_nocase, name);
+
+		if (i >= 0 && r_info[i].name && !my_stricmp(r_info[i].name, name))
+			return &r_info[i];
+	}
+
+	return lookup_monster_closest(name);
+}
+
 /**
  * Return the monster base matching the given name.
  */
@@ -240,7 +297,7 @@ static void path_analyse(struct chunk *c, struct loc grid)
 	for (i = 0; i < path_n - 1; ++i) {
 		/* Forget grids which would block los */
 		if (!square_allowslos(player->cave, path_g[i])) {
-			sqinfo_off(square(c, path_g[i])->info, SQUARE_SEEN);
+			sqinfo_off(square(c, path_g[i]).info, SQUARE_SEEN);
 			square_forget(c, path_g[i]);
 			square_light_spot(c, path_g[i]);
 		}
@@ -336,7 +393,7 @@ void update_mon(struct monster *mon, struct chunk *c, bool full)
 
 	lore = get_lore(mon->race);
 	
-	/* Compute distance, or just use the current one; update any heatmaps */
+	/* Compute distance, or just use the current one; update any scent */
 	if (full) {
 		/* Target */
 		struct loc target = monster_target_loc(mon);
@@ -351,13 +408,13 @@ void update_mon(struct monster *mon, struct chunk *c, bool full)
 		/* Restrict distance */
 		if (d > 255) d = 255;
 
-		/* Save the distance */
-		mon->cdis = d;
-
-		/* Heatmaps */
-		if (mon->noise.grids) {
-			make_noise(c, NULL, mon);
+		/* Save the distance; a dormant monster may now notice it */
+		if (mon->cdis != d) {
+			mon->cdis = d;
+			monster_schedule_stir(c, mon);
 		}
+
+		/* Scent trail; noise is worked out when something listens */
 		if (mon->scent.grids) {
 			update_scent(c, NULL, mon);
 		}
@@ -609,8 +666,8 @@ void monster_swap(struct loc grid1, struct loc grid2)
 	struct loc pgrid = player->grid;
 
 	/* Monsters */
-	m1 = cave->squares[grid1.y][grid1.x].mon;
-	m2 = cave->squares[grid2.y][grid2.x].mon;
+	m1 = cave->sq_mon[square_idx(cave, grid1)];
+	m2 = cave->sq_mon[square_idx(cave, grid2)];
 
 	/* Update grids */
 	square_set_mon(cave, grid1, m2);
@@ -637,6 +694,7 @@ void monster_swap(struct loc grid1, struct loc grid2)
 			}
 		}
 		mon->grid = grid2;
+		monster_schedule_stir(cave, mon);
 		update_mon(mon, cave, true);
 
 		/* Affect light? */
@@ -684,6 +742,7 @@ void monster_swap(struct loc grid1, struct loc grid2)
 			}
 		}
 		mon->grid = grid1;
+		monster_schedule_stir(cave, mon);
 		update_mon(mon, cave, true);
 
 		/* Affect light? */
@@ -1273,6 +1332,7 @@ bool mon_take_nonplayer_hit(int dam, struct monster *t_mon,
 
 	/* Hurt the monster */
 	t_mon->hp -= dam;
+	monster_schedule_update(cave, t_mon);
 
 	/* Dead or damaged monster */
 	if (t_mon->hp < 0) {
@@ -1343,6 +1403,7 @@ bool mon_take_hit(struct monster *mon, struct player *p, int dam, bool *fear,
 
 	/* Hurt it */
 	mon->hp -= dam;
+	monster_schedule_update(cave, mon);
 	if (mon->hp < 0) {
 		/* Deal with arena monsters */
 		if (p->upkeep->arena_level) {
@@ -1623,6 +1684,7 @@ void steal_monster_item(struct monster *mon, int midx)
 
 			/* Become hostile */
 			mon->target.midx = thief->midx;
+			monster_schedule_stir(cave, mon);
 		}
 	}
 }
@@ -1746,6 +1808,7 @@ bool monster_change_shape(struct monster *mon)
 			mon->player_race = NULL;
 		}
 		mon->mspeed += mon->race->speed - mon->original_race->speed;
+		monster_schedule_update(cave, mon);
 	}
 
 	/* Emergency teleport if needed */
@@ -1775,6 +1838,7 @@ bool monster_revert_shape(struct monster *mon)
 			square_light_spot(cave, mon->grid);
 		}
 		mon->mspeed += mon->original_race->speed - mon->race->speed;
+		monster_schedule_update(cave, mon);
 		mon->race = mon->original_race;
 		mon->original_race = NULL;
 		mon->player_race = mon->original_player_race;
@@ -1818,16 +1882,14 @@ struct loc monster_target_loc(const struct monster *mon)
 }
 
 /**
- * Create noise and scent heatmaps for a monster
+ * Create a scent heatmap for a monster
  *
  * This function should be called when a monster becomes the long-term target
- * of another monster, to allow movement to work properly
+ * of another monster, to allow movement to work properly.  Noise needs no
+ * preparation; see monster_noise().
  */
-void monster_make_heatmaps(struct chunk *c, struct monster *mon)
+void monster_make_scent(struct chunk *c, struct monster *mon)
 {
-	if (!mon->noise.grids) {
-		mon->noise.grids = heatmap_new(c);
-	}
 	if (!mon->scent.grids) {
 		mon->scent.grids = heatmap_new(c);
 	}
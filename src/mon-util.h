@@ -24,6 +24,8 @@
 
 const char *describe_race_flag(int flag);
 void create_mon_flag_mask(bitflag *f, ...);
+void monster_name_index_build(void);
+void monster_name_index_free(void);
 struct monster_race *lookup_monster(const char *name);
 struct monster_base *lookup_monster_base(const char *name);
 struct blow_effect *lookup_monster_blow_effect(const char *eff_name);
@@ -54,7 +56,7 @@ void steal_monster_item(struct monster *mon, int midx);
 bool monster_change_shape(struct monster *mon);
 bool monster_revert_shape(struct monster *mon);
 struct loc monster_target_loc(const struct monster *mon);
-void monster_make_heatmaps(struct chunk *c, struct monster *mon);
+void monster_make_scent(struct chunk *c, struct monster *mon);
 void monster_remove_from_targets(struct chunk *c, struct monster *mon);
 
 #endif /* MONSTER_UTILITIES_H */
@@ -454,7 +454,6 @@ struct monster {
 	struct loc home;					/* Home for territorial monsters */
 
 	struct monster_group_info group_info[GROUP_MAX];/* Monster group details */
-	struct heatmap noise;				/* Monster noise heatmap */
 	struct heatmap scent;				/* Monster scent heatmap */
 
 	uint8_t min_range;			/* What is the closest we want to be? */
@@ -32,6 +32,7 @@
 #include "obj-curse.h"
 #include "obj-design.h"
 #include "obj-ignore.h"
+#include "obj-init.h"
 #include "obj-list.h"
 #include "obj-make.h"
 #include "obj-pile.h"
@@ -2693,6 +2694,7 @@ static errr finish_parse_ego(struct parser *p) {
 		mem_free(e);
 	}
 	z_info->e_max += 1;
+	ego_name_index_build();
 
 	parser_destroy(p);
 	return 0;
@@ -2718,6 +2720,7 @@ static void cleanup_ego(void)
 			poss = next;
 		}
 	}
+	ego_name_index_free();
 	mem_free(e_info);
 }
 
@@ -3246,7 +3249,7 @@ static errr run_parse_artifact(struct parser *p) {
 
 static errr finish_parse_artifact(struct parser *p) {
 	struct artifact *a, *n;
-	int none, aidx;
+	int aidx;
 
 	/* Scan the list for the max id */
 	z_info->a_max = 0;
@@ -3273,6 +3276,21 @@ static errr finish_parse_artifact(struct parser *p) {
 		aup_info[aidx].aidx = aidx;
 	}
 	z_info->a_max += 1;
+	artifact_name_index_build();
+	finish_artifact_kinds();
+
+	parser_destroy(p);
+	return 0;
+}
+
+/**
+ * Tie the object kinds to the artifacts once both are in place:  look up the
+ * special kinds, and give the kinds made for special artifacts what they
+ * take from their artifact.
+ */
+void finish_artifact_kinds(void)
+{
+	int none, aidx;
 
 	/* Now we're done with object kinds, deal with object-like things... */
 	none = tval_find_idx("none");
@@ -3300,9 +3318,6 @@ static errr finish_parse_artifact(struct parser *p) {
 			}
 		}
 	}
-
-	parser_destroy(p);
-	return 0;
 }
 
 static void cleanup_artifact(void)
@@ -3319,6 +3334,7 @@ static void cleanup_artifact(void)
 		mem_free(art->curses);
 		free_effect(art->effect);
 	}
+	artifact_name_index_free();
 	mem_free(a_info);
 	mem_free(aup_info);
 }
@@ -3564,6 +3580,7 @@ static errr finish_parse_randart(struct parser *p) {
 		memset(&aup_info[aidx], 0, sizeof(*aup_info));
 		aup_info[aidx].aidx = aidx;
 	}
+	artifact_name_index_build();
 
 	parser_destroy(p);
 	return 0;
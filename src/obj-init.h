@@ -39,4 +39,6 @@ extern struct file_parser artifact_set_parser;
 extern struct file_parser randart_parser;
 extern struct file_parser object_property_parser;
 
+void finish_artifact_kinds(void);
+
 #endif /* OBJECT_INIT_H_ */
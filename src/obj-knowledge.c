@@ -949,7 +949,9 @@ void object_sense(struct player *p, struct object *obj)
 
 		/* Attach it to the current floor pile */
 		new_obj->grid = grid;
-		pile_insert_end(&p->cave->squares[grid.y][grid.x].obj, new_obj);
+		pile_insert_end(&p->cave->sq_obj[square_idx(p->cave, grid)], new_obj);
+		cave_index_note(p->cave, grid);
+		map_cache_forget(cave, grid);
 	}
 }
 
@@ -980,7 +982,9 @@ void object_see(struct player *p, struct object *obj)
 
 		/* Attach it to the current floor pile */
 		new_obj->grid = grid;
-		pile_insert_end(&p->cave->squares[grid.y][grid.x].obj, new_obj);
+		pile_insert_end(&p->cave->sq_obj[square_idx(p->cave, grid)], new_obj);
+		cave_index_note(p->cave, grid);
+		map_cache_forget(cave, grid);
 	} else {
 		struct loc old = known_obj->grid;
 
@@ -997,15 +1001,20 @@ void object_see(struct player *p, struct object *obj)
 		/* If monster held, we're done */
 		if (obj->held_m_idx) return;
 
+		/* Its kind or details may have changed in the pile */
+		map_cache_forget(cave, grid);
+
 		/* Attach it to the current floor pile if necessary */
 		if (! square_holds_object(p->cave, grid, known_obj)) {
 			/* Detach from any old pile */
 			if (!loc_is_zero(old) && square_holds_object(p->cave, old, known_obj)) {
 				square_excise_object(p->cave, old, known_obj);
+				map_cache_forget(cave, old);
 			}
 
 			known_obj->grid = grid;
-			pile_insert_end(&p->cave->squares[grid.y][grid.x].obj, known_obj);
+			pile_insert_end(&p->cave->sq_obj[square_idx(p->cave, grid)], known_obj);
+			cave_index_note(p->cave, grid);
 		}
 	}
 }
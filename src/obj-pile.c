@@ -957,7 +957,8 @@ bool floor_carry(struct chunk *c, struct loc grid, struct object *drop,
 	drop->held_m_idx = 0;
 
 	/* Link to the first object in the pile */
-	pile_insert(&c->squares[grid.y][grid.x].obj, drop);
+	pile_insert(&c->sq_obj[square_idx(c, grid)], drop);
+	cave_index_note(c, grid);
 
 	/* Record in the level list */
 	list_object(c, drop);
@@ -1148,7 +1149,7 @@ void drop_near(struct chunk *c, struct object **dropped, int chance,
 	drop_find_grid(player, c, *dropped, prefer_pile, &best);
 	if (floor_carry(c, best, *dropped, &dont_ignore)) {
 		sound(MSG_DROP);
-		if (dont_ignore && (square(c, best)->mon < 0)) {
+		if (dont_ignore && (square(c, best).mon < 0)) {
 			msg("You feel something roll beneath your feet.");
 		}
 	} else {
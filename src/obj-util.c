@@ -41,6 +41,7 @@
 #include "player-spell.h"
 #include "player-util.h"
 #include "randname.h"
+#include "z-names.h"
 #include "z-queue.h"
 
 struct object_base *kb_info;
@@ -471,9 +472,53 @@ struct object_kind *objkind_byid(int kidx) {
 /*** Textual<->numeric conversion ***/
 
 /**
- * Return the a_idx of the artifact with the given name
+ * Indexes of artifact and ego item names, made once their files have been read
  */
-const struct artifact *lookup_artifact_name(const char *name)
+static struct name_index *artifact_names;
+static struct name_index *ego_names;
+
+void artifact_name_index_build(void)
+{
+	int i;
+
+	name_index_free(artifact_names);
+	artifact_names = name_index_new(false);
+	for (i = 0; i < z_info->a_max; i++) {
+		if (a_info[i].name)
+			name_index_add(artifact_names, a_info[i].name, i);
+	}
+}
+
+void artifact_name_index_free(void)
+{
+	name_index_free(artifact_names);
+	artifact_names = NULL;
+}
+
+void ego_name_index_build(void)
+{
+	int i;
+
+	name_index_free(ego_names);
+	ego_names = name_index_new(false);
+	for (i = 0; i < z_info->e_max; i++) {
+		if (e_info[i].name)
+			name_index_add(ego_names, e_info[i].name, i);
+	}
+}
+
+void ego_name_index_free(void)
+{
+	name_index_free(ego_names);
+	ego_names = NULL;
+}
+
+/**
+ * Return the first artifact with the given name as a (case-insensitive)
+ * substring, looking through all of them; this also finds artifacts named
+ * since the index was made
+ */
+static const struct artifact *lookup_artifact_closest(const char *name)
 {
 	int i;
 	int a_idx = -1;
@@ -496,6 +541,46 @@ const struct artifact *lookup_artifact_name(const char *name)
 	return a_idx > 0 ? &a_info[a_idx] : NULL;
 }
 
+/**
+ * Return the a_idx of the artifact with the given name
+ */
+const struct artifact *lookup_artifact_name(const char *name)
+{
+	if (artifact_names) {
+		int i = name_index_find(artifact_names, name);
+
+		if (i >= 0 && a_info[i].name && streq(a_info[i].name, name))
+			return &a_info[i];
+	}
+
+	return lookup_artifact_closest(name);
+}
+
+/**
+ * Check whether an ego item type has the given name and can be made from the
+ * given kind of object
+ */
+static bool ego_item_fits(const struct ego_item *ego, const char *name,
+		int tval, int sval)
+{
+	struct poss_item *poss_item = ego->poss_items;
+
+	/* Reject nameless and wrong names */
+	if (!ego->name) return false;
+	if (!streq(name, ego->name)) return false;
+
+	/* Check tval and sval */
+	while (poss_item) {
+		struct object_kind *kind = lookup_kind(tval, sval);
+		if (kind->kidx == poss_item->kidx) {
+			return true;
+		}
+		poss_item = poss_item->next;
+	}
+
+	return false;
+}
+
 /**
  * \param name ego type name
  * \param tval object tval
@@ -506,23 +591,21 @@ struct ego_item *lookup_ego_item(const char *name, int tval, int sval)
 {
 	int i;
 
+	/* Look among those with the name */
+	if (ego_names) {
+		size_t pos = 0;
+
+		while ((i = name_index_next(ego_names, name, &pos)) >= 0) {
+			if (ego_item_fits(&e_info[i], name, tval, sval))
+				return &e_info[i];
+		}
+		return NULL;
+	}
+
 	/* Look for it */
 	for (i = 0; i < z_info->e_max; i++) {
-		struct ego_item *ego = &e_info[i];
-		struct poss_item *poss_item = ego->poss_items;
-
-		/* Reject nameless and wrong names */
-		if (!ego->name) continue;
-		if (!streq(name, ego->name)) continue;
-
-		/* Check tval and sval */
-		while (poss_item) {
-			struct object_kind *kind = lookup_kind(tval, sval);
-			if (kind->kidx == poss_item->kidx) {
-				return ego;
-			}
-			poss_item = poss_item->next;
-		}
+		if (ego_item_fits(&e_info[i], name, tval, sval))
+			return &e_info[i];
 	}
 
 	return NULL;
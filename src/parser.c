@@ -33,6 +33,13 @@
  * Each hook has a list of specs, which are essentially named formal parameters;
  * when we run a particular hook across a line, each spec in the hook is
  * assigned a value.
+ *
+ * Parsing a line allocates nothing:  hooks are found through a hash table of
+ * their directives, the line is copied into a buffer kept by the parser and
+ * split in place, so symbols and strings point into it, and the values go in
+ * an array kept big enough for the hook with the most specs.  All of that is
+ * reused for the next line.  Spec names are hashed when the hook is
+ * registered, so looking a value up by name rarely needs a string compare.
  */
 
 enum {
@@ -50,10 +57,11 @@ struct parser_spec {
 	struct parser_spec *next;
 	int type;
 	const char *name;
+	uint32_t hash;
 };
 
 struct parser_value {
-	struct parser_spec spec;
+	const struct parser_spec *spec;
 	union {
 		wchar_t cval;
 		int ival;
@@ -67,6 +75,8 @@ struct parser_hook {
 	struct parser_hook *next;
 	enum parser_error (*func)(struct parser *p);
 	char *dir;
+	uint32_t hash;
+	int nspecs;
 	struct parser_spec *fhead;
 	struct parser_spec *ftail;
 };
@@ -76,9 +86,20 @@ struct parser {
 	unsigned int lineno;
 	unsigned int colno;
 	char errmsg[1024];
+
+	/* All hooks, newest first, and the current one for each directive */
 	struct parser_hook *hooks;
-	struct parser_value *fhead;
-	struct parser_value *ftail;
+	struct parser_hook **table;
+	size_t table_size;
+	size_t table_used;
+
+	/* Values of the current line, and the copy of it they point into */
+	struct parser_value *values;
+	int nvalues;
+	int values_size;
+	char *line;
+	size_t line_size;
+
 	void *priv;
 };
 
@@ -90,26 +111,82 @@ struct parser *parser_new(void) {
 	return p;
 }
 
-static struct parser_hook *findhook(struct parser *p, const char *dir) {
-	struct parser_hook *h = p->hooks;
-	while (h) {
-		if (streq(h->dir, dir))
-			break;
-		h = h->next;
+/**
+ * FNV-1a hash of a directive or field name
+ */
+static uint32_t parser_hash(const char *s) {
+	uint32_t h = 2166136261U;
+
+	while (*s) {
+		h = (h ^ (unsigned char) *s++) * 16777619U;
 	}
 	return h;
 }
 
-static void parser_freeold(struct parser *p) {
-	struct parser_value *v;
-	while (p->fhead) {
-		int t = p->fhead->spec.type & ~PARSE_T_OPT;
-		v = (struct parser_value *)p->fhead->spec.next;
-		if (t == PARSE_T_SYM || t == PARSE_T_STR)
-			mem_free(p->fhead->u.sval);
-		mem_free(p->fhead);
-		p->fhead = v;
+/**
+ * Find the slot in the directive table for `dir`, which is either the one
+ * holding its hook or the empty one where it would go.
+ */
+static struct parser_hook **findslot(struct parser *p, const char *dir,
+		uint32_t hash) {
+	size_t mask = p->table_size - 1, i = hash & mask;
+
+	while (p->table[i]) {
+		if (p->table[i]->hash == hash && streq(p->table[i]->dir, dir))
+			break;
+		i = (i + 1) & mask;
 	}
+	return &p->table[i];
+}
+
+static struct parser_hook *findhook(struct parser *p, const char *dir) {
+	if (!p->table_size) return NULL;
+	return *findslot(p, dir, parser_hash(dir));
+}
+
+/**
+ * Make `h` the hook for its directive, superseding any earlier one
+ */
+static void addhook(struct parser *p, struct parser_hook *h) {
+	struct parser_hook **slot;
+
+	if (2 * (p->table_used + 1) > p->table_size) {
+		struct parser_hook **old = p->table;
+		size_t old_size = p->table_size, i;
+
+		p->table_size = old_size ? 2 * old_size : 64;
+		p->table = mem_zalloc(p->table_size * sizeof(*p->table));
+		for (i = 0; i < old_size; i++) {
+			if (old[i]) *findslot(p, old[i]->dir, old[i]->hash) = old[i];
+		}
+		mem_free(old);
+	}
+	slot = findslot(p, h->dir, h->hash);
+	if (!*slot) p->table_used++;
+	*slot = h;
+}
+
+/**
+ * Split off the next token from `*pos` as strtok() would:  skip any leading
+ * delimiters, then end the token at the next delimiter, if any.  An empty
+ * `delim` takes the rest of the line.
+ */
+static char *parser_token(char **pos, const char *delim) {
+	char *s = *pos + strspn(*pos, delim);
+	char *e;
+
+	if (!*s) {
+		*pos = s;
+		return NULL;
+	}
+	e = strpbrk(s, delim);
+	if (e) {
+		*e = '\0';
+		*pos = e + 1;
+	} else {
+		*pos = s + strlen(s);
+	}
+	return s;
 }
 
 static bool parse_random(const char *str, random_value *bonus) {
@@ -208,22 +285,19 @@ static bool parse_random(const char *str, random_value *bonus) {
  * This runs the first parser hook registered with `p` that matches `line`.
  */
 enum parser_error parser_parse(struct parser *p, const char *line) {
-	char *cline;
+	char *pos;
 	char *tok;
 	struct parser_hook *h;
 	struct parser_spec *s;
 	struct parser_value *v;
-	char *sp = NULL;
+	size_t len;
 
 	assert(p);
 	assert(line);
 
-	parser_freeold(p);
-
+	p->nvalues = 0;
 	p->lineno++;
 	p->colno = 1;
-	p->fhead = NULL;
-	p->ftail = NULL;
 
 	/* Ignore empty lines and comments. */
 	while (*line && (isspace(*line)))
@@ -231,11 +305,16 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 	if (!*line || *line == '#')
 		return PARSE_ERROR_NONE;
 
-	cline = string_make(line);
+	len = strlen(line) + 1;
+	if (len > p->line_size) {
+		p->line_size = MAX(len, 2 * p->line_size);
+		p->line = mem_realloc(p->line, p->line_size);
+	}
+	memcpy(p->line, line, len);
+	pos = p->line;
 
-	tok = strtok(cline, ":");
+	tok = parser_token(&pos, ":");
 	if (!tok) {
-		mem_free(cline);
 		p->error = PARSE_ERROR_MISSING_FIELD;
 		return PARSE_ERROR_MISSING_FIELD;
 	}
@@ -244,7 +323,6 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 	if (!h) {
 		my_strcpy(p->errmsg, tok, sizeof(p->errmsg));
 		p->error = PARSE_ERROR_UNDEFINED_DIRECTIVE;
-		mem_free(cline);
 		return PARSE_ERROR_UNDEFINED_DIRECTIVE;
 	}
 
@@ -257,42 +335,37 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 		p->colno++;
 
 		/* These types are tokenized on ':'; strings are not tokenized
-		 * at all (i.e., they consume the remainder of the line) */
+		 * at all (i.e., they consume the remainder of the line), and
+		 * characters take one byte and the ':' after it */
 		if (t == PARSE_T_INT || t == PARSE_T_SYM || t == PARSE_T_RAND ||
 			t == PARSE_T_UINT) {
-			tok = strtok(sp, ":");
-			sp = NULL;
+			tok = parser_token(&pos, ":");
 		} else if (t == PARSE_T_CHAR) {
-			tok = strtok(sp, "");
+			tok = parser_token(&pos, "");
 			if (tok)
-				sp = tok + 2;
+				pos = tok[1] ? tok + 2 : tok + 1;
 		} else {
-			tok = strtok(sp, "");
-			sp = NULL;
+			tok = parser_token(&pos, "");
 		}
 		if (!tok) {
 			if (!(s->type & PARSE_T_OPT)) {
 				my_strcpy(p->errmsg, s->name, sizeof(p->errmsg));
 				p->error = PARSE_ERROR_MISSING_FIELD;
-				mem_free(cline);
 				return PARSE_ERROR_MISSING_FIELD;
 			}
 			break;
 		}
 
-		/* Allocate a value node. */
-		v = mem_alloc(sizeof *v);
-		v->spec.next = NULL;
-		v->spec.type = s->type;
-		v->spec.name = s->name;
+		/* Take the next value slot. */
+		assert(p->nvalues < p->values_size);
+		v = &p->values[p->nvalues];
+		v->spec = s;
 
 		/* Parse out its value. */
 		if (t == PARSE_T_INT) {
 			char *z = NULL;
 			v->u.ival = strtol(tok, &z, 0);
 			if (z == tok) {
-				mem_free(v);
-				mem_free(cline);
 				my_strcpy(p->errmsg, s->name, sizeof(p->errmsg));
 				p->error = PARSE_ERROR_NOT_NUMBER;
 				return PARSE_ERROR_NOT_NUMBER;
@@ -301,8 +374,6 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 			char *z = NULL;
 			v->u.uval = strtoul(tok, &z, 0);
 			if (z == tok || *tok == '-') {
-				mem_free(v);
-				mem_free(cline);
 				my_strcpy(p->errmsg, s->name, sizeof(p->errmsg));
 				p->error = PARSE_ERROR_NOT_NUMBER;
 				return PARSE_ERROR_NOT_NUMBER;
@@ -310,27 +381,17 @@ enum parser_error parser_parse(struct parser *p, const char *line) {
 		} else if (t == PARSE_T_CHAR) {
 			text_mbstowcs(&v->u.cval, tok, 1);
 		} else if (t == PARSE_T_SYM || t == PARSE_T_STR) {
-			v->u.sval = string_make(tok);
+			v->u.sval = tok;
 		} else if (t == PARSE_T_RAND) {
 			if (!parse_random(tok, &v->u.rval)) {
-				mem_free(v);
-				mem_free(cline);
 				my_strcpy(p->errmsg, s->name, sizeof(p->errmsg));
 				p->error = PARSE_ERROR_NOT_RANDOM;
 				return PARSE_ERROR_NOT_RANDOM;
 			}
 		}
-
-		/* Link it into the value list. */
-		if (!p->fhead)
-			p->fhead = v;
-		else
-			p->ftail->spec.next = &v->spec;
-		p->ftail = v;
+		p->nvalues++;
 	}
 
-	mem_free(cline);
-
 	p->error = h->func(p);
 	return p->error;
 }
@@ -388,7 +449,9 @@ static void clean_specs(struct parser_hook *h) {
  */
 void parser_destroy(struct parser *p) {
 	struct parser_hook *h;
-	parser_freeold(p);
+	mem_free(p->table);
+	mem_free(p->values);
+	mem_free(p->line);
 	while (p->hooks) {
 		h = p->hooks->next;
 		clean_specs(p->hooks);
@@ -411,6 +474,8 @@ static errr parse_specs(struct parser_hook *h, char *fmt) {
 	if (!name)
 		return -EINVAL;
 	h->dir = string_make(name);
+	h->hash = parser_hash(name);
+	h->nspecs = 0;
 	h->fhead = NULL;
 	h->ftail = NULL;
 	while (name) {
@@ -447,12 +512,14 @@ static errr parse_specs(struct parser_hook *h, char *fmt) {
 		s = mem_alloc(sizeof *s);
 		s->type = type;
 		s->name = string_make(name);
+		s->hash = parser_hash(name);
 		s->next = NULL;
 		if (h->fhead)
 			h->ftail->next = s;
 		else
 			h->fhead = s;
 		h->ftail = s;
+		h->nspecs++;
 	}
 
 	return 0;
@@ -493,6 +560,12 @@ errr parser_reg(struct parser *p, const char *fmt,
 	}
 
 	p->hooks = h;
+	addhook(p, h);
+	if (h->nspecs > p->values_size) {
+		p->values_size = h->nspecs;
+		p->values = mem_realloc(p->values,
+			p->values_size * sizeof(*p->values));
+	}
 	mem_free(cfmt);
 	return 0;
 }
@@ -509,21 +582,28 @@ enum parser_error ignored(struct parser *p) {
  *
  * Used to test for presence of optional values.
  */
-bool parser_hasval(struct parser *p, const char *name) {
-	struct parser_value *v;
-	for (v = p->fhead; v; v = (struct parser_value *)v->spec.next) {
-		if (streq(v->spec.name, name))
-			return true;
+static struct parser_value *parser_findval(struct parser *p,
+		const char *name) {
+	uint32_t hash = parser_hash(name);
+	int i;
+
+	for (i = 0; i < p->nvalues; i++) {
+		const struct parser_spec *s = p->values[i].spec;
+
+		if (s->hash == hash && streq(s->name, name))
+			return &p->values[i];
 	}
-	return false;
+	return NULL;
+}
+
+bool parser_hasval(struct parser *p, const char *name) {
+	return parser_findval(p, name) != NULL;
 }
 
 static struct parser_value *parser_getval(struct parser *p, const char *name) {
-	struct parser_value *v;
-	for (v = p->fhead; v; v = (struct parser_value *)v->spec.next) {
-		if (streq(v->spec.name, name)) {
-			return v;
-		}
+	struct parser_value *v = parser_findval(p, name);
+	if (v) {
+		return v;
 	}
 	quit_fmt("parser_getval error: name is %s\n", name);
 	return 0; /* Needed to avoid Windows compiler warning */
@@ -534,7 +614,7 @@ static struct parser_value *parser_getval(struct parser *p, const char *name) {
  */
 const char *parser_getsym(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_SYM);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_SYM);
 	return v->u.sval;
 }
 
@@ -543,7 +623,7 @@ const char *parser_getsym(struct parser *p, const char *name) {
  */
 int parser_getint(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_INT);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_INT);
 	return v->u.ival;
 }
 
@@ -552,7 +632,7 @@ int parser_getint(struct parser *p, const char *name) {
  */
 unsigned int parser_getuint(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_UINT);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_UINT);
 	return v->u.uval;
 }
 
@@ -561,7 +641,7 @@ unsigned int parser_getuint(struct parser *p, const char *name) {
  */
 const char *parser_getstr(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_STR);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_STR);
 	return v->u.sval;
 }
 
@@ -570,7 +650,7 @@ const char *parser_getstr(struct parser *p, const char *name) {
  */
 struct random parser_getrand(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_RAND);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_RAND);
 	return v->u.rval;
 }
 
@@ -579,7 +659,7 @@ struct random parser_getrand(struct parser *p, const char *name) {
  */
 wchar_t parser_getchar(struct parser *p, const char *name) {
 	struct parser_value *v = parser_getval(p, name);
-	assert((v->spec.type & ~PARSE_T_OPT) == PARSE_T_CHAR);
+	assert((v->spec->type & ~PARSE_T_OPT) == PARSE_T_CHAR);
 	return v->u.cval;
 }
 
@@ -2965,6 +2965,9 @@ void notice_stuff(struct player *p)
 	if (p->upkeep->notice & PN_IGNORE) {
 		p->upkeep->notice &= ~(PN_IGNORE);
 		ignore_drop(p);
+
+		/* Objects on the floor may have been hidden or shown */
+		if (cave) map_cache_forget_all(cave);
 	}
 
 	/* Combine the pack */
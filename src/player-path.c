@@ -1752,7 +1752,7 @@ static bool run_test(const struct player *p)
 		grid = loc_sum(p->grid, ddgrid[new_dir]);
 
 		/* Visible monsters abort running */
-		if (square(cave, grid)->mon > 0) {
+		if (square(cave, grid).mon > 0) {
 			struct monster *mon = square_monster(cave, grid);
 			if (monster_is_visible(mon)) {
 				return true;
@@ -1912,7 +1912,7 @@ static bool run_test(const struct player *p)
 		if (!square_in_bounds(cave, grid)) continue;
 
 		/* Obvious monsters abort running */
-		if (square(cave, grid)->mon > 0) {
+		if (square(cave, grid).mon > 0) {
 			struct monster *mon = square_monster(cave, grid);
 			if (monster_is_obvious(mon))
 				return true;
@@ -2086,7 +2086,7 @@ void run_step(int dir)
 			}
 
 			/* Visible monsters abort running */
-			if (square(cave, grid)->mon > 0) {
+			if (square(cave, grid).mon > 0) {
 				struct monster *mon =
 					square_monster(cave, grid);
 
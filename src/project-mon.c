@@ -26,6 +26,7 @@
 #include "mon-move.h"
 #include "mon-msg.h"
 #include "mon-predicate.h"
+#include "mon-schedule.h"
 #include "mon-spell.h"
 #include "mon-timed.h"
 #include "mon-util.h"
@@ -146,11 +147,11 @@ void thrust_away(struct loc centre, struct loc target, int grids_away)
 			next = loc_sum(grid, ddgrid_ddd[d % 8]);
 
 			/* There's someone there, try to switch places. */
-			if (square(cave, next)->mon != 0) {
+			if (square(cave, next).mon != 0) {
 				/* A monster is trying to pass. */
-				if (square(cave, grid)->mon > 0) {
+				if (square(cave, grid).mon > 0) {
 					struct monster *mon = square_monster(cave, grid);
-					if (square(cave, next)->mon > 0) {
+					if (square(cave, next).mon > 0) {
 						struct monster *mon1 = square_monster(cave, next);
 
 						/* Monsters cannot pass by stronger monsters. */
@@ -164,8 +165,8 @@ void thrust_away(struct loc centre, struct loc target, int grids_away)
 				}
 
 				/* The player is trying to pass. */
-				if (square(cave, grid)->mon < 0) {
-					if (square(cave, next)->mon > 0) {
+				if (square(cave, grid).mon < 0) {
+					if (square(cave, next).mon > 0) {
 						struct monster *mon1 = square_monster(cave, next);
 
 						/* Players cannot pass by stronger monsters. */
@@ -181,7 +182,7 @@ void thrust_away(struct loc centre, struct loc target, int grids_away)
 				if (square_ispassable(cave, next)) {
 					/* Travel down the path. */
 					monster_swap(grid, next);
-					if (square(cave, grid)->mon < 0) {
+					if (square(cave, grid).mon < 0) {
 						player_handle_post_move(
 							player, true, true);
 					}
@@ -199,14 +200,14 @@ void thrust_away(struct loc centre, struct loc target, int grids_away)
 				/* If there are walls everywhere, stop here. */
 				else if (d == (8 + first_d - 1)) {
 					/* Message for player. */
-					if (square(cave, grid)->mon < 0)
+					if (square(cave, grid).mon < 0)
 						msg("You come to rest next to a wall.");
 					i = grids_away;
 				}
 			} else {
 				/* Travel down the path. */
 				monster_swap(grid, next);
-				if (square(cave, grid)->mon < 0) {
+				if (square(cave, grid).mon < 0) {
 					player_handle_post_move(player, true,
 						true);
 				}
@@ -222,13 +223,13 @@ void thrust_away(struct loc centre, struct loc target, int grids_away)
 
 	/* Some special messages or effects for player or monster. */
 	if (square_isfiery(cave, grid)) {
-		if (square(cave, grid)->mon < 0) {
+		if (square(cave, grid).mon < 0) {
 			msg("You are thrown into molten lava!");
 		}
 	}
 
 	/* Clear the projection mark. */
-	sqinfo_off(square(cave, grid)->info, SQUARE_PROJECT);
+	sqinfo_off(square(cave, grid).info, SQUARE_PROJECT);
 }
 
 /**
@@ -1191,6 +1192,7 @@ static bool project_m_monster_attack(project_monster_handler_context_t *context,
 
 	/* Hurt the monster */
 	mon->hp -= dam;
+	monster_schedule_update(cave, mon);
 
 	/* Dead or damaged monster */
 	if (mon->hp < 0) {
@@ -1470,7 +1472,7 @@ void project_m(struct source origin, int r, struct loc grid, int dam, int typ,
 	bool beguile = (origin.what == SRC_PLAYER) ?
 		player_has(player, PF_BEGUILE) : false;
 
-	int m_idx = square(cave, grid)->mon;
+	int m_idx = square(cave, grid).mon;
 
 	project_monster_handler_f monster_handler = monster_handlers[typ];
 	project_monster_handler_context_t context = {
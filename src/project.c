@@ -29,6 +29,7 @@
 #include "project.h"
 #include "source.h"
 #include "trap.h"
+#include "z-names.h"
 
 struct projection *projections;
 
@@ -57,9 +58,34 @@ static const char *proj_name_list[] =
     NULL
 };
 
+/**
+ * Index of PROJ type names, made before the data files are read
+ */
+static struct name_index *proj_names;
+
+void proj_name_index_build(void)
+{
+	int i;
+
+	name_index_free(proj_names);
+	proj_names = name_index_new(true);
+	for (i = 0; proj_name_list[i]; i++)
+		name_index_add(proj_names, proj_name_list[i], i);
+}
+
+void proj_name_index_free(void)
+{
+	name_index_free(proj_names);
+	proj_names = NULL;
+}
+
 int proj_name_to_idx(const char *name)
 {
     int i;
+
+    if (proj_names) {
+        return name_index_find(proj_names, name);
+    }
     for (i = 0; proj_name_list[i]; i++) {
         if (!my_stricmp(name, proj_name_list[i]))
             return i;
@@ -215,7 +241,7 @@ int project_path(struct chunk *c, struct loc *gp, int range, struct loc grid1,
 
 			/* Sometimes stop at non-initial monsters/players, decoys */
 			if (flg & (PROJECT_STOP)) {
-				if ((n > 0) && (square(c, loc(x, y))->mon != 0)) break;
+				if ((n > 0) && (square(c, loc(x, y)).mon != 0)) break;
 				if (loc_eq(loc(x, y), decoy)) break;
 			}
 
@@ -281,7 +307,7 @@ int project_path(struct chunk *c, struct loc *gp, int range, struct loc grid1,
 
 			/* Sometimes stop at non-initial monsters/players, decoys */
 			if (flg & (PROJECT_STOP)) {
-				if ((n > 0) && (square(c, loc(x, y))->mon != 0)) break;
+				if ((n > 0) && (square(c, loc(x, y)).mon != 0)) break;
 				if (loc_eq(loc(x, y), decoy)) break;
 			}
 
@@ -341,7 +367,7 @@ int project_path(struct chunk *c, struct loc *gp, int range, struct loc grid1,
 
 			/* Sometimes stop at non-initial monsters/players, decoys */
 			if (flg & (PROJECT_STOP)) {
-				if ((n > 0) && (square(c, loc(x, y))->mon != 0)) break;
+				if ((n > 0) && (square(c, loc(x, y)).mon != 0)) break;
 				if (loc_eq(loc(x, y), decoy)) break;
 			}
 
@@ -667,7 +693,7 @@ bool project(struct source origin, int rad, struct loc finish,
 		blast_grid[num_grids] =  finish;
 		centre = finish;
 		distance_to_grid[num_grids] = 0;
-		sqinfo_on(square(cave, finish)->info, SQUARE_PROJECT);
+		sqinfo_on(square(cave, finish).info, SQUARE_PROJECT);
 		num_grids++;
 	} else {
 		/* Start from caster */
@@ -711,13 +737,13 @@ bool project(struct source origin, int rad, struct loc finish,
 					blast_grid[num_grids].y = y;
 					blast_grid[num_grids].x = x;
 					distance_to_grid[num_grids] = 0;
-					sqinfo_on(square(cave, loc(x, y))->info, SQUARE_PROJECT);
+					sqinfo_on(square(cave, loc(x, y)).info, SQUARE_PROJECT);
 					num_grids++;
 				} else if (i == num_path_grids - 1) {
 					blast_grid[num_grids].y = y;
 					blast_grid[num_grids].x = x;
 					distance_to_grid[num_grids] = 0;
-					sqinfo_on(square(cave, loc(x, y))->info, SQUARE_PROJECT);
+					sqinfo_on(square(cave, loc(x, y)).info, SQUARE_PROJECT);
 					num_grids++;
 				}
 
@@ -768,7 +794,7 @@ bool project(struct source origin, int rad, struct loc finish,
 		if (num_grids == 0) {
 			blast_grid[num_grids] = centre;
 			distance_to_grid[num_grids] = 0;
-			sqinfo_on(square(cave, centre)->info, SQUARE_PROJECT);
+			sqinfo_on(square(cave, centre).info, SQUARE_PROJECT);
 			num_grids++;
 		}
 
@@ -855,7 +881,7 @@ bool project(struct source origin, int rad, struct loc finish,
 					blast_grid[num_grids].y = y;
 					blast_grid[num_grids].x = x;
 					distance_to_grid[num_grids] = dist_from_centre;
-					sqinfo_on(square(cave, grid)->info, SQUARE_PROJECT);
+					sqinfo_on(square(cave, grid).info, SQUARE_PROJECT);
 					num_grids++;
 				}
 			}
@@ -975,7 +1001,7 @@ bool project(struct source origin, int rad, struct loc finish,
 			int y = last_hit_grid.y;
 
 			/* Track if possible */
-			if (square(cave, loc(x, y))->mon > 0) {
+			if (square(cave, loc(x, y)).mon > 0) {
 				struct monster *mon = square_monster(cave, loc(x, y));
 
 				/* Recall and track */
@@ -1026,7 +1052,7 @@ bool project(struct source origin, int rad, struct loc finish,
 	/* Clear all the processing marks. */
 	for (i = 0; i < num_grids; i++) {
 		/* Clear the mark */
-		sqinfo_off(square(cave, blast_grid[i])->info, SQUARE_PROJECT);
+		sqinfo_off(square(cave, blast_grid[i]).info, SQUARE_PROJECT);
 	}
 
 	/* Update stuff if needed */
@@ -122,6 +122,8 @@ bool project_p(struct source, int r, struct loc grid, int dam, int typ,
 int project_path(struct chunk *c, struct loc *gp, int range, struct loc grid1,
 				 struct loc grid2, int flg);
 bool projectable(struct chunk *c, struct loc grid1, struct loc grid2, int flg);
+void proj_name_index_build(void);
+void proj_name_index_free(void);
 int proj_name_to_idx(const char *name);
 const char *proj_idx_to_name(int type);
 
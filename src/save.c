@@ -19,10 +19,12 @@
 #include "angband.h"
 #include "cave.h"
 #include "game-world.h"
+#include "generate.h"
 #include "init.h"
 #include "mon-group.h"
 #include "mon-lore.h"
 #include "mon-make.h"
+#include "mon-schedule.h"
 #include "monster.h"
 #include "object.h"
 #include "obj-desc.h"
@@ -309,16 +311,16 @@ void wr_randomizer(void)
 	wr_u32b(Rand_value);
 
 	/* state index */
-	wr_u32b(state_i);
+	wr_u32b(Rand_game.i);
 
-	/* RNG variables */
-	wr_u32b(z0);
-	wr_u32b(z1);
-	wr_u32b(z2);
+	/* RNG variables, no longer kept */
+	wr_u32b(0);
+	wr_u32b(0);
+	wr_u32b(0);
 
 	/* RNG state */
 	for (i = 0; i < RAND_DEG; i++)
-		wr_u32b(STATE[i]);
+		wr_u32b(Rand_game.state[i]);
 
 	/* NULL padding */
 	for (i = 0; i < 59 - RAND_DEG; i++)
@@ -852,78 +854,60 @@ void wr_stores(void)
 /**
  * Write the current dungeon terrain features and info flags
  *
- * Note that the cost and when fields of c->squares[y][x] are not saved
+ * Note that the cost and when fields of the grids are not saved
  */
-static void wr_dungeon_aux(struct chunk *c)
+/**
+ * Write n bytes, each stride apart, from a chunk's grid array as runs of
+ * (count, value) pairs.
+ */
+static void wr_grid_runs(const uint8_t *plane, size_t n, size_t stride)
 {
-	int y, x;
-	size_t i;
+	uint8_t runs[512];
+	size_t i, len = 0;
+	uint8_t count = 0;
+	uint8_t prev_char = 0;
+
+	for (i = 0; i < n; i++) {
+		uint8_t tmp8u = plane[i * stride];
+
+		/* If the run is broken, or too full, flush it */
+		if ((tmp8u != prev_char) || (count == UCHAR_MAX)) {
+			runs[len++] = count;
+			runs[len++] = prev_char;
+			if (len == sizeof(runs)) {
+				wr_bytes(runs, len);
+				len = 0;
+			}
+			prev_char = tmp8u;
+			count = 1;
+		} else /* Continue the run */
+			count++;
+	}
 
-	uint8_t tmp8u;
+	/* Flush the data (if any) */
+	if (count) {
+		runs[len++] = count;
+		runs[len++] = prev_char;
+	}
+	wr_bytes(runs, len);
+}
 
-	uint8_t count;
-	uint8_t prev_char;
+static void wr_dungeon_aux(struct chunk *c)
+{
+	size_t i, n = (size_t) c->height * c->width;
 
 	/* Dungeon specific info follows */
 	wr_string(c->name ? c->name : "Blank");
 	wr_u16b(c->height);
 	wr_u16b(c->width);
 
-	/* Run length encoding of c->squares[y][x].info */
+	/* Run length encoding of c->sq_info, one flag byte at a time */
 	for (i = 0; i < SQUARE_SIZE; i++) {
-		count = 0;
-		prev_char = 0;
-
-		/* Dump for each grid */
-		for (y = 0; y < c->height; y++) {
-			for (x = 0; x < c->width; x++) {
-				/* Extract the important c->squares[y][x].info flags */
-				tmp8u = square(c, loc(x, y))->info[i];
-
-				/* If the run is broken, or too full, flush it */
-				if ((tmp8u != prev_char) || (count == UCHAR_MAX)) {
-					wr_byte(count);
-					wr_byte(prev_char);
-					prev_char = tmp8u;
-					count = 1;
-				} else /* Continue the run */
-					count++;
-			}
-		}
-
-		/* Flush the data (if any) */
-		if (count) {
-			wr_byte(count);
-			wr_byte(prev_char);
-		}
+		wr_grid_runs(c->sq_info + i, n, SQUARE_SIZE);
 	}
 
 	/* Now the terrain */
-	count = 0;
-	prev_char = 0;
-
-	/* Dump for each grid */
-	for (y = 0; y < c->height; y++) {
-		for (x = 0; x < c->width; x++) {
-			/* Extract a byte */
-			tmp8u = square(c, loc(x, y))->feat;
-
-			/* If the run is broken, or too full, flush it */
-			if ((tmp8u != prev_char) || (count == UCHAR_MAX)) {
-				wr_byte(count);
-				wr_byte(prev_char);
-				prev_char = tmp8u;
-				count = 1;
-			} else /* Continue the run */
-				count++;
-		}
-	}
-
-	/* Flush the data (if any) */
-	if (count) {
-		wr_byte(count);
-		wr_byte(prev_char);
-	}
+	wr_grid_runs(c->sq_feat, n, 1);
 
 	/* Write feeling */
 	wr_byte(c->feeling);
@@ -968,7 +952,7 @@ static void wr_objects_aux(struct chunk *c)
 	wr_u16b(c->obj_max);
 	for (y = 0; y < c->height; y++) {
 		for (x = 0; x < c->width; x++) {
-			struct object *obj = square(c, loc(x, y))->obj;
+			struct object *obj = square(c, loc(x, y)).obj;
 			while (obj) {
 				wr_item(obj);
 				obj = obj->next;
@@ -1005,6 +989,9 @@ static void wr_monsters_aux(struct chunk *c)
 	if (player->is_dead)
 		return;
 
+	/* The monsters' energies as they stand */
+	monster_schedule_drop(c);
+
 	/* Total monsters */
 	wr_u16b(cave_monster_max(c));
 
@@ -1028,7 +1015,7 @@ static void wr_traps_aux(struct chunk *c)
 
 	for (y = 0; y < c->height; y++) {
 		for (x = 0; x < c->width; x++) {
-			struct trap *trap = square(c, loc(x, y))->trap;
+			struct trap *trap = square(c, loc(x, y)).trap;
 			while (trap) {
 				wr_trap(trap);
 				trap = trap->next;
@@ -1081,6 +1068,44 @@ void wr_traps(void)
 	wr_traps_aux(player->cave);
 }
 
+/**
+ * Write a stored chunk
+ */
+void wr_chunk(struct chunk *c)
+{
+	/* Write the terrain and info */
+	wr_dungeon_aux(c);
+
+	/* Write the objects */
+	wr_objects_aux(c);
+
+	/* Write the monsters */
+	wr_monsters_aux(c);
+
+	/* Write the traps */
+	wr_traps_aux(c);
+
+	/* Write other chunk info */
+	if (OPT(player, birth_levels_persist)) {
+		int i;
+
+		wr_string(c->name);
+		wr_s32b(c->turn);
+		wr_u16b(c->depth);
+		wr_byte(c->feeling);
+		wr_u32b(c->obj_rating);
+		wr_u32b(c->mon_rating);
+		wr_byte(c->good_item ? 1 : 0);
+		wr_u16b(c->height);
+		wr_u16b(c->width);
+		wr_u16b(c->feeling_squares);
+		for (i = 0; i < z_info->f_max + 1; i++) {
+			wr_u16b(c->feat_count[i]);
+		}
+		wr_byte(c->ghost->bones_selector);
+	}
+}
+
 /*
  * Write the chunk list
  */
@@ -1097,36 +1122,15 @@ void wr_chunks(void)
 	for (j = 0; j < chunk_list_max; j++) {
 		struct chunk *c = chunk_list[j];
 
-		/* Write the terrain and info */
-		wr_dungeon_aux(c);
-
-		/* Write the objects */
-		wr_objects_aux(c);
-
-		/* Write the monsters */
-		wr_monsters_aux(c);
-
-		/* Write the traps */
-		wr_traps_aux(c);
-
-		/* Write other chunk info */
-		if (OPT(player, birth_levels_persist)) {
-			int i;
-
-			wr_string(c->name);
-			wr_s32b(c->turn);
-			wr_u16b(c->depth);
-			wr_byte(c->feeling);
-			wr_u32b(c->obj_rating);
-			wr_u32b(c->mon_rating);
-			wr_byte(c->good_item ? 1 : 0);
-			wr_u16b(c->height);
-			wr_u16b(c->width);
-			wr_u16b(c->feeling_squares);
-			for (i = 0; i < z_info->f_max + 1; i++) {
-				wr_u16b(c->feat_count[i]);
-			}
-			wr_byte(c->ghost->bones_selector);
+		if (c->packed) {
+			/* Packed chunks are already in savefile form */
+			uint32_t size;
+			uint8_t *data = chunk_packed_copy(c, &size);
+
+			wr_bytes(data, size);
+			mem_free(data);
+		} else {
+			wr_chunk(c);
 		}
 	}
 }
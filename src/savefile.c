@@ -15,13 +15,16 @@
  *    and not for profit purposes provided that this copyright and statement
  *    are included in all such copies.  Other copyrights may also apply.
  */
-#include <errno.h>
 #include "angband.h"
 #include "game-world.h"
 #include "init.h"
 #include "savefile.h"
 #include "save-charoutput.h"
 #include "z-file.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <signal.h>
+#endif
 
 /**
  * The savefile code.
@@ -50,9 +53,12 @@
  * need simply remove old loaders and you will not have to disentangle
  * lots of code with "if (version > 3)" and its like everywhere.
  *
- * Savefile loading and saving is done by keeping the current block in
- * memory, which is accessed using the wr_* and rd_* functions.  This is
- * then written out, whole, to disk, with the appropriate header.
+ * Savefile loading is done by keeping the current block in memory, which is
+ * accessed using the rd_* functions.  Saving goes through a buffer of fixed
+ * size, filled by the wr_* functions and written out each time it fills; the
+ * block header goes first and its size and checksum are filled in once the
+ * whole block is out.  Saving in the background instead makes the whole
+ * savefile in memory, which another thread then writes to disk.
  *
  *
  * So, if you want to make a savefile compat-breaking change, then there are
@@ -161,8 +167,13 @@ static uint32_t buffer_size;
 static uint32_t buffer_pos;
 static uint32_t buffer_check;
 
+/* Where the savefile goes as the buffer fills; NULL to keep it all */
+static ang_file *stream;
+static uint32_t stream_done;	/* bytes of the savefile gone to the file */
+static bool stream_failed;
+
 #define BUFFER_INITIAL_SIZE		1024
-#define BUFFER_BLOCK_INCREMENT	1024
+#define BUFFER_STREAM_SIZE		65536
 
 #define SAVEFILE_HEAD_SIZE		28
 
@@ -187,18 +198,45 @@ void note(const char *message)
  * Base put/get
  * ------------------------------------------------------------------------ */
 
-static void sf_put(uint8_t v)
+/**
+ * Make room for at least n more bytes in the buffer:  when saving to a file,
+ * by writing out what the buffer holds, otherwise by growing it.
+ */
+static void sf_make_room(uint32_t n)
 {
 	assert(buffer != NULL);
 	assert(buffer_size > 0);
 
-	if (buffer_size == buffer_pos)
-	{
-		buffer_size += BUFFER_BLOCK_INCREMENT;
+	if (stream && buffer_pos) {
+		if (!file_write(stream, (char *)buffer, buffer_pos))
+			stream_failed = true;
+		stream_done += buffer_pos;
+		buffer_pos = 0;
+	}
+
+	if (buffer_size - buffer_pos < n) {
+		while (buffer_size - buffer_pos < n)
+			buffer_size *= 2;
 		buffer = mem_realloc(buffer, buffer_size);
 	}
+}
+
+/**
+ * Get space for n bytes at the end of the buffer; the caller fills them,
+ * adds them to the checksum and moves buffer_pos past them.
+ */
+static inline uint8_t *sf_reserve(uint32_t n)
+{
+	if (buffer_size - buffer_pos < n)
+		sf_make_room(n);
+
+	return buffer + buffer_pos;
+}
 
-	assert(buffer_pos < buffer_size);
+static inline void sf_put(uint8_t v)
+{
+	if (buffer_pos == buffer_size)
+		sf_make_room(1);
 
 	buffer[buffer_pos++] = v;
 	buffer_check += v;
@@ -227,8 +265,12 @@ void wr_byte(uint8_t v)
 
 void wr_u16b(uint16_t v)
 {
-	sf_put((uint8_t)(v & 0xFF));
-	sf_put((uint8_t)((v >> 8) & 0xFF));
+	uint8_t *p = sf_reserve(2);
+
+	p[0] = (uint8_t)(v & 0xFF);
+	p[1] = (uint8_t)((v >> 8) & 0xFF);
+	buffer_check += p[0] + p[1];
+	buffer_pos += 2;
 }
 
 void wr_s16b(int16_t v)
@@ -238,10 +280,14 @@ void wr_s16b(int16_t v)
 
 void wr_u32b(uint32_t v)
 {
-	sf_put((uint8_t)(v & 0xFF));
-	sf_put((uint8_t)((v >> 8) & 0xFF));
-	sf_put((uint8_t)((v >> 16) & 0xFF));
-	sf_put((uint8_t)((v >> 24) & 0xFF));
+	uint8_t *p = sf_reserve(4);
+
+	p[0] = (uint8_t)(v & 0xFF);
+	p[1] = (uint8_t)((v >> 8) & 0xFF);
+	p[2] = (uint8_t)((v >> 16) & 0xFF);
+	p[3] = (uint8_t)((v >> 24) & 0xFF);
+	buffer_check += p[0] + p[1] + p[2] + p[3];
+	buffer_pos += 4;
 }
 
 void wr_s32b(int32_t v)
@@ -249,14 +295,32 @@ void wr_s32b(int32_t v)
 	wr_u32b((uint32_t)v);
 }
 
-void wr_string(const char *str)
+void wr_bytes(const uint8_t *data, uint32_t n)
 {
-	while (*str)
-	{
-		wr_byte(*str);
-		str++;
+	uint32_t i, check = 0;
+
+	for (i = 0; i < n; i++)
+		check += data[i];
+	buffer_check += check;
+
+	/* Anything bigger than the buffer goes straight to the file */
+	if (stream && n > buffer_size - buffer_pos) {
+		sf_make_room(0);
+		if (n > buffer_size) {
+			if (!file_write(stream, (const char *)data, n))
+				stream_failed = true;
+			stream_done += n;
+			return;
+		}
 	}
-	wr_byte(*str);
+
+	memcpy(sf_reserve(n), data, n);
+	buffer_pos += n;
+}
+
+void wr_string(const char *str)
+{
+	wr_bytes((const uint8_t *)str, strlen(str) + 1);
 }
 
 
@@ -322,21 +386,49 @@ void pad_bytes(int n)
  * ------------------------------------------------------------------------ */
 
 
-static bool try_save(ang_file *file)
+/**
+ * Write bytes which are not part of any block, so not in any checksum.
+ */
+static void sf_put_raw(const void *data, uint32_t n)
+{
+	memcpy(sf_reserve(n), data, n);
+	buffer_pos += n;
+}
+
+/**
+ * Overwrite n bytes written earlier, 'at' bytes from the start of the
+ * savefile; they may still be in the buffer or already in the file.
+ */
+static void sf_patch(uint32_t at, const uint8_t *data, uint32_t n)
+{
+	if (at >= stream_done) {
+		memcpy(buffer + at - stream_done, data, n);
+	} else if (! file_seek(stream, at) || ! file_write(stream,
+			(const char *)data, n) || ! file_seek(stream, stream_done)) {
+		stream_failed = true;
+	}
+}
+
+/**
+ * Write the whole savefile through the buffer, which goes to the file in
+ * 'stream' as it fills, or grows to hold everything if there is no file.
+ * The size and checksum in each block header are filled in at the end of
+ * the block.
+ */
+static bool save_blocks(void)
 {
 	uint8_t savefile_head[SAVEFILE_HEAD_SIZE];
 	size_t i, pos;
-	bool success = true;
 
-	/* Start off the buffer */
-	buffer = mem_alloc(BUFFER_INITIAL_SIZE);
-	buffer_size = BUFFER_INITIAL_SIZE;
+	buffer_pos = 0;
+	stream_done = 0;
+	stream_failed = false;
 
-	for (i = 0; i < N_ELEMENTS(savers); i++) {
-		buffer_pos = 0;
-		buffer_check = 0;
+	sf_put_raw(savefile_magic, 4);
+	sf_put_raw(savefile_name, 4);
 
-		savers[i].save();
+	for (i = 0; i < N_ELEMENTS(savers) && !stream_failed; i++) {
+		uint32_t head_at = stream_done + buffer_pos, block_size;
 
 		/* 16-byte block name */
 		pos = my_strcpy((char *)savefile_head,
@@ -351,33 +443,105 @@ static bool try_save(ang_file *file)
 		savefile_head[pos++] = ((v >> 16) & 0xFF); \
 		savefile_head[pos++] = ((v >> 24) & 0xFF);
 
+		/* Size and checksum to come */
 		SAVE_U32B(savers[i].version);
-		SAVE_U32B(buffer_pos);
-		SAVE_U32B(buffer_check);
+		SAVE_U32B(0);
+		SAVE_U32B(0);
 
 		assert(pos == SAVEFILE_HEAD_SIZE);
+		sf_put_raw(savefile_head, SAVEFILE_HEAD_SIZE);
 
-		if (! file_write(file, (char *)savefile_head,
-				SAVEFILE_HEAD_SIZE)) {
-			success = false;
-		}
-		if (! file_write(file, (char *)buffer, buffer_pos)) {
-			success = false;
-		}
+		buffer_check = 0;
+		savers[i].save();
+		block_size = stream_done + buffer_pos - head_at -
+			SAVEFILE_HEAD_SIZE;
 
 		/* pad to 4 byte multiples */
-		if (buffer_pos % 4) {
-			if (! file_write(file, "xxx", 4 - (buffer_pos % 4))) {
-				success = false;
-			}
-		}
+		if (block_size % 4)
+			sf_put_raw("xxx", 4 - (block_size % 4));
+
+		/* Go back and finish the header */
+		pos = 20;
+		SAVE_U32B(block_size);
+		SAVE_U32B(buffer_check);
+		sf_patch(head_at + 20, savefile_head + 20, 8);
 	}
 
+	/* Write out the rest */
+	sf_make_room(0);
+
+	return !stream_failed;
+}
+
+/**
+ * Write the savefile to an open file, through a buffer of fixed size.
+ */
+static bool try_save(ang_file *file)
+{
+	bool success;
+
+	/* Start off the buffer */
+	buffer = mem_alloc(BUFFER_STREAM_SIZE);
+	buffer_size = BUFFER_STREAM_SIZE;
+	stream = file;
+
+	success = save_blocks();
+
 	mem_free(buffer);
+	buffer = NULL;
+	stream = NULL;
 
 	return success;
 }
 
+/**
+ * Put a newly written savefile in place of the old one, which is kept until
+ * the new one is there; if the new one couldn't be written, remove it.
+ *
+ * \param path is the savefile
+ * \param new_savefile is where the new savefile was written
+ * \param old_savefile is where the old savefile goes in the meantime
+ * \param created is whether new_savefile was created
+ * \param written is whether new_savefile was written in full
+ * \return whether the new savefile is now at path
+ */
+static bool savefile_commit(const char *path, const char *new_savefile,
+		const char *old_savefile, bool created, bool written)
+{
+	if (written) {
+		bool err = false;
+
+		safe_setuid_grab();
+
+		if (file_exists(path) && !file_move(path, old_savefile))
+			err = true;
+
+		if (!err) {
+			if (!file_move(new_savefile, path))
+				err = true;
+
+			if (err)
+				file_move(old_savefile, path);
+			else
+				file_delete(old_savefile);
+		} 
+
+		safe_setuid_drop();
+
+		return err ? false : true;
+	}
+
+	/* Delete temp file if the save failed */
+	if (created) {
+		/* File is no longer valid, but it still points to a non zero
+		 * value if the file was created above */
+		safe_setuid_grab();
+		file_delete(new_savefile);
+		safe_setuid_drop();
+	}
+	return false;
+}
+
 /**
  * Attempt to save the player in a savefile
  */
@@ -387,6 +551,9 @@ bool savefile_save(const char *path)
 	char new_savefile[1024];
 	char old_savefile[1024];
 
+	/* Let any save in the background finish first */
+	savefile_save_wait();
+
 	/* Generate a CharOutput.txt, mainly for angband.live, when saving. */
 	(void) save_charoutput();
 
@@ -401,51 +568,264 @@ bool savefile_save(const char *path)
 	safe_setuid_drop();
 
 	if (file) {
-		if (file_write(file, (char *) &savefile_magic, 4)
-			&& file_write(file, (char *) &savefile_name, 4)) {
-			character_saved = try_save(file);
-		} else {
-			character_saved = false;
-		}
+		character_saved = try_save(file);
 		file_close(file);
 	} else {
 		character_saved = false;
 	}
 
-	if (character_saved) {
-		bool err = false;
+	return savefile_commit(path, new_savefile, old_savefile, file != NULL,
+		character_saved);
+}
 
-		safe_setuid_grab();
 
-		if (file_exists(path) && !file_move(path, old_savefile))
-			err = true;
+/**
+ * ------------------------------------------------------------------------
+ * Saving in the background
+ * ------------------------------------------------------------------------ */
 
-		if (!err) {
-			if (!file_move(new_savefile, path))
-				err = true;
+/**
+ * A savefile made in memory, waiting to be written out
+ */
+struct save_job {
+	uint8_t *data;
+	uint32_t size;
+	ang_file *file;
+	char path[1024];
+	char new_savefile[1024];
+	char old_savefile[1024];
+	bool written;
+};
 
-			if (err)
-				file_move(old_savefile, path);
-			else
-				file_delete(old_savefile);
-		} 
+/* The save in progress, if any */
+static struct save_job *save_job;
+static bool save_finished;
 
-		safe_setuid_drop();
+#ifdef HAVE_PTHREAD
+static pthread_t save_thread;
+static pthread_mutex_t save_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool save_threaded;
+#endif
 
-		return err ? false : true;
+/**
+ * Write a savefile made in memory out to the file already opened for it.
+ * This touches nothing but the job, and needs no privileges, so can be done
+ * while the game goes on.
+ */
+static void save_job_write(struct save_job *job)
+{
+	job->written = file_write(job->file, (char *)job->data, job->size);
+	if (!file_close(job->file))
+		job->written = false;
+}
+
+#ifdef HAVE_PTHREAD
+static void *save_job_run(void *arg)
+{
+	struct save_job *job = arg;
+	sigset_t signals;
+
+	/* Leave signals to the game thread */
+	sigfillset(&signals);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	save_job_write(job);
+
+	pthread_mutex_lock(&save_lock);
+	save_finished = true;
+	pthread_mutex_unlock(&save_lock);
+
+	return NULL;
+}
+#endif
+
+/**
+ * Tidy up after a save in the background, waiting for it to be written out
+ * if need be, put it in place, and tell the game how it went.
+ */
+static void save_job_finish(void)
+{
+	bool success;
+
+#ifdef HAVE_PTHREAD
+	if (save_threaded)
+		pthread_join(save_thread, NULL);
+	save_threaded = false;
+#endif
+
+	success = savefile_commit(save_job->path, save_job->new_savefile,
+		save_job->old_savefile, save_job->file != NULL,
+		save_job->written);
+	mem_free(save_job->data);
+	mem_free(save_job);
+	save_job = NULL;
+	save_finished = false;
+
+	character_saved = success;
+	event_signal_flag(EVENT_SAVEFILE_DONE, success);
+}
+
+/**
+ * Save the player in a savefile without waiting for the disk:  the savefile
+ * is made in memory now, so later changes to the game aren't in it, and
+ * written out by another thread.  EVENT_SAVEFILE_DONE is signalled, from
+ * savefile_save_poll() or savefile_save_wait(), once it is in place.
+ *
+ * Everything that needs privileges, opening the new savefile and moving it
+ * into place, is done on the game thread; the other thread only writes.
+ * Without threads, the savefile is written out straight away.
+ */
+void savefile_save_async(const char *path)
+{
+	struct save_job *job;
+
+	/* One at a time */
+	savefile_save_wait();
+
+	(void) save_charoutput();
+
+	job = mem_zalloc(sizeof(*job));
+	my_strcpy(job->path, path, sizeof(job->path));
+	file_get_savefile(job->old_savefile, sizeof(job->old_savefile), path,
+		"old");
+	file_get_savefile(job->new_savefile, sizeof(job->new_savefile), path,
+		"new");
+
+	/* Make the savefile */
+	buffer = mem_alloc(BUFFER_STREAM_SIZE);
+	buffer_size = BUFFER_STREAM_SIZE;
+	stream = NULL;
+	(void) save_blocks();
+	job->data = buffer;
+	job->size = buffer_pos;
+	buffer = NULL;
+
+	save_job = job;
+	save_finished = false;
+
+	/* Open the new savefile */
+	safe_setuid_grab();
+	job->file = file_open(job->new_savefile, MODE_WRITE, FTYPE_SAVE);
+	safe_setuid_drop();
+	if (!job->file) {
+		save_job_finish();
+		return;
 	}
 
-	/* Delete temp file if the save failed */
-	if (file) {
-		/* File is no longer valid, but it still points to a non zero
-		 * value if the file was created above */
-		safe_setuid_grab();
-		file_delete(new_savefile);
-		safe_setuid_drop();
+#ifdef HAVE_PTHREAD
+	if (pthread_create(&save_thread, NULL, save_job_run, job) == 0) {
+		save_threaded = true;
+		return;
 	}
-	return false;
+#endif
+
+	/* No thread, so write it out now */
+	save_job_write(job);
+	save_job_finish();
+}
+
+/**
+ * Check whether a save in the background is under way.
+ */
+bool savefile_save_pending(void)
+{
+	return save_job != NULL;
 }
 
+/**
+ * Finish off a save in the background if it is done; call this regularly
+ * from the game thread.
+ */
+void savefile_save_poll(void)
+{
+	bool finished;
+
+	if (!save_job) return;
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&save_lock);
+	finished = save_finished;
+	pthread_mutex_unlock(&save_lock);
+#else
+	finished = save_finished;
+#endif
+
+	if (finished)
+		save_job_finish();
+}
+
+/**
+ * Wait for any save in the background to finish.
+ */
+void savefile_save_wait(void)
+{
+	if (save_job)
+		save_job_finish();
+}
+
+
+/**
+ * ------------------------------------------------------------------------
+ * Stored chunk packing functions
+ * ------------------------------------------------------------------------ */
+
+/**
+ * Write a stored chunk, in the form it takes in the savefile, to a new block
+ * of memory; *size is set to the length of the block.
+ *
+ * This may be called while a savefile is being read, so the buffer in use
+ * is put aside and restored afterwards.
+ */
+uint8_t *savefile_pack_chunk(struct chunk *c, uint32_t *size)
+{
+	uint8_t *old_buffer = buffer, *data;
+	uint32_t old_size = buffer_size, old_pos = buffer_pos;
+	uint32_t old_check = buffer_check;
+	ang_file *old_stream = stream;
+
+	buffer = mem_alloc(BUFFER_INITIAL_SIZE);
+	buffer_size = BUFFER_INITIAL_SIZE;
+	buffer_pos = 0;
+	buffer_check = 0;
+	stream = NULL;
+
+	wr_chunk(c);
+	data = mem_realloc(buffer, buffer_pos);
+	*size = buffer_pos;
+
+	buffer = old_buffer;
+	buffer_size = old_size;
+	buffer_pos = old_pos;
+	buffer_check = old_check;
+	stream = old_stream;
+	return data;
+}
+
+/**
+ * Read back a chunk written by savefile_pack_chunk(); returns NULL if it
+ * could not be read.
+ */
+struct chunk *savefile_unpack_chunk(uint8_t *data, uint32_t size)
+{
+	uint8_t *old_buffer = buffer;
+	uint32_t old_size = buffer_size, old_pos = buffer_pos;
+	uint32_t old_check = buffer_check;
+	struct chunk *c = NULL;
+	bool failed;
+
+	buffer = data;
+	buffer_size = size;
+	buffer_pos = 0;
+	buffer_check = 0;
+
+	failed = rd_packed_chunk(&c) || buffer_pos != size;
+
+	buffer = old_buffer;
+	buffer_size = old_size;
+	buffer_pos = old_pos;
+	buffer_check = old_check;
+	return failed ? NULL : c;
+}
 
 
 /**
@@ -632,6 +1012,9 @@ bool savefile_load(const char *path, bool cheat_death)
 	bool ok;
 	ang_file *f;
 
+	/* Make sure the file is all there */
+	savefile_save_wait();
+
 	safe_setuid_grab();
 	f = file_open(path, MODE_READ, FTYPE_TEXT);
 	safe_setuid_drop();
@@ -18,6 +18,8 @@
 #ifndef INCLUDED_SAVEFILE_H
 #define INCLUDED_SAVEFILE_H
 
+struct chunk;
+
 #define FINISHED_CODE 255
 #define ITEM_VERSION	5
 #define EGO_ART_KNOWN 0xffffffff
@@ -37,6 +39,15 @@ extern bool character_saved;
  */
 bool savefile_save(const char *path);
 
+/**
+ * Save to the given location in the background; EVENT_SAVEFILE_DONE says
+ * whether it worked.
+ */
+void savefile_save_async(const char *path);
+bool savefile_save_pending(void);
+void savefile_save_poll(void);
+void savefile_save_wait(void);
+
 /**
  * Load the savefile given.  Returns true on succcess, false otherwise.
  */
@@ -52,6 +63,12 @@ const char *savefile_get_description(const char *path);
  */
 void savefile_get_panic_name(char *buffer, size_t len, const char *path);
 
+/**
+ * Convert a stored chunk to and from its savefile form in memory.
+ */
+uint8_t *savefile_pack_chunk(struct chunk *c, uint32_t *size);
+struct chunk *savefile_unpack_chunk(uint8_t *data, uint32_t size);
+
 
 /**
  * ------------------------------------------------------------------------
@@ -68,6 +85,7 @@ void wr_u16b(uint16_t v);
 void wr_s16b(int16_t v);
 void wr_u32b(uint32_t v);
 void wr_s32b(int32_t v);
+void wr_bytes(const uint8_t *data, uint32_t n);
 void wr_string(const char *str);
 void pad_bytes(int n);
 
@@ -99,6 +117,7 @@ int rd_gear(void);
 int rd_stores(void);
 int rd_dungeon(void);
 int rd_chunks(void);
+int rd_packed_chunk(struct chunk **c);
 int rd_objects(void);
 int rd_monsters(void);
 int rd_monster_groups(void);
@@ -125,6 +144,7 @@ void wr_gear(void);
 void wr_stores(void);
 void wr_dungeon(void);
 void wr_chunks(void);
+void wr_chunk(struct chunk *c);
 void wr_objects(void);
 void wr_monsters(void);
 void wr_monster_groups(void);
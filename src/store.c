@@ -888,12 +888,15 @@ int price_item(struct store *store, const struct object *obj,
  */
 static int mass_roll(int times, int max)
 {
+	uint32_t rolls[8];
 	int i, t = 0;
 
 	assert(max > 1);
+	assert(times <= (int) N_ELEMENTS(rolls));
 
+	Rand_fill(max, rolls, times);
 	for (i = 0; i < times; i++)
-		t += randint0(max);
+		t += rolls[i];
 
 	return (t);
 }
@@ -339,13 +339,13 @@ bool target_accept(int y, int x)
 	struct object *obj;
 
 	/* Player grids are always interesting */
-	if (square(cave, grid)->mon < 0) return true;
+	if (square(cave, grid).mon < 0) return true;
 
 	/* Handle hallucination */
 	if (player->timed[TMD_IMAGE]) return false;
 
 	/* Obvious monsters */
-	if (square(cave, grid)->mon > 0) {
+	if (square(cave, grid).mon > 0) {
 		struct monster *mon = square_monster(cave, grid);
 		if (monster_is_obvious(mon)) {
 			return true;
@@ -435,6 +435,27 @@ bool target_sighted(void)
 
 #define TS_INITIAL_SIZE	20
 
+struct kill_targets {
+	monster_predicate pred;
+	struct point_set *targets;
+};
+
+/**
+ * Add a grid with a monster to the targets if it's interesting and the
+ * monster is targetable and matches the predicate
+ */
+static bool add_kill_target(struct chunk *c, struct loc grid, void *data)
+{
+	struct kill_targets *kill = data;
+	struct monster *mon = square_monster(c, grid);
+
+	if (square_in_bounds_fully(c, grid) && target_accept(grid.y, grid.x)
+			&& target_able(mon) && (!kill->pred || kill->pred(mon))) {
+		add_to_point_set(kill->targets, grid);
+	}
+	return true;
+}
+
 /**
  * Return a target set of interesting locations including monsters, objects,
  * traps, and features.
@@ -461,33 +482,27 @@ struct point_set *target_get_monsters(int mode, monster_predicate pred,
 		max_x = player->grid.x + z_info->max_range + 1;
 	}
 
-	/* Scan for targets */
-	for (y = min_y; y < max_y; y++) {
-		for (x = min_x; x < max_x; x++) {
-			struct loc grid = loc(x, y);
-
-			/* Check bounds */
-			if (!square_in_bounds_fully(cave, grid)) continue;
+	/* Special mode:  only the grids with monsters need be looked at */
+	if (mode & (TARGET_KILL)) {
+		struct kill_targets kill = { pred, targets };
 
-			/* Require "interesting" contents */
-			if (!target_accept(y, x)) continue;
-
-			/* Special mode */
-			if (mode & (TARGET_KILL)) {
-				struct monster *mon = square_monster(cave, grid);
+		cave_index_box(cave, CAVE_INDEX_MON, loc(min_x, min_y),
+			loc(max_x - 1, max_y - 1), add_kill_target, &kill);
+	} else {
+		/* Scan for targets */
+		for (y = min_y; y < max_y; y++) {
+			for (x = min_x; x < max_x; x++) {
+				struct loc grid = loc(x, y);
 
-				/* Must contain a monster */
-				if (mon == NULL) continue;
+				/* Check bounds */
+				if (!square_in_bounds_fully(cave, grid)) continue;
 
-				/* Must be a targettable monster */
-				if (!target_able(mon)) continue;
+				/* Require "interesting" contents */
+				if (!target_accept(y, x)) continue;
 
-				/* Must be the right sort of monster */
-				if (pred && !pred(mon)) continue;
+				/* Save the location */
+				add_to_point_set(targets, grid);
 			}
-
-			/* Save the location */
-			add_to_point_set(targets, grid);
 		}
 	}
 
@@ -28,7 +28,7 @@ static void wipe_chunk_flags(struct chunk *c) {
 
 	for (grid.y = 0; grid.y < c->height; ++grid.y) {
 		for (grid.x = 0; grid.x < c->width; ++grid.x) {
-			sqinfo_wipe(square(c, grid)->info);
+			sqinfo_wipe(square(c, grid).info);
 		}
 	}
 }
@@ -48,46 +48,46 @@ static int test_cave_find_0(void *state) {
 	for (i = 0; i < (int)N_ELEMENTS(targets); ++i) {
 		target.x = targets[i].x + ((targets[i].x < 0) ? c->width : 0);
 		target.y = targets[i].y + ((targets[i].y < 0) ? c->height : 0);
-		sqinfo_on(square(c, target)->info, SQUARE_ROOM);
+		sqinfo_on(square(c, target).info, SQUARE_ROOM);
 		require(cave_find(c, &grid, square_isroom));
 		require(loc_eq(grid, target));
-		sqinfo_off(square(c, target)->info, SQUARE_ROOM);
+		sqinfo_off(square(c, target).info, SQUARE_ROOM);
 	}
 
 	target.x = 1 + randint0(c->width - 2);
 	target.y = 0;
-	sqinfo_on(square(c, target)->info, SQUARE_ROOM);
+	sqinfo_on(square(c, target).info, SQUARE_ROOM);
 	require(cave_find(c, &grid, square_isroom));
 	require(loc_eq(grid, target));
-	sqinfo_off(square(c, target)->info, SQUARE_ROOM);
+	sqinfo_off(square(c, target).info, SQUARE_ROOM);
 
 	target.x = 1 + randint0(c->width - 2);
 	target.y = c->height - 1;
-	sqinfo_on(square(c, target)->info, SQUARE_ROOM);
+	sqinfo_on(square(c, target).info, SQUARE_ROOM);
 	require(cave_find(c, &grid, square_isroom));
 	require(loc_eq(grid, target));
-	sqinfo_off(square(c, target)->info, SQUARE_ROOM);
+	sqinfo_off(square(c, target).info, SQUARE_ROOM);
 
 	target.x = 1 + randint0(c->width - 2);
 	target.y = 1 + randint0(c->height - 2);
-	sqinfo_on(square(c, target)->info, SQUARE_ROOM);
+	sqinfo_on(square(c, target).info, SQUARE_ROOM);
 	require(cave_find(c, &grid, square_isroom));
 	require(loc_eq(grid, target));
-	sqinfo_off(square(c, target)->info, SQUARE_ROOM);
+	sqinfo_off(square(c, target).info, SQUARE_ROOM);
 
 	target.x = 0;
 	target.y = 1 + randint0(c->height - 2);
-	sqinfo_on(square(c, target)->info, SQUARE_ROOM);
+	sqinfo_on(square(c, target).info, SQUARE_ROOM);
 	require(cave_find(c, &grid, square_isroom));
 	require(loc_eq(grid, target));
-	sqinfo_off(square(c, target)->info, SQUARE_ROOM);
+	sqinfo_off(square(c, target).info, SQUARE_ROOM);
 
 	target.x = c->width - 1;
 	target.y = 1 + randint0(c->height - 2);
-	sqinfo_on(square(c, target)->info, SQUARE_ROOM);
+	sqinfo_on(square(c, target).info, SQUARE_ROOM);
 	require(cave_find(c, &grid, square_isroom));
 	require(loc_eq(grid, target));
-	sqinfo_off(square(c, target)->info, SQUARE_ROOM);
+	sqinfo_off(square(c, target).info, SQUARE_ROOM);
 
 	ok;
 }
@@ -190,7 +190,7 @@ static int test_find_nearby_grid_0(void *state) {
 static int test_unbundled_find_0(void *state) {
 	struct chunk *c = state;
 	bool invalid = false;
-	int *find_state;
+	struct cave_find_state *find_state;
 	struct loc grid;
 
 	wipe_chunk_flags(c);
@@ -199,7 +199,7 @@ static int test_unbundled_find_0(void *state) {
 		loc(c->width - 2, c->height - 2));
 	while (cave_find_get_grid(&grid, find_state)) {
 		if (square_in_bounds_fully(c, grid) && !square_isroom(c, grid)) {
-			sqinfo_on(square(c, grid)->info, SQUARE_ROOM);
+			sqinfo_on(square(c, grid).info, SQUARE_ROOM);
 		} else {
 			invalid = true;
 		}
@@ -217,7 +217,7 @@ static int test_unbundled_find_0(void *state) {
 	cave_find_reset(find_state);
 	while (cave_find_get_grid(&grid, find_state)) {
 		if (square_in_bounds_fully(c, grid) && square_isroom(c, grid)) {
-			sqinfo_off(square(c, grid)->info, SQUARE_ROOM);
+			sqinfo_off(square(c, grid).info, SQUARE_ROOM);
 		} else {
 			invalid = true;
 		}
@@ -232,16 +232,77 @@ static int test_unbundled_find_0(void *state) {
 		}
 	}
 
-	mem_free(find_state);
+	cave_find_free(find_state);
 	require(!invalid);
 	ok;
 }
 
+/*
+ * Searches give the grids in just the order a shuffle of a full array of
+ * the grids would, whether or not they are reset or reuse another's storage
+ */
+static int test_unbundled_find_order(void *state) {
+	struct loc tl = loc(2, 3), br = loc(40, 20), grid;
+	int w = br.x - tl.x + 1, n = w * (br.y - tl.y + 1);
+	int *arr = mem_alloc(n * sizeof(*arr));
+	bool quick = Rand_quick;
+	int pass, i;
+
+	Rand_quick = true;
+	for (pass = 0; pass < 3; pass++) {
+		struct cave_find_state *find_state, *other;
+		uint32_t value;
+		int next;
+
+		/* Shuffle an array the old way, then rewind the generator */
+		Rand_value = 1000 + pass;
+		for (i = 0; i < n; i++) {
+			arr[i] = i;
+		}
+		for (next = 0; next < n; next++) {
+			int j = randint0(n - next) + next, k = arr[j];
+
+			arr[j] = arr[next];
+			arr[next] = k;
+			if (next == n / 3) break;
+		}
+		for (next = 0; next < n; next++) {
+			int j = randint0(n - next) + next, k = arr[j];
+
+			arr[j] = arr[next];
+			arr[next] = k;
+		}
+		value = Rand_value;
+
+		/* Search part way, start again and search the lot */
+		Rand_value = 1000 + pass;
+		find_state = cave_find_init(tl, br);
+		other = cave_find_init(loc(0, 0), loc(3, 3));
+		for (i = 0; i <= n / 3; i++) {
+			require(cave_find_get_grid(&grid, find_state));
+		}
+		cave_find_reset(find_state);
+		for (i = 0; i < n; i++) {
+			require(cave_find_get_grid(&grid, find_state));
+			eq(grid.x, tl.x + arr[i] % w);
+			eq(grid.y, tl.y + arr[i] / w);
+		}
+		require(!cave_find_get_grid(&grid, find_state));
+		eq(Rand_value, value);
+		cave_find_free(find_state);
+		cave_find_free(other);
+	}
+	Rand_quick = quick;
+	mem_free(arr);
+	ok;
+}
+
 const char *suite_name = "cave/find";
 struct test tests[] = {
 	{ "cave_find 0", test_cave_find_0 },
 	{ "cave_find_in_range 0", test_cave_find_in_range_0 },
 	{ "find_nearby_grid 0", test_find_nearby_grid_0 },
 	{ "unbundled find 0", test_unbundled_find_0 },
+	{ "unbundled find order", test_unbundled_find_order },
 	{ NULL, NULL }
 };
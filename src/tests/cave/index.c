@@ -0,0 +1,327 @@
+/* cave/index */
+/*
+ * Check that the spatial index of monsters and objects agrees with the grids
+ * on generated levels and as monsters and objects come, go and move, and
+ * that searches of it find what looking at every grid would.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "mon-util.h"
+#include "monster.h"
+#include "obj-knowledge.h"
+#include "obj-make.h"
+#include "obj-pile.h"
+#include "obj-util.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-util.h"
+#include "z-rand.h"
+#include <time.h>
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	if (cave) {
+		wipe_mon_list(cave, player);
+	}
+	cleanup_angband();
+	return 0;
+}
+
+static bool index_bit(struct chunk *c, enum cave_index_kind kind,
+		struct loc grid) {
+	uint64_t word = c->index[kind][grid.y * c->index_words + grid.x / 64];
+
+	return (word >> (grid.x % 64)) & 1;
+}
+
+static bool index_matches(struct chunk *c) {
+	struct loc grid;
+
+	for (grid.y = 0; grid.y < c->height; grid.y++) {
+		for (grid.x = 0; grid.x < c->width; grid.x++) {
+			if (index_bit(c, CAVE_INDEX_MON, grid) !=
+					(square(c, grid).mon > 0)
+					|| index_bit(c, CAVE_INDEX_OBJ, grid) !=
+					(square(c, grid).obj != NULL))
+				return false;
+		}
+	}
+	return true;
+}
+
+static struct loc random_floor(struct chunk *c) {
+	struct loc grid;
+
+	do {
+		grid = loc(randint1(c->width - 2), randint1(c->height - 2));
+	} while (!square_isfloor(c, grid));
+	return grid;
+}
+
+static struct monster *random_monster(struct chunk *c) {
+	int tries;
+
+	for (tries = 0; tries < 1000; tries++) {
+		struct monster *mon = cave_monster(c,
+			randint1(cave_monster_max(c) - 1));
+
+		if (mon && mon->race) return mon;
+	}
+	return NULL;
+}
+
+static struct object *new_flask(void) {
+	struct object_kind *kind = lookup_kind(TV_FLASK, 1);
+	struct object *obj = object_new();
+
+	object_prep(obj, kind, 0, RANDOMISE);
+	return obj;
+}
+
+/* Grids in a box from looking at each, in the order searches give them */
+static int brute_box(struct chunk *c, enum cave_index_kind kind,
+		struct loc top_left, struct loc bottom_right, struct loc centre,
+		int radius, struct loc *found) {
+	struct loc grid;
+	int n = 0;
+
+	for (grid.y = top_left.y; grid.y <= bottom_right.y; grid.y++) {
+		for (grid.x = top_left.x; grid.x <= bottom_right.x; grid.x++) {
+			if (!square_in_bounds(c, grid)) continue;
+			if (radius >= 0 && distance(centre, grid) > radius)
+				continue;
+			if (kind == CAVE_INDEX_MON ? square(c, grid).mon <= 0 :
+					!square(c, grid).obj) continue;
+			found[n++] = grid;
+		}
+	}
+	return n;
+}
+
+struct collected {
+	struct loc *grids;
+	int n;
+	int stop;
+};
+
+static bool collect(struct chunk *c, struct loc grid, void *data) {
+	struct collected *col = data;
+
+	col->grids[col->n++] = grid;
+	return col->n != col->stop;
+}
+
+static bool same_grids(const struct loc *a, const struct loc *b, int n) {
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (!loc_eq(a[i], b[i])) return false;
+	}
+	return true;
+}
+
+/* Levels at places spread through the world, as generated */
+static int test_levels(void *state) {
+	int i, place = player->place;
+
+	/*
+	 * Themed levels can put the player on a monster when there is no path
+	 * from the last place, so keep to ordinary ones
+	 */
+	player->themed_level_appeared = UINT16_MAX;
+	for (i = 0; i < 6; i++) {
+		player_change_place(player, place);
+		prepare_next_level(player);
+		on_new_level();
+		notnull(cave);
+		require(index_matches(cave));
+		require(index_matches(player->cave));
+		place = 1 + (place + world->num_levels / 6) %
+			(world->num_levels - 1);
+	}
+
+	/* Finish on a busy cave level */
+	do {
+		place++;
+	} while (place < world->num_levels
+		&& (world->levels[place].topography != TOP_CAVE
+		|| world->levels[place].depth < 20));
+	require(place < world->num_levels);
+	player_change_place(player, place);
+	prepare_next_level(player);
+	on_new_level();
+	require(cave_monster_count(cave) > 0);
+	require(index_matches(cave));
+	ok;
+}
+
+static int test_changes(void *state) {
+	const char *races[] = { "scout", "soldier", "cave spider" };
+	struct chunk *c = cave;
+	int i;
+
+	for (i = 0; i < 3000; i++) {
+		int roll = randint0(100);
+		struct loc grid = random_floor(c);
+		struct monster *mon;
+
+		if (roll < 20) {
+			if (square_isempty(c, grid) && c->mon_cnt <
+					z_info->level_monster_max - 2) {
+				(void) t_add_monster(c, grid,
+					races[i % N_ELEMENTS(races)]);
+			}
+		} else if (roll < 35) {
+			mon = random_monster(c);
+			if (mon) delete_monster_idx(c, mon->midx);
+		} else if (roll < 65) {
+			mon = random_monster(c);
+			if (mon) {
+				grid = loc_sum(mon->grid,
+					ddgrid_ddd[randint0(8)]);
+				if (square_isempty(c, grid))
+					monster_swap(mon->grid, grid);
+			}
+		} else if (roll < 75) {
+			grid = loc_sum(player->grid, ddgrid_ddd[randint0(8)]);
+			if (square_isempty(c, grid))
+				monster_swap(player->grid, grid);
+		} else if (roll < 90) {
+			struct object *obj = new_flask();
+			bool note = false;
+
+			if (!floor_carry(c, grid, obj, &note)) {
+				object_delete(c, player->cave, &obj);
+			}
+		} else if (square_object(c, grid) && !square_monster(c, grid)) {
+			/* Leave alone any pile a mimic is hiding in */
+			square_excise_pile(c, grid);
+		}
+		if (i % 100 == 0) {
+			require(index_matches(c));
+		}
+	}
+	require(index_matches(c));
+	require(index_matches(player->cave));
+	ok;
+}
+
+static int test_searches(void *state) {
+	struct chunk *c = cave;
+	int n = c->height * c->width;
+	struct loc *want = mem_alloc(n * sizeof(*want));
+	struct collected col = { mem_alloc(n * sizeof(struct loc)), 0, 0 };
+	int i;
+
+	for (i = 0; i < 500; i++) {
+		enum cave_index_kind kind = i % 2 ? CAVE_INDEX_OBJ :
+			CAVE_INDEX_MON;
+		struct loc centre = loc(randint0(c->width + 20) - 10,
+			randint0(c->height + 20) - 10);
+		int radius = randint0(70), m;
+		struct loc top_left = loc(centre.x - randint0(70),
+			centre.y - randint0(30));
+		struct loc bottom_right = loc(centre.x + randint0(70),
+			centre.y + randint0(30));
+
+		/* Boxes */
+		m = brute_box(c, kind, top_left, bottom_right, centre, -1, want);
+		col.n = 0;
+		col.stop = 0;
+		eq(cave_index_box(c, kind, top_left, bottom_right, collect, &col),
+			m);
+		eq(col.n, m);
+		require(same_grids(col.grids, want, m));
+		eq(cave_index_box(c, kind, top_left, bottom_right, NULL, NULL), m);
+
+		/* Radii */
+		m = brute_box(c, kind, loc(centre.x - radius, centre.y - radius),
+			loc(centre.x + radius, centre.y + radius), centre, radius,
+			want);
+		col.n = 0;
+		eq(cave_index_radius(c, kind, centre, radius, collect, &col), m);
+		eq(col.n, m);
+		require(same_grids(col.grids, want, m));
+
+		/* Stopping early */
+		if (m > 1) {
+			col.n = 0;
+			col.stop = m / 2;
+			eq(cave_index_radius(c, kind, centre, radius, collect, &col),
+				m / 2);
+			require(same_grids(col.grids, want, m / 2));
+		}
+	}
+
+	/* Upside down boxes hold nothing */
+	eq(cave_index_box(c, CAVE_INDEX_MON, loc(c->width - 1, c->height - 1),
+		loc(0, 0), NULL, NULL), 0);
+
+	mem_free(col.grids);
+	mem_free(want);
+	ok;
+}
+
+/* Monsters near the player, by the index and by the monster list */
+static int test_timing(void *state) {
+	const int n = 20000;
+	struct chunk *c = cave;
+	clock_t start, list_ticks, index_ticks;
+	int i, k, by_list = 0, by_index = 0;
+
+	start = clock();
+	for (i = 0; i < n; i++) {
+		for (k = 1; k < cave_monster_max(c); k++) {
+			struct monster *mon = cave_monster(c, k);
+
+			if (mon->race && distance(player->grid, mon->grid) <=
+					z_info->max_range)
+				by_list++;
+		}
+	}
+	list_ticks = clock() - start;
+	start = clock();
+	for (i = 0; i < n; i++) {
+		by_index += cave_index_radius(c, CAVE_INDEX_MON, player->grid,
+			z_info->max_range, NULL, NULL);
+	}
+	index_ticks = clock() - start;
+	eq(by_index, by_list);
+	if (verbose) {
+		printf("%d monsters: list %.1f ms, index %.1f ms per %d searches\n",
+			cave_monster_count(c), 1000.0 * list_ticks / CLOCKS_PER_SEC,
+			1000.0 * index_ticks / CLOCKS_PER_SEC, n);
+	}
+	ok;
+}
+
+const char *suite_name = "cave/index";
+struct test tests[] = {
+	{ "levels", test_levels },
+	{ "changes", test_changes },
+	{ "searches", test_searches },
+	{ "timing", test_timing },
+	{ NULL, NULL }
+};
@@ -0,0 +1,299 @@
+/* cave/light */
+/*
+ * Check that the light levels kept up to date by the light map match those
+ * from computing everything from scratch, as calc_lighting() used to, while
+ * the player and monsters move and terrain and permanent light change.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "game-world.h"
+#include "init.h"
+#include "mon-make.h"
+#include "mon-predicate.h"
+#include "mon-util.h"
+#include "monster.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-calcs.h"
+#include "player-timed.h"
+#include "player-util.h"
+#include "z-rand.h"
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	if (cave) {
+		wipe_mon_list(cave, player);
+		cave_free(cave);
+		cave = NULL;
+	}
+	if (player->cave) {
+		cave_free(player->cave);
+		player->cave = NULL;
+	}
+	cleanup_angband();
+	return 0;
+}
+
+/* The reference:  calc_lighting() before the light map was introduced */
+static bool ref_source_can_light_wall(struct chunk *c, struct player *p,
+		struct loc sgrid, struct loc wgrid) {
+	struct loc sn = next_grid(wgrid, motion_dir(wgrid, sgrid)), pn, cn;
+
+	if (loc_eq(sn, wgrid)) return true;
+	pn = next_grid(wgrid, motion_dir(wgrid, p->grid));
+	if (loc_eq(pn, wgrid)) return true;
+	if (sn.x == pn.x) {
+		if (sn.y == pn.y) return true;
+		cn.x = sn.x;
+		cn.y = 0;
+	} else if (sn.y == pn.y) {
+		cn.x = 0;
+		cn.y = sn.y;
+	} else {
+		return false;
+	}
+	return square_allowslos(c, cn);
+}
+
+static bool ref_glow_lights(struct chunk *c, struct player *p,
+		struct loc chk, struct loc wgrid, bool sunlit) {
+	return square_in_bounds(c, chk) && square_allowslos(c, chk) &&
+		(sunlit || square_isroom(c, chk)) && square_isglow(c, chk) &&
+		ref_source_can_light_wall(c, p, chk, wgrid);
+}
+
+static bool ref_glow_can_light_wall(struct chunk *c, struct player *p,
+		struct loc wgrid, bool sunlit) {
+	struct loc pn = next_grid(wgrid, motion_dir(wgrid, p->grid));
+
+	if (loc_eq(pn, wgrid)) return true;
+	if (square_allowslos(c, pn) && (sunlit || square_isroom(c, pn)) &&
+			square_isglow(c, pn)) return true;
+	if (pn.x != wgrid.x) {
+		if (pn.y != wgrid.y) {
+			return ref_glow_lights(c, p, loc(pn.x, wgrid.y), wgrid,
+					sunlit)
+				|| ref_glow_lights(c, p, loc(wgrid.x, pn.y),
+					wgrid, sunlit);
+		}
+		return ref_glow_lights(c, p, loc(pn.x, wgrid.y - 1), wgrid,
+				sunlit)
+			|| ref_glow_lights(c, p, loc(pn.x, wgrid.y + 1),
+				wgrid, sunlit);
+	}
+	return ref_glow_lights(c, p, loc(wgrid.x - 1, pn.y), wgrid, sunlit)
+		|| ref_glow_lights(c, p, loc(wgrid.x + 1, pn.y), wgrid, sunlit);
+}
+
+static void ref_add_light(struct chunk *c, struct player *p, int *ref,
+		struct loc sgrid, int radius, int inten) {
+	int x, y;
+
+	for (y = -radius; y <= radius; y++) {
+		for (x = -radius; x <= radius; x++) {
+			struct loc grid = loc_sum(sgrid, loc(x, y));
+			int dist = distance(sgrid, grid);
+
+			if (!square_in_bounds(c, grid)) continue;
+			if (dist > radius) continue;
+			if (!los(c, sgrid, grid)) continue;
+			if (!square_allowslos(c, grid) &&
+					!ref_source_can_light_wall(c, p, sgrid,
+					grid)) continue;
+			ref[grid.y * c->width + grid.x] +=
+				(inten > 0) ? inten - dist : inten + dist;
+		}
+	}
+}
+
+static void ref_calc_lighting(struct chunk *c, struct player *p, int *ref) {
+	int dir, k, x, y;
+	int light = p->state.cur_light;
+	bool sunlit = is_daytime() && outside();
+
+	for (y = 0; y < c->height; y++) {
+		for (x = 0; x < c->width; x++) {
+			struct loc grid = loc(x, y);
+			int *r = &ref[y * c->width + x];
+
+			*r = (square_isglow(c, grid) && (sunlit ||
+				square_allowslos(c, grid) ||
+				ref_glow_can_light_wall(c, p, grid, sunlit))) ?
+				1 : 0;
+			if (!square_isbright(c, grid)) continue;
+			*r += 2;
+			for (dir = 0; dir < 8; dir++) {
+				struct loc adj = loc_sum(grid, ddgrid_ddd[dir]);
+
+				if (!square_in_bounds(c, adj)) continue;
+				if (!square_allowslos(c, adj) &&
+						!ref_source_can_light_wall(c, p,
+						grid, adj)) continue;
+				ref[adj.y * c->width + adj.x] += 1;
+			}
+		}
+	}
+	ref_add_light(c, p, ref, p->grid, ABS(light) - 1, light);
+	for (k = 1; k < cave_monster_max(c); k++) {
+		struct monster *mon = cave_monster(c, k);
+
+		if (!mon->race || monster_is_camouflaged(mon)) continue;
+		light = mon->race->light;
+		if (!light) continue;
+		if (distance(p->grid, mon->grid) - (ABS(light) - 1) >
+				z_info->max_sight) continue;
+		ref_add_light(c, p, ref, mon->grid, ABS(light) - 1, light);
+	}
+}
+
+static struct chunk *create_random_cave(int height, int width) {
+	struct chunk *c = cave_new(height, width);
+	struct loc grid;
+
+	for (grid.y = 0; grid.y < height; grid.y++) {
+		for (grid.x = 0; grid.x < width; grid.x++) {
+			int roll = randint0(100);
+
+			if (grid.y == 0 || grid.x == 0 || grid.y == height - 1
+					|| grid.x == width - 1) {
+				square_set_feat(c, grid, FEAT_PERM);
+			} else if (roll < 20) {
+				square_set_feat(c, grid, FEAT_GRANITE);
+			} else if (roll < 23) {
+				square_set_feat(c, grid, FEAT_LAVA);
+			} else {
+				square_set_feat(c, grid, FEAT_FLOOR);
+			}
+			if (randint0(100) < 30) {
+				sqinfo_on(square(c, grid).info, SQUARE_ROOM);
+				sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+			}
+		}
+	}
+	c->depth = 1;
+	return c;
+}
+
+static struct loc random_empty(struct chunk *c) {
+	struct loc grid;
+
+	do {
+		grid = loc(randint1(c->width - 2), randint1(c->height - 2));
+	} while (!square_isfloor(c, grid) || square(c, grid).mon);
+	return grid;
+}
+
+static bool check_light(struct chunk *c, struct player *p) {
+	int *ref = mem_zalloc(c->height * c->width * sizeof(*ref));
+	struct loc grid;
+	bool same = true;
+
+	ref_calc_lighting(c, p, ref);
+	for (grid.y = 0; grid.y < c->height && same; grid.y++) {
+		for (grid.x = 0; grid.x < c->width && same; grid.x++) {
+			if (square_light(c, grid) !=
+					ref[grid.y * c->width + grid.x])
+				same = false;
+		}
+	}
+	mem_free(ref);
+	return same;
+}
+
+static int test_changes(void *state) {
+	const char *races[] = { "scout", "dark hound", "soldier" };
+	struct player *p = player;
+	int i;
+
+	cave = create_random_cave(66, 198);
+	p->cave = cave_new(cave->height, cave->width);
+	p->grid = random_empty(cave);
+	square_set_mon(cave, p->grid, -1);
+	for (i = 0; i < 60; i++) {
+		struct loc grid = random_empty(cave);
+
+		grid = loc(MIN(MAX(grid.x, p->grid.x - 15), p->grid.x + 15),
+			MIN(MAX(grid.y, p->grid.y - 10), p->grid.y + 10));
+		if (!square_isempty(cave, grid)) continue;
+		t_add_monster(cave, grid, races[i % N_ELEMENTS(races)]);
+	}
+	p->state.cur_light = 2;
+	update_view(cave, p);
+	require(check_light(cave, p));
+
+	for (i = 0; i < 300; i++) {
+		int roll = randint0(100), k;
+		struct loc grid;
+
+		if (roll < 30) {
+			/* Step or teleport the player */
+			grid = one_in_(5) ? random_empty(cave) :
+				loc_sum(p->grid, ddgrid_ddd[randint0(8)]);
+			if (square_isempty(cave, grid))
+				monster_swap(p->grid, grid);
+		} else if (roll < 70) {
+			/* Move some monsters */
+			for (k = 1; k < cave_monster_max(cave); k++) {
+				struct monster *mon = cave_monster(cave, k);
+
+				if (!mon->race || !one_in_(3)) continue;
+				grid = loc_sum(mon->grid,
+					ddgrid_ddd[randint0(8)]);
+				if (square_isempty(cave, grid))
+					monster_swap(mon->grid, grid);
+			}
+		} else if (roll < 85) {
+			/* Change terrain */
+			grid = loc(randint1(cave->width - 2),
+				randint1(cave->height - 2));
+			if (square(cave, grid).mon) continue;
+			square_set_feat(cave, grid, square_isfloor(cave, grid) ?
+				(one_in_(2) ? FEAT_GRANITE : FEAT_CLOSED) :
+				FEAT_FLOOR);
+		} else if (roll < 95) {
+			/* Change permanent light */
+			grid = loc(randint1(cave->width - 2),
+				randint1(cave->height - 2));
+			if (square_isglow(cave, grid)) {
+				square_unglow(cave, grid);
+			} else {
+				square_glow(cave, grid);
+			}
+		} else {
+			p->state.cur_light = randint0(5) - 1;
+		}
+		update_view(cave, p);
+		require(check_light(cave, p));
+	}
+
+	wipe_mon_list(cave, p);
+	cave_free(p->cave);
+	p->cave = NULL;
+	cave_free(cave);
+	cave = NULL;
+	ok;
+}
+
+const char *suite_name = "cave/light";
+struct test tests[] = {
+	{ "changes", test_changes },
+	{ NULL, NULL }
+};
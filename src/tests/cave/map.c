@@ -0,0 +1,207 @@
+/* cave/map */
+/*
+ * Check that what map_info() gives from its cache matches what it works out
+ * afresh, while the player walks, rests and drops things on a busy level
+ * and senses and detects the objects on it, and time full passes over the map with and without the cache.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "cmd-core.h"
+#include "effects.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-calcs.h"
+#include "player-timed.h"
+#include "player-util.h"
+#include "z-rand.h"
+#include <time.h>
+
+int setup_tests(void **state) {
+	int place = 1;
+
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	Rand_quick = true;
+	Rand_value = 2718;
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+	while (world->levels[place].topography != TOP_CAVE
+			|| world->levels[place].depth < 5) {
+		place++;
+	}
+	player_change_place(player, place);
+	prepare_next_level(player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+	Rand_quick = false;
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	if (cave) {
+		wipe_mon_list(cave, player);
+	}
+	cleanup_angband();
+	return 0;
+}
+
+static bool same_grid_data(const struct grid_data *a,
+		const struct grid_data *b) {
+	return a->m_idx == b->m_idx && a->f_idx == b->f_idx
+		&& a->first_kind == b->first_kind && a->trap == b->trap
+		&& a->multiple_objects == b->multiple_objects
+		&& a->unseen_object == b->unseen_object
+		&& a->unseen_money == b->unseen_money
+		&& a->lighting == b->lighting && a->in_view == b->in_view
+		&& a->is_player == b->is_player
+		&& a->hallucinate == b->hallucinate;
+}
+
+/* Count the grids where the cache disagrees with working it out afresh */
+static int map_mismatches(void) {
+	struct loc grid;
+	int bad = 0;
+
+	for (grid.y = 0; grid.y < cave->height; grid.y++) {
+		for (grid.x = 0; grid.x < cave->width; grid.x++) {
+			struct grid_data cached, fresh;
+
+			map_info(grid, &cached);
+			map_cache_forget(cave, grid);
+			map_info(grid, &fresh);
+			if (!same_grid_data(&cached, &fresh)) bad++;
+		}
+	}
+	return bad;
+}
+
+static int test_play(void *state) {
+	int i;
+
+	require(map_mismatches() == 0);
+	Rand_quick = true;
+	Rand_value = 31;
+	for (i = 0; i < 300; i++) {
+		struct object *obj = player->upkeep->inven[0];
+
+		if (player->is_dead || player->upkeep->generate_level) break;
+		player->timed[TMD_INVULN] = 100;
+		player->timed[TMD_FOOD] = PY_FOOD_FULL - 1;
+		if (i % 25 == 24 && obj) {
+			cmdq_push(CMD_DROP);
+			cmd_set_arg_item(cmdq_peek(), "item", obj);
+			cmd_set_arg_number(cmdq_peek(), "quantity", 1);
+		} else if (i % 10 == 9) {
+			cmdq_push(CMD_REST);
+			cmd_set_arg_choice(cmdq_peek(), "choice", 5);
+		} else {
+			cmdq_push(CMD_WALK);
+			cmd_set_arg_direction(cmdq_peek(), "direction",
+				ddd[randint0(8)]);
+		}
+		run_game_loop();
+		eq(map_mismatches(), 0);
+	}
+	Rand_quick = false;
+	ok;
+}
+
+/* Count the grids with objects the player knows of */
+static int known_piles(void) {
+	struct loc grid;
+	int n = 0;
+
+	for (grid.y = 0; grid.y < cave->height; grid.y++) {
+		for (grid.x = 0; grid.x < cave->width; grid.x++) {
+			if (square_object(player->cave, grid)) n++;
+		}
+	}
+	return n;
+}
+
+/* Fill the cache for every grid */
+static void map_warm(void) {
+	struct grid_data g;
+	struct loc grid;
+
+	for (grid.y = 0; grid.y < cave->height; grid.y++) {
+		for (grid.x = 0; grid.x < cave->width; grid.x++) {
+			map_info(grid, &g);
+		}
+	}
+}
+
+/* Sensing and then detecting objects changes known piles in place */
+static int test_detect(void *state) {
+	map_warm();
+	effect_simple(EF_SENSE_OBJECTS, source_player(), "0", 0, 0, 0,
+		cave->height, cave->width, NULL);
+	require(known_piles() > 0);
+	eq(map_mismatches(), 0);
+
+	map_warm();
+	effect_simple(EF_DETECT_OBJECTS, source_player(), "0", 0, 0, 0,
+		cave->height, cave->width, NULL);
+	eq(map_mismatches(), 0);
+	ok;
+}
+
+static int test_timing(void *state) {
+	const int passes = 50;
+	clock_t start, cached, fresh;
+	struct grid_data g;
+	struct loc grid;
+	int i;
+
+	start = clock();
+	for (i = 0; i < passes; i++) {
+		for (grid.y = 0; grid.y < cave->height; grid.y++) {
+			for (grid.x = 0; grid.x < cave->width; grid.x++) {
+				map_info(grid, &g);
+			}
+		}
+	}
+	cached = clock() - start;
+
+	start = clock();
+	for (i = 0; i < passes; i++) {
+		map_cache_forget_all(cave);
+		for (grid.y = 0; grid.y < cave->height; grid.y++) {
+			for (grid.x = 0; grid.x < cave->width; grid.x++) {
+				map_info(grid, &g);
+			}
+		}
+	}
+	fresh = clock() - start;
+
+	if (verbose) {
+		printf("%d passes over %dx%d: %.1f ms cached, %.1f ms afresh\n",
+			passes, cave->width, cave->height,
+			1000.0 * cached / CLOCKS_PER_SEC,
+			1000.0 * fresh / CLOCKS_PER_SEC);
+	}
+	ok;
+}
+
+const char *suite_name = "cave/map";
+struct test tests[] = {
+	{ "play", test_play },
+	{ "detect", test_detect },
+	{ "timing", test_timing },
+	{ NULL, NULL }
+};
@@ -0,0 +1,317 @@
+/* cave/noise */
+/*
+ * Check the noise flows from make_noise(), make_noise_everywhere() and
+ * monster_noise() against a flood of the whole level, as make_noise() used to
+ * do, check the sharing of monster noise, and time flows on large levels.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "mon-util.h"
+#include "monster.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-timed.h"
+#include "z-queue.h"
+#include "z-rand.h"
+#include <time.h>
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	if (cave) {
+		wipe_mon_list(cave, player);
+		cave_free(cave);
+		cave = NULL;
+	}
+	cleanup_angband();
+	return 0;
+}
+
+/* The reference:  make_noise() before flows were bounded and kept */
+static void ref_make_noise(struct chunk *c, struct player *p,
+		struct monster *mon, int *ref) {
+	struct loc next = p ? p->grid : mon->grid;
+	int d, noise = 0;
+	int noise_increment = p && p->timed[TMD_COVERTRACKS] ? 4 : 1;
+	struct queue *queue = q_new(c->height * c->width);
+
+	memset(ref, 0, c->height * c->width * sizeof(*ref));
+	if (p && !loc_is_zero(c->decoy)) {
+		next = c->decoy;
+	}
+	ref[next.y * c->width + next.x] = noise;
+	q_push_int(queue, grid_to_i(next, c->width));
+	noise += noise_increment;
+	while (q_len(queue) > 0) {
+		i_to_grid(q_pop_int(queue), c->width, &next);
+		if (ref[next.y * c->width + next.x] == noise) {
+			q_push_int(queue, grid_to_i(next, c->width));
+			noise += noise_increment;
+			continue;
+		}
+		for (d = 0; d < 8; d++)	{
+			struct loc grid = loc_sum(next, ddgrid_ddd[d]);
+
+			if (!square_in_bounds(c, grid)) continue;
+			if (square_isnoflow(c, grid)) continue;
+			if (ref[grid.y * c->width + grid.x] != 0) continue;
+			if (p && loc_eq(p->grid, grid)) continue;
+			if (mon && loc_eq(mon->grid, grid)) continue;
+			ref[grid.y * c->width + grid.x] = noise;
+			q_push_int(queue, grid_to_i(grid, c->width));
+		}
+	}
+	q_free(queue);
+}
+
+static struct chunk *create_random_cave(int height, int width) {
+	struct chunk *c = cave_new(height, width);
+	struct loc grid;
+
+	for (grid.y = 0; grid.y < height; grid.y++) {
+		for (grid.x = 0; grid.x < width; grid.x++) {
+			if (grid.y == 0 || grid.x == 0 || grid.y == height - 1
+					|| grid.x == width - 1) {
+				square_set_feat(c, grid, FEAT_PERM);
+			} else if (randint0(100) < 30) {
+				square_set_feat(c, grid, FEAT_GRANITE);
+			} else {
+				square_set_feat(c, grid, FEAT_FLOOR);
+			}
+		}
+	}
+	c->depth = 1;
+	return c;
+}
+
+static struct loc random_empty(struct chunk *c) {
+	struct loc grid;
+
+	do {
+		grid = loc(randint1(c->width - 2), randint1(c->height - 2));
+	} while (!square_isfloor(c, grid) || square(c, grid).mon);
+	return grid;
+}
+
+/*
+ * Grids the flow reaches must match the reference; those it stops short of
+ * must read as silent.
+ */
+static bool check_noise(struct chunk *c, struct heatmap map,
+		struct player *p, struct monster *mon, int *ref) {
+	struct loc grid;
+
+	ref_make_noise(c, p, mon, ref);
+	for (grid.y = 0; grid.y < c->height; grid.y++) {
+		for (grid.x = 0; grid.x < c->width; grid.x++) {
+			int r = ref[grid.y * c->width + grid.x];
+
+			if (r - map.step >= map.range) r = 0;
+			if (heatmap_get(map, grid) != r) return false;
+		}
+	}
+	return true;
+}
+
+static int test_changes(void *state) {
+	struct player *p = player;
+	struct monster *mon;
+	int *ref;
+	int i;
+
+	cave = create_random_cave(66, 198);
+	ref = mem_alloc(cave->height * cave->width * sizeof(*ref));
+	p->grid = random_empty(cave);
+	square_set_mon(cave, p->grid, -1);
+	mon = t_add_monster(cave, random_empty(cave), "soldier");
+	make_noise(cave, p);
+	require(check_noise(cave, cave->noise, p, NULL, ref));
+
+	for (i = 0; i < 400; i++) {
+		int roll = randint0(100);
+		struct loc grid;
+
+		if (roll < 30) {
+			/* Move the player */
+			grid = random_empty(cave);
+			square_set_mon(cave, p->grid, 0);
+			p->grid = grid;
+			square_set_mon(cave, grid, -1);
+		} else if (roll < 45) {
+			/* Move the monster */
+			grid = random_empty(cave);
+			monster_swap(mon->grid, grid);
+		} else if (roll < 75) {
+			/* Change terrain, with or without changing the flow */
+			grid = loc(randint1(cave->width - 2),
+				randint1(cave->height - 2));
+			if (square(cave, grid).mon) continue;
+			if (one_in_(3)) {
+				square_set_feat(cave, grid, FEAT_PASS_RUBBLE);
+			} else {
+				square_set_feat(cave, grid,
+					square_isfloor(cave, grid) ?
+					FEAT_GRANITE : FEAT_FLOOR);
+			}
+		} else if (roll < 85) {
+			/* Lay or remove a decoy */
+			cave->decoy = one_in_(2) ? loc(0, 0) : random_empty(cave);
+		} else if (roll < 92) {
+			/* Cover tracks, or stop */
+			p->timed[TMD_COVERTRACKS] = one_in_(2) ? 10 : 0;
+		} else if (roll < 94) {
+			/* Bring in a keen listener */
+			grid = random_empty(cave);
+			t_add_monster(cave, grid, "fire vortex");
+		}
+
+		make_noise(cave, p);
+		require(check_noise(cave, cave->noise, p, NULL, ref));
+		require(check_noise(cave, *monster_noise(cave, mon, randint1(40)),
+			NULL, mon, ref));
+
+		/* Sometimes carry the player's noise on over the whole level */
+		if (one_in_(8)) {
+			make_noise_everywhere(cave);
+			eq(cave->noise.range, NOISE_RANGE_ALL);
+			require(check_noise(cave, cave->noise, p, NULL, ref));
+		}
+	}
+
+	p->timed[TMD_COVERTRACKS] = 0;
+	mem_free(ref);
+	wipe_mon_list(cave, p);
+	cave_free(cave);
+	cave = NULL;
+	ok;
+}
+
+/*
+ * Monsters after the same target share its noise; when there are more
+ * targets than the cache holds, the ones nobody is listening for go first.
+ */
+static int test_sharing(void *state) {
+	struct player *p = player;
+	struct monster *targets[NOISE_CACHE_SIZE + 1];
+	struct noise_cache *cache;
+	int i;
+
+	cave = create_random_cave(66, 198);
+	p->grid = random_empty(cave);
+	square_set_mon(cave, p->grid, -1);
+	for (i = 0; i <= NOISE_CACHE_SIZE; i++) {
+		targets[i] = t_add_monster(cave, random_empty(cave), "soldier");
+	}
+
+	/* Three monsters after the first target */
+	for (i = 0; i < 3; i++) {
+		struct monster *mon = t_add_monster(cave, random_empty(cave),
+			"soldier");
+
+		mon->target.midx = targets[0]->midx;
+		notnull(monster_noise(cave, targets[0], 20));
+	}
+	cache = cave->noise_cache;
+	notnull(cache);
+	eq(cache->lookups, 3);
+	eq(cache->flows_made, 1);
+	eq(cache->hits, 2);
+
+	/* Fill the cache, then make room for one more */
+	for (i = 1; i <= NOISE_CACHE_SIZE; i++) {
+		(void) monster_noise(cave, targets[i], 20);
+	}
+	eq(cache->flows_made, NOISE_CACHE_SIZE + 1);
+	eq(cache->evictions, 1);
+	(void) monster_noise(cave, targets[0], 20);
+	eq(cache->hits, 3);
+
+	/* A target that moves needs a new flow; a louder request does too */
+	monster_swap(targets[0]->grid, random_empty(cave));
+	(void) monster_noise(cave, targets[0], 20);
+	eq(cache->hits, 3);
+	(void) monster_noise(cave, targets[0], 40);
+	eq(cache->flows_made, NOISE_CACHE_SIZE + 3);
+	(void) monster_noise(cave, targets[0], 30);
+	eq(cache->hits, 4);
+
+	wipe_mon_list(cave, p);
+	cave_free(cave);
+	cave = NULL;
+	ok;
+}
+
+/*
+ * Time the player's noise flow, as made every ten game turns, on a large
+ * level where the player mostly stands still and sometimes walks.
+ */
+static int test_timing(void *state) {
+	struct player *p = player;
+	int *ref;
+	clock_t start, ref_ticks, new_ticks;
+	int i;
+
+	cave = create_random_cave(132, 396);
+	ref = mem_alloc(cave->height * cave->width * sizeof(*ref));
+	p->grid = random_empty(cave);
+	square_set_mon(cave, p->grid, -1);
+
+	start = clock();
+	for (i = 0; i < 50; i++) {
+		ref_make_noise(cave, p, NULL, ref);
+	}
+	ref_ticks = clock() - start;
+
+	start = clock();
+	for (i = 0; i < 50; i++) {
+		if (one_in_(4)) {
+			struct loc grid = random_empty(cave);
+
+			square_set_mon(cave, p->grid, 0);
+			p->grid = grid;
+			square_set_mon(cave, grid, -1);
+		}
+		make_noise(cave, p);
+	}
+	new_ticks = clock() - start;
+
+	if (verbose) {
+		printf("whole level %.1f ms, bounded %.1f ms per 50 flows\n",
+			1000.0 * ref_ticks / CLOCKS_PER_SEC,
+			1000.0 * new_ticks / CLOCKS_PER_SEC);
+	}
+	require(check_noise(cave, cave->noise, p, NULL, ref));
+
+	mem_free(ref);
+	cave_free(cave);
+	cave = NULL;
+	ok;
+}
+
+const char *suite_name = "cave/noise";
+struct test tests[] = {
+	{ "changes", test_changes },
+	{ "sharing", test_sharing },
+	{ "timing", test_timing },
+	{ NULL, NULL }
+};
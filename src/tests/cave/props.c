@@ -0,0 +1,103 @@
+/* cave/props */
+/*
+ * Check that the terrain property bytes agree with the terrain flags, both
+ * per feature and per grid as terrain changes and chunks are copied.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "generate.h"
+#include "init.h"
+#include "z-rand.h"
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	cleanup_angband();
+	return 0;
+}
+
+static bool props_match_flags(int feat, uint8_t props) {
+	bitflag *flags = f_info[feat].flags;
+
+	return tf_has(flags, TF_LOS) == ((props & FPROP_LOS) != 0)
+		&& tf_has(flags, TF_PROJECT) == ((props & FPROP_PROJECT) != 0)
+		&& tf_has(flags, TF_PASSABLE) == ((props & FPROP_PASSABLE) != 0)
+		&& tf_has(flags, TF_NO_FLOW) == ((props & FPROP_NO_FLOW) != 0)
+		&& tf_has(flags, TF_NO_SCENT) == ((props & FPROP_NO_SCENT) != 0)
+		&& tf_has(flags, TF_TORCH) == ((props & FPROP_TORCH) != 0)
+		&& tf_has(flags, TF_BRIGHT) == ((props & FPROP_BRIGHT) != 0);
+}
+
+static bool chunk_props_match(struct chunk *c) {
+	struct loc grid;
+
+	for (grid.y = 0; grid.y < c->height; grid.y++) {
+		for (grid.x = 0; grid.x < c->width; grid.x++) {
+			int feat = square(c, grid).feat;
+
+			if (c->sq_props[square_idx(c, grid)] != feat_props[feat]
+					|| square_allowslos(c, grid) !=
+					tf_has(f_info[feat].flags, TF_LOS)
+					|| square_ispassable(c, grid) !=
+					tf_has(f_info[feat].flags, TF_PASSABLE)
+					|| square_isnoflow(c, grid) !=
+					tf_has(f_info[feat].flags, TF_NO_FLOW))
+				return false;
+		}
+	}
+	return true;
+}
+
+static int test_features(void *state) {
+	int feat;
+
+	for (feat = 0; feat < z_info->f_max; feat++) {
+		require(props_match_flags(feat, feat_props[feat]));
+		eq(feat_is_projectable(feat),
+			tf_has(f_info[feat].flags, TF_PROJECT));
+	}
+	ok;
+}
+
+static int test_grids(void *state) {
+	struct chunk *c = cave_new(20, 30), *copy, *big;
+	int i;
+
+	require(chunk_props_match(c));
+	for (i = 0; i < 2000; i++) {
+		struct loc grid = loc(randint0(c->width), randint0(c->height));
+
+		square_set_feat(c, grid, randint1(z_info->f_max - 1));
+	}
+	require(chunk_props_match(c));
+
+	copy = chunk_write(c);
+	require(chunk_props_match(copy));
+
+	/* Copies with and without a transformation */
+	big = cave_new(50, 50);
+	require(chunk_copy(big, player, copy, 2, 3, 0, false));
+	require(chunk_props_match(big));
+	require(chunk_copy(big, player, c, 10, 5, 1, true));
+	require(chunk_props_match(big));
+
+	cave_free(big);
+	cave_free(copy);
+	cave_free(c);
+	ok;
+}
+
+const char *suite_name = "cave/props";
+struct test tests[] = {
+	{ "features", test_features },
+	{ "grids", test_grids },
+	{ NULL, NULL }
+};
@@ -0,0 +1,235 @@
+/* cave/store */
+/*
+ * Check that persistent levels come back from the chunk list as they were
+ * left, whether they were packed in memory, spilled to disk or saved and
+ * loaded in between.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "monster.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-util.h"
+#include "savefile.h"
+
+#define NUM_PLACES 4
+
+/* What the level at a place looked like when the player left it */
+struct snapshot {
+	int place;
+	int height, width;
+	uint8_t *feat;
+	int monsters;
+	int objects;
+};
+
+static struct snapshot shots[NUM_PLACES];
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+	player->opts.opt[OPT_birth_levels_persist] = true;
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	int i;
+
+	for (i = 0; i < NUM_PLACES; i++) {
+		mem_free(shots[i].feat);
+	}
+	if (cave) {
+		wipe_mon_list(cave, player);
+	}
+	cleanup_angband();
+	file_delete("Test-store");
+	return 0;
+}
+
+static int object_count(struct chunk *c) {
+	int i, n = 0;
+
+	for (i = 1; i < c->obj_max; i++) {
+		if (c->objects[i]) n++;
+	}
+	return n;
+}
+
+/* Total of the racial counts, which returning to a level mustn't change */
+static int racial_count(void) {
+	int i, n = 0;
+
+	for (i = 0; i < z_info->r_max; i++) {
+		n += r_info[i].cur_num;
+	}
+	return n;
+}
+
+static void take_snapshot(struct snapshot *shot) {
+	int n = cave->height * cave->width;
+
+	shot->place = player->place;
+	shot->height = cave->height;
+	shot->width = cave->width;
+	mem_free(shot->feat);
+	shot->feat = mem_alloc(n);
+	memcpy(shot->feat, cave->sq_feat, n);
+	shot->monsters = cave_monster_count(cave);
+	shot->objects = object_count(cave);
+}
+
+/* Arriving finds any secret doors next to the player */
+static int seen_feat(int feat) {
+	return feat == FEAT_SECRET ? FEAT_CLOSED : feat;
+}
+
+static bool matches_snapshot(const struct snapshot *shot) {
+	int i;
+
+	if (player->place != shot->place || cave->height != shot->height
+			|| cave->width != shot->width) return false;
+	for (i = 0; i < shot->height * shot->width; i++) {
+		if (seen_feat(cave->sq_feat[i]) != seen_feat(shot->feat[i])) {
+			return false;
+		}
+	}
+	return cave_monster_count(cave) == shot->monsters
+		&& object_count(cave) == shot->objects;
+}
+
+static void go_to(int place) {
+	player_change_place(player, place);
+	prepare_next_level(player);
+	on_new_level();
+}
+
+static bool all_packed(void) {
+	int i;
+
+	for (i = 0; i < chunk_list_max; i++) {
+		if (!chunk_list[i]->packed) return false;
+	}
+	return true;
+}
+
+static uint32_t packed_in_memory(void) {
+	uint32_t total = 0;
+	int i;
+
+	for (i = 0; i < chunk_list_max; i++) {
+		struct packed_chunk *packed = chunk_list[i]->packed;
+
+		if (packed && packed->data) total += packed->size;
+	}
+	return total;
+}
+
+/* Visit some cave levels, then go back to the first */
+static int test_pack(void *state) {
+	int i, place = 0, count;
+
+	for (i = 0; i < NUM_PLACES; i++) {
+		do {
+			place++;
+		} while (place < world->num_levels
+			&& (world->levels[place].topography != TOP_CAVE
+			|| world->levels[place].depth < 5));
+		require(place < world->num_levels);
+		go_to(place);
+		notnull(cave);
+		if (i > 0) {
+			require(all_packed());
+		}
+		take_snapshot(&shots[i]);
+	}
+	eq(chunk_list_max, 2 * NUM_PLACES - 2);
+	if (verbose) {
+		printf("%d stored levels packed into %lu bytes\n", chunk_list_max,
+			(unsigned long) packed_in_memory());
+	}
+
+	count = racial_count();
+	go_to(shots[0].place);
+	require(matches_snapshot(&shots[0]));
+	eq(racial_count(), count);
+	eq(chunk_list_max, 2 * NUM_PLACES - 2);
+	require(all_packed());
+	notnull(chunk_peek_name(level_name(&world->levels[shots[3].place])));
+	ok;
+}
+
+/* With next to no memory allowed, the stored levels go to disk */
+static int test_spill(void *state) {
+	int i, spilled = 0;
+
+	z_info->level_memory = 1;
+	go_to(shots[1].place);
+	require(matches_snapshot(&shots[1]));
+	require(all_packed());
+	require(packed_in_memory() <= 1024);
+	for (i = 0; i < chunk_list_max; i++) {
+		struct packed_chunk *packed = chunk_list[i]->packed;
+
+		if (packed->data) continue;
+		notnull(packed->spill);
+		require(file_exists(packed->spill));
+		spilled++;
+	}
+	require(spilled > 0);
+
+	go_to(shots[2].place);
+	require(matches_snapshot(&shots[2]));
+	z_info->level_memory = 0;
+	ok;
+}
+
+/* Packed and spilled levels are saved as they are, and packed when loaded */
+static int test_save(void *state) {
+	int stored = chunk_list_max;
+
+	z_info->level_memory = 1;
+	go_to(shots[3].place);
+	require(matches_snapshot(&shots[3]));
+	eq(savefile_save("Test-store"), true);
+
+	play_again = true;
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	init_angband();
+	play_again = false;
+	eq(savefile_load("Test-store", false), true);
+	require(OPT(player, birth_levels_persist));
+	eq(chunk_list_max, stored);
+	require(all_packed());
+
+	go_to(shots[0].place);
+	require(matches_snapshot(&shots[0]));
+	go_to(shots[3].place);
+	require(matches_snapshot(&shots[3]));
+	ok;
+}
+
+const char *suite_name = "cave/store";
+struct test tests[] = {
+	{ "pack", test_pack },
+	{ "spill", test_spill },
+	{ "save", test_save },
+	{ NULL, NULL }
+};
@@ -1,3 +1,11 @@
 TESTPROGS += \
 	cave/find \
-	cave/scatter
+	cave/index \
+	cave/light \
+	cave/map \
+	cave/noise \
+	cave/props \
+	cave/scatter \
+	cave/store \
+	cave/timing \
+	cave/view
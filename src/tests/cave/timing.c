@@ -0,0 +1,122 @@
+/* cave/timing */
+/*
+ * Time the things that lean hardest on the grid storage of a chunk:  level
+ * generation and update_view().  Times are printed with -v; the checks only
+ * make sure the work was done.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "mon-util.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-calcs.h"
+#include "player-util.h"
+#include "z-rand.h"
+#include <time.h>
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	if (cave) {
+		wipe_mon_list(cave, player);
+	}
+	cleanup_angband();
+	return 0;
+}
+
+/* Find a cave level of moderate depth */
+static int find_cave_place(void) {
+	int i;
+
+	for (i = 0; i < world->num_levels; i++) {
+		struct level *lev = &world->levels[i];
+
+		if (lev->topography == TOP_CAVE && lev->depth >= 10) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static double msecs(clock_t ticks) {
+	return 1000.0 * ticks / CLOCKS_PER_SEC;
+}
+
+static int test_generate(void *state) {
+	int place = find_cave_place();
+	clock_t start, ticks;
+	int i;
+
+	require(place > 0);
+	Rand_state_init(42);
+	start = clock();
+	for (i = 0; i < 20; i++) {
+		player_change_place(player, place);
+		prepare_next_level(player);
+		on_new_level();
+		notnull(cave);
+		eq(cave->depth, world->levels[place].depth);
+	}
+	ticks = clock() - start;
+	if (verbose) {
+		printf("%.2f ms per level\n", msecs(ticks) / 20);
+	}
+	ok;
+}
+
+static int test_view(void *state) {
+	clock_t start, ticks;
+	int i, seen = 0;
+
+	notnull(cave);
+	Rand_state_init(42);
+	start = clock();
+	for (i = 0; i < 2000; i++) {
+		struct loc grid;
+
+		/* Look from somewhere new every so often */
+		if (i % 20 == 0) {
+			do {
+				grid = loc(randint1(cave->width - 2),
+					randint1(cave->height - 2));
+			} while (!square_isempty(cave, grid));
+			monster_swap(player->grid, grid);
+		}
+		update_view(cave, player);
+		seen += square_isview(cave, player->grid) ? 1 : 0;
+	}
+	ticks = clock() - start;
+	if (verbose) {
+		printf("%.3f ms per update_view()\n", msecs(ticks) / 2000);
+	}
+	eq(seen, 2000);
+	ok;
+}
+
+const char *suite_name = "cave/timing";
+struct test tests[] = {
+	{ "generate", test_generate },
+	{ "view", test_view },
+	{ NULL, NULL }
+};
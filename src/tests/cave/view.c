@@ -0,0 +1,230 @@
+/* cave/view */
+/*
+ * Check update_view() against a straightforward reimplementation of the
+ * rules it follows, applied to every grid of the level with los().
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "game-world.h"
+#include "init.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-calcs.h"
+#include "player-timed.h"
+#include "player-util.h"
+#include "z-rand.h"
+
+enum {
+	REF_VIEW = 0x1,
+	REF_SEEN = 0x2,
+	REF_CLOSE = 0x4
+};
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	if (cave) {
+		cave_free(cave);
+		cave = NULL;
+	}
+	if (player->cave) {
+		cave_free(player->cave);
+		player->cave = NULL;
+	}
+	cleanup_angband();
+	return 0;
+}
+
+/*
+ * Build a level of random walls and floors; some floors are glowing room
+ * grids.
+ */
+static struct chunk *create_random_cave(int height, int width, int walls) {
+	struct chunk *c = cave_new(height, width);
+	struct loc grid;
+
+	for (grid.y = 0; grid.y < height; grid.y++) {
+		for (grid.x = 0; grid.x < width; grid.x++) {
+			if (grid.y == 0 || grid.x == 0 || grid.y == height - 1
+					|| grid.x == width - 1) {
+				square_set_feat(c, grid, FEAT_PERM);
+			} else if (randint0(100) < walls) {
+				square_set_feat(c, grid, FEAT_GRANITE);
+			} else {
+				square_set_feat(c, grid, FEAT_FLOOR);
+			}
+			if (randint0(100) < 20) {
+				sqinfo_on(square(c, grid).info, SQUARE_ROOM);
+				sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+			}
+		}
+	}
+	c->depth = 1;
+	return c;
+}
+
+static void place_player(struct chunk *c, struct player *p) {
+	struct loc grid;
+
+	do {
+		grid = loc(randint1(c->width - 2), randint1(c->height - 2));
+	} while (!square_isfloor(c, grid));
+	if (square_in_bounds(c, p->grid) && square(c, p->grid).mon == -1) {
+		square_set_mon(c, p->grid, 0);
+	}
+	p->grid = grid;
+	square_set_mon(c, grid, -1);
+}
+
+/* What update_view_one() did when it tested every grid with los() */
+static void ref_view_one(struct chunk *c, struct player *p, struct loc grid,
+		uint8_t *ref) {
+	int x = grid.x, y = grid.y, xc = x, yc = y;
+	int d = distance(grid, p->grid);
+	bool close = d < p->state.cur_light;
+	uint8_t *r = &ref[y * c->width + x];
+
+	if (d > z_info->max_sight) return;
+	if ((player_has(p, PF_UNLIGHT) || player_of_has(p, OF_DARKNESS))
+			&& (p->state.cur_light <= 1)) {
+		close = d < (2 + p->lev / 6 - p->state.cur_light);
+	}
+	if (!square_allowslos(c, grid)) {
+		int dx = x - p->grid.x, dy = y - p->grid.y;
+		int ax = ABS(dx), ay = ABS(dy);
+		int sx = dx > 0 ? 1 : -1, sy = dy > 0 ? 1 : -1;
+
+		xc = (x < p->grid.x) ? (x + 1) : (x > p->grid.x) ? (x - 1) : x;
+		yc = (y < p->grid.y) ? (y + 1) : (y > p->grid.y) ? (y - 1) : y;
+		if (!square_allowslos(c, loc(xc, yc))) {
+			xc = x;
+			yc = y;
+		}
+		if (ax == 2 && ay == 1) {
+			if (square_allowslos(c, loc(x - sx, y))
+					&& !square_allowslos(c, loc(x - sx, y - sy))) {
+				xc = x;
+				yc = y;
+			}
+		} else if (ax == 1 && ay == 2) {
+			if (square_allowslos(c, loc(x, y - sy))
+					&& !square_allowslos(c, loc(x - sx, y - sy))) {
+				xc = x;
+				yc = y;
+			}
+		}
+	}
+	if (!los(c, p->grid, loc(xc, yc))) return;
+	if (*r & REF_VIEW) return;
+	*r |= REF_VIEW;
+	if (close) *r |= REF_SEEN | REF_CLOSE;
+	if (square_islit(c, grid)) {
+		if (!square_allowslos(c, grid)) {
+			xc = (x < p->grid.x) ? (x + 1) : (x > p->grid.x) ? (x - 1) : x;
+			yc = (y < p->grid.y) ? (y + 1) : (y > p->grid.y) ? (y - 1) : y;
+			if (square_islit(c, loc(xc, yc))) *r |= REF_SEEN;
+		} else {
+			*r |= REF_SEEN;
+		}
+	}
+}
+
+/* Compare the view flags of every grid against the reference */
+static bool check_view(struct chunk *c, struct player *p) {
+	uint8_t *ref = mem_zalloc(c->height * c->width * sizeof(*ref));
+	struct loc grid;
+	bool same = true;
+
+	ref[p->grid.y * c->width + p->grid.x] = REF_VIEW;
+	if (p->state.cur_light > 0 || square_islit(c, p->grid) ||
+			player_has(p, PF_UNLIGHT) || player_of_has(p, OF_DARKNESS)) {
+		ref[p->grid.y * c->width + p->grid.x] |= REF_SEEN | REF_CLOSE;
+	}
+	for (grid.y = 0; grid.y < c->height; grid.y++)
+		for (grid.x = 0; grid.x < c->width; grid.x++)
+			ref_view_one(c, p, grid, ref);
+
+	for (grid.y = 0; grid.y < c->height && same; grid.y++) {
+		for (grid.x = 0; grid.x < c->width && same; grid.x++) {
+			uint8_t r = ref[grid.y * c->width + grid.x];
+
+			if (p->timed[TMD_BLIND]) r &= ~(REF_SEEN | REF_CLOSE);
+			if (square_isview(c, grid) != ((r & REF_VIEW) != 0)
+					|| square_isseen(c, grid) !=
+					((r & REF_SEEN) != 0)
+					|| sqinfo_has(square(c, grid).info,
+					SQUARE_CLOSE_PLAYER) !=
+					((r & REF_CLOSE) != 0)
+					|| square_wasseen(c, grid)) {
+				same = false;
+			}
+		}
+	}
+	mem_free(ref);
+	return same;
+}
+
+static int run_walk(struct player *p, int height, int width, int walls,
+		int steps) {
+	int i;
+
+	cave = create_random_cave(height, width, walls);
+	p->cave = cave_new(height, width);
+	p->grid = loc(0, 0);
+	for (i = 0; i < steps; i++) {
+		place_player(cave, p);
+		p->state.cur_light = randint0(4);
+		p->timed[TMD_BLIND] = one_in_(8) ? 1 : 0;
+		update_view(cave, p);
+		if (!check_view(cave, p)) {
+			return 1;
+		}
+	}
+	p->timed[TMD_BLIND] = 0;
+	cave_free(p->cave);
+	p->cave = NULL;
+	cave_free(cave);
+	cave = NULL;
+	return 0;
+}
+
+static int test_open(void *state) {
+	eq(run_walk(player, 66, 198, 5, 40), 0);
+	ok;
+}
+
+static int test_cluttered(void *state) {
+	eq(run_walk(player, 66, 198, 35, 40), 0);
+	ok;
+}
+
+static int test_small(void *state) {
+	/* Smaller than the view box in both directions */
+	eq(run_walk(player, 9, 13, 20, 40), 0);
+	ok;
+}
+
+const char *suite_name = "cave/view";
+struct test tests[] = {
+	{ "open", test_open },
+	{ "cluttered", test_cluttered },
+	{ "small", test_small },
+	{ NULL, NULL }
+};
@@ -1 +1,2 @@
-TESTPROGS += effects/chain effects/destruction effects/earthquake effects/info
+TESTPROGS += effects/chain effects/destruction effects/earthquake effects/info \
+	effects/values
@@ -0,0 +1,105 @@
+/*
+ * effects/values
+ * Work out the values of every class spell's effects at every player level,
+ * as the spell menus and casting do, and time it.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "effects.h"
+#include "init.h"
+#include "player.h"
+#include "player-birth.h"
+#include "z-dice.h"
+#include <time.h>
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	Rand_quick = true;
+	Rand_value = 1;
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+	Rand_quick = false;
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	cleanup_angband();
+	return 0;
+}
+
+/*
+ * Evaluate the dice of every effect of every spell of every class once per
+ * player level, and roll them; return the number of dice evaluated, or -1 if
+ * a roll fell outside what its dice can give
+ */
+static int evaluate_spells(int *total) {
+	struct player_class *c;
+	int count = 0, lev;
+
+	for (lev = 1; lev <= PY_MAX_LEVEL; lev++) {
+		player->lev = lev;
+		for (c = classes; c; c = c->next) {
+			int i, j;
+
+			for (i = 0; i < c->magic.num_books; i++) {
+				struct class_book *book = &c->magic.books[i];
+
+				for (j = 0; j < book->num_spells; j++) {
+					struct effect *e;
+
+					for (e = book->spells[j].effect; e; e = e->next) {
+						random_value rv;
+						int v;
+
+						if (!e->dice) continue;
+						*total += dice_evaluate(e->dice, lev, AVERAGE, NULL);
+						v = dice_roll(e->dice, &rv) - rv.base;
+						if (rv.dice > 0 && rv.sides > 0
+								&& (v < rv.dice || v > rv.dice * rv.sides)) {
+							return -1;
+						}
+						*total += v;
+						count++;
+					}
+				}
+			}
+		}
+	}
+	return count;
+}
+
+static int test_spells(void *state) {
+	const int passes = 50;
+	clock_t start, ticks;
+	int lev = player->lev, total = 0, count = 0, i;
+
+	start = clock();
+	for (i = 0; i < passes; i++) {
+		count = evaluate_spells(&total);
+		require(count > 0);
+	}
+	ticks = clock() - start;
+	player->lev = lev;
+	if (verbose) {
+		printf("%d spell effect dice: %.1f ms for %d passes\n",
+			count / PY_MAX_LEVEL, 1000.0 * ticks / CLOCKS_PER_SEC, passes);
+	}
+	ok;
+}
+
+const char *suite_name = "effects/values";
+struct test tests[] = {
+	{ "spells", test_spells },
+	{ NULL, NULL }
+};
@@ -0,0 +1,258 @@
+/* game/rest */
+/*
+ * Rest from next to no hit points on busy levels, and check that the games
+ * end up just as they did when every game turn was refreshed on its own:  the
+ * digests below were recorded from that code, and take in the state of the
+ * random number generator, so the same numbers must have been drawn.  Also
+ * count the screen refreshes and time the rests, both bare and with the game's
+ * own display drawing to a screen that shows nothing.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-event.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-calcs.h"
+#include "player-timed.h"
+#include "player-util.h"
+#include "ui-display.h"
+#include "ui-event.h"
+#include "ui-prefs.h"
+#include "ui-term.h"
+#include "z-rand.h"
+#include <time.h>
+
+/* Digests of rests from the seeds, as recorded */
+static const struct {
+	uint32_t seed;
+	uint32_t digest;
+} rests[] = {
+	{ 1, 0x15257a8d },
+	{ 57721, 0xab3cd75f },
+	{ 1414213, 0x773bb5e5 },
+};
+
+static int refreshes;
+
+/* Time spent resting, leaving out making the level */
+static clock_t rest_ticks;
+
+static void count_refresh(game_event_type type, game_event_data *data,
+		void *user) {
+	refreshes++;
+}
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	/* The same character every time */
+	Rand_quick = true;
+	Rand_value = 1;
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+	Rand_quick = false;
+	event_add_handler(EVENT_REFRESH, count_refresh, NULL);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	event_remove_handler(EVENT_REFRESH, count_refresh, NULL);
+	if (cave) {
+		wipe_mon_list(cave, player);
+	}
+	cleanup_angband();
+	return 0;
+}
+
+static uint32_t mix(uint32_t hash, int value) {
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		hash = (hash ^ ((uint32_t) value & 0xff)) * 16777619U;
+		value >>= 8;
+	}
+	return hash;
+}
+
+/* The player, the monsters and the random number generator */
+static uint32_t digest(void) {
+	uint32_t hash = 2166136261U;
+	int i;
+
+	hash = mix(hash, turn);
+	hash = mix(hash, player->grid.x);
+	hash = mix(hash, player->grid.y);
+	hash = mix(hash, player->chp);
+	hash = mix(hash, player->chp_frac);
+	hash = mix(hash, player->csp);
+	hash = mix(hash, player->csp_frac);
+	hash = mix(hash, player->energy);
+	for (i = 0; i < TMD_MAX; i++) {
+		hash = mix(hash, player->timed[i]);
+	}
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+
+		if (!mon->race) continue;
+		hash = mix(hash, mon->race->ridx);
+		hash = mix(hash, mon->grid.x);
+		hash = mix(hash, mon->grid.y);
+		hash = mix(hash, mon->hp);
+	}
+	hash = mix(hash, (int) Rand_value);
+	return hash;
+}
+
+/*
+ * Rest on a cave level, getting up only when there is no rest to be had, and
+ * starting again whenever disturbed
+ */
+static uint32_t rest(uint32_t seed, int *turns, int *commands) {
+	int place = 1, i;
+	int32_t start;
+
+	Rand_quick = true;
+	Rand_value = seed;
+	while (world->levels[place].topography != TOP_CAVE
+			|| world->levels[place].depth < 5) {
+		place++;
+	}
+	player_change_place(player, place + seed % 5);
+	prepare_next_level(player);
+	on_new_level();
+	player->upkeep->generate_level = false;
+
+	player->chp = 1;
+	player->csp = 0;
+	player->timed[TMD_FOOD] = PY_FOOD_FULL - 1;
+	player->upkeep->redraw |= (PR_HP | PR_MANA);
+	start = turn;
+	rest_ticks = clock();
+	for (i = 0; i < 100; i++) {
+		if (player->is_dead || player->upkeep->generate_level) break;
+		if (player->chp == player->mhp && player->csp == player->msp) break;
+		player->timed[TMD_INVULN] = 100;
+		cmdq_push(CMD_REST);
+		cmd_set_arg_choice(cmdq_peek(), "choice", REST_COMPLETE);
+		run_game_loop();
+	}
+	rest_ticks = clock() - rest_ticks;
+	*turns = turn - start;
+	*commands = i;
+	Rand_quick = false;
+	return mix(digest(), i);
+}
+
+static int test_digests(void *state) {
+	size_t i;
+
+	for (i = 0; i < N_ELEMENTS(rests); i++) {
+		int turns, commands;
+		uint32_t hash;
+
+		refreshes = 0;
+		hash = rest(rests[i].seed, &turns, &commands);
+		if (verbose) {
+			printf("seed %lu: %d game turns, %d rests, %d refreshes, "
+				"digest 0x%08lx\n", (unsigned long) rests[i].seed, turns,
+				commands, refreshes, (unsigned long) hash);
+		}
+		eq(hash, rests[i].digest);
+
+		/* The screen is only brought up to date around each rest */
+		require(refreshes <= 25 * commands);
+	}
+	ok;
+}
+
+/* Time the rests from all the seeds */
+static void time_rests(const char *how) {
+	clock_t ticks = 0;
+	int turns = 0;
+	size_t i;
+
+	for (i = 0; i < N_ELEMENTS(rests); i++) {
+		int rest_turns, commands;
+
+		(void) rest(rests[i].seed, &rest_turns, &commands);
+		ticks += rest_ticks;
+		turns += rest_turns;
+	}
+	if (verbose) {
+		printf("%.1f ms resting for %d game turns%s\n",
+			1000.0 * ticks / CLOCKS_PER_SEC, turns, how);
+	}
+}
+
+static int test_timing(void *state) {
+	time_rests("");
+	ok;
+}
+
+/* A screen the size of the smallest front end, which shows nothing */
+static term screen;
+
+static errr screen_xtra(int n, int v) {
+	/* Answer anything that waits for a key, but never interrupt the rest */
+	if (n == TERM_XTRA_EVENT && v) Term_keypress(ESCAPE, 0);
+	return 0;
+}
+
+static errr screen_curs(int x, int y) {
+	return 0;
+}
+
+static errr screen_wipe(int x, int y, int n) {
+	return 0;
+}
+
+static errr screen_text(int x, int y, int n, int a, const wchar_t *s) {
+	return 0;
+}
+
+static int test_timing_screen(void *state) {
+	term_init(&screen, 80, 24, 256);
+	screen.xtra_hook = screen_xtra;
+	screen.curs_hook = screen_curs;
+	screen.wipe_hook = screen_wipe;
+	screen.text_hook = screen_text;
+	Term_activate(&screen);
+	angband_term[0] = &screen;
+	textui_prefs_init();
+	option_set("auto_more", 1);
+	init_display();
+	event_signal(EVENT_ENTER_WORLD);
+
+	time_rests(", drawn to the screen");
+
+	event_signal(EVENT_LEAVE_WORLD);
+	angband_term[0] = NULL;
+	Term_activate(NULL);
+	term_nuke(&screen);
+	textui_prefs_free();
+	ok;
+}
+
+const char *suite_name = "game/rest";
+struct test tests[] = {
+	{ "digests", test_digests },
+	{ "timing", test_timing },
+	{ "timing-screen", test_timing_screen },
+	{ NULL, NULL }
+};
@@ -0,0 +1,156 @@
+/* game/run */
+/*
+ * Run down a long corridor, with the map scrolling to a new panel every few
+ * steps as the UI would, and check that each scroll is redrawn and put on the
+ * screen before the next step rather than when the run ends.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-event.h"
+#include "game-world.h"
+#include "init.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-calcs.h"
+#include "player-util.h"
+#include "z-rand.h"
+
+/* Columns the map moves by when the player leaves a panel */
+#define PANEL_WID	13
+
+static int panel;
+static int panels;
+static bool redrawn;
+static bool stale;
+static int stale_steps;
+
+/* Scroll to the player's panel, as the UI's check on the panel does */
+static void check_panel(game_event_type type, game_event_data *data,
+		void *user) {
+	if (stale) stale_steps++;
+	if (player->grid.x / PANEL_WID != panel) {
+		panel = player->grid.x / PANEL_WID;
+		panels++;
+		redrawn = false;
+		stale = true;
+		player->upkeep->redraw |= PR_MAP;
+	}
+}
+
+static void redraw_map(game_event_type type, game_event_data *data,
+		void *user) {
+	if (data->point.x == -1 && data->point.y == -1) redrawn = true;
+}
+
+/* The new panel is only on the screen once it is refreshed after the redraw */
+static void refresh(game_event_type type, game_event_data *data, void *user) {
+	if (redrawn) stale = false;
+}
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	Rand_quick = true;
+	Rand_value = 1;
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+	Rand_quick = false;
+	event_add_handler(EVENT_PLAYERMOVED, check_panel, NULL);
+	event_add_handler(EVENT_MAP, redraw_map, NULL);
+	event_add_handler(EVENT_REFRESH, refresh, NULL);
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	event_remove_handler(EVENT_REFRESH, refresh, NULL);
+	event_remove_handler(EVENT_MAP, redraw_map, NULL);
+	event_remove_handler(EVENT_PLAYERMOVED, check_panel, NULL);
+	cleanup_angband();
+	return 0;
+}
+
+/* A level of rock with one long corridor through it, the player at one end */
+static void build_level(int height, int width) {
+	struct loc grid;
+	int i;
+
+	cave = t_build_arena(height, width);
+	cave->depth = 1;
+	for (grid.y = 1; grid.y < height - 1; grid.y++) {
+		for (grid.x = 1; grid.x < width - 1; grid.x++) {
+			if (grid.y != height / 2) {
+				square_set_feat(cave, grid, FEAT_GRANITE);
+			}
+		}
+	}
+	player->cave = cave_new(cave->height, cave->width);
+	player->cave->objects = mem_realloc(player->cave->objects,
+		(cave->obj_max + 1) * sizeof(struct object*));
+	player->cave->obj_max = cave->obj_max;
+	for (i = 0; i <= player->cave->obj_max; i++) {
+		player->cave->objects[i] = NULL;
+	}
+	player_place(cave, player, loc(1, height / 2));
+	character_dungeon = true;
+	on_new_level();
+}
+
+static void free_level(void) {
+	cave_free(player->cave);
+	player->cave = NULL;
+	cave_free(cave);
+	cave = NULL;
+	character_dungeon = false;
+}
+
+static int test_panels(void *state) {
+	int width = 100;
+	int alloc_monster_chance = z_info->alloc_monster_chance;
+
+	/* Run the same way every time, with no monster turning up to stop it */
+	Rand_quick = true;
+	Rand_value = 1;
+	z_info->alloc_monster_chance = 1000000;
+
+	build_level(9, width);
+	panel = player->grid.x / PANEL_WID;
+	panels = 0;
+	redrawn = true;
+	stale = false;
+	stale_steps = 0;
+
+	cmdq_push(CMD_RUN);
+	cmd_set_arg_direction(cmdq_peek(), "direction", 6);
+	run_game_loop();
+	while (player->upkeep->running && !player->is_dead) {
+		run_game_loop();
+	}
+	z_info->alloc_monster_chance = alloc_monster_chance;
+	Rand_quick = false;
+
+	/* The run went the length of the corridor, scrolling as it went */
+	eq(player->grid.x, width - 2);
+	require(panels >= 6);
+	eq(stale_steps, 0);
+
+	free_level();
+	ok;
+}
+
+const char *suite_name = "game/run";
+struct test tests[] = {
+	{ "panels", test_panels },
+	{ NULL, NULL }
+};
@@ -0,0 +1,238 @@
+/* game/save */
+/*
+ * Save and load a character with a large world of stored levels, checking
+ * that every block in the savefile has the size and checksum its header
+ * claims and that the levels come back as they were, and time both.  Then
+ * save in the background, checking that the savefile is of the game as it
+ * was when the save began.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "game-event.h"
+#include "game-world.h"
+#include "generate.h"
+#include "init.h"
+#include "mon-make.h"
+#include "player.h"
+#include "player-birth.h"
+#include "savefile.h"
+#include "z-rand.h"
+#include <time.h>
+
+#define NUM_CHUNKS 300
+
+/* The terrain of each synthetic level */
+static uint8_t *feats[NUM_CHUNKS];
+
+/* What EVENT_SAVEFILE_DONE said, or -1 before it is heard */
+static int save_done = -1;
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+	player->opts.opt[OPT_birth_levels_persist] = true;
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	int i;
+
+	for (i = 0; i < NUM_CHUNKS; i++) {
+		mem_free(feats[i]);
+	}
+	if (cave) {
+		wipe_mon_list(cave, player);
+	}
+	cleanup_angband();
+	file_delete("Test-save");
+	return 0;
+}
+
+static void chunk_name(char *buf, size_t len, int n) {
+	strnfmt(buf, len, "Synthetic %d", n);
+}
+
+static struct chunk *create_synthetic_level(int n) {
+	struct chunk *c = cave_new(z_info->dungeon_hgt, z_info->dungeon_wid);
+	char name[32];
+	struct loc grid;
+
+	chunk_name(name, sizeof(name), n);
+	c->name = string_make(name);
+	c->depth = 1 + n % 50;
+	for (grid.y = 0; grid.y < c->height; grid.y++) {
+		for (grid.x = 0; grid.x < c->width; grid.x++) {
+			int roll = randint0(100);
+
+			if (grid.y == 0 || grid.x == 0 || grid.y == c->height - 1
+					|| grid.x == c->width - 1) {
+				square_set_feat(c, grid, FEAT_PERM);
+			} else if (roll < 40) {
+				square_set_feat(c, grid, FEAT_GRANITE);
+			} else if (roll < 42) {
+				square_set_feat(c, grid, FEAT_CLOSED);
+			} else {
+				square_set_feat(c, grid, FEAT_FLOOR);
+				if (roll < 60) {
+					sqinfo_on(square(c, grid).info, SQUARE_ROOM);
+					sqinfo_on(square(c, grid).info, SQUARE_GLOW);
+				}
+			}
+		}
+	}
+	feats[n] = mem_alloc(c->height * c->width);
+	memcpy(feats[n], c->sq_feat, c->height * c->width);
+	return c;
+}
+
+/*
+ * Go through the blocks of a savefile, checking each against its header;
+ * return the number of bytes in the file, or 0 if a block is wrong.
+ */
+static size_t check_blocks(const char *path) {
+	ang_file *f = file_open(path, MODE_READ, FTYPE_SAVE);
+	uint8_t head[28];
+	uint8_t *data = NULL;
+	size_t total = 8;
+	bool good = f && file_read(f, (char *)head, 8) == 8;
+
+	while (good) {
+		uint32_t size, padded, check, sum = 0, i;
+		int len = file_read(f, (char *)head, 28);
+
+		if (len == 0) break;
+		if (len != 28) {
+			good = false;
+			break;
+		}
+		size = head[20] | (head[21] << 8) | (head[22] << 16)
+			| ((uint32_t)head[23] << 24);
+		check = head[24] | (head[25] << 8) | (head[26] << 16)
+			| ((uint32_t)head[27] << 24);
+		padded = size % 4 ? size + 4 - size % 4 : size;
+		data = mem_realloc(data, padded + 1);
+		if (file_read(f, (char *)data, padded) != (int)padded) {
+			good = false;
+			break;
+		}
+		for (i = 0; i < size; i++) {
+			sum += data[i];
+		}
+		if (sum != check) good = false;
+		total += 28 + padded;
+	}
+	mem_free(data);
+	if (f) file_close(f);
+	return good ? total : 0;
+}
+
+static int test_save_load(void *state) {
+	clock_t start, save_ticks, load_ticks;
+	size_t bytes;
+	int i;
+
+	prepare_next_level(player);
+	on_new_level();
+	notnull(cave);
+
+	/* Half the stored levels packed, as they are in play, half not */
+	for (i = 0; i < NUM_CHUNKS; i++) {
+		chunk_list_add(create_synthetic_level(i));
+		if (i == NUM_CHUNKS / 2) {
+			chunk_list_pack();
+		}
+	}
+	require(chunk_list_max >= NUM_CHUNKS);
+
+	start = clock();
+	eq(savefile_save("Test-save"), true);
+	save_ticks = clock() - start;
+	bytes = check_blocks("Test-save");
+	require(bytes > 0);
+
+	play_again = true;
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	init_angband();
+	play_again = false;
+	start = clock();
+	eq(savefile_load("Test-save", false), true);
+	load_ticks = clock() - start;
+	require(chunk_list_max >= NUM_CHUNKS);
+
+	if (verbose) {
+		double save_ms = 1000.0 * save_ticks / CLOCKS_PER_SEC;
+		double load_ms = 1000.0 * load_ticks / CLOCKS_PER_SEC;
+
+		printf("%d stored levels, %lu bytes: save %.1f ms, load %.1f ms\n",
+			chunk_list_max, (unsigned long) bytes, save_ms, load_ms);
+	}
+
+	/* The levels come back as they went */
+	for (i = 0; i < NUM_CHUNKS; i++) {
+		char name[32];
+		struct chunk *c;
+
+		chunk_name(name, sizeof(name), i);
+		c = chunk_find_name(name);
+		notnull(c);
+		require(!memcmp(c->sq_feat, feats[i], c->height * c->width));
+	}
+	ok;
+}
+
+static void savefile_done(game_event_type type, game_event_data *data,
+		void *user) {
+	save_done = data->flag ? 1 : 0;
+}
+
+static int test_background(void *state) {
+	int32_t gold = player->au;
+
+	event_add_handler(EVENT_SAVEFILE_DONE, savefile_done, NULL);
+
+	/* Play goes on while the save is written out */
+	savefile_save_async("Test-save");
+	player->au = gold + 1000;
+	savefile_save_wait();
+	require(!savefile_save_pending());
+	eq(save_done, 1);
+	require(check_blocks("Test-save") > 0);
+
+	/* A save that can't be written says so and leaves nothing behind */
+	save_done = -1;
+	savefile_save_async("no-such-directory/Test-save");
+	savefile_save_wait();
+	eq(save_done, 0);
+	require(!file_exists("no-such-directory/Test-save"));
+
+	play_again = true;
+	wipe_mon_list(cave, player);
+	cleanup_angband();
+	init_angband();
+	play_again = false;
+	eq(savefile_load("Test-save", false), true);
+	eq(player->au, gold);
+	require(chunk_list_max >= NUM_CHUNKS);
+	ok;
+}
+
+const char *suite_name = "game/save";
+struct test tests[] = {
+	{ "save-load", test_save_load },
+	{ "background", test_background },
+	{ NULL, NULL }
+};
@@ -0,0 +1,342 @@
+/* monster/alloc */
+/*
+ * Check the races chosen by get_mon_num() against get_mon_num() as it was
+ * before the chances of each race were kept:  the two pick the same races
+ * from the same random numbers, with or without uniques around.  Also time
+ * both.
+ * The reference looks up the date once per call rather than once per race.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "game-world.h"
+#include "init.h"
+#include "mon-make.h"
+#include "monster.h"
+#include "player.h"
+#include "player-birth.h"
+#include "z-rand.h"
+#include <time.h>
+
+/* The reference:  the allocation table and get_mon_num() as they were */
+struct ref_entry {
+	struct monster_race *race;
+	int prob2;
+	int prob3;
+};
+
+static struct ref_entry *ref_table;
+static int ref_size;
+
+int setup_tests(void **state) {
+	int i, lev;
+
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+
+	/* Races sorted by level, then index, as in init_race_allocs() */
+	ref_table = mem_zalloc(z_info->r_max * sizeof(*ref_table));
+	for (lev = 0; lev < z_info->max_depth; lev++) {
+		for (i = 1; i < z_info->r_max - 1; i++) {
+			struct monster_race *race = &r_info[i];
+
+			if (!race->rarity || race->level != lev) continue;
+			ref_table[ref_size].race = race;
+			ref_table[ref_size].prob2 = (100 / race->rarity) *
+				(1 + lev / 10);
+			ref_size++;
+		}
+	}
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	mem_free(ref_table);
+	cleanup_angband();
+	return 0;
+}
+
+static void ref_prep(bool (*hook)(struct monster_race *race)) {
+	int i;
+
+	for (i = 0; i < ref_size; i++) {
+		struct monster_race *race = ref_table[i].race;
+
+		ref_table[i].prob2 = (!hook || hook(race)) ?
+			(100 / race->rarity) * (1 + race->level / 10) : 0;
+	}
+}
+
+static bool ref_forbidden(struct monster_race *race, bool seasonal) {
+	struct level *lev = &world->levels[player->place];
+
+	if (rf_has(race->flags, RF_SEASONAL) && !seasonal)
+		return true;
+	if (rf_has(race->flags, RF_UNIQUE) && (race->cur_num >= race->max_num))
+		return true;
+	if (rf_has(race->flags, RF_FORCE_DEPTH) && race->level > player->depth)
+		return true;
+	if (rf_has(race->flags, RF_ANGBAND) && (lev->locality != LOC_ANGBAND))
+		return true;
+	if (!streq(world->name, "Angband Dungeon")) {
+		if (rf_has(race->flags, RF_AMON_RUDH) &&
+			(lev->locality != LOC_AMON_RUDH)) {
+			return true;
+		} else if (rf_has(race->flags, RF_NARGOTHROND) &&
+				   (lev->locality != LOC_NARGOTHROND)) {
+			return true;
+		} else if (rf_has(race->flags, RF_DUNGORTHEB) &&
+				   (lev->locality != LOC_NAN_DUNGORTHEB)) {
+			return true;
+		} else if (rf_has(race->flags, RF_GAURHOTH) &&
+				   (lev->locality != LOC_TOL_IN_GAURHOTH)) {
+			return true;
+		}
+	}
+	if (rf_has(race->flags, RF_DUNGEON) && (lev->topography != TOP_CAVE))
+		return true;
+	if (!rf_has(race->flags, RF_FLYING) &&
+		(lev->topography == TOP_MOUNTAINTOP))
+		return true;
+	return false;
+}
+
+static int ref_adjust(int prob, struct monster_race *race) {
+	struct level *lev = &world->levels[player->place];
+
+	if (lev->locality == LOC_NAN_DUNGORTHEB) {
+		if (streq(race->base->name, "spider")) {
+			prob *= 5;
+		} else if (streq(race->base->name, "person") ||
+				   streq(race->base->name, "humanoid")) {
+			prob /= 3;
+		}
+	} else if (lev->locality == LOC_TOL_IN_GAURHOTH) {
+		if (streq(race->base->name, "wolf")) {
+			prob *= 4;
+		} else if (rf_has(race->flags, RF_UNDEAD)) {
+			prob *= 2;
+		}
+	}
+	if ((lev->topography == TOP_DESERT) || (lev->topography == TOP_MOUNTAIN)) {
+		if (streq(race->base->name, "reptile") ||
+			streq(race->base->name, "snake") ||
+			streq(race->base->name, "centipede")) {
+			prob *= 2;
+		} else if (rf_has(race->flags, RF_ANIMAL)) {
+			prob /= 2;
+		}
+	} else if (lev->topography == TOP_FOREST) {
+		if (streq(race->base->name, "reptile")) {
+			prob /= 2;
+		} else if (rf_has(race->flags, RF_ANIMAL) &&
+				   !streq(race->base->name, "zephyr hound")) {
+			prob *= 2;
+		}
+	}
+	return prob;
+}
+
+static struct monster_race *ref_race_aux(long total) {
+	long value = randint0(total);
+	int i;
+
+	for (i = 0; i < ref_size; i++) {
+		if (value < ref_table[i].prob3) break;
+		value -= ref_table[i].prob3;
+	}
+	return ref_table[i].race;
+}
+
+static struct monster_race *ref_get_mon_num(int generated_level) {
+	time_t cur_time = time(NULL);
+	struct tm *date = localtime(&cur_time);
+	bool seasonal = date->tm_mon == 11 && date->tm_mday >= 24 &&
+		date->tm_mday <= 26;
+	int i, p;
+	long total = 0L;
+	struct monster_race *race;
+
+	if (generated_level > 0 && one_in_(z_info->ood_monster_chance))
+		generated_level += MIN(generated_level / 4 + 2,
+			z_info->ood_monster_amount);
+	for (i = 0; i < ref_size; i++) {
+		if (ref_table[i].race->level > generated_level) break;
+		ref_table[i].prob3 = 0;
+		if (generated_level > 0 && ref_table[i].race->level <= 0) continue;
+		race = ref_table[i].race;
+		if (ref_forbidden(race, seasonal)) continue;
+		ref_table[i].prob3 = ref_adjust(ref_table[i].prob2, race);
+		total += ref_table[i].prob3;
+	}
+	if (total <= 0) return NULL;
+	race = ref_race_aux(total);
+	p = randint0(100);
+	if (p < 60) {
+		struct monster_race *old = race;
+
+		race = ref_race_aux(total);
+		if (race->level < old->level) race = old;
+	}
+	if (p < 10) {
+		struct monster_race *old = race;
+
+		race = ref_race_aux(total);
+		if (race->level < old->level) race = old;
+	}
+	return race;
+}
+
+/* Go to a level with the given locality and topography, if there is one */
+static bool go_to(int locality, int topography) {
+	int i;
+
+	for (i = 0; i < world->num_levels; i++) {
+		struct level *lev = &world->levels[i];
+
+		if ((int) lev->locality == locality &&
+				(int) lev->topography == topography) {
+			player->place = i;
+			player->depth = lev->depth;
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Both pick the same races from the same random numbers */
+static bool same_races(int level, int n) {
+	uint32_t seed = randint0(0x10000000);
+	int i;
+
+	Rand_quick = true;
+	for (i = 0; i < n; i++) {
+		struct monster_race *ref, *race;
+
+		Rand_value = seed + i;
+		ref = ref_get_mon_num(level);
+		Rand_value = seed + i;
+		race = get_mon_num(level, level);
+		if (ref != race) break;
+	}
+	Rand_quick = false;
+	return i == n;
+}
+
+static int test_same(void *state) {
+	int level;
+
+	require(go_to(LOC_ANGBAND, TOP_CAVE));
+	for (level = 0; level <= 100; level += 5) {
+		require(same_races(level, 400));
+	}
+
+	/* Everywhere there is in this world */
+	for (level = TOP_TOWN; level <= TOP_MOUNTAINTOP; level++) {
+		int loc;
+
+		for (loc = 0; loc <= LOC_ANGBAND; loc++) {
+			if (!go_to(loc, level)) continue;
+			require(same_races(player->depth, 200));
+		}
+	}
+	ok;
+}
+
+static bool spider_hook(struct monster_race *race) {
+	return streq(race->base->name, "spider");
+}
+
+static int test_hook(void *state) {
+	require(go_to(LOC_ANGBAND, TOP_CAVE));
+	require(same_races(30, 500));
+
+	get_mon_num_prep(spider_hook);
+	ref_prep(spider_hook);
+	require(same_races(30, 500));
+
+	/* Back to no restriction, where the old chances are still good */
+	get_mon_num_prep(NULL);
+	ref_prep(NULL);
+	require(same_races(30, 500));
+	ok;
+}
+
+/*
+ * With uniques around, coming and going between picks, both still pick the
+ * same races from the same random numbers
+ */
+static int test_uniques(void *state) {
+	const int level = 40;
+	int i, j, around = 0;
+
+	require(go_to(LOC_ANGBAND, TOP_CAVE));
+	for (i = 0; i < z_info->r_max; i++) {
+		struct monster_race *race = &r_info[i];
+
+		if (!rf_has(race->flags, RF_UNIQUE) || race->level > level
+				|| i % 2) continue;
+		race->cur_num = race->max_num;
+		around++;
+	}
+	require(around > 10);
+	require(same_races(level, 2000));
+
+	for (j = 0; j < 50; j++) {
+		struct monster_race *race = &r_info[randint1(z_info->r_max - 2)];
+
+		if (!rf_has(race->flags, RF_UNIQUE)) continue;
+		race->cur_num = race->cur_num ? 0 : race->max_num;
+		require(same_races(level - j % 3, 100));
+	}
+
+	for (i = 0; i < z_info->r_max; i++) {
+		r_info[i].cur_num = 0;
+	}
+	require(same_races(level, 500));
+	ok;
+}
+
+static int test_timing(void *state) {
+	const int n = 20000;
+	clock_t start, ref_ticks, new_ticks;
+	int i;
+
+	require(go_to(LOC_ANGBAND, TOP_CAVE));
+	start = clock();
+	for (i = 0; i < n; i++) {
+		(void) ref_get_mon_num(30 + i % 4);
+	}
+	ref_ticks = clock() - start;
+	start = clock();
+	for (i = 0; i < n; i++) {
+		(void) get_mon_num(30 + i % 4, 30);
+	}
+	new_ticks = clock() - start;
+	if (verbose) {
+		printf("scan %.1f ms, kept chances %.1f ms per %d races\n",
+			1000.0 * ref_ticks / CLOCKS_PER_SEC,
+			1000.0 * new_ticks / CLOCKS_PER_SEC, n);
+	}
+	ok;
+}
+
+const char *suite_name = "monster/alloc";
+struct test tests[] = {
+	{ "same", test_same },
+	{ "hook", test_hook },
+	{ "uniques", test_uniques },
+	{ "timing", test_timing },
+	{ NULL, NULL }
+};
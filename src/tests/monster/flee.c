@@ -0,0 +1,116 @@
+/* monster/flee */
+/*
+ * Monsters taking damage from terrain head for safety by the player's noise,
+ * even when they are too far away for the noise flow made each turn to reach
+ * them.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "cmd-core.h"
+#include "game-world.h"
+#include "init.h"
+#include "mon-make.h"
+#include "mon-util.h"
+#include "monster.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-timed.h"
+#include "player-util.h"
+#include "z-rand.h"
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	Rand_quick = true;
+	Rand_value = 1;
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+	Rand_quick = false;
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	cleanup_angband();
+	return 0;
+}
+
+/*
+ * A long arena with the player at one end and a pool of lava far down it;
+ * the player's noise only has to flow as far as the monsters can hear.
+ */
+static void build_level(int height, int width, struct loc centre, int r) {
+	struct loc grid;
+	int i;
+
+	cave = t_build_arena(height, width);
+	cave->depth = 10;
+	for (grid.y = centre.y - r; grid.y <= centre.y + r; grid.y++) {
+		for (grid.x = centre.x - r; grid.x <= centre.x + r; grid.x++) {
+			square_set_feat(cave, grid, FEAT_LAVA);
+		}
+	}
+	player->cave = cave_new(cave->height, cave->width);
+	player->cave->objects = mem_realloc(player->cave->objects,
+		(cave->obj_max + 1) * sizeof(struct object*));
+	player->cave->obj_max = cave->obj_max;
+	for (i = 0; i <= player->cave->obj_max; i++) {
+		player->cave->objects[i] = NULL;
+	}
+	player_place(cave, player, loc(2, height / 2));
+	character_dungeon = true;
+	on_new_level();
+}
+
+static void free_level(void) {
+	wipe_mon_list(cave, player);
+	cave_free(player->cave);
+	player->cave = NULL;
+	cave_free(cave);
+	cave = NULL;
+	character_dungeon = false;
+}
+
+/*
+ * In the middle of a wide pool, the monster should aim for the far shore;
+ * it used to score every way out as 0 and aim south
+ */
+static int test_lava(void *state) {
+	struct loc centre = loc(100, 10);
+	struct monster *mon;
+
+	Rand_quick = true;
+	Rand_value = 7;
+	build_level(21, 130, centre, 8);
+	mon = t_add_monster(cave, centre, "soldier");
+	mon->maxhp = mon->hp = 10000;
+	make_noise(cave, player);
+	eq(heatmap_get(cave->noise, mon->grid), 0);
+
+	player->timed[TMD_INVULN] = 100;
+	cmdq_push(CMD_HOLD);
+	run_game_loop();
+	require(mon->race);
+	ptreq(square_monster(cave, centre), mon);
+	eq(mon->target.grid.x, centre.x + 1);
+
+	free_level();
+	Rand_quick = false;
+	ok;
+}
+
+const char *suite_name = "monster/flee";
+struct test tests[] = {
+	{ "lava", test_lava },
+	{ NULL, NULL }
+};
@@ -128,9 +128,51 @@ static int test_nearby_kin(void *state) {
 	ok;
 }
 
+/* Look for a race the long way, as lookup_monster() always did */
+static struct monster_race *lookup_monster_scan(const char *name) {
+	struct monster_race *closest = NULL;
+	int i;
+
+	for (i = 0; i < z_info->r_max; i++) {
+		struct monster_race *race = &r_info[i];
+		if (!race->name) continue;
+		if (streq(name, race->name)) return race;
+		if (my_stricmp(name, race->name) == 0) closest = race;
+		if (!closest && my_stristr(race->name, name)) closest = race;
+	}
+	return closest;
+}
+
+static int test_lookup(void *state) {
+	int i;
+
+	for (i = 0; i < z_info->r_max; i++) {
+		char buf[80];
+		size_t j;
+
+		if (!r_info[i].name) continue;
+		ptreq(lookup_monster(r_info[i].name), &r_info[i]);
+
+		/* Names in other cases, as monster.txt gives friends */
+		my_strcpy(buf, r_info[i].name, sizeof(buf));
+		for (j = 0; buf[j]; j++) buf[j] = tolower((unsigned char) buf[j]);
+		ptreq(lookup_monster(buf), lookup_monster_scan(buf));
+		my_strcap(buf);
+		ptreq(lookup_monster(buf), lookup_monster_scan(buf));
+
+		/* And parts of names */
+		my_strcpy(buf, r_info[i].name + strlen(r_info[i].name) / 2,
+			sizeof(buf));
+		ptreq(lookup_monster(buf), lookup_monster_scan(buf));
+	}
+	null(lookup_monster("No such monster anywhere"));
+	ok;
+}
+
 const char *suite_name = "monster/monster";
 struct test tests[] = {
 	{ "match_monster_bases", test_match_monster_bases },
 	{ "nearby_kin", test_nearby_kin },
+	{ "lookup", test_lookup },
 	{ NULL, NULL }
 };
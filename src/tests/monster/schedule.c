@@ -0,0 +1,289 @@
+/* monster/schedule */
+/*
+ * Replay games in an arena full of monsters, with the player holding still
+ * while things are done to the monsters between turns, and check that the
+ * monsters end up just as they did when process_monsters() looked at every
+ * monster every game turn:  the digests below were recorded from that code.
+ * Also time a level full of monsters which seldom move.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "cave.h"
+#include "cmd-core.h"
+#include "effects.h"
+#include "game-world.h"
+#include "init.h"
+#include "mon-make.h"
+#include "mon-schedule.h"
+#include "mon-timed.h"
+#include "mon-util.h"
+#include "monster.h"
+#include "player.h"
+#include "player-birth.h"
+#include "player-timed.h"
+#include "player-util.h"
+#include "source.h"
+#include "z-rand.h"
+#include <time.h>
+
+/* Digests of replays from the seeds, holding or resting, as recorded */
+static const struct {
+	uint32_t seed;
+	bool rest;
+	uint32_t digest;
+} replays[] = {
+	{ 1, false, 0xb295b4a5 },
+	{ 271828, false, 0xf720a79b },
+	{ 3141592, false, 0x7b6df550 },
+	{ 2, true, 0xf03c9278 },
+	{ 161803, true, 0x05823d8f },
+};
+
+int setup_tests(void **state) {
+	set_file_paths();
+	if (!init_angband()) {
+		return 1;
+	}
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+
+	/* The same character every time */
+	Rand_quick = true;
+	Rand_value = 1;
+	if (!player_make_simple(NULL, NULL, "Tester")) {
+		cleanup_angband();
+		return 1;
+	}
+	Rand_quick = false;
+
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	cleanup_angband();
+	return 0;
+}
+
+/* An arena with pillars and pools of rubble, and the player in the middle */
+static void build_level(int height, int width) {
+	struct loc grid;
+	int i;
+
+	cave = t_build_arena(height, width);
+	cave->depth = 10;
+	for (i = 0; i < height * width / 40; i++) {
+		grid = loc(randint1(width - 2), randint1(height - 2));
+		square_set_feat(cave, grid, one_in_(3) ? FEAT_PASS_RUBBLE :
+			FEAT_GRANITE);
+	}
+	player->cave = cave_new(cave->height, cave->width);
+	player->cave->objects = mem_realloc(player->cave->objects,
+		(cave->obj_max + 1) * sizeof(struct object*));
+	player->cave->obj_max = cave->obj_max;
+	for (i = 0; i <= player->cave->obj_max; i++) {
+		player->cave->objects[i] = NULL;
+	}
+	grid = loc(width / 2, height / 2);
+	square_set_feat(cave, grid, FEAT_FLOOR);
+	player_place(cave, player, grid);
+	character_dungeon = true;
+	on_new_level();
+}
+
+static void free_level(void) {
+	wipe_mon_list(cave, player);
+	cave_free(player->cave);
+	player->cave = NULL;
+	cave_free(cave);
+	cave = NULL;
+	character_dungeon = false;
+}
+
+static struct loc random_empty(struct chunk *c) {
+	struct loc grid;
+
+	do {
+		grid = loc(randint1(c->width - 2), randint1(c->height - 2));
+	} while (!square_isempty(c, grid));
+	return grid;
+}
+
+static struct monster *random_monster(struct chunk *c) {
+	int tries;
+
+	for (tries = 0; tries < 1000; tries++) {
+		struct monster *mon = cave_monster(c,
+			randint1(cave_monster_max(c) - 1));
+
+		if (mon && mon->race) return mon;
+	}
+	return NULL;
+}
+
+static uint32_t mix(uint32_t hash, int value) {
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		hash = (hash ^ ((uint32_t) value & 0xff)) * 16777619U;
+		value >>= 8;
+	}
+	return hash;
+}
+
+/* Where the monsters are and how they are doing, including their energy */
+static uint32_t digest(uint32_t hash) {
+	int i;
+
+	hash = mix(hash, turn);
+	hash = mix(hash, player->grid.x);
+	hash = mix(hash, player->grid.y);
+	hash = mix(hash, player->energy);
+	for (i = 1; i < cave_monster_max(cave); i++) {
+		struct monster *mon = cave_monster(cave, i);
+
+		if (!mon->race) continue;
+		monster_schedule_sync(cave, mon);
+		hash = mix(hash, i);
+		hash = mix(hash, mon->race->ridx);
+		hash = mix(hash, mon->grid.x);
+		hash = mix(hash, mon->grid.y);
+		hash = mix(hash, mon->hp);
+		hash = mix(hash, mon->mspeed);
+		hash = mix(hash, mon->energy);
+		hash = mix(hash, mon->m_timed[MON_TMD_SLEEP]);
+		hash = mix(hash, mon->m_timed[MON_TMD_FAST]);
+		hash = mix(hash, mon->m_timed[MON_TMD_SLOW]);
+	}
+	return hash;
+}
+
+/* Something the player might do to the monsters on their turn */
+static void meddle(int roll) {
+	const char *races[] = { "scout", "cave spider", "giant white mouse" };
+	struct monster *mon = random_monster(cave);
+
+	if (roll < 20) {
+		if (mon) mon_inc_timed(mon, MON_TMD_SLOW, 10 + roll, 0);
+	} else if (roll < 40) {
+		if (mon) mon_inc_timed(mon, MON_TMD_FAST, 10 + roll, 0);
+	} else if (roll < 50) {
+		effect_simple(EF_ENERGY_DRAIN, source_player(), "0", 0, 6, 0, 0,
+			0, NULL);
+	} else if (roll < 60) {
+		if (mon) delete_monster_idx(cave, mon->midx);
+	} else if (roll < 80) {
+		if (cave->mon_cnt < z_info->level_monster_max - 40) {
+			(void) t_add_monster(cave, random_empty(cave),
+				races[roll % N_ELEMENTS(races)]);
+		}
+	} else if (roll < 85) {
+		compact_monsters(cave, 0);
+	} else if (roll < 90) {
+		if (mon) mon_inc_timed(mon, MON_TMD_SLEEP, 30, 0);
+	}
+}
+
+/*
+ * Hold still or rest for some turns among monsters of kinds which haste and
+ * slow themselves and the player, blink, breed and crowd round
+ */
+static uint32_t replay(uint32_t seed, bool rest, int commands) {
+	const char *races[] = { "scout", "tamer", "illusionist",
+		"giant white mouse", "white worm mass", "poltergeist",
+		"cave spider", "soldier", "blink dog", "dark hound" };
+	uint32_t hash = 2166136261U;
+	int i;
+
+	Rand_quick = true;
+	Rand_value = seed;
+
+	/* Start a little before dawn */
+	turn = 10L * z_info->day_length - 2000;
+	player->energy = 0;
+	build_level(44, 132);
+	for (i = 0; i < 150; i++) {
+		(void) t_add_monster(cave, random_empty(cave),
+			races[i % N_ELEMENTS(races)]);
+	}
+
+	for (i = 0; i < commands; i++) {
+		if (player->is_dead || player->upkeep->generate_level) break;
+		player->timed[TMD_INVULN] = 100;
+		player->chp = player->mhp;
+		if (one_in_(3)) meddle(randint0(100));
+		if (rest) {
+			cmdq_push(CMD_REST);
+			cmd_set_arg_choice(cmdq_peek(), "choice", randint1(50));
+		} else {
+			cmdq_push(CMD_HOLD);
+		}
+		run_game_loop();
+		hash = digest(hash);
+	}
+	hash = mix(hash, i);
+
+	free_level();
+	Rand_quick = false;
+	return hash;
+}
+
+static int test_replay(void *state) {
+	size_t i;
+
+	for (i = 0; i < N_ELEMENTS(replays); i++) {
+		uint32_t hash = replay(replays[i].seed, replays[i].rest, 600);
+
+		if (verbose) {
+			printf("seed %lu%s: digest 0x%08lx\n",
+				(unsigned long) replays[i].seed,
+				replays[i].rest ? " resting" : "",
+				(unsigned long) hash);
+		}
+		eq(hash, replays[i].digest);
+	}
+	ok;
+}
+
+/* Many sleeping monsters, a tenth of which move on any one game turn */
+static int test_timing(void *state) {
+	const int commands = 2000;
+	clock_t start, ticks;
+	int i;
+
+	Rand_quick = true;
+	Rand_value = 5;
+	turn = 1;
+	build_level(z_info->dungeon_hgt, z_info->dungeon_wid);
+	while (cave->mon_cnt < z_info->level_monster_max - 100) {
+		struct monster *mon = t_add_monster(cave, random_empty(cave),
+			one_in_(2) ? "white icky thing" : "grey mold");
+
+		mon_inc_timed(mon, MON_TMD_SLEEP, 10000, MON_TMD_FLG_NOFAIL);
+	}
+
+	start = clock();
+	for (i = 0; i < commands; i++) {
+		player->timed[TMD_INVULN] = 100;
+		cmdq_push(CMD_HOLD);
+		run_game_loop();
+	}
+	ticks = clock() - start;
+	if (verbose) {
+		printf("%d monsters: %.1f ms for %d game turns\n",
+			cave_monster_count(cave), 1000.0 * ticks / CLOCKS_PER_SEC,
+			10 * commands);
+	}
+
+	free_level();
+	Rand_quick = false;
+	ok;
+}
+
+const char *suite_name = "monster/schedule";
+struct test tests[] = {
+	{ "replay", test_replay },
+	{ "timing", test_timing },
+	{ NULL, NULL }
+};
@@ -1 +1 @@
-TESTPROGS += monster/attack monster/desc monster/monster
+TESTPROGS += monster/alloc monster/attack monster/desc monster/flee monster/monster monster/schedule
@@ -0,0 +1,122 @@
+/* parse/cache */
+/*
+ * Start with the game data cache:  the tables loaded from the image have to
+ * come out the same as the ones parsed, and a damaged image has to be passed
+ * over.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "datacache.h"
+#include "init.h"
+#include <time.h>
+
+static char cache_path[1024];
+
+int setup_tests(void **state) {
+	set_file_paths();
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+	path_build(cache_path, sizeof(cache_path), ANGBAND_DIR_USER,
+		"gamedata.cache");
+	if (file_exists(cache_path)) file_delete(cache_path);
+	return 0;
+}
+
+int teardown_tests(void *state) {
+	if (file_exists(cache_path)) file_delete(cache_path);
+	play_again = false;
+	use_data_cache = false;
+	return 0;
+}
+
+/**
+ * Start up, note the digest of the cached tables and how many were loaded,
+ * and clean up again
+ */
+static bool start(bool use_cache, uint64_t *digest, int *loaded,
+		double *ms) {
+	clock_t begin = clock();
+	bool started;
+
+	use_data_cache = use_cache;
+	started = init_angband();
+	*ms = 1000.0 * (clock() - begin) / CLOCKS_PER_SEC;
+	*digest = datacache_digest();
+	datacache_sections(loaded);
+	play_again = true;
+	cleanup_angband();
+	use_data_cache = false;
+	return started;
+}
+
+static int test_cache(void *state) {
+	uint64_t parsed, digest;
+	int loaded, sections = datacache_sections(&loaded);
+	double ms_plain, ms_write, ms_load;
+
+	/* Without the cache */
+	require(start(false, &parsed, &loaded, &ms_plain));
+	eq(loaded, 0);
+	require(!file_exists(cache_path));
+
+	/* With no image yet, everything is parsed and the image written */
+	require(start(true, &digest, &loaded, &ms_write));
+	eq(loaded, 0);
+	require(digest == parsed);
+	require(file_exists(cache_path));
+
+	/* Then everything is loaded, and comes out the same */
+	require(start(true, &digest, &loaded, &ms_load));
+	eq(loaded, sections);
+	require(digest == parsed);
+
+	if (verbose) {
+		printf("init_angband(): %.1f ms parsing, %.1f ms writing the "
+			"image, %.1f ms loading it\n", ms_plain, ms_write, ms_load);
+	}
+	ok;
+}
+
+static int test_damaged(void *state) {
+	uint64_t parsed, digest;
+	int loaded;
+	double ms;
+	ang_file *fh;
+	char *image;
+	size_t len;
+
+	require(start(false, &parsed, &loaded, &ms));
+	require(start(true, &digest, &loaded, &ms));
+	require(file_exists(cache_path));
+
+	/* Flip a byte in the middle of the image */
+	fh = file_open(cache_path, MODE_READ, FTYPE_RAW);
+	require(fh);
+	image = file_read_all(fh, &len);
+	file_close(fh);
+	require(image && len > 64);
+	image[len / 2] ^= 0x20;
+	fh = file_open(cache_path, MODE_WRITE, FTYPE_RAW);
+	require(fh);
+	require(file_write(fh, image, len));
+	file_close(fh);
+	mem_free(image);
+
+	/* The image is passed over, and written again */
+	require(start(true, &digest, &loaded, &ms));
+	eq(loaded, 0);
+	require(digest == parsed);
+	require(start(true, &digest, &loaded, &ms));
+	require(loaded > 0);
+	require(digest == parsed);
+	ok;
+}
+
+const char *suite_name = "parse/cache";
+struct test tests[] = {
+	{ "cache", test_cache },
+	{ "damaged", test_damaged },
+	{ NULL, NULL }
+};
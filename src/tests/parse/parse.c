@@ -3,6 +3,7 @@
 #include "unit-test.h"
 
 #include "parser.h"
+#include "z-form.h"
 
 int setup_tests(void **state) {
 	struct parser *p = parser_new();
@@ -516,6 +517,65 @@ static int test_char1(void *state) {
 	ok;
 }
 
+static enum parser_error helper_super0(struct parser *p) {
+	int *which = parser_priv(p);
+	*which = 1;
+	return PARSE_ERROR_NONE;
+}
+
+static enum parser_error helper_super1(struct parser *p) {
+	int *which = parser_priv(p);
+	*which = parser_getint(p, "i0");
+	return PARSE_ERROR_NONE;
+}
+
+static int test_supersede(void *state) {
+	int which = 0;
+	errr r = parser_reg(state, "test-super sym s0", helper_super0);
+	eq(r, 0);
+	parser_setpriv(state, &which);
+	r = parser_parse(state, "test-super:foo");
+	eq(r, PARSE_ERROR_NONE);
+	eq(which, 1);
+
+	/* A later hook with the same directive takes over */
+	r = parser_reg(state, "test-super int i0", helper_super1);
+	eq(r, 0);
+	r = parser_parse(state, "test-super:7");
+	eq(r, PARSE_ERROR_NONE);
+	eq(which, 7);
+	require(!parser_hasval(state, "s0"));
+	ok;
+}
+
+static enum parser_error helper_many(struct parser *p) {
+	int *sum = parser_priv(p);
+	*sum += parser_getint(p, "i0") + parser_getint(p, "i9");
+	return PARSE_ERROR_NONE;
+}
+
+static int test_many(void *state) {
+	char buf[200];
+	int i, sum = 0;
+
+	/* Enough hooks to make the directive table grow, with many fields */
+	for (i = 0; i < 300; i++) {
+		strnfmt(buf, sizeof(buf), "test-many%d int i0 int i1 int i2 int i3 "
+			"int i4 int i5 int i6 int i7 int i8 int i9", i);
+		eq(parser_reg(state, buf, helper_many), 0);
+	}
+	parser_setpriv(state, &sum);
+	for (i = 0; i < 300; i++) {
+		strnfmt(buf, sizeof(buf), "test-many%d:%d:1:2:3:4:5:6:7:8:%d", i,
+			i, 2 * i);
+		eq(parser_parse(state, buf), PARSE_ERROR_NONE);
+	}
+	eq(sum, 3 * 299 * 300 / 2);
+	eq(parser_parse(state, "test-many300:1:1:1:1:1:1:1:1:1:1"),
+		PARSE_ERROR_UNDEFINED_DIRECTIVE);
+	ok;
+}
+
 const char *suite_name = "parse/parser";
 struct test tests[] = {
 	{ "priv", test_priv },
@@ -560,5 +620,8 @@ struct test tests[] = {
 
 	{ "baddir", test_baddir },
 
+	{ "supersede", test_supersede },
+	{ "many", test_many },
+
 	{ NULL, NULL }
 };
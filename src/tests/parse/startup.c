@@ -0,0 +1,52 @@
+/* parse/startup */
+/*
+ * Time a cold start:  everything init_angband() does, which is mostly parsing
+ * the game data files.
+ */
+
+#include "unit-test.h"
+#include "test-utils.h"
+#include "init.h"
+#include <time.h>
+
+int setup_tests(void **state) {
+	set_file_paths();
+#ifdef UNIX
+	create_needed_dirs();
+#endif
+	return 0;
+}
+
+NOTEARDOWN
+
+static int test_cold_start(void *state) {
+	const int passes = 5;
+	clock_t ticks = 0, best = 0;
+	int i;
+
+	for (i = 0; i < passes; i++) {
+		clock_t start = clock(), t;
+
+		require(init_angband());
+		t = clock() - start;
+		ticks += t;
+		if (!i || t < best) best = t;
+
+		/* Keep the directories for the next pass */
+		play_again = (i < passes - 1);
+		cleanup_angband();
+	}
+	play_again = false;
+	if (verbose) {
+		printf("init_angband(): %.1f ms on average, %.1f ms at best, "
+			"over %d passes\n", 1000.0 * ticks / passes / CLOCKS_PER_SEC,
+			1000.0 * best / CLOCKS_PER_SEC, passes);
+	}
+	ok;
+}
+
+const char *suite_name = "parse/startup";
+struct test tests[] = {
+	{ "cold-start", test_cold_start },
+	{ NULL, NULL }
+};
@@ -3,6 +3,7 @@ TESTPROGS += parse/a-info \
 	parse/blowm \
 	parse/body \
 	parse/brand \
+	parse/cache \
 	parse/curse \
 	parse/c-info \
 	parse/e-info \
@@ -31,6 +32,7 @@ TESTPROGS += parse/a-info \
 	parse/realm \
 	parse/shape \
 	parse/slay \
+	parse/startup \
 	parse/ui_knowledge \
 	parse/v-info \
 	parse/z-info
@@ -127,6 +127,7 @@ TEST_CONSTANT(feeling_total, "feeling-total", "world")
 TEST_CONSTANT(feeling_need, "feeling-need", "world")
 TEST_CONSTANT(stair_skip, "stair-skip", "world")
 TEST_CONSTANT(move_energy, "move-energy", "world")
+TEST_CONSTANT(level_memory, "level-memory", "world")
 
 TEST_CONSTANT(pack_size, "pack-size", "carry-cap")
 TEST_CONSTANT(quiver_size, "quiver-size", "carry-cap")
@@ -318,6 +319,7 @@ struct test tests[] = {
 	{ "feeling_need", test_feeling_need },
 	{ "stair_skip", test_stair_skip },
 	{ "move_energy", test_move_energy },
+	{ "level_memory", test_level_memory },
 	{ "pack_size", test_pack_size },
 	{ "quiver_size", test_quiver_size },
 	{ "quiver_slot_size", test_quiver_slot_size },
@@ -1320,7 +1320,13 @@ static struct chunk TEST_DATA test_cave = {
 	.feeling_squares = 0,
 	.feat_count = NULL,
 
-	.squares = NULL,
+	.sq_feat = NULL,
+	.sq_props = NULL,
+	.sq_info = NULL,
+	.sq_light = NULL,
+	.sq_mon = NULL,
+	.sq_obj = NULL,
+	.sq_trap = NULL,
 
 	.monsters = NULL,
 	.mon_max = 1,
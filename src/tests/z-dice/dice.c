@@ -195,11 +195,72 @@ static int test_evaluate(void *state)
 	ok;
 }
 
+static int test_format(void *state)
+{
+	const char *strings[] = {
+		"1+2d3M4", "d3", "M4", "-1+d3", "11+22d33M44", "$B+$Xd$Ym$M",
+		"$DAM", "3+d$S", "$B+2d3",
+	};
+	size_t i;
+
+	for (i = 0; i < N_ELEMENTS(strings); i++) {
+		char buf[80];
+		dice_t *new = dice_new();
+		dice_t *copy = dice_new();
+		int j;
+
+		require(dice_parse_string(new, strings[i]));
+		require(dice_format_string(new, buf, sizeof(buf)));
+		require(dice_parse_string(copy, buf));
+		require(dice_base_equal(new, copy));
+		for (j = 0; j < DICE_MAX_EXPRESSIONS; j++) {
+			const char *name, *copy_name;
+
+			ptreq(dice_get_expression(new, j, &name), NULL);
+			ptreq(dice_get_expression(copy, j, &copy_name), NULL);
+			require((name == NULL) == (copy_name == NULL));
+			require(!name || streq(name, copy_name));
+		}
+		require(!dice_format_string(new, buf, 4));
+		dice_free(copy);
+		dice_free(new);
+	}
+	ok;
+}
+
+static int test_format_expression(void *state)
+{
+	expression_t *expression = expression_new();
+	dice_t *new = dice_new();
+	const expression_t *bound;
+	const char *name;
+	char buf[80];
+
+	require(expression_add_operations_string(expression, "+ 5") > 0);
+	require(dice_parse_string(new, "2d$S"));
+	require(dice_bind_expression(new, "S", expression) >= 0);
+	require(dice_format_string(new, buf, sizeof(buf)));
+	require(streq(buf, "0+2d$Sm0"));
+	bound = dice_get_expression(new, 0, &name);
+	require(bound != NULL);
+	require(streq(name, "S"));
+	eq(expression_evaluate(bound), 5);
+	ptreq(dice_get_expression(new, 1, &name), NULL);
+	ptreq(name, NULL);
+	ptreq(dice_get_expression(new, DICE_MAX_EXPRESSIONS, &name), NULL);
+
+	dice_free(new);
+	expression_free(expression);
+	ok;
+}
+
 const char *suite_name = "z-dice/dice";
 struct test tests[] = {
 	{ "alloc", test_alloc },
 	{ "parse-success", test_parse_success },
 	{ "parse-failure", test_parse_failure },
 	{ "evaluate", test_evaluate },
+	{ "format", test_format },
+	{ "format-expression", test_format_expression },
 	{ NULL, NULL },
 };
@@ -2,6 +2,9 @@
 
 #include "unit-test.h"
 #include "z-expression.h"
+#include "z-form.h"
+#include "z-rand.h"
+#include "z-util.h"
 
 NOSETUP
 NOTEARDOWN
@@ -150,11 +153,124 @@ static int test_evaluate(void *state)
 	ok;
 }
 
+static int32_t base_value_3(void)
+{
+	return -7;
+}
+
+/* Work an expression string out one operation at a time */
+static int32_t reference(int32_t value, const char *string)
+{
+	char op = 0;
+	char buf[200];
+	char *token;
+
+	my_strcpy(buf, string, sizeof(buf));
+	for (token = strtok(buf, " "); token; token = strtok(NULL, " ")) {
+		char *end;
+		long operand = strtol(token, &end, 0);
+
+		if (end == token) {
+			op = token[0];
+			if (op == 'n') value = -value;
+			continue;
+		}
+		switch (op) {
+			case '+': value = (int32_t)((uint32_t)value + operand); break;
+			case '-': value = (int32_t)((uint32_t)value - operand); break;
+			case '*': value = (int32_t)((uint32_t)value * operand); break;
+			case '/': value /= operand; break;
+		}
+	}
+	return value;
+}
+
+static int test_fold(void *state)
+{
+	const char *ops = "+-*/n";
+	expression_base_value_f bases[] = { NULL, base_value_2, base_value_3 };
+	bool quick = Rand_quick;
+	int i, j;
+
+	Rand_quick = true;
+	Rand_value = 161;
+	for (i = 0; i < 2000; i++) {
+		char string[200] = "";
+		size_t end = 0;
+		expression_t *new = expression_new();
+		expression_t *copy;
+		expression_base_value_f base = bases[randint0(N_ELEMENTS(bases))];
+		int n = randint1(8);
+
+		/* A random expression, divisions included */
+		for (j = 0; j < n; j++) {
+			char op = ops[randint0(5)];
+			int m = randint1(3);
+
+			strnfcat(string, sizeof(string), &end, "%c ", op);
+			while (op != 'n' && m--) {
+				int operand = randint0(40) - 20;
+
+				/* Never divide by zero, nor overflow dividing by -1 */
+				if (op == '/' && (operand == 0 || operand == -1)) {
+					operand = 3;
+				}
+				strnfcat(string, sizeof(string), &end, "%d ", operand);
+			}
+		}
+		expression_set_base_value(new, base);
+		require(expression_add_operations_string(new, string) >= 0);
+		copy = expression_copy(new);
+		eq(expression_evaluate(new), reference(base ? base() : 0, string));
+		eq(expression_evaluate(copy), expression_evaluate(new));
+		expression_free(copy);
+		expression_free(new);
+	}
+	Rand_quick = quick;
+	ok;
+}
+
+static int test_format(void *state)
+{
+	const char *strings[] = {
+		"", "+ 1", "- 2 3", "* 4 n", "n / 3", "+ -5 * 2 n - 1 / 7",
+	};
+	size_t i;
+
+	for (i = 0; i < N_ELEMENTS(strings); i++) {
+		char buf[200], again[200];
+		expression_t *new = expression_new();
+		expression_t *copy = expression_new();
+
+		expression_set_base_value(new, base_value_3);
+		require(expression_add_operations_string(new, strings[i]) >= 0);
+		require(expression_operations_string(new, buf, sizeof(buf)));
+		ptreq(expression_get_base_value(new), base_value_3);
+
+		/* The string makes the same expression, and comes out the same */
+		expression_set_base_value(copy, expression_get_base_value(new));
+		require(expression_add_operations_string(copy, buf) >= 0);
+		eq(expression_evaluate(copy), expression_evaluate(new));
+		require(expression_operations_string(copy, again, sizeof(again)));
+		require(streq(again, buf));
+
+		/* Too short a buffer is turned down */
+		if (strlen(buf) > 0) {
+			require(!expression_operations_string(new, again, strlen(buf)));
+		}
+		expression_free(copy);
+		expression_free(new);
+	}
+	ok;
+}
+
 const char *suite_name = "z-expression/expression";
 struct test tests[] = {
 	{ "alloc", test_alloc },
 	{ "parse-success", test_parse_success },
 	{ "parse-failure", test_parse_failure },
 	{ "evaluate", test_evaluate },
+	{ "fold", test_fold },
+	{ "format", test_format },
 	{ NULL, NULL },
 };
@@ -0,0 +1,102 @@
+/* z-file/getl.c */
+
+#include "unit-test.h"
+#include "z-file.h"
+#include "z-virt.h"
+
+NOSETUP
+NOTEARDOWN
+
+static const char *texts[] = {
+	"",
+	"one line",
+	"one line\n",
+	"a\nb\r\nc\rd\r\re\n\n\nf",
+	"\r",
+	"\r\n\r\n",
+	"\ttab\t\tand\tmore\ttabs\t\t\t\tto\tthe\tend\n",
+	"a line which is much too long for the small buffer, so it is split\n"
+		"x\n",
+	"end with a carriage return\r",
+};
+
+/* Lines from the file by file_getl(), and from its contents by text_getl() */
+static bool same_lines(const char *name, size_t size) {
+	char a[128], b[128];
+	ang_file *f = file_open(name, MODE_READ, FTYPE_TEXT);
+	char *text;
+	const char *pos;
+	size_t len;
+	bool same = true;
+
+	if (!f) return false;
+	text = file_read_all(f, &len);
+	file_close(f);
+	if (!text) return false;
+
+	f = file_open(name, MODE_READ, FTYPE_TEXT);
+	pos = text;
+	while (same) {
+		bool got_a = file_getl(f, a, size);
+		bool got_b = text_getl(&pos, text + len, b, size);
+
+		if (got_a != got_b || (got_a && strcmp(a, b))) same = false;
+		if (!got_a) break;
+	}
+	file_close(f);
+	mem_free(text);
+	return same;
+}
+
+static int test_same(void *state) {
+	const char *name = "z-file-getl.txt";
+	size_t sizes[] = { 1024, 16, 5 };
+	size_t i, j;
+
+	for (i = 0; i < N_ELEMENTS(texts); i++) {
+		ang_file *f = file_open(name, MODE_WRITE, FTYPE_RAW);
+
+		require(f);
+		require(file_write(f, texts[i], strlen(texts[i])));
+		file_close(f);
+		for (j = 0; j < N_ELEMENTS(sizes); j++) {
+			require(same_lines(name, sizes[j]));
+		}
+	}
+	file_delete(name);
+	ok;
+}
+
+static int test_read_all(void *state) {
+	const char *name = "z-file-getl.txt";
+	size_t n = 100000, i, len;
+	char *big = mem_alloc(n), *text;
+	ang_file *f = file_open(name, MODE_WRITE, FTYPE_RAW);
+
+	require(f);
+	for (i = 0; i < n; i++) {
+		big[i] = (i % 61 == 60) ? '\n' : 'a' + i % 26;
+	}
+	require(file_write(f, big, n));
+	file_close(f);
+
+	f = file_open(name, MODE_READ, FTYPE_RAW);
+	require(f);
+	text = file_read_all(f, &len);
+	file_close(f);
+	file_delete(name);
+	require(text);
+	eq(len, n);
+	require(!memcmp(text, big, n));
+	eq(text[n], '\0');
+	mem_free(text);
+	mem_free(big);
+	ok;
+}
+
+const char *suite_name = "z-file/getl";
+struct test tests[] = {
+	{ "same", test_same },
+	{ "read-all", test_read_all },
+	{ NULL, NULL }
+};
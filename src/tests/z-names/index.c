@@ -0,0 +1,87 @@
+/* z-names/index.c */
+
+#include "unit-test.h"
+#include "z-form.h"
+#include "z-names.h"
+#include "z-util.h"
+
+NOSETUP
+NOTEARDOWN
+
+static int test_find(void *state) {
+	struct name_index *index = name_index_new(false);
+	char name[20];
+
+	my_strcpy(name, "fire", sizeof(name));
+	name_index_add(index, name, 3);
+	name_index_add(index, "cold", 7);
+
+	/* The index has its own copy of each name */
+	my_strcpy(name, "acid", sizeof(name));
+	eq(name_index_find(index, "fire"), 3);
+	eq(name_index_find(index, "cold"), 7);
+	eq(name_index_find(index, "acid"), -1);
+	eq(name_index_find(index, "Fire"), -1);
+	eq(name_index_find(index, ""), -1);
+
+	name_index_free(index);
+	ok;
+}
+
+static int test_ignore_case(void *state) {
+	struct name_index *index = name_index_new(true);
+
+	name_index_add(index, "POIS", 4);
+	eq(name_index_find(index, "pois"), 4);
+	eq(name_index_find(index, "Pois"), 4);
+	eq(name_index_find(index, "poison"), -1);
+
+	name_index_free(index);
+	ok;
+}
+
+static int test_next(void *state) {
+	struct name_index *index = name_index_new(false);
+	size_t pos = 0;
+	int i;
+
+	/* The same name many times, among many others */
+	for (i = 0; i < 300; i++) {
+		name_index_add(index, format("name %d", i), i);
+		if (i % 30 == 0) name_index_add(index, "of Slay Evil", i);
+	}
+	for (i = 0; i < 300; i += 30) {
+		eq(name_index_next(index, "of Slay Evil", &pos), i);
+	}
+	eq(name_index_next(index, "of Slay Evil", &pos), -1);
+	eq(name_index_next(index, "of Slay Evil", &pos), -1);
+	eq(name_index_find(index, "of Slay Evil"), 0);
+
+	name_index_free(index);
+	ok;
+}
+
+static int test_many(void *state) {
+	struct name_index *index = name_index_new(false);
+	int i;
+
+	for (i = 0; i < 5000; i++) {
+		name_index_add(index, format("%d", i), i);
+	}
+	for (i = 0; i < 5000; i++) {
+		eq(name_index_find(index, format("%d", i)), i);
+	}
+	eq(name_index_find(index, "5000"), -1);
+
+	name_index_free(index);
+	ok;
+}
+
+const char *suite_name = "z-names/index";
+struct test tests[] = {
+	{ "find", test_find },
+	{ "ignore-case", test_ignore_case },
+	{ "next", test_next },
+	{ "many", test_many },
+	{ NULL, NULL }
+};
@@ -0,0 +1 @@
+TESTPROGS += z-names/index
@@ -1,7 +1,10 @@
 /* z-quark/quark.c */
 
 #include "unit-test.h"
+#include "z-form.h"
 #include "z-quark.h"
+#include "z-util.h"
+#include "z-virt.h"
 
 int setup_tests(void **state) {
 	quarks_init();
@@ -46,9 +49,43 @@ static int test_dedup(void *state) {
 	ok;
 }
 
+static int test_many(void *state) {
+	static quark_t q[5000];
+	char buf[32], *big;
+	quark_t qbig;
+	size_t i;
+
+	/* Enough to fill several pages and grow the index many times */
+	for (i = 0; i < N_ELEMENTS(q); i++) {
+		strnfmt(buf, sizeof(buf), "2-%lu", (unsigned long) i);
+		q[i] = quark_add(buf);
+	}
+	for (i = 0; i < N_ELEMENTS(q); i++) {
+		strnfmt(buf, sizeof(buf), "2-%lu", (unsigned long) i);
+		eq(quark_add(buf), q[i]);
+		require(streq(quark_str(q[i]), buf));
+	}
+
+	/* A string longer than a page */
+	big = mem_zalloc(10000);
+	memset(big, 'x', 9999);
+	qbig = quark_add(big);
+	require(streq(quark_str(qbig), big));
+	eq(quark_add(big), qbig);
+	require(streq(quark_str(q[N_ELEMENTS(q) - 1]), buf));
+	mem_free(big);
+
+	/* Earlier quarks are unharmed */
+	require(streq(quark_str(quark_add("0-foo")), "0-foo"));
+	require(quark_str(qbig + 1) == NULL);
+
+	ok;
+}
+
 const char *suite_name = "z-quark/quark";
 struct test tests[] = {
 	{ "alloc", test_alloc },
 	{ "dedup", test_dedup },
+	{ "many", test_many },
 	{ NULL, NULL }
 };
@@ -0,0 +1,206 @@
+/* z-rand/damroll.c */
+
+#include "unit-test.h"
+#include "z-rand.h"
+#include <math.h>
+#include <time.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+NOSETUP
+
+int teardown_tests(void *state) {
+	damroll_distributions_free();
+	return 0;
+}
+
+/* Upper 0.1% point of the chi-squared distribution */
+#define CHI2_20_DF	45.31
+
+static int test_exact(void *state)
+{
+	const struct damroll_distribution *d = damroll_distribution(2, 6);
+	int k;
+
+	require(d);
+	eq(d->min, 2);
+	eq(d->max, 12);
+	require(fabs(d->mean - 7.0) < 1e-12);
+	for (k = 0; k <= 10; k++) {
+		int ways = k < 6 ? k + 1 : 11 - k;
+
+		require(fabs(d->chance[k] - ways / 36.0) < 1e-12);
+	}
+
+	/* The same one comes back */
+	ptreq(damroll_distribution(2, 6), d);
+	ok;
+}
+
+static int test_large(void *state)
+{
+	const struct damroll_distribution *d = damroll_distribution(40, 8);
+	double sum = 0.0, mean = 0.0;
+	int k;
+
+	require(d);
+	eq(d->min, 40);
+	eq(d->max, 320);
+	for (k = 0; k <= d->max - d->min; k++) {
+		sum += d->chance[k];
+		mean += d->chance[k] * (d->min + k);
+	}
+	require(fabs(sum - 1.0) < 1e-9);
+	require(fabs(mean - 180.0) < 1e-6);
+	require(fabs(d->mean - 180.0) < 1e-12);
+
+	/* Symmetric about the mean */
+	for (k = 0; k <= d->max - d->min; k++) {
+		require(fabs(d->chance[k] - d->chance[d->max - d->min - k]) < 1e-12);
+	}
+
+	/* Too many totals to tabulate */
+	require(!damroll_distribution(1000, 1000));
+	require(!damroll_distribution(0, 6));
+	ok;
+}
+
+/* Totals rolled from the table follow the distribution */
+static int test_roll(void *state)
+{
+	const struct damroll_distribution *d = damroll_distribution(30, 6);
+	uint32_t counts[21] = { 0 };
+	double expect[21] = { 0.0 }, chi2 = 0.0;
+	bool quick = Rand_quick;
+	int i, k, n = 100000;
+
+	/* Put the totals in 21 bins of similar chances: the tails, and the
+	 * middle by value */
+	for (k = 0; k <= d->max - d->min; k++) {
+		int bin = MIN(MAX(d->min + k - 95, 0), 20);
+
+		expect[bin] += d->chance[k] * n;
+	}
+
+	Rand_quick = false;
+	Rand_state_init(1);
+	for (i = 0; i < n; i++) {
+		int total = damroll(30, 6);
+
+		require(total >= 30 && total <= 180);
+		counts[MIN(MAX(total - 95, 0), 20)]++;
+	}
+	Rand_quick = quick;
+
+	for (k = 0; k < 21; k++) {
+		double diff = counts[k] - expect[k];
+
+		chi2 += diff * diff / expect[k];
+	}
+	require(chi2 < CHI2_20_DF);
+	ok;
+}
+
+/* Compare rolling 40d8 die by die with drawing it from the table */
+static int test_timing(void *state)
+{
+	bool quick = Rand_quick;
+	clock_t start, by_die, by_table;
+	int i, j, n = 200000;
+	long sum = 0;
+
+	Rand_quick = false;
+	Rand_state_init(2);
+	start = clock();
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < 40; j++) {
+			sum += randint1(8);
+		}
+	}
+	by_die = clock() - start;
+	start = clock();
+	for (i = 0; i < n; i++) {
+		sum -= damroll(40, 8);
+	}
+	by_table = clock() - start;
+	Rand_quick = quick;
+
+	if (verbose) {
+		printf("40d8 die by die %.1f ms, from the table %.1f ms (%ld)\n",
+			1000.0 * by_die / CLOCKS_PER_SEC,
+			1000.0 * by_table / CLOCKS_PER_SEC, sum);
+	}
+	ok;
+}
+
+#ifdef HAVE_PTHREAD
+/* Numbers of dice and sides looked up by each thread, none made yet */
+#define LOOKUP_NUM	16
+#define LOOKUP_SIDES	8
+
+static void *lookup_thread_run(void *arg)
+{
+	const struct damroll_distribution **got = arg;
+	int num, sides;
+
+	for (num = 0; num < LOOKUP_NUM; num++) {
+		for (sides = 0; sides < LOOKUP_SIDES; sides++) {
+			got[num * LOOKUP_SIDES + sides] =
+				damroll_distribution(50 + num, 10 + sides);
+		}
+	}
+	return NULL;
+}
+
+/* Threads making the same distributions at once all get the one copy */
+static int test_threads(void *state)
+{
+	const struct damroll_distribution *got[4][LOOKUP_NUM * LOOKUP_SIDES];
+	pthread_t threads[4];
+	int i, k;
+
+	for (i = 0; i < 4; i++) {
+		require(pthread_create(&threads[i], NULL, lookup_thread_run,
+			got[i]) == 0);
+	}
+	for (i = 0; i < 4; i++) {
+		require(pthread_join(threads[i], NULL) == 0);
+	}
+	for (k = 0; k < LOOKUP_NUM * LOOKUP_SIDES; k++) {
+		require(got[0][k]);
+		eq(got[0][k]->num, 50 + k / LOOKUP_SIDES);
+		eq(got[0][k]->sides, 10 + k % LOOKUP_SIDES);
+		for (i = 1; i < 4; i++) {
+			ptreq(got[i][k], got[0][k]);
+		}
+		ptreq(damroll_distribution(got[0][k]->num, got[0][k]->sides),
+			got[0][k]);
+	}
+	ok;
+}
+#endif
+
+/* With the RNG fixed, every die still gives the fixed value; there is no
+ * unfixing it, so this comes last */
+static int test_fixed(void *state)
+{
+	rand_fix(50);
+	eq(damroll(DAMROLL_TABLE_DICE * 2, 6), DAMROLL_TABLE_DICE * 2 * 3);
+	rand_fix(100);
+	eq(damroll(DAMROLL_TABLE_DICE * 2, 6), DAMROLL_TABLE_DICE * 2 * 6);
+	ok;
+}
+
+const char *suite_name = "z-rand/damroll";
+struct test tests[] = {
+	{ "exact", test_exact },
+	{ "large", test_large },
+	{ "roll", test_roll },
+	{ "timing", test_timing },
+#ifdef HAVE_PTHREAD
+	{ "threads", test_threads },
+#endif
+	{ "fixed", test_fixed },
+	{ NULL, NULL }
+};
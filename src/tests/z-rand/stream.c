@@ -0,0 +1,276 @@
+/* z-rand/stream.c */
+
+#include "unit-test.h"
+#include "z-rand.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+NOSETUP
+NOTEARDOWN
+
+/* Upper 0.1% points of the chi-squared distribution */
+#define CHI2_9_DF	27.88
+#define CHI2_63_DF	103.44
+
+static double chi2(const uint32_t *counts, int cells, int total)
+{
+	double expect = (double) total / cells, sum = 0.0;
+	int i;
+
+	for (i = 0; i < cells; i++) {
+		double d = counts[i] - expect;
+
+		sum += d * d / expect;
+	}
+	return sum;
+}
+
+static int test_seed(void *state)
+{
+	struct rand_stream a, b, c;
+	int i, same = 0;
+
+	rand_stream_seed(&a, 12345);
+	rand_stream_seed(&b, 12345);
+	rand_stream_seed(&c, 12346);
+	for (i = 0; i < 1000; i++) {
+		uint32_t v = rand_stream_next(&a), w = rand_stream_next(&b);
+
+		eq(v, w);
+		if (v == rand_stream_next(&c)) same++;
+	}
+	require(same < 5);
+	ok;
+}
+
+static int test_game_untouched(void *state)
+{
+	struct rand_stream a, saved;
+	int i;
+
+	Rand_state_init(99);
+	saved = Rand_game;
+	rand_stream_seed(&a, 7);
+	for (i = 0; i < 1000; i++) {
+		(void) rand_stream_div(&a, 100);
+	}
+	require(!memcmp(&saved, &Rand_game, sizeof(saved)));
+	ok;
+}
+
+static int test_use(void *state)
+{
+	struct rand_stream a, copy, game;
+	bool quick = Rand_quick;
+	int i;
+
+	Rand_quick = false;
+	Rand_state_init(3);
+	game = Rand_game;
+	rand_stream_seed(&a, 42);
+	copy = a;
+
+	/* The usual functions draw from the current stream */
+	ptreq(Rand_use(&a), &Rand_game);
+	for (i = 0; i < 500; i++) {
+		int32_t v = randint0(1000);
+
+		eq(v, (int32_t) rand_stream_div(&copy, 1000));
+	}
+	require(!memcmp(&game, &Rand_game, sizeof(game)));
+
+	/* And from the game's own once it is back */
+	ptreq(Rand_use(NULL), &a);
+	for (i = 0; i < 500; i++) {
+		int32_t v = randint0(1000);
+
+		eq(v, (int32_t) rand_stream_div(&game, 1000));
+	}
+	Rand_quick = quick;
+	ok;
+}
+
+static int test_split(void *state)
+{
+	struct rand_stream a, b, c1, c2, d;
+	uint32_t counts[64] = { 0 };
+	int i, n = 64000, same = 0;
+
+	/* Splitting the same state gives the same child */
+	rand_stream_seed(&a, 2718);
+	rand_stream_seed(&b, 2718);
+	rand_stream_split(&a, &c1);
+	rand_stream_split(&b, &c2);
+	require(!memcmp(&a, &b, sizeof(a)));
+	require(!memcmp(&c1, &c2, sizeof(c1)));
+
+	/* A second split gives another child */
+	rand_stream_split(&a, &d);
+	for (i = 0; i < 1000; i++) {
+		if (rand_stream_next(&c1) == rand_stream_next(&d)) same++;
+	}
+	require(same < 5);
+
+	/* Parent and child draw independently of each other */
+	for (i = 0; i < n; i++) {
+		uint32_t x = rand_stream_div(&a, 8);
+		uint32_t y = rand_stream_div(&c2, 8);
+
+		counts[x * 8 + y]++;
+	}
+	require(chi2(counts, 64, n) < CHI2_63_DF);
+	ok;
+}
+
+static int test_uniform(void *state)
+{
+	struct rand_stream a;
+	uint32_t counts[10] = { 0 }, bits[32] = { 0 };
+	int i, j, n = 100000;
+
+	rand_stream_seed(&a, 31337);
+	for (i = 0; i < n; i++) {
+		counts[rand_stream_div(&a, 10)]++;
+	}
+	require(chi2(counts, 10, n) < CHI2_9_DF);
+
+	/* Every bit of the raw numbers is set half the time, give or take six
+	 * standard deviations */
+	for (i = 0; i < n; i++) {
+		uint32_t v = rand_stream_next(&a);
+
+		for (j = 0; j < 32; j++) {
+			if (v & (1U << j)) bits[j]++;
+		}
+	}
+	for (j = 0; j < 32; j++) {
+		require(bits[j] > 50000 - 950 && bits[j] < 50000 + 950);
+	}
+	ok;
+}
+
+/* Rand_fill() gets the same as calling Rand_div() over and over */
+static int test_fill(void *state)
+{
+	uint32_t out[300], m[] = { 1, 2, 6, 1000, 0x10000000 };
+	bool quick = Rand_quick;
+	int i, k, pass;
+
+	for (pass = 0; pass < 2; pass++) {
+		Rand_quick = pass == 0;
+		for (k = 0; k < (int) N_ELEMENTS(m); k++) {
+			struct rand_stream saved;
+			uint32_t value;
+
+			Rand_value = 555;
+			Rand_state_init(555);
+			saved = Rand_game;
+			value = Rand_value;
+			Rand_fill(m[k], out, N_ELEMENTS(out));
+			Rand_game = saved;
+			Rand_value = value;
+			for (i = 0; i < (int) N_ELEMENTS(out); i++) {
+				uint32_t v = Rand_div(m[k]);
+
+				eq(out[i], v);
+			}
+		}
+	}
+	Rand_quick = quick;
+	ok;
+}
+
+/* damroll() draws one number per die, as it always did, for a few dice */
+static int test_damroll(void *state)
+{
+	bool quick = Rand_quick;
+	int num, sum, i;
+
+	Rand_quick = false;
+	for (num = 0; num < DAMROLL_TABLE_DICE; num += 3) {
+		struct rand_stream saved;
+
+		Rand_state_init(num);
+		saved = Rand_game;
+		sum = damroll(num, 6);
+		Rand_game = saved;
+		for (i = 0; i < num; i++) {
+			sum -= randint1(6);
+		}
+		eq(sum, 0);
+	}
+	Rand_quick = quick;
+	ok;
+}
+
+#ifdef HAVE_PTHREAD
+struct use_thread {
+	struct rand_stream own;
+	struct rand_stream *before;
+	int32_t v[100];
+};
+
+static void *use_thread_run(void *arg)
+{
+	struct use_thread *t = arg;
+	int i;
+
+	t->before = Rand_use(&t->own);
+	for (i = 0; i < 100; i++) {
+		t->v[i] = randint0(1000);
+	}
+	(void) Rand_use(NULL);
+	return NULL;
+}
+
+/* Rand_use() in one thread leaves the stream of another alone */
+static int test_use_thread(void *state)
+{
+	struct rand_stream a, copy, own;
+	struct use_thread t;
+	pthread_t thread;
+	bool quick = Rand_quick;
+	int i;
+
+	Rand_quick = false;
+	rand_stream_seed(&a, 42);
+	copy = a;
+	rand_stream_seed(&t.own, 43);
+	own = t.own;
+	ptreq(Rand_use(&a), &Rand_game);
+	require(pthread_create(&thread, NULL, use_thread_run, &t) == 0);
+	for (i = 0; i < 100; i++) {
+		int32_t v = randint0(1000);
+
+		eq(v, (int32_t) rand_stream_div(&copy, 1000));
+	}
+	require(pthread_join(thread, NULL) == 0);
+
+	/* The new thread started on the game's stream, and drew from its own */
+	ptreq(t.before, &Rand_game);
+	for (i = 0; i < 100; i++) {
+		eq(t.v[i], (int32_t) rand_stream_div(&own, 1000));
+	}
+
+	/* Its Rand_use(NULL) did not touch this thread's current stream */
+	ptreq(Rand_use(NULL), &a);
+	Rand_quick = quick;
+	ok;
+}
+#endif
+
+const char *suite_name = "z-rand/stream";
+struct test tests[] = {
+	{ "seed", test_seed },
+	{ "game-untouched", test_game_untouched },
+	{ "use", test_use },
+	{ "split", test_split },
+	{ "uniform", test_uniform },
+	{ "fill", test_fill },
+	{ "damroll", test_damroll },
+#ifdef HAVE_PTHREAD
+	{ "use-thread", test_use_thread },
+#endif
+	{ NULL, NULL }
+};
@@ -0,0 +1,3 @@
+TESTPROGS += \
+	z-rand/damroll \
+	z-rand/stream
@@ -141,7 +141,7 @@ void square_free_trap(struct chunk *c, struct loc grid)
 bool square_remove_trap(struct chunk *c, struct loc grid, struct trap *trap,
 		bool memorize)
 {
-	struct trap *cursor = square(c, grid)->trap;
+	struct trap *cursor = square(c, grid).trap;
 	struct trap *prev_trap = NULL;
 	bool removed = false;
 
@@ -158,7 +158,7 @@ bool square_remove_trap(struct chunk *c, struct loc grid, struct trap *trap,
 				square_set_trap(c, grid, next_trap);
 				if (!next_trap) {
 					/* There are no more traps here. */
-					sqinfo_off(square(c, grid)->info,
+					sqinfo_off(square(c, grid).info,
 						SQUARE_TRAP);
 				}
 			}
@@ -183,7 +183,7 @@ bool square_remove_trap(struct chunk *c, struct loc grid, struct trap *trap,
  */
 bool square_remove_all_traps(struct chunk *c, struct loc grid)
 {
-	struct trap *trap = square(c, grid)->trap;
+	struct trap *trap = square(c, grid).trap;
 	struct trap_kind *rune = lookup_trap("glyph of warding");
 	bool were_there_traps = trap == NULL ? false : true;
 
@@ -198,7 +198,7 @@ bool square_remove_all_traps(struct chunk *c, struct loc grid)
 	}
 
 	square_set_trap(c, grid, NULL);
-	sqinfo_off(square(c, grid)->info, SQUARE_TRAP);
+	sqinfo_off(square(c, grid).info, SQUARE_TRAP);
 
 	/* Refresh grids that the character can see */
 	if (square_isseen(c, grid)) {
@@ -221,7 +221,7 @@ bool square_remove_all_traps_of_type(struct chunk *c, struct loc grid,
 
 	/* Look at the traps in this grid */
 	struct trap *prev_trap = NULL;
-	struct trap *trap = square(c, grid)->trap;
+	struct trap *trap = square(c, grid).trap;
 
 	while (trap) {
 		struct trap *next_trap = trap->next;
@@ -235,7 +235,7 @@ bool square_remove_all_traps_of_type(struct chunk *c, struct loc grid,
 			} else {
 				square_set_trap(c, grid, next_trap);
 				if (!next_trap) {
-					sqinfo_off(square(c, grid)->info,
+					sqinfo_off(square(c, grid).info,
 						SQUARE_TRAP);
 				}
 			}
@@ -383,7 +383,7 @@ void place_trap(struct chunk *c, struct loc grid, int t_idx, int trap_level)
 		/* Require the correct terrain */
 		if (!square_player_trap_allowed(c, grid)) return;
 
-		t_idx = pick_trap(c, square(c, grid)->feat, trap_level);
+		t_idx = pick_trap(c, square(c, grid).feat, trap_level);
 	}
 
 	/* Failure */
@@ -412,7 +412,7 @@ void place_trap(struct chunk *c, struct loc grid, int t_idx, int trap_level)
 	}
 
 	/* Toggle on the trap marker */
-	sqinfo_on(square(c, grid)->info, SQUARE_TRAP);
+	sqinfo_on(square(c, grid).info, SQUARE_TRAP);
 
 	/* Redraw the grid */
 	square_note_spot(c, grid);
@@ -484,13 +484,13 @@ bool square_reveal_trap(struct chunk *c, struct loc grid, bool always,
  */
 void square_memorize_traps(struct chunk *c, struct loc grid)
 {
-	struct trap *trap = square(c, grid)->trap;
+	struct trap *trap = square(c, grid).trap;
 	struct trap *current = NULL;
 	if (c != cave) return;
 
 	/* Clear current knowledge */
 	square_remove_all_traps(player->cave, grid);
-	sqinfo_off(square(player->cave, grid)->info, SQUARE_TRAP);
+	sqinfo_off(square(player->cave, grid).info, SQUARE_TRAP);
 
 	/* Copy all visible traps to the known cave */
 	while (trap) {
@@ -502,15 +502,15 @@ void square_memorize_traps(struct chunk *c, struct loc grid)
 				current = next;
 			} else {
 				current = mem_zalloc(sizeof(*current));
-				player->cave->squares[grid.y][grid.x].trap = current;
+				player->cave->sq_trap[square_idx(player->cave, grid)] = current;
 			}
 			memcpy(current, trap, sizeof(*trap));
 			current->next = NULL;
 		}
 		trap = trap->next;
 	}
-	if (square(player->cave, grid)->trap) {
-		sqinfo_on(square(player->cave, grid)->info, SQUARE_TRAP);
+	if (square(player->cave, grid).trap) {
+		sqinfo_on(square(player->cave, grid).info, SQUARE_TRAP);
 	}
 }
 
@@ -658,7 +658,7 @@ bool square_set_trap_timeout(struct chunk *c, struct loc grid, bool domsg,
 	assert(square_in_bounds(c, grid));
 
 	/* Look at the traps in this grid */
-	current_trap = square(c, grid)->trap;
+	current_trap = square(c, grid).trap;
 	while (current_trap) {
 		/* Get the next trap (may be NULL) */
 		struct trap *next_trap = current_trap->next;
@@ -672,6 +672,7 @@ bool square_set_trap_timeout(struct chunk *c, struct loc grid, bool domsg,
 
 		/* Set the timer */
 		current_trap->timeout = time;
+		if (time) c->timed_traps++;
 		disabled = true;
 
 		/* Message if requested */
@@ -699,7 +700,7 @@ bool square_set_trap_timeout(struct chunk *c, struct loc grid, bool domsg,
  */
 int square_trap_timeout(struct chunk *c, struct loc grid, int t_idx)
 {
-	struct trap *current_trap = square(c, grid)->trap;
+	struct trap *current_trap = square(c, grid).trap;
 	while (current_trap) {
 		/* Get the next trap (may be NULL) */
 		struct trap *next_trap = current_trap->next;
@@ -440,7 +440,7 @@ int context_menu_cave(struct chunk *c, int y, int x, int adjacent, int mx,
 	cmdkey = (mode == KEYMAP_MODE_ORIG) ? 'l' : 'x';
 	menu_dynamic_add_label(m, "Look At", cmdkey, MENU_VALUE_LOOK, labels);
 
-	if (square(c, grid)->mon)
+	if (square(c, grid).mon)
 		/* '/' is used for recall in both keymaps. */
 		menu_dynamic_add_label(m, "Recall Info", '/', MENU_VALUE_RECALL,
 							   labels);
@@ -452,7 +452,7 @@ int context_menu_cave(struct chunk *c, int y, int x, int adjacent, int mx,
 
 	if (adjacent) {
 		struct object *obj = chest_check(player, grid, CHEST_ANY);
-		ADD_LABEL((square(c, grid)->mon) ? "Attack" : "Alter", CMD_ALTER,
+		ADD_LABEL((square(c, grid).mon) ? "Attack" : "Alter", CMD_ALTER,
 				  MN_ROW_VALID);
 
 		if (obj && !ignore_item_ok(player, obj)) {
@@ -468,7 +468,7 @@ int context_menu_cave(struct chunk *c, int y, int x, int adjacent, int mx,
 			}
 		}
 
-		if ((square(c, grid)->mon > 0) && player_has(player, PF_STEAL)) {
+		if ((square(c, grid).mon > 0) && player_has(player, PF_STEAL)) {
 			ADD_LABEL("Steal", CMD_STEAL, MN_ROW_VALID);
 		}
 
@@ -513,7 +513,7 @@ int context_menu_cave(struct chunk *c, int y, int x, int adjacent, int mx,
 
 	if (player->timed[TMD_IMAGE]) {
 		prt("(Enter to select command, ESC to cancel) You see something strange:", 0, 0);
-	} else if (square(c, grid)->mon) {
+	} else if (square(c, grid).mon) {
 		char m_name[80];
 		struct monster *mon = square_monster(c, grid);
 
@@ -1359,6 +1359,14 @@ static void trace_map_updates(game_event_type type, game_event_data *data,
 }
 #endif
 
+/**
+ * Map grids are drawn into the terminals as they change, but the screen is
+ * only refreshed once a frame:  when the game asks for a refresh, after
+ * animating, and once a player turn otherwise
+ */
+static bool map_dirty = false;
+static struct map_frame_counter map_frame;
+
 /**
  * Update either a single map grid or a whole map
  */
@@ -1422,18 +1430,66 @@ static void update_maps(game_event_type type, game_event_data *data, void *user)
 			Term_big_queue_char(t, vx, vy, clipy, a, c, COLOUR_WHITE, L' ');
 	}
 
-	/* Refresh the main screen unless the map needs to center */
-	if (player->upkeep->update & (PU_PANEL) && OPT(player, center_player)) {
-		int hgt = (t == angband_term[0]) ? SCREEN_HGT / 2 :
-			t->hgt / (tile_height * 2);
-		int wid = (t == angband_term[0]) ? SCREEN_WID / 2 :
-			t->wid / (tile_width * 2);
+	/* Show it with the rest of the frame */
+	map_frame.points++;
+	map_dirty = true;
+}
 
-		if (panel_should_modify(t, player->grid.y - hgt, player->grid.x - wid))
-			return;
+/**
+ * Whether the main map is about to move to centre on the player, in which case
+ * it is not worth showing as it is
+ */
+static bool map_needs_centring(void)
+{
+	if (player->upkeep->update & (PU_PANEL) && OPT(player, center_player)) {
+		return panel_should_modify(angband_term[0],
+			player->grid.y - SCREEN_HGT / 2,
+			player->grid.x - SCREEN_WID / 2);
 	}
+	return false;
+}
+
+/**
+ * Refresh the screen, ending a frame
+ */
+static void map_frame_fresh(void)
+{
+	clock_t start = clock();
 
 	Term_fresh();
+	if (map_dirty) {
+		map_frame.frames++;
+		map_frame.ticks += clock() - start;
+		map_dirty = false;
+	}
+}
+
+/**
+ * Show map changes made since the last frame, unless the map is about to move
+ */
+static void map_frame_end(void)
+{
+	if (map_dirty && !map_needs_centring())
+		map_frame_fresh();
+}
+
+/**
+ * Show the map once per player turn while running or resting, when the
+ * screen is not otherwise refreshed
+ */
+static void check_map_frame(game_event_type type, game_event_data *data,
+		void *user)
+{
+	map_frame_end();
+}
+
+/**
+ * How many map grids have been redrawn, and how many refreshes and how much
+ * processor time it took to show them
+ */
+const struct map_frame_counter *map_frame_counter(void)
+{
+	return &map_frame;
 }
 
 /**
@@ -1510,6 +1566,7 @@ void disallow_animations(void)
 static void animate(game_event_type type, game_event_data *data, void *user)
 {
 	do_animation();
+	map_frame_end();
 }
 
 /**
@@ -2512,7 +2569,7 @@ static void refresh(game_event_type type, game_event_data *data, void *user)
 		move_cursor_relative(target.y, target.x);
 	}
 
-	Term_fresh();
+	map_frame_fresh();
 }
 
 static void repeated_command_display(game_event_type type,
@@ -2563,9 +2620,9 @@ static void new_level_display_update(game_event_type type,
 	 * set for a few game turns, manually force an update on level change. */
 	monster_list_force_subwindow_update();
 
-	/* If autosave is pending, do it now. */
+	/* If autosave is pending, do it now, without waiting for the disk. */
 	if (player->upkeep->autosave) {
-		save_game();
+		save_game_in_background();
 		player->upkeep->autosave = false;
 	}
 
@@ -2596,6 +2653,15 @@ static void cheat_death(game_event_type type, game_event_data *data, void *user)
 	wiz_cheat_death();
 }
 
+static void savefile_done(game_event_type type, game_event_data *data,
+		void *user)
+{
+	if (!data->flag) {
+		msg("Saving game... failed!");
+		event_signal(EVENT_MESSAGE_FLUSH);
+	}
+}
+
 static void check_panel(game_event_type type, game_event_data *data, void *user)
 {
 	verify_panel();
@@ -2791,6 +2857,9 @@ static void ui_enter_world(game_event_type type, game_event_data *data,
 	/* Check to see if the player has tried to cancel game processing */
 	event_add_handler(EVENT_CHECK_INTERRUPT, check_for_player_interrupt, NULL);
 
+	/* Show the map as it is before that (handlers run newest first) */
+	event_add_handler(EVENT_CHECK_INTERRUPT, check_map_frame, NULL);
+
 	/* Refresh the screen and put the cursor in the appropriate place */
 	event_add_handler(EVENT_REFRESH, refresh, NULL);
 
@@ -2806,6 +2875,9 @@ static void ui_enter_world(game_event_type type, game_event_data *data,
 	/* Allow the player to cheat death, if appropriate */
 	event_add_handler(EVENT_CHEAT_DEATH, cheat_death, NULL);
 
+	/* Say if a save in the background didn't work */
+	event_add_handler(EVENT_SAVEFILE_DONE, savefile_done, NULL);
+
 	/* Hack -- Decrease "icky" depth */
 	screen_save_depth--;
 }
@@ -2855,6 +2927,7 @@ static void ui_leave_world(game_event_type type, game_event_data *data,
 
 	/* Check to see if the player has tried to cancel game processing */
 	event_remove_handler(EVENT_CHECK_INTERRUPT, check_for_player_interrupt, NULL);
+	event_remove_handler(EVENT_CHECK_INTERRUPT, check_map_frame, NULL);
 
 	/* Refresh the screen and put the cursor in the appropriate place */
 	event_remove_handler(EVENT_REFRESH, refresh, NULL);
@@ -2871,6 +2944,9 @@ static void ui_leave_world(game_event_type type, game_event_data *data,
 	/* Allow the player to cheat death, if appropriate */
 	event_remove_handler(EVENT_CHEAT_DEATH, cheat_death, NULL);
 
+	/* Say if a save in the background didn't work */
+	event_remove_handler(EVENT_SAVEFILE_DONE, savefile_done, NULL);
+
 	/* Prepare to interact with a store */
 	event_add_handler(EVENT_USE_STORE, use_store, NULL);
 
@@ -27,11 +27,21 @@ extern const char *stat_names[STAT_MAX];
 extern const char *stat_names_reduced[STAT_MAX];
 extern const char *window_flag_desc[32];
 
+/**
+ * Map grids redrawn, and the screen refreshes which showed them
+ */
+struct map_frame_counter {
+	uint32_t points;	/* Grids drawn for EVENT_MAP */
+	uint32_t frames;	/* Refreshes with map grids to show */
+	clock_t ticks;		/* Processor time spent in those refreshes */
+};
+
 uint8_t monster_health_attr(void);
 void cnv_stat(int val, char *out_val, size_t out_len);
 void allow_animations(void);
 void disallow_animations(void);
 void idle_update(void);
+const struct map_frame_counter *map_frame_counter(void);
 void toggle_inven_equip(void);
 void subwindows_set_flags(uint32_t *new_flags, size_t n_subwindows);
 void init_display(void);
@@ -993,50 +993,42 @@ void save_game(void)
 }
 
 /**
- * Save the game.
+ * Save the player, then the window prefs and monster memory that go with
+ * them, either now or in the background.
  *
- * \return whether the save was successful.
+ * \param background is whether the savefile is written out while play goes
+ * on, with EVENT_SAVEFILE_DONE saying how it went.
+ * \return whether the save was successful, always true in the background.
  */
-bool save_game_checked(void)
+static bool save_game_files(bool background)
 {
 	char path[1024];
-	bool result;
-
-	/* Disturb the player */
-	disturb(player);
-
-	/* Clear messages */
-	event_signal(EVENT_MESSAGE_FLUSH);
-
-	/* Handle stuff */
-	handle_stuff(player);
-
-	/* Message */
-	prt("Saving game...", 0, 0);
-
-	/* Refresh */
-	Term_fresh();
+	bool result = true;
 
 	/* The player is not dead */
 	my_strcpy(player->died_from, "(saved)", sizeof(player->died_from));
 
-	/* Forbid suspend */
-	signals_ignore_tstp();
-
-	/* Save the player */
-	if (savefile_save(savefile)) {
-		prt("Saving game... done.", 0, 0);
-		result = true;
+	if (background) {
+		/* Save the player; play goes on while it is written out */
+		savefile_save_async(savefile);
 	} else {
-		prt("Saving game... failed!", 0, 0);
-		result = false;
-	}
+		/* Forbid suspend */
+		signals_ignore_tstp();
 
-	/* Refresh */
-	Term_fresh();
+		/* Save the player */
+		if (savefile_save(savefile)) {
+			prt("Saving game... done.", 0, 0);
+		} else {
+			prt("Saving game... failed!", 0, 0);
+			result = false;
+		}
 
-	/* Allow suspend again */
-	signals_handle_tstp();
+		/* Refresh */
+		Term_fresh();
+
+		/* Allow suspend again */
+		signals_handle_tstp();
+	}
 
 	/* Save the window prefs */
 	path_build(path, sizeof(path), ANGBAND_DIR_USER, "window.prf");
@@ -1061,6 +1053,44 @@ bool save_game_checked(void)
 	return result;
 }
 
+/**
+ * Save the game.
+ *
+ * \return whether the save was successful.
+ */
+bool save_game_checked(void)
+{
+	/* Disturb the player */
+	disturb(player);
+
+	/* Clear messages */
+	event_signal(EVENT_MESSAGE_FLUSH);
+
+	/* Handle stuff */
+	handle_stuff(player);
+
+	/* Message */
+	prt("Saving game...", 0, 0);
+
+	/* Refresh */
+	Term_fresh();
+
+	return save_game_files(false);
+}
+
+
+/**
+ * Save the game without waiting for it to reach the disk, as for autosaves;
+ * EVENT_SAVEFILE_DONE says how it went.
+ */
+void save_game_in_background(void)
+{
+	/* Handle stuff */
+	handle_stuff(player);
+
+	(void) save_game_files(true);
+}
+
 
 /**
  * Close up the current game (player may or may not be dead).
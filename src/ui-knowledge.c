@@ -1515,6 +1515,9 @@ static struct object *find_artifact(struct artifact *artifact)
 		int j;
 		if (strstr(c->name, "known")) continue;
 
+		/* Packed levels aren't searched; the lore makes do without */
+		if (c->packed) continue;
+
 		/* Ground objects */
 		for (y = 1; y < c->height; y++) {
 			for (x = 1; x < c->width; x++) {
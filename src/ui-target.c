@@ -347,7 +347,7 @@ static ui_event target_recall_loop_object(struct object *obj, int y, int x,
 			if (p->wizard) {
 				strnfmt(out_val, TARGET_OUT_VAL_SIZE,
 						"%s%s%s%s, %s (%d:%d, noise=%d, scent=%d).", s1, s2, s3,
-						o_name, coords, y, x, (int)cave->noise.grids[y][x],
+						o_name, coords, y, x, heatmap_get(cave->noise, loc(x, y)),
 						(int)cave->scent.grids[y][x]);
 			} else {
 				strnfmt(out_val, TARGET_OUT_VAL_SIZE,
@@ -391,7 +391,7 @@ static bool aux_reinit(struct chunk *c, struct player *p,
 	/* Assume boring. */
 	auxst->boring = true;
 
-	if (square(c, auxst->grid)->mon < 0) {
+	if (square(c, auxst->grid).mon < 0) {
 		/* Looking at the player's grid */
 		auxst->phrase1 = "You are ";
 		auxst->phrase2 = "on ";
@@ -436,7 +436,7 @@ static bool aux_hallucinate(struct chunk *c, struct player *p,
 			auxst->coord_desc,
 			auxst->grid.y,
 			auxst->grid.x,
-			(int)c->noise.grids[auxst->grid.y][auxst->grid.x],
+			heatmap_get(c->noise, auxst->grid),
 			(int)c->scent.grids[auxst->grid.y][auxst->grid.x]);
 	} else {
 		strnfmt(out_val, sizeof(out_val), "%s%s%s, %s.",
@@ -469,7 +469,7 @@ static bool aux_monster(struct chunk *c, struct player *p,
 	char out_val[TARGET_OUT_VAL_SIZE];
 	bool recall;
 
-	if (square(c, auxst->grid)->mon <= 0) return false;
+	if (square(c, auxst->grid).mon <= 0) return false;
 
 	mon = square_monster(c, auxst->grid);
 	if (!monster_is_obvious(mon)) return false;
@@ -500,7 +500,7 @@ static bool aux_monster(struct chunk *c, struct player *p,
 
 			/* Describe the monster */
 			look_mon_desc(buf, sizeof(buf),
-				square(c, auxst->grid)->mon);
+				square(c, auxst->grid).mon);
 
 			/* Describe, and prompt for recall */
 			if (p->wizard) {
@@ -513,7 +513,7 @@ static bool aux_monster(struct chunk *c, struct player *p,
 					auxst->coord_desc,
 					auxst->grid.y,
 					auxst->grid.x,
-					(int)c->noise.grids[auxst->grid.y][auxst->grid.x],
+					heatmap_get(c->noise, auxst->grid),
 					(int)c->scent.grids[auxst->grid.y][auxst->grid.x]);
 			} else {
 				strnfmt(out_val, sizeof(out_val),
@@ -599,7 +599,7 @@ static bool aux_monster(struct chunk *c, struct player *p,
 				auxst->coord_desc,
 				auxst->grid.y,
 				auxst->grid.x,
-				(int)c->noise.grids[auxst->grid.y][auxst->grid.x],
+				heatmap_get(c->noise, auxst->grid),
 				(int)c->scent.grids[auxst->grid.y][auxst->grid.x]);
 
 			prt(out_val, 0, 0);
@@ -650,7 +650,7 @@ static bool aux_trap(struct chunk *c, struct player *p,
 	if (!square_isvisibletrap(p->cave, auxst->grid)) return false;
 
 	/* A trap */
-	trap = square(p->cave, auxst->grid)->trap;
+	trap = square(p->cave, auxst->grid).trap;
 
 	/* Not boring */
 	auxst->boring = false;
@@ -671,7 +671,7 @@ static bool aux_trap(struct chunk *c, struct player *p,
 				auxst->coord_desc,
 				auxst->grid.y,
 				auxst->grid.x,
-				(int)c->noise.grids[auxst->grid.y][auxst->grid.x],
+				heatmap_get(c->noise, auxst->grid),
 				(int)c->scent.grids[auxst->grid.y][auxst->grid.x]);
 		} else {
 			strnfmt(out_val, sizeof(out_val), "%s%s%s%s, %s.",
@@ -743,7 +743,7 @@ static bool aux_object(struct chunk *c, struct player *p,
 					auxst->coord_desc,
 					auxst->grid.y,
 					auxst->grid.x,
-					(int)c->noise.grids[auxst->grid.y][auxst->grid.x],
+					heatmap_get(c->noise, auxst->grid),
 					(int)c->scent.grids[auxst->grid.y][auxst->grid.x]);
 			} else {
 				strnfmt(out_val, sizeof(out_val),
@@ -869,7 +869,7 @@ static bool aux_terrain(struct chunk *c, struct player *p,
 			auxst->coord_desc,
 			auxst->grid.y,
 			auxst->grid.x,
-			(int)c->noise.grids[auxst->grid.y][auxst->grid.x],
+			heatmap_get(c->noise, auxst->grid),
 			(int)c->scent.grids[auxst->grid.y][auxst->grid.x]);
 	} else {
 		strnfmt(out_val, sizeof(out_val),
@@ -439,6 +439,8 @@ void visuals_cycler_set_cycle_for_race(struct monster_race const *race,
 		size_t new_count = old_count + visuals_color_cycles_by_race->alloc_size;
 		size_t new_size = new_count * sizeof(*(visuals_color_cycles_by_race->race));
 		visuals_color_cycles_by_race->race = mem_realloc(visuals_color_cycles_by_race->race, new_size);
+		memset(visuals_color_cycles_by_race->race + old_count, 0,
+			(new_count - old_count) * sizeof(*(visuals_color_cycles_by_race->race)));
 		visuals_color_cycles_by_race->max_entries = new_count;
 
 		if (new_count >= 10000) {
@@ -488,6 +490,60 @@ uint8_t visuals_cycler_get_attr_for_race(struct monster_race const *race,
 	return visuals_color_cycle_attr_for_frame(cycle, frame);
 }
 
+/**
+ * Get the number of monster race indexes the race to color cycle table has
+ * room for; every index from there on has no color cycle.
+ */
+size_t visuals_cycler_race_entries(void)
+{
+	if (visuals_color_cycles_by_race == NULL) {
+		return 0;
+	}
+
+	return visuals_color_cycles_by_race->max_entries;
+}
+
+/**
+ * Get the color cycle set for a monster race index, by the names that
+ * visuals_cycler_set_cycle_for_race() takes.
+ *
+ * \param ridx The index of the race.
+ * \param group_name Is set to the group of the color cycle.
+ * \param cycle_name Is set to the name of the color cycle.
+ * \return true if the race has a color cycle, false if not.
+ */
+bool visuals_cycler_get_cycle_for_race(size_t ridx, const char **group_name,
+									   const char **cycle_name)
+{
+	struct visuals_cycler *table = visuals_cycler_table;
+	struct visuals_color_cycle *cycle;
+	size_t i, j;
+
+	if (ridx >= visuals_cycler_race_entries()) {
+		return false;
+	}
+
+	cycle = visuals_color_cycles_by_race->race[ridx];
+
+	if (cycle == NULL || table == NULL) {
+		return false;
+	}
+
+	for (i = 0; i < table->max_groups; i++) {
+		struct visuals_cycle_group *group = table->groups[i];
+
+		for (j = 0; j < group->max_cycles; j++) {
+			if (group->cycles[j] == cycle) {
+				*group_name = group->group_name;
+				*cycle_name = cycle->cycle_name;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 /* ----- Legacy Flicker Cycling ----- */
 
 /**
@@ -29,6 +29,9 @@ void visuals_cycler_set_cycle_for_race(struct monster_race const *race,
 									   const char *cycle_name);
 uint8_t visuals_cycler_get_attr_for_race(struct monster_race const *race,
 									  size_t const frame);
+size_t visuals_cycler_race_entries(void);
+bool visuals_cycler_get_cycle_for_race(size_t ridx, const char **group_name,
+									   const char **cycle_name);
 uint8_t visuals_flicker_get_attr_for_frame(uint8_t const selection_attr,
 										size_t const frame);
 
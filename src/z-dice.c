@@ -19,6 +19,7 @@
 #include "z-dice.h"
 #include "z-virt.h"
 #include "z-util.h"
+#include "z-form.h"
 #include "z-rand.h"
 #include "z-expression.h"
 
@@ -31,6 +32,10 @@ struct dice_s {
 	int b, x, y, m;
 	bool ex_b, ex_x, ex_y, ex_m;
 	dice_expression_entry_t *expressions;
+
+	/* Compiled by dice_compile() */
+	random_value fixed;		/* The parts given as numbers, others zero */
+	const expression_t *source[4];	/* The bound expressions for the rest */
 };
 
 /**
@@ -69,12 +74,6 @@ typedef enum dice_input_e {
 	DICE_INPUT_MAX,
 } dice_input_t;
 
-/**
- * Hard limit on the number of variables/expressions. Shouldn't need more than
- * the possible values.
- */
-#define DICE_MAX_EXPRESSIONS 4
-
 /**
  * Max size for a token/number to be parsed. Longer strings will be truncated.
  */
@@ -172,6 +171,9 @@ static void dice_reset(dice_t *dice)
 	dice->ex_y = false;
 	dice->ex_m = false;
 
+	memset(&dice->fixed, 0, sizeof(dice->fixed));
+	memset(dice->source, 0, sizeof(dice->source));
+
 	if (dice->expressions == NULL)
 		return;
 
@@ -188,6 +190,35 @@ static void dice_reset(dice_t *dice)
 	}
 }
 
+/**
+ * Get the expression bound to a part of the dice, if the part is a variable.
+ */
+static const expression_t *dice_source(const dice_t *dice, bool variable,
+		int index)
+{
+	if (!variable || dice->expressions == NULL || index < 0)
+		return NULL;
+
+	return dice->expressions[index].expression;
+}
+
+/**
+ * Work out what dice_random_value() needs, so it need not look anything up:
+ * the parts of the dice given as numbers, and the expressions for the rest.
+ */
+static void dice_compile(dice_t *dice)
+{
+	dice->fixed.base = dice->ex_b ? 0 : dice->b;
+	dice->fixed.dice = dice->ex_x ? 0 : dice->x;
+	dice->fixed.sides = dice->ex_y ? 0 : dice->y;
+	dice->fixed.m_bonus = dice->ex_m ? 0 : dice->m;
+
+	dice->source[0] = dice_source(dice, dice->ex_b, dice->b);
+	dice->source[1] = dice_source(dice, dice->ex_x, dice->x);
+	dice->source[2] = dice_source(dice, dice->ex_y, dice->y);
+	dice->source[3] = dice_source(dice, dice->ex_m, dice->m);
+}
+
 /**
  * Allocate and initialize a new dice object. Returns NULL if it was unable to
  * be created.
@@ -279,6 +310,7 @@ int dice_bind_expression(dice_t *dice, const char *name,
 
 		if (my_stricmp(name, dice->expressions[i].name) == 0) {
 			dice->expressions[i].expression = expression_copy(expression);
+			dice_compile(dice);
 
 			if (dice->expressions[i].expression == NULL)
 				return -1;
@@ -392,9 +424,11 @@ bool dice_parse_string(dice_t *dice, const char *string)
 			state = dice_parse_state_transition(state, DICE_INPUT_BONUS);
 		}
 
-		/* Illegal transition. */
-		if (state >= DICE_STATE_MAX)
+		/* Illegal transition, keeping what was parsed before it. */
+		if (state >= DICE_STATE_MAX) {
+			dice_compile(dice);
 			return false;
+		}
 
 		/*
 		 * Default flushing to true, since there are more states that don't
@@ -494,6 +528,7 @@ bool dice_parse_string(dice_t *dice, const char *string)
 		}
 	}
 
+	dice_compile(dice);
 	return true;
 }
 
@@ -508,41 +543,15 @@ void dice_random_value(const dice_t *dice, random_value *v)
 	if (v == NULL)
 		return;
 
-	if (dice->ex_b) {
-		if (dice->expressions != NULL && dice->expressions[dice->b].expression != NULL)
-			v->base = expression_evaluate(dice->expressions[dice->b].expression);
-		else
-			v->base = 0;
-	}
-	else
-		v->base = dice->b;
-
-	if (dice->ex_x) {
-		if (dice->expressions != NULL && dice->expressions[dice->x].expression != NULL)
-			v->dice = expression_evaluate(dice->expressions[dice->x].expression);
-		else
-			v->dice = 0;
-	}
-	else
-		v->dice = dice->x;
-
-	if (dice->ex_y) {
-		if (dice->expressions != NULL && dice->expressions[dice->y].expression != NULL)
-			v->sides = expression_evaluate(dice->expressions[dice->y].expression);
-		else
-			v->sides = 0;
-	}
-	else
-		v->sides = dice->y;
-
-	if (dice->ex_m) {
-		if (dice->expressions != NULL && dice->expressions[dice->m].expression != NULL)
-			v->m_bonus = expression_evaluate(dice->expressions[dice->m].expression);
-		else
-			v->m_bonus = 0;
-	}
-	else
-		v->m_bonus = dice->m;
+	*v = dice->fixed;
+	if (dice->source[0])
+		v->base = expression_evaluate(dice->source[0]);
+	if (dice->source[1])
+		v->dice = expression_evaluate(dice->source[1]);
+	if (dice->source[2])
+		v->sides = expression_evaluate(dice->source[2]);
+	if (dice->source[3])
+		v->m_bonus = expression_evaluate(dice->source[3]);
 }
 
 /**
@@ -650,3 +659,72 @@ bool dice_base_equal(const dice_t *dice1, const dice_t *dice2)
 	if (dice1->m != dice2->m) return false;
 	return true;
 }
+
+/**
+ * Write one part of a dice object for dice_format_string().
+ */
+static void dice_format_part(const dice_t *dice, bool variable, int value,
+		char *buf, size_t len)
+{
+	char number[16];
+
+	if (variable) {
+		my_strcat(buf, "$", len);
+		my_strcat(buf, dice->expressions[value].name, len);
+	} else {
+		strnfmt(number, sizeof(number), "%d", value);
+		my_strcat(buf, number, len);
+	}
+}
+
+/**
+ * Write a dice object out as a string that dice_parse_string() turns back
+ * into the same dice.
+ *
+ * Every part is written, in the form "1+2d3m4", with variables in place of
+ * the parts bound to them; the lower case bonus marker keeps it apart from a
+ * variable name before it.  Bound expressions are not part of the string;
+ * dice_get_expression() gives them.
+ *
+ * \param dice is the dice object to write.
+ * \param buf is the buffer for the string.
+ * \param len is the size of the buffer.
+ * \return true if the string fitted in the buffer, false if not.
+ */
+bool dice_format_string(const dice_t *dice, char *buf, size_t len)
+{
+	if (len == 0)
+		return false;
+
+	buf[0] = '\0';
+	dice_format_part(dice, dice->ex_b, dice->b, buf, len);
+	my_strcat(buf, "+", len);
+	dice_format_part(dice, dice->ex_x, dice->x, buf, len);
+	my_strcat(buf, "d", len);
+	dice_format_part(dice, dice->ex_y, dice->y, buf, len);
+	my_strcat(buf, "m", len);
+	dice_format_part(dice, dice->ex_m, dice->m, buf, len);
+
+	return strlen(buf) + 1 < len;
+}
+
+/**
+ * Get a variable of a dice object and the expression bound to it.
+ *
+ * \param dice is the dice object.
+ * \param index is the variable's place in the dice, from 0 to
+ * DICE_MAX_EXPRESSIONS - 1.
+ * \param name is set to the name of the variable, or NULL if there is none.
+ * \return The expression bound to the variable, or NULL if there is none.
+ */
+const expression_t *dice_get_expression(const dice_t *dice, int index,
+		const char **name)
+{
+	*name = NULL;
+	if (dice->expressions == NULL || index < 0 ||
+			index >= DICE_MAX_EXPRESSIONS)
+		return NULL;
+
+	*name = dice->expressions[index].name;
+	return dice->expressions[index].expression;
+}
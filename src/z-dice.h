@@ -24,6 +24,12 @@
 #include "z-rand.h"
 #include "z-expression.h"
 
+/**
+ * Hard limit on the number of variables/expressions. Shouldn't need more than
+ * the possible values.
+ */
+#define DICE_MAX_EXPRESSIONS 4
+
 typedef struct dice_s dice_t;
 
 dice_t *dice_new(void);
@@ -39,5 +45,8 @@ bool dice_test_values(const dice_t *dice, int base, int dice_count, int sides,
 bool dice_test_variables(const dice_t *dice, const char *base,
 		const char *dice_name, const char *sides, const char *bonus);
 bool dice_base_equal(const dice_t *dice1, const dice_t *dice2);
+bool dice_format_string(const dice_t *dice, char *buf, size_t len);
+const expression_t *dice_get_expression(const dice_t *dice, int index,
+		const char **name);
 
 #endif /* INCLUDED_Z_DICE_H */
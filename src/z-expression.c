@@ -19,17 +19,34 @@
 #include "z-expression.h"
 #include "z-virt.h"
 #include "z-util.h"
+#include "z-form.h"
 
 struct expression_operation_s {
 	uint8_t operator;
 	int16_t operand;
 };
 
+/**
+ * A run of operations folded together:  the value is multiplied by mul and
+ * has add added to it, with 32-bit wrap-around just as the operations had one
+ * at a time, then is divided by div unless that is 1.
+ */
+typedef struct expression_step_s {
+	uint32_t mul;
+	uint32_t add;
+	int32_t div;
+} expression_step_t;
+
 struct expression_s {
 	expression_base_value_f base_value;
 	size_t operation_count;
 	size_t operations_size;
 	expression_operation_t *operations;
+
+	/* What the operations come to, kept up to date by expression_compile() */
+	size_t step_count;
+	expression_step_t *steps;
+	int32_t constant;
 };
 
 /**
@@ -170,10 +187,85 @@ void expression_free(expression_t *expression)
 		mem_free(expression->operations);
 		expression->operations = NULL;
 	}
+	mem_free(expression->steps);
 
 	mem_free(expression);
 }
 
+/**
+ * Apply folded steps to a value.
+ */
+static int32_t expression_run_steps(int32_t value,
+									const expression_step_t *step,
+									size_t count)
+{
+	const expression_step_t *end = step + count;
+
+	for (; step < end; step++) {
+		value = (int32_t)((uint32_t)value * step->mul + step->add);
+		if (step->div != 1)
+			value /= step->div;
+	}
+
+	return value;
+}
+
+/**
+ * Fold the operations of an expression into as few steps as will do:  adding,
+ * subtracting, multiplying and negating all come to one multiply and one add,
+ * and only division has to be done on its own.  An expression with no base
+ * value function always comes to the same thing, so it is worked out here.
+ */
+static void expression_compile(expression_t *expression)
+{
+	expression_step_t step = { 1, 0, 1 };
+	size_t i;
+
+	mem_free(expression->steps);
+	expression->steps = mem_zalloc((expression->operation_count + 1) *
+								   sizeof(expression_step_t));
+	expression->step_count = 0;
+
+	for (i = 0; i < expression->operation_count; i++) {
+		uint32_t operand = (uint32_t)expression->operations[i].operand;
+
+		switch (expression->operations[i].operator) {
+			case OPERATOR_ADD:
+				step.add += operand;
+				break;
+			case OPERATOR_SUB:
+				step.add -= operand;
+				break;
+			case OPERATOR_MUL:
+				step.mul *= operand;
+				step.add *= operand;
+				break;
+			case OPERATOR_DIV:
+				step.div = expression->operations[i].operand;
+				expression->steps[expression->step_count++] = step;
+				step.mul = 1;
+				step.add = 0;
+				step.div = 1;
+				break;
+			case OPERATOR_NEG:
+				step.mul = 0U - step.mul;
+				step.add = 0U - step.add;
+				break;
+			default:
+				break;
+		}
+	}
+	if (step.mul != 1 || step.add != 0)
+		expression->steps[expression->step_count++] = step;
+
+	expression->constant = 0;
+	if (expression->base_value == NULL) {
+		expression->constant = expression_run_steps(0, expression->steps,
+													expression->step_count);
+		expression->step_count = 0;
+	}
+}
+
 /**
  * Return a deep copy of the given expression.
  */
@@ -206,6 +298,7 @@ expression_t *expression_copy(const expression_t *source)
 		copy->operations[i].operand = source->operations[i].operand;
 		copy->operations[i].operator = source->operations[i].operator;
 	}
+	expression_compile(copy);
 
 	return copy;
 }
@@ -217,6 +310,15 @@ void expression_set_base_value(expression_t *expression,
 							   expression_base_value_f function)
 {
 	expression->base_value = function;
+	expression_compile(expression);
+}
+
+/**
+ * Get the base value function that the operations operate on.
+ */
+expression_base_value_f expression_get_base_value(const expression_t *expression)
+{
+	return expression->base_value;
 }
 
 /**
@@ -225,35 +327,11 @@ void expression_set_base_value(expression_t *expression,
  */
 int32_t expression_evaluate(expression_t const * const expression)
 {
-	size_t i;
-	int32_t value = 0;
+	if (expression->base_value == NULL)
+		return expression->constant;
 
-	if (expression->base_value != NULL)
-		value = expression->base_value();
-
-	for (i = 0; i < expression->operation_count; i++) {
-		switch (expression->operations[i].operator) {
-			case OPERATOR_ADD:
-				value += expression->operations[i].operand;
-				break;
-			case OPERATOR_SUB:
-				value -= expression->operations[i].operand;
-				break;
-			case OPERATOR_MUL:
-				value *= expression->operations[i].operand;
-				break;
-			case OPERATOR_DIV:
-				value /= expression->operations[i].operand;
-				break;
-			case OPERATOR_NEG:
-				value = -value;
-				break;
-			default:
-				break;
-		}
-	}
-
-	return value;
+	return expression_run_steps(expression->base_value(), expression->steps,
+								expression->step_count);
 }
 
 /**
@@ -391,11 +469,54 @@ int16_t expression_add_operations_string(expression_t *expression,
 	for (i = 0; i < count; i++) {
 		expression_add_operation(expression, operations[i]);
 	}
+	expression_compile(expression);
 
 	string_free(parse_string);
 	return count;
 }
 
+/**
+ * Write the operations of an expression out as a string that
+ * expression_add_operations_string() turns back into the same operations.
+ *
+ * Each operation is written as its operator followed by its operand, so the
+ * string is in the prefix notation the parser reads, if not the shortest.
+ *
+ * \param expression is the expression to write.
+ * \param buf is the buffer for the string.
+ * \param len is the size of the buffer.
+ * \return true if the string fitted in the buffer, false if not.
+ */
+bool expression_operations_string(const expression_t *expression, char *buf,
+								  size_t len)
+{
+	static const char operator_tokens[] = { '\0', '+', '-', '*', '/', 'n' };
+	size_t i;
+
+	if (len == 0 || expression->operation_count > EXPRESSION_MAX_OPERATIONS)
+		return false;
+
+	buf[0] = '\0';
+	for (i = 0; i < expression->operation_count; i++) {
+		const expression_operation_t *operation = &expression->operations[i];
+		char token[16];
+
+		if (operation->operator == OPERATOR_NONE ||
+				operation->operator > OPERATOR_NEG)
+			return false;
+		if (operation->operator == OPERATOR_NEG) {
+			strnfmt(token, sizeof(token), "%sn", i ? " " : "");
+		} else {
+			strnfmt(token, sizeof(token), "%s%c %d", i ? " " : "",
+					operator_tokens[operation->operator], operation->operand);
+		}
+		if (my_strcat(buf, token, len) >= len)
+			return false;
+	}
+
+	return true;
+}
+
 /**
  * Test to make sure that the deep copy from expression_copy() is equal in value
  */
@@ -39,9 +39,12 @@ void expression_free(expression_t *expression);
 expression_t *expression_copy(const expression_t *source);
 void expression_set_base_value(expression_t *expression,
 							   expression_base_value_f function);
+expression_base_value_f expression_get_base_value(const expression_t *expression);
 int32_t expression_evaluate(expression_t const * const expression);
 int16_t expression_add_operations_string(expression_t *expression,
 									  const char *string);
+bool expression_operations_string(const expression_t *expression, char *buf,
+								  size_t len);
 bool expression_test_copy(const expression_t *a, const expression_t *b);
 
 #endif /* INCLUDED_Z_EXPRESSION_H */
@@ -989,6 +989,23 @@ bool file_newer(const char *first, const char *second)
 #endif /* !HAVE_STAT */
 }
 
+/**
+ * Get the size and modification time of a file.
+ */
+bool file_stamp(const char *fname, uint64_t *size, uint64_t *mtime)
+{
+#ifdef HAVE_STAT
+	struct stat st;
+
+	if (stat(fname, &st) != 0) return false;
+	*size = (uint64_t)st.st_size;
+	*mtime = (uint64_t)st.st_mtime;
+	return true;
+#else /* HAVE_STAT */
+	return false;
+#endif /* !HAVE_STAT */
+}
+
 
 
 
@@ -1113,6 +1130,22 @@ bool file_skip(ang_file *f, int bytes)
 	return (fseek(f->fh, bytes, SEEK_CUR) == 0);
 }
 
+/**
+ * Get the current position in file 'f'.
+ */
+long file_tell(ang_file *f)
+{
+	return ftell(f->fh);
+}
+
+/**
+ * Move to position 'pos' in file 'f'.
+ */
+bool file_seek(ang_file *f, long pos)
+{
+	return (fseek(f->fh, pos, SEEK_SET) == 0);
+}
+
 /**
  * Read a single, 8-bit character from file 'f'.
  */
@@ -1148,6 +1181,33 @@ int file_read(ang_file *f, char *buf, size_t n)
 		return read;
 }
 
+/**
+ * Read the rest of 'f' into a buffer allocated with mem_alloc().
+ */
+char *file_read_all(ang_file *f, size_t *len)
+{
+	size_t size = 16384, n = 0;
+	char *buf = mem_alloc(size);
+
+	while (1) {
+		int read = file_read(f, buf + n, size - n - 1);
+
+		if (read < 0) {
+			mem_free(buf);
+			return NULL;
+		}
+		if (read == 0) break;
+		n += read;
+		if (n + 1 == size) {
+			size *= 2;
+			buf = mem_realloc(buf, size);
+		}
+	}
+	buf[n] = '\0';
+	*len = n;
+	return buf;
+}
+
 /**
  * Append 'n' bytes of array 'buf' to file 'f'.
  */
@@ -1221,6 +1281,68 @@ bool file_getl(ang_file *f, char *buf, size_t len)
 	return true;
 }
 
+/**
+ * Read a line of text from the text between *pos and end, exactly as
+ * file_getl() would from a file holding it.
+ */
+bool text_getl(const char **pos, const char *end, char *buf, size_t len)
+{
+	const char *s = *pos;
+	bool seen_cr = false;
+	size_t i = 0;
+
+	/* Leave a byte for the terminating 0 */
+	size_t max_len = len - 1;
+
+	while (i < max_len) {
+		char c;
+
+		if (s == end) {
+			buf[i] = '\0';
+			*pos = s;
+			return (i == 0) ? false : true;
+		}
+
+		c = *s++;
+
+		if (c == '\r') {
+			seen_cr = true;
+			continue;
+		}
+
+		if (seen_cr && c != '\n') {
+			*pos = s - 1;
+			buf[i] = '\0';
+			return true;
+		}
+
+		if (c == '\n') {
+			buf[i] = '\0';
+			*pos = s;
+			return true;
+		}
+
+		/* Expand tabs */
+		if (c == '\t') {
+			/* Next tab stop */
+			size_t tabstop = ((i + TAB_COLUMNS) / TAB_COLUMNS) * TAB_COLUMNS;
+			if (tabstop >= len) break;
+
+			/* Convert to spaces */
+			while (i < tabstop)
+				buf[i++] = ' ';
+
+			continue;
+		}
+
+		buf[i++] = c;
+	}
+
+	buf[i] = '\0';
+	*pos = s;
+	return true;
+}
+
 /**
  * Append a line of text 'buf' to the end of file 'f', using system-dependent
  * line ending.
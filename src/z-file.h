@@ -172,6 +172,13 @@ bool file_move(const char *fname, const char *newname);
  */
 bool file_newer(const char *first, const char *second);
 
+/**
+ * Gets the size and modification time of the file `fname`.
+ *
+ * Returns true if successful, false otherwise.
+ */
+bool file_stamp(const char *fname, uint64_t *size, uint64_t *mtime);
+
 
 /** File handle creation **/
 
@@ -232,6 +239,14 @@ void file_unlock(ang_file *f);
  */
 bool file_getl(ang_file *f, char *buf, size_t n);
 
+/**
+ * Get a line of text, as file_getl() would, from the text between `*pos` and
+ * `end`, advancing `*pos` past it.
+ *
+ * Returns true when data is returned; false otherwise.
+ */
+bool text_getl(const char **pos, const char *end, char *buf, size_t n);
+
 /**
  * Write the string pointed to by `buf` to the file represented by `f`.
  *
@@ -254,12 +269,31 @@ bool file_vputf(ang_file *f, const char *fmt, va_list vp);
  */
 bool file_skip(ang_file *f, int bytes);
 
+/**
+ * Get the current position in the file, as a number of bytes from the start.
+ * \returns the position, or -1 on error.
+ */
+long file_tell(ang_file *f);
+
+/**
+ * Move to position 'pos', as returned by file_tell().
+ * \returns true if successful, false otherwise.
+ */
+bool file_seek(ang_file *f, long pos);
+
 /**
  * Reads n bytes from file 'f' into buffer 'buf'.
  * \returns Number of bytes read; -1 on error
  */
 int file_read(ang_file *f, char *buf, size_t n);
 
+/**
+ * Reads the rest of file 'f' into a buffer allocated with mem_alloc(), with a
+ * terminating 0 after the contents.
+ * \returns The buffer, with its length put in *len; NULL on error
+ */
+char *file_read_all(ang_file *f, size_t *len);
+
 /**
  * Write the first `n` bytes following the pointer `buf` to the file represented
  * by `f`.  Do not mix with calls to file_writec().
@@ -0,0 +1,189 @@
+/**
+ * \file z-names.c
+ * \brief Hash indexes from names to numbers
+ *
+ * Copyright (c) 2026 StukovTTV
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+#include "z-names.h"
+#include "z-util.h"
+#include "z-virt.h"
+
+struct name_entry {
+	size_t name;
+	uint32_t hash;
+	int value;
+};
+
+/**
+ * The names are kept end to end in one buffer, and the entries, which give
+ * where in the buffer their names are, in the order they were added.  The
+ * slots hold one more than the place of an entry, or zero if empty.  Linear
+ * probing means that entries for the same name are met in the order they were
+ * added, so long as the slots are filled in that order, which they are even
+ * when the index grows.
+ */
+struct name_index {
+	bool ignore_case;
+	char *text;
+	size_t text_used;
+	size_t text_alloc;
+	struct name_entry *entries;
+	size_t count;
+	size_t alloc;
+	uint32_t *slots;
+	size_t nr_slots;
+};
+
+#define NAME_INDEX_INIT	32
+#define NAME_INDEX_TEXT_INIT	1024
+
+static uint32_t name_hash(const char *name, bool ignore_case)
+{
+	uint32_t hash = 2166136261U;
+
+	for (; *name; name++) {
+		unsigned char c = (unsigned char)*name;
+
+		if (ignore_case)
+			c = (unsigned char)tolower(c);
+		hash = (hash ^ c) * 16777619U;
+	}
+
+	return hash;
+}
+
+static void name_index_slot(struct name_index *index, size_t n)
+{
+	size_t mask = index->nr_slots - 1;
+	size_t i = index->entries[n].hash & mask;
+
+	while (index->slots[i])
+		i = (i + 1) & mask;
+	index->slots[i] = (uint32_t)(n + 1);
+}
+
+/**
+ * Make a new, empty index, which matches names exactly or ignoring case
+ */
+struct name_index *name_index_new(bool ignore_case)
+{
+	struct name_index *index = mem_zalloc(sizeof(*index));
+
+	index->ignore_case = ignore_case;
+	index->text_alloc = NAME_INDEX_TEXT_INIT;
+	index->text = mem_alloc(index->text_alloc);
+	index->alloc = NAME_INDEX_INIT;
+	index->entries = mem_zalloc(index->alloc * sizeof(struct name_entry));
+	index->nr_slots = 2 * NAME_INDEX_INIT;
+	index->slots = mem_zalloc(index->nr_slots * sizeof(uint32_t));
+
+	return index;
+}
+
+void name_index_free(struct name_index *index)
+{
+	if (!index)
+		return;
+
+	mem_free(index->slots);
+	mem_free(index->entries);
+	mem_free(index->text);
+	mem_free(index);
+}
+
+/**
+ * Add a name to an index, standing for the given number
+ */
+void name_index_add(struct name_index *index, const char *name, int value)
+{
+	struct name_entry *entry;
+	size_t len = strlen(name) + 1;
+
+	while (index->text_used + len > index->text_alloc) {
+		index->text_alloc *= 2;
+		index->text = mem_realloc(index->text, index->text_alloc);
+	}
+
+	if (index->count == index->alloc) {
+		index->alloc *= 2;
+		index->entries = mem_realloc(index->entries,
+			index->alloc * sizeof(struct name_entry));
+	}
+
+	entry = &index->entries[index->count];
+	entry->name = index->text_used;
+	memcpy(index->text + index->text_used, name, len);
+	index->text_used += len;
+	entry->hash = name_hash(name, index->ignore_case);
+	entry->value = value;
+	index->count++;
+
+	/* Keep the slots no more than half full */
+	if (index->count * 2 > index->nr_slots) {
+		size_t n;
+
+		mem_free(index->slots);
+		index->nr_slots *= 2;
+		index->slots = mem_zalloc(index->nr_slots * sizeof(uint32_t));
+		for (n = 0; n < index->count; n++)
+			name_index_slot(index, n);
+	} else {
+		name_index_slot(index, index->count - 1);
+	}
+}
+
+/**
+ * Return the number for the next entry with the given name, or -1 if there
+ * are no more.  pos should be zero to start with, and is moved along as
+ * entries are found.
+ */
+int name_index_next(const struct name_index *index, const char *name,
+	size_t *pos)
+{
+	uint32_t hash = name_hash(name, index->ignore_case);
+	size_t mask = index->nr_slots - 1;
+
+	while (*pos < index->nr_slots) {
+		uint32_t slot = index->slots[(hash + *pos) & mask];
+		const struct name_entry *entry;
+		const char *entry_name;
+
+		(*pos)++;
+		if (!slot)
+			break;
+
+		entry = &index->entries[slot - 1];
+		if (entry->hash != hash)
+			continue;
+		entry_name = index->text + entry->name;
+		if (index->ignore_case ? !my_stricmp(entry_name, name) :
+				streq(entry_name, name))
+			return entry->value;
+	}
+
+	/* Don't look past an empty slot again */
+	*pos = index->nr_slots;
+	return -1;
+}
+
+/**
+ * Return the number for the first entry with the given name, or -1 if there
+ * is none
+ */
+int name_index_find(const struct name_index *index, const char *name)
+{
+	size_t pos = 0;
+
+	return name_index_next(index, name, &pos);
+}
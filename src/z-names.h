@@ -0,0 +1,38 @@
+/**
+ * \file z-names.h
+ * \brief Hash indexes from names to numbers
+ *
+ * Copyright (c) 2026 StukovTTV
+ *
+ * This work is free software; you can redistribute it and/or modify it
+ * under the terms of either:
+ *
+ * a) the GNU General Public License as published by the Free Software
+ *    Foundation, version 2, or
+ *
+ * b) the "Angband licence":
+ *    This software may be copied and distributed for educational, research,
+ *    and not for profit purposes provided that this copyright and statement
+ *    are included in all such copies.  Other copyrights may also apply.
+ */
+
+#ifndef INCLUDED_Z_NAMES_H
+#define INCLUDED_Z_NAMES_H
+
+#include "h-basic.h"
+
+/**
+ * An index of names, each standing for a number such as its place in a
+ * table.  The index keeps its own copies of the names.  A name may be added
+ * more than once, and is then found in the order the numbers were added.
+ */
+struct name_index;
+
+struct name_index *name_index_new(bool ignore_case);
+void name_index_free(struct name_index *index);
+void name_index_add(struct name_index *index, const char *name, int value);
+int name_index_find(const struct name_index *index, const char *name);
+int name_index_next(const struct name_index *index, const char *name,
+	size_t *pos);
+
+#endif /* !INCLUDED_Z_NAMES_H */
@@ -22,28 +22,120 @@
 #include "z-quark.h"
 #include "init.h"
 
-static char **quarks;
+/**
+ * Quark strings are kept end to end in pages of memory which are only freed
+ * when the quarks are; a string too long for a page gets one of its own
+ */
+struct quark_page {
+	struct quark_page *next;
+	size_t used;
+	size_t size;
+	char text[];
+};
+
+static const char **quarks;
 static size_t nr_quarks = 1;
 static size_t alloc_quarks = 0;
+static struct quark_page *pages;
+
+/**
+ * Open-addressed index from string hashes to quarks, with zero for an empty
+ * slot (quark zero is never handed out); it is never more than half full
+ */
+static quark_t *slots;
+static size_t nr_slots = 0;
 
 #define QUARKS_INIT	16
+#define QUARK_PAGE_SIZE	4096
 
-quark_t quark_add(const char *str)
+static uint32_t quark_hash(const char *str)
+{
+	uint32_t hash = 2166136261U;
+
+	while (*str)
+		hash = (hash ^ (unsigned char)*str++) * 16777619U;
+
+	return hash;
+}
+
+/**
+ * Find the slot where a string is, or would go
+ */
+static size_t quark_slot(const char *str)
+{
+	size_t mask = nr_slots - 1;
+	size_t i = quark_hash(str) & mask;
+
+	while (slots[i] && !streq(quarks[slots[i]], str))
+		i = (i + 1) & mask;
+
+	return i;
+}
+
+/**
+ * Double the size of the index, and put the quarks back into it
+ */
+static void quark_grow_index(void)
 {
 	quark_t q;
 
-	for (q = 1; q < nr_quarks; q++) {
-		if (streq(quarks[q], str))
-			return q;
+	mem_free(slots);
+	nr_slots *= 2;
+	slots = mem_zalloc(nr_slots * sizeof(quark_t));
+	for (q = 1; q < nr_quarks; q++)
+		slots[quark_slot(quarks[q])] = q;
+}
+
+/**
+ * Copy a string into the pages
+ */
+static const char *quark_store(const char *str)
+{
+	size_t len = strlen(str) + 1;
+	struct quark_page *page = pages;
+	char *copy;
+
+	if (!page || page->size - page->used < len) {
+		size_t size = MAX(len, QUARK_PAGE_SIZE);
+
+		page = mem_alloc(sizeof(*page) + size);
+		page->used = 0;
+		page->size = size;
+
+		/* Keep filling the old page if the new one is just for this string */
+		if (pages && len > QUARK_PAGE_SIZE) {
+			page->next = pages->next;
+			pages->next = page;
+		} else {
+			page->next = pages;
+			pages = page;
+		}
 	}
 
+	copy = page->text + page->used;
+	page->used += len;
+	memcpy(copy, str, len);
+	return copy;
+}
+
+quark_t quark_add(const char *str)
+{
+	size_t i = quark_slot(str);
+	quark_t q = slots[i];
+
+	if (q)
+		return q;
+
 	if (nr_quarks == alloc_quarks) {
 		alloc_quarks *= 2;
 		quarks = mem_realloc(quarks, alloc_quarks * sizeof(char *));
 	}
 
 	q = nr_quarks++;
-	quarks[q] = string_make(str);
+	quarks[q] = quark_store(str);
+	slots[i] = q;
+	if (nr_quarks * 2 > nr_slots)
+		quark_grow_index();
 
 	return q;
 }
@@ -58,16 +150,23 @@ void quarks_init(void)
 	nr_quarks = 1;
 	alloc_quarks = QUARKS_INIT;
 	quarks = mem_zalloc(alloc_quarks * sizeof(char*));
+	nr_slots = 2 * QUARKS_INIT;
+	slots = mem_zalloc(nr_slots * sizeof(quark_t));
+	pages = NULL;
 }
 
 void quarks_free(void)
 {
-	size_t i;
+	while (pages) {
+		struct quark_page *next = pages->next;
 
-	/* quarks[0] is special */
-	for (i = 1; i < nr_quarks; i++)
-		string_free(quarks[i]);
+		mem_free(pages);
+		pages = next;
+	}
 
+	mem_free(slots);
+	slots = NULL;
+	nr_slots = 0;
 	mem_free(quarks);
 }
 
@@ -18,9 +18,13 @@
  *    are included in all such copies.  Other copyrights may also apply.
  */
 #include "z-rand.h"
+#include "z-virt.h"
 #ifdef _WIN32
 #include <windows.h> /* GetCurrentProcessId() */
 #endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 /**
  * This file provides a pseudo-random number generator.
@@ -36,6 +40,14 @@
  * "Rand_value = seed". After that it will be automatically used instead of
  * the "complex" RNG. When you are done, you can de-activate it via
  * "Rand_quick = false". You can also choose a new seed.
+ *
+ * The complex RNG draws from the current stream, which is the game's own,
+ * Rand_game, unless another has been put in its place with Rand_use().  Other
+ * streams have their own state, so can be seeded, split and drawn from
+ * without touching the game's; the functions below taking no stream all draw
+ * from the current one.  Each thread has a current stream of its own, so
+ * threads can draw from streams of their own at the same time.  The simple
+ * RNG and Rand_fixed() are still shared by the whole process.
  */
 
 /* begin WELL RNG
@@ -53,13 +65,6 @@
 #define MAT0NEG(t, v) (v ^ (v << (-(t))))
 #define Identity(v) (v)
 
-uint32_t state_i = 0;
-uint32_t STATE[RAND_DEG] = {0, 0, 0, 0, 0, 0, 0, 0,
-						0, 0, 0, 0, 0, 0, 0, 0,
-						0, 0, 0, 0, 0, 0, 0, 0,
-						0, 0, 0, 0, 0, 0, 0, 0};
-uint32_t z0, z1, z2;
-
 #define V0    STATE[state_i]
 #define VM1   STATE[(state_i + M1) & 0x0000001fU]
 #define VM2   STATE[(state_i + M2) & 0x0000001fU]
@@ -68,13 +73,18 @@ uint32_t z0, z1, z2;
 #define newV0 STATE[(state_i + 31) & 0x0000001fU]
 #define newV1 STATE[state_i]
 
-static uint32_t WELLRNG1024a (void){
+static uint32_t WELLRNG1024a (struct rand_stream *r){
+	uint32_t *STATE = r->state;
+	uint32_t state_i = r->i;
+	uint32_t z0, z1, z2;
+
 	z0      = VRm1;
 	z1      = Identity(V0) ^ MAT0POS (8, VM1);
 	z2      = MAT0NEG (-19, VM2) ^ MAT0NEG(-14,VM3);
 	newV1   = z1 ^ z2; 
 	newV0   = MAT0NEG (-11,z0) ^ MAT0NEG(-7,z1) ^ MAT0NEG(-13,z2);
 	state_i = (state_i + 31) & 0x0000001fU;
+	r->i = state_i;
 	return STATE[state_i];
 }
 /* end WELL RNG */
@@ -95,34 +105,127 @@ bool Rand_quick = true;
  */
 uint32_t Rand_value;
 
+/**
+ * The game's own stream for the complex RNG, which goes in the savefile.
+ */
+struct rand_stream Rand_game;
+
+/**
+ * The stream the complex RNG draws from, one for each thread where the
+ * compiler allows.
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+static _Thread_local struct rand_stream *rand_current = &Rand_game;
+#elif defined(__GNUC__)
+static __thread struct rand_stream *rand_current = &Rand_game;
+#elif defined(_MSC_VER)
+static __declspec(thread) struct rand_stream *rand_current = &Rand_game;
+#else
+static struct rand_stream *rand_current = &Rand_game;
+#endif
+
 static bool rand_fixed = false;
 static uint32_t rand_fixval = 0;
 
 /**
- * Initialize the complex RNG using a new seed.
+ * Fill the table of a stream from a seed, starting from wherever its index
+ * happens to be.
  */
-void Rand_state_init(uint32_t seed)
+static void rand_stream_fill_table(struct rand_stream *r, uint32_t seed)
 {
 	int i, j;
 
 	/* Seed the table */
-	STATE[0] = seed;
+	r->state[0] = seed;
 
 	/* Propagate the seed */
 	for (i = 1; i < RAND_DEG; i++)
-		STATE[i] = LCRNG(STATE[i - 1]);
+		r->state[i] = LCRNG(r->state[i - 1]);
 
 	/* Cycle the table ten times per degree */
 	for (i = 0; i < RAND_DEG * 10; i++) {
 		/* Acquire the next index */
-		j = (state_i + 1) % RAND_DEG;
+		j = (r->i + 1) % RAND_DEG;
 
 		/* Update the table, extract an entry */
-		STATE[j] += STATE[state_i];
+		r->state[j] += r->state[r->i];
 
 		/* Advance the index */
-		state_i = j;
+		r->i = j;
+	}
+}
+
+/**
+ * Initialize the complex RNG using a new seed.
+ */
+void Rand_state_init(uint32_t seed)
+{
+	rand_stream_fill_table(&Rand_game, seed);
+}
+
+/**
+ * Seed a stream, so that the same seed always gives the same numbers.
+ */
+void rand_stream_seed(struct rand_stream *r, uint32_t seed)
+{
+	r->i = 0;
+	rand_stream_fill_table(r, seed);
+}
+
+/**
+ * Scramble the bits of a number (the finaliser of MurmurHash3), so that the
+ * state of a split stream bears no simple relation to the numbers drawn from
+ * its parent to make it.
+ */
+static uint32_t rand_scramble(uint32_t v)
+{
+	v ^= v >> 16;
+	v *= 0x85ebca6bU;
+	v ^= v >> 13;
+	v *= 0xc2b2ae35U;
+	v ^= v >> 16;
+	return v;
+}
+
+/**
+ * Split off a new stream from an existing one, drawing its state from the
+ * existing stream.  The two can then be drawn from independently, and the
+ * same parent state always gives the same child.
+ */
+void rand_stream_split(struct rand_stream *r, struct rand_stream *child)
+{
+	uint32_t any = 0;
+	int i;
+
+	for (i = 0; i < RAND_DEG; i++) {
+		child->state[i] = rand_scramble(WELLRNG1024a(r) ^
+			(0x9e3779b9U * (uint32_t) (i + 1)));
+		any |= child->state[i];
 	}
+	child->i = 0;
+
+	/* An empty table would give nothing but zeroes */
+	if (!any) child->state[0] = 1;
+}
+
+/**
+ * Get the next raw 32-bit number from a stream.
+ */
+uint32_t rand_stream_next(struct rand_stream *r)
+{
+	return WELLRNG1024a(r);
+}
+
+/**
+ * Make a stream the one the complex RNG draws from in this thread, or the
+ * game's own stream if NULL, returning the one it was drawing from before.
+ */
+struct rand_stream *Rand_use(struct rand_stream *r)
+{
+	struct rand_stream *old = rand_current;
+
+	rand_current = r ? r : &Rand_game;
+	return old;
 }
 
 /**
@@ -154,6 +257,29 @@ void Rand_init(void)
 }
 
 
+/**
+ * Extract a "random" number from 0 to m - 1 from a stream, by the method
+ * described for Rand_div() below.
+ */
+uint32_t rand_stream_div(struct rand_stream *r, uint32_t m)
+{
+	uint32_t n, v;
+
+	/* Division by zero will result if m is larger than 0x10000000 */
+	assert(m <= 0x10000000);
+
+	if (m <= 1) return 0;
+
+	/* Partition size */
+	n = 0x10000000 / m;
+
+	do {
+		v = ((WELLRNG1024a(r) >> 4) & 0x0FFFFFFF) / n;
+	} while (v >= m);
+
+	return v;
+}
+
 /**
  * Extract a "random" number from 0 to m - 1, via division.
  *
@@ -195,23 +321,58 @@ uint32_t Rand_div(uint32_t m)
 			if (r < m) break;
 		}
 	} else {
-		/* Use a complex RNG */
-		while (1) {
-			/* Get the next pseudorandom number */
-			r = WELLRNG1024a();
-
-			/* Mutate a 28-bit "random" number */
-			r = ((r >> 4) & 0x0FFFFFFF) / n;
-
-			/* Done */
-			if (r < m) break;
-		}
+		/* Use the complex RNG */
+		r = rand_stream_div(rand_current, m);
 	}
 
 	/* Use the value */
 	return (r);
 }
 
+/**
+ * Draw n numbers from 0 to m - 1 at once, getting just what n calls to
+ * Rand_div(m) would.
+ */
+void Rand_fill(uint32_t m, uint32_t *out, int n)
+{
+	uint32_t part;
+	int i;
+
+	assert(m <= 0x10000000);
+
+	if (m <= 1) {
+		for (i = 0; i < n; i++) out[i] = 0;
+		return;
+	}
+
+	if (rand_fixed) {
+		for (i = 0; i < n; i++)
+			out[i] = (rand_fixval * 1000 * (m - 1)) / (100 * 1000);
+		return;
+	}
+
+	part = 0x10000000 / m;
+	if (Rand_quick) {
+		uint32_t value = Rand_value;
+
+		for (i = 0; i < n; i++) {
+			do {
+				value = LCRNG(value);
+				out[i] = ((value >> 4) & 0x0FFFFFFF) / part;
+			} while (out[i] >= m);
+		}
+		Rand_value = value;
+	} else {
+		struct rand_stream *r = rand_current;
+
+		for (i = 0; i < n; i++) {
+			do {
+				out[i] = ((WELLRNG1024a(r) >> 4) & 0x0FFFFFFF) / part;
+			} while (out[i] >= m);
+		}
+	}
+}
+
 
 /**
  * The number of entries in the "Rand_normal_table"
@@ -350,18 +511,198 @@ int Rand_sample(int mean, int upper, int lower, int stand_u, int stand_l)
 	return mean + pick;
 }
 
+/**
+ * The most totals a damroll_distribution is made for
+ */
+#define DAMROLL_TABLE_MAX	4096
+
+/**
+ * Distributions made so far, hashed by number and sides of the dice
+ */
+#define DAMROLL_TABLE_BUCKETS	256
+static struct damroll_distribution *damroll_tables[DAMROLL_TABLE_BUCKETS];
+
+/**
+ * Held while the distributions are looked up, made or freed, since damroll()
+ * may be called from any thread
+ */
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t damroll_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ * Work out the chances of each total of num dice with the given sides, by
+ * adding one die at a time, and make the alias table (Vose's method) that
+ * lets a total be rolled with two draws from the RNG.
+ */
+static struct damroll_distribution *damroll_distribution_make(int num,
+		int sides, int totals)
+{
+	struct damroll_distribution *d = mem_zalloc(sizeof(*d));
+	double *next = mem_zalloc(totals * sizeof(*next));
+	double *scaled = mem_zalloc(totals * sizeof(*scaled));
+	int *small = mem_zalloc(totals * sizeof(*small));
+	int *large = mem_zalloc(totals * sizeof(*large));
+	int i, k, n_small = 0, n_large = 0;
+
+	d->num = num;
+	d->sides = sides;
+	d->min = num;
+	d->max = num * sides;
+	d->mean = num * (sides + 1) / 2.0;
+	d->chance = mem_zalloc(totals * sizeof(*d->chance));
+	d->cut = mem_zalloc(totals * sizeof(*d->cut));
+	d->alias = mem_zalloc(totals * sizeof(*d->alias));
+
+	/* One die; then each further die spreads each total over the next
+	 * sides totals, kept as a running window sum */
+	for (k = 0; k < sides; k++)
+		d->chance[k] = 1.0 / sides;
+	for (i = 1; i < num; i++) {
+		int span = i * (sides - 1) + 1;
+		double window = 0.0;
+
+		for (k = 0; k < span + sides - 1; k++) {
+			if (k < span) window += d->chance[k];
+			if (k >= sides) window -= d->chance[k - sides];
+			next[k] = window / sides;
+		}
+		memcpy(d->chance, next, (span + sides - 1) * sizeof(*next));
+	}
+
+	/* Pair off the totals less likely than average with more likely ones */
+	for (k = 0; k < totals; k++) {
+		scaled[k] = d->chance[k] * totals;
+		if (scaled[k] < 1.0)
+			small[n_small++] = k;
+		else
+			large[n_large++] = k;
+	}
+	while (n_small && n_large) {
+		int s = small[--n_small], l = large[--n_large];
+
+		d->cut[s] = (uint32_t) (scaled[s] * 0x10000000 + 0.5);
+		d->alias[s] = l;
+		scaled[l] += scaled[s] - 1.0;
+		if (scaled[l] < 1.0)
+			small[n_small++] = l;
+		else
+			large[n_large++] = l;
+	}
+	while (n_large) {
+		k = large[--n_large];
+		d->cut[k] = 0x10000000;
+		d->alias[k] = k;
+	}
+	while (n_small) {
+		k = small[--n_small];
+		d->cut[k] = 0x10000000;
+		d->alias[k] = k;
+	}
+
+	mem_free(large);
+	mem_free(small);
+	mem_free(scaled);
+	mem_free(next);
+	return d;
+}
+
+/**
+ * Get the distribution of the totals of num dice with the given sides, or
+ * NULL if there are too many totals to tabulate.  Distributions are made
+ * once and kept until damroll_distributions_free().
+ */
+const struct damroll_distribution *damroll_distribution(int num, int sides)
+{
+	uint32_t bucket;
+	struct damroll_distribution *d;
+	long long totals = (long long) num * (sides - 1) + 1;
+
+	if (num <= 0 || sides <= 0 || totals > DAMROLL_TABLE_MAX) return NULL;
+
+	bucket = ((uint32_t) num * 31U + (uint32_t) sides) % DAMROLL_TABLE_BUCKETS;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&damroll_lock);
+#endif
+	for (d = damroll_tables[bucket]; d; d = d->next) {
+		if (d->num == num && d->sides == sides) break;
+	}
+	if (!d) {
+		d = damroll_distribution_make(num, sides, (int) totals);
+		d->next = damroll_tables[bucket];
+		damroll_tables[bucket] = d;
+	}
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&damroll_lock);
+#endif
+	return d;
+}
+
+/**
+ * Roll a total from a distribution
+ */
+int damroll_distribution_roll(const struct damroll_distribution *d)
+{
+	int k = (int) Rand_div(d->max - d->min + 1);
+
+	if (Rand_div(0x10000000) >= d->cut[k]) k = d->alias[k];
+	return d->min + k;
+}
+
+/**
+ * Free all the distributions made
+ */
+void damroll_distributions_free(void)
+{
+	int i;
+
+#ifdef HAVE_PTHREAD
+	pthread_mutex_lock(&damroll_lock);
+#endif
+	for (i = 0; i < DAMROLL_TABLE_BUCKETS; i++) {
+		while (damroll_tables[i]) {
+			struct damroll_distribution *d = damroll_tables[i];
+
+			damroll_tables[i] = d->next;
+			mem_free(d->alias);
+			mem_free(d->cut);
+			mem_free(d->chance);
+			mem_free(d);
+		}
+	}
+#ifdef HAVE_PTHREAD
+	pthread_mutex_unlock(&damroll_lock);
+#endif
+}
+
 /**
  * Generates damage for "2d6" style dice rolls
+ *
+ * Many dice are rolled at once, as a total drawn from their distribution;
+ * fewer are rolled one by one.
  */
 int damroll(int num, int sides)
 {
-	int i;
-	int sum = 0;
+	uint32_t rolls[32];
+	int sum = num;
+
+	if (sides <= 0 || num <= 0) return 0;
 
-	if (sides <= 0) return 0;
+	if (num >= DAMROLL_TABLE_DICE && !rand_fixed) {
+		const struct damroll_distribution *d =
+			damroll_distribution(num, sides);
 
-	for (i = 0; i < num; i++)
-		sum += randint1(sides);
+		if (d) return damroll_distribution_roll(d);
+	}
+
+	while (num > 0) {
+		int i, n = MIN(num, (int) N_ELEMENTS(rolls));
+
+		Rand_fill(sides, rolls, n);
+		for (i = 0; i < n; i++)
+			sum += rolls[i];
+		num -= n;
+	}
 	return sum;
 }
 
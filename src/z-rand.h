@@ -108,13 +108,17 @@ extern bool Rand_quick;
 extern uint32_t Rand_value;
 
 /**
- * The state used by the "complex" RNG.
+ * The state of a stream of numbers from the "complex" RNG.
  */
-extern uint32_t state_i;
-extern uint32_t STATE[RAND_DEG];
-extern uint32_t z0;
-extern uint32_t z1;
-extern uint32_t z2;
+struct rand_stream {
+	uint32_t i;
+	uint32_t state[RAND_DEG];
+};
+
+/**
+ * The game's own stream for the "complex" RNG.
+ */
+extern struct rand_stream Rand_game;
 
 
 /**
@@ -127,6 +131,36 @@ void Rand_state_init(uint32_t seed);
  */
 void Rand_init(void);
 
+/**
+ * Seed a stream of its own for the "complex" RNG.
+ */
+void rand_stream_seed(struct rand_stream *r, uint32_t seed);
+
+/**
+ * Split an independent stream off an existing one.
+ */
+void rand_stream_split(struct rand_stream *r, struct rand_stream *child);
+
+/**
+ * Get the next raw 32-bit number from a stream.
+ */
+uint32_t rand_stream_next(struct rand_stream *r);
+
+/**
+ * Generates a random unsigned long integer X where "0 <= X < M" holds, from
+ * the given stream.
+ */
+uint32_t rand_stream_div(struct rand_stream *r, uint32_t m);
+
+/**
+ * Make the "complex" RNG draw from the given stream (the game's own if NULL)
+ * in the calling thread, returning the stream it drew from before.  Other
+ * threads keep drawing from their own current stream, which starts out as
+ * the game's.  On compilers without thread-local storage there is one
+ * current stream for the whole process.
+ */
+struct rand_stream *Rand_use(struct rand_stream *r);
+
 /**
  * Generates a random unsigned long integer X where "0 <= X < M" holds.
  *
@@ -134,6 +168,12 @@ void Rand_init(void);
  */
 uint32_t Rand_div(uint32_t m);
 
+/**
+ * Fills `out` with `n` random unsigned integers X where "0 <= X < M" holds,
+ * the same numbers as `n` calls to Rand_div(M) would give.
+ */
+void Rand_fill(uint32_t m, uint32_t *out, int n);
+
 /**
  * Generate a signed random integer within `stand` standard deviations of
  * `mean`, following a normal distribution.
@@ -155,6 +195,46 @@ int Rand_sample(int mean, int upper, int lower, int stand_u, int stand_l);
  */
 uint32_t Rand_simple(uint32_t m);
 
+/**
+ * The fewest dice that damroll() rolls all at once, from the distribution of
+ * their totals, rather than one by one.
+ */
+#define DAMROLL_TABLE_DICE	16
+
+/**
+ * The chances of each total of `num` dice with `sides` sides, with the
+ * alias table used to roll them.
+ */
+struct damroll_distribution {
+	int num;
+	int sides;
+	int min;
+	int max;
+	double mean;
+	double *chance;		/* chance[k] is the chance of a total of min + k */
+	uint32_t *cut;		/* Keep k if a 28-bit roll is below cut[k], */
+	int *alias;			/* else take alias[k] */
+	struct damroll_distribution *next;
+};
+
+/**
+ * Get the (shared, unchanging) distribution of totals of `num` dice with
+ * `sides` sides, or NULL if there are too many totals.  Safe to call from
+ * any thread; a missing distribution is made under a lock.
+ */
+const struct damroll_distribution *damroll_distribution(int num, int sides);
+
+/**
+ * Roll a total from a distribution.
+ */
+int damroll_distribution_roll(const struct damroll_distribution *d);
+
+/**
+ * Free the distributions made by damroll_distribution().  No other thread
+ * may be rolling dice, or holding a distribution, at the time.
+ */
+void damroll_distributions_free(void);
+
 /**
  * Emulate a number `num` of dice rolls of dice with `sides` sides.
  */